@@ -37,25 +37,17 @@
 #include <libxml/tree.h>
 
 #include "../constants.h"
-
-#define NUM_BANDS 10
+#include "mafw-gst-renderer-eq-layout.h"
 
 #define XML_NODE_BAND        "band"
 #define XML_NODE_EQUALIZER   "equalizer"
 #define XML_PROP_BAND_NUMBER "num"
+#define XML_PROP_LAYOUT      "layout"
 
 static GConfClient *confclient = NULL;
 
-static const gchar *title_band[NUM_BANDS] = { "29 Hz: %.1f dB",
-                                              "59 Hz: %.1f dB",
-                                              "119 Hz: %.1f dB",
-                                              "227 Hz: %.1f dB",
-                                              "474 Hz: %.1f dB",
-                                              "947 Hz: %.1f dB",
-                                              "2 KHz: %.1f dB",
-                                              "4 KHz: %.1f dB",
-                                              "8 KHz: %.1f dB",
-                                              "15 KHz: %.1f dB" };
+/* Band layout shared with the renderer; one slider is shown per band */
+static EqDspLayout layout;
 
 struct label_band {
         GtkWidget *label;
@@ -68,13 +60,31 @@ struct dialog_and_sliders {
 };
 
 
+/* Reads the band layout stored in gconf, or the default one */
+static void load_layout(void)
+{
+        gchar *layout_str;
+
+        if (!confclient) {
+                confclient = gconf_client_get_default();
+        }
+
+        layout_str = gconf_client_get_string(confclient,
+                                             GCONF_MAFW_GST_EQ_RENDERER_LAYOUT,
+                                             NULL);
+        if (!layout_str || !eq_layout_parse(layout_str, &layout)) {
+                eq_layout_init_default(&layout);
+        }
+        g_free(layout_str);
+}
+
 /* Returns currently stored gain in gconf for band */
 static gdouble get_band_value(gint band)
 {
         gchar *key;
         gdouble value;
 
-        g_return_val_if_fail(band >= 0 && band < NUM_BANDS, 0);
+        g_return_val_if_fail(band >= 0 && band < layout.n_bands, 0);
 
         if (!confclient) {
                 confclient = gconf_client_get_default();
@@ -111,10 +121,18 @@ static void update_band_cb(GtkRange *range, gpointer band)
 static void update_label_cb(GtkRange *range, gpointer user_data)
 {
         gchar *label_value;
+        gdouble freq;
         struct label_band *lband = (struct label_band *) user_data;
 
-        label_value = g_strdup_printf(title_band[lband->id],
-                                      gtk_range_get_value(range));
+        freq = layout.bands[lband->id].freq;
+        if (freq >= 1000.0) {
+                label_value = g_strdup_printf("%.0f KHz: %.1f dB",
+                                              freq / 1000.0,
+                                              gtk_range_get_value(range));
+        } else {
+                label_value = g_strdup_printf("%.0f Hz: %.1f dB", freq,
+                                              gtk_range_get_value(range));
+        }
         gtk_label_set_label(GTK_LABEL(lband->label), label_value);
         g_free(label_value);
 }
@@ -124,7 +142,7 @@ static void update_label_cb(GtkRange *range, gpointer user_data)
 static void update_slider_cb(GConfClient *client,
                              guint cnxn_id,
                              GConfEntry *entry,
-                             GtkWidget *slider_band[NUM_BANDS])
+                             GtkWidget **slider_band)
 {
         const gchar *key;
         GConfValue *value;
@@ -134,11 +152,15 @@ static void update_slider_cb(GConfClient *client,
         key = gconf_entry_get_key(entry);
         value = gconf_entry_get_value(entry);
 
-        /* Get band number */
-        sscanf (key, GCONF_MAFW_GST_EQ_RENDERER "/band%d", &band_number);
-        if (band_number < NUM_BANDS) {
+        /* Get band number; other keys, as the layout, are ignored */
+        if (sscanf(key, GCONF_MAFW_GST_EQ_RENDERER "/band%d",
+                   &band_number) != 1) {
+                return;
+        }
+        if (band_number >= 0 && band_number < layout.n_bands) {
                 gain = value?
-                        CLAMP(gconf_value_get_float(value), -24.0, +12.0): 0.0;
+                        CLAMP(gconf_value_get_float(value),
+                              EQ_GAIN_MIN, EQ_GAIN_MAX): 0.0;
                 gtk_range_set_value(GTK_RANGE(slider_band[band_number]), gain);
         }
 }
@@ -196,6 +218,8 @@ static void preset_load(xmlDoc *preset)
         xmlNode *current_node;
         xmlChar *band_number;
         xmlChar *value_text;
+        xmlChar *layout_text;
+        EqDspLayout preset_layout;
         gdouble value;
         gchar *key;
 
@@ -206,6 +230,23 @@ static void preset_load(xmlDoc *preset)
         }
 
         root_node = xmlDocGetRootElement(preset);
+
+        /* The gains are only meaningful on the layout they were set on;
+         * presets saved before layouts were stored keep the current one */
+        layout_text = xmlGetProp(root_node, BAD_CAST XML_PROP_LAYOUT);
+        if (layout_text &&
+            eq_layout_parse((const gchar *) layout_text, &preset_layout)) {
+                gconf_client_set_string(confclient,
+                                        GCONF_MAFW_GST_EQ_RENDERER_LAYOUT,
+                                        (const gchar *) layout_text, NULL);
+                /* Sliders are only built once; a layout of another
+                 * size is shown next time the applet is opened */
+                if (preset_layout.n_bands == layout.n_bands) {
+                        layout = preset_layout;
+                }
+        }
+        xmlFree(layout_text);
+
         current_node = root_node->children;
         while (current_node) {
                 if (xmlStrcmp(current_node->name,
@@ -232,20 +273,25 @@ static void preset_load(xmlDoc *preset)
 
 /* Populate the preset with the current values in sliders, and save it to
  * disk */
-static void preset_save(xmlDoc *preset, GtkWidget *slider_band[NUM_BANDS])
+static void preset_save(xmlDoc *preset, GtkWidget **slider_band)
 {
         gint i;
         gchar *gain;
         gchar *band_number;
+        gchar *layout_str;
         gchar *preset_fullname;
         xmlNode *child_node;
         xmlNode *root_node;
 
-        /* Create nodes with band values */
+        /* Create nodes with band values, along with the layout they
+         * apply to */
         root_node = xmlNewDocNode(preset, NULL, BAD_CAST XML_NODE_EQUALIZER,
                                   NULL);
         xmlDocSetRootElement(preset, root_node);
-        for (i = 0; i < NUM_BANDS; i++) {
+        layout_str = eq_layout_to_string(&layout);
+        xmlSetProp(root_node, BAD_CAST XML_PROP_LAYOUT, BAD_CAST layout_str);
+        g_free(layout_str);
+        for (i = 0; i < layout.n_bands; i++) {
                 gain = g_strdup_printf(
                         "%.1f",
                         gtk_range_get_value(GTK_RANGE(slider_band[i])));
@@ -474,13 +520,13 @@ execute(osso_context_t *osso, gpointer data, gboolean user_activated)
 {
         /* Create needed variables */
         GtkWidget *dialog;
-        GtkObject *adj[NUM_BANDS];
-        struct label_band *lband[NUM_BANDS];
+        GtkObject *adj[EQ_DSP_MAX_BANDS];
+        struct label_band *lband[EQ_DSP_MAX_BANDS];
         struct dialog_and_sliders *dialog_slid;
-        GtkWidget *slider_band[NUM_BANDS];
-        GtkWidget *single_slider_container[NUM_BANDS];
-        gulong update_label_signal[NUM_BANDS];
-        gulong update_band_signal[NUM_BANDS];
+        GtkWidget *slider_band[EQ_DSP_MAX_BANDS];
+        GtkWidget *single_slider_container[EQ_DSP_MAX_BANDS];
+        gulong update_label_signal[EQ_DSP_MAX_BANDS];
+        gulong update_band_signal[EQ_DSP_MAX_BANDS];
         GtkWidget *sliders_container;
         gint i;
         GtkWidget *toolbar;
@@ -503,7 +549,8 @@ execute(osso_context_t *osso, gpointer data, gboolean user_activated)
         toolbar = gtk_toolbar_new();
 
         /* Create the bands */
-        for (i = 0; i < NUM_BANDS; i++) {
+        load_layout();
+        for (i = 0; i < layout.n_bands; i++) {
                 slider_band[i] = hildon_gtk_vscale_new();
                 adj[i] = gtk_adjustment_new(EQ_GAIN_MIN, EQ_GAIN_MIN,
                                             EQ_GAIN_MAX, 1, 10, 0);
@@ -602,7 +649,7 @@ execute(osso_context_t *osso, gpointer data, gboolean user_activated)
 
         /* Free everything */
         gconf_client_notify_remove(confclient, update_slider_signal);
-        for (i = 0; i < NUM_BANDS; i++) {
+        for (i = 0; i < layout.n_bands; i++) {
                 g_signal_handler_disconnect(slider_band[i],
                                             update_label_signal[i]);
                 g_signal_handler_disconnect(slider_band[i],
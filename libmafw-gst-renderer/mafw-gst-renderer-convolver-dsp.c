@@ -0,0 +1,765 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Uniformly partitioned FFT convolution for the renderer convolver.
+ *
+ * The impulse response is cut into partitions of one block, B frames, and
+ * the spectrum of each one (zero padded to 2B) is computed once.  Every B
+ * input frames the last 2B frames are transformed and the spectrum is
+ * pushed into a frequency domain delay line; the output spectrum is the sum
+ * of each partition spectrum times the input spectrum of as many blocks
+ * ago, and its inverse transform gives B new output frames (overlap-save).
+ * The cost per frame does not depend much on the length of the response,
+ * and the latency is B frames whatever the length.
+ *
+ * Transforms are real FFTs done as a complex FFT of half the size, in
+ * split (separate real and imaginary arrays) format so the butterflies and
+ * the spectrum products vectorize with SSE2 or NEON.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "mafw-gst-renderer-convolver-dsp.h"
+
+#undef  G_LOG_DOMAIN
+#define G_LOG_DOMAIN "mafw-gst-renderer-convolver"
+
+#if defined(__SSE2__) && !defined(MAFW_GST_RENDERER_DISABLE_SIMD)
+# define EQ_CONV_SSE2 1
+# include <emmintrin.h>
+#elif defined(__ARM_NEON__) && !defined(MAFW_GST_RENDERER_DISABLE_SIMD)
+# define EQ_CONV_NEON 1
+# include <arm_neon.h>
+#endif
+
+/*----------------------------------------------------------------------------
+  Vector abstraction
+  ----------------------------------------------------------------------------*/
+
+#if defined(EQ_CONV_SSE2)
+
+#define EQ_CONV_LANES 4
+typedef __m128 eq_conv_vec;
+#define _vec_add(a, b)		_mm_add_ps((a), (b))
+#define _vec_sub(a, b)		_mm_sub_ps((a), (b))
+#define _vec_mul(a, b)		_mm_mul_ps((a), (b))
+#define _vec_load(p)		_mm_loadu_ps(p)
+#define _vec_store(p, v)	_mm_storeu_ps((p), (v))
+
+#elif defined(EQ_CONV_NEON)
+
+#define EQ_CONV_LANES 4
+typedef float32x4_t eq_conv_vec;
+#define _vec_add(a, b)		vaddq_f32((a), (b))
+#define _vec_sub(a, b)		vsubq_f32((a), (b))
+#define _vec_mul(a, b)		vmulq_f32((a), (b))
+#define _vec_load(p)		vld1q_f32(p)
+#define _vec_store(p, v)	vst1q_f32((p), (v))
+
+#else
+
+#define EQ_CONV_LANES 1
+
+#endif
+
+/*----------------------------------------------------------------------------
+  FFT
+  ----------------------------------------------------------------------------*/
+
+/*
+ * size:           Real transform size, N.
+ * half:           Complex transform size, M = N / 2.
+ * rev:            Bit reversal permutation of M points.
+ * tw_re, tw_im:   Butterfly twiddles; the stage of span 2h uses the h
+ *                 entries at offset h - 1, exp(-2 pi i j / 2h).
+ * post_re, post_im: exp(-2 pi i k / N) for k < M / 2, to split the complex
+ *                 transform into the real one.
+ */
+struct _EqConvFft {
+	gint size;
+	gint half;
+	guint *rev;
+	gfloat *tw_re;
+	gfloat *tw_im;
+	gfloat *post_re;
+	gfloat *post_im;
+};
+
+/* Creates a plan for real transforms of @size points, a power of two of
+ * at least 8 */
+EqConvFft *eq_conv_fft_new(gint size)
+{
+	EqConvFft *fft;
+	gint bits, h, i, j;
+
+	g_return_val_if_fail(size >= 8 && (size & (size - 1)) == 0, NULL);
+
+	fft = g_new0(EqConvFft, 1);
+	fft->size = size;
+	fft->half = size / 2;
+
+	for (bits = 0; (1 << bits) < fft->half; bits++);
+	fft->rev = g_new(guint, fft->half);
+	for (i = 0; i < fft->half; i++) {
+		guint r = 0;
+
+		for (j = 0; j < bits; j++) {
+			if (i & (1 << j))
+				r |= 1 << (bits - 1 - j);
+		}
+		fft->rev[i] = r;
+	}
+
+	fft->tw_re = g_new(gfloat, fft->half);
+	fft->tw_im = g_new(gfloat, fft->half);
+	for (h = 1; h < fft->half; h <<= 1) {
+		for (j = 0; j < h; j++) {
+			fft->tw_re[h - 1 + j] = cos(-G_PI * j / h);
+			fft->tw_im[h - 1 + j] = sin(-G_PI * j / h);
+		}
+	}
+
+	fft->post_re = g_new(gfloat, fft->half / 2);
+	fft->post_im = g_new(gfloat, fft->half / 2);
+	for (i = 0; i < fft->half / 2; i++) {
+		fft->post_re[i] = cos(-2.0 * G_PI * i / size);
+		fft->post_im[i] = sin(-2.0 * G_PI * i / size);
+	}
+
+	return fft;
+}
+
+void eq_conv_fft_free(EqConvFft *fft)
+{
+	if (!fft)
+		return;
+
+	g_free(fft->rev);
+	g_free(fft->tw_re);
+	g_free(fft->tw_im);
+	g_free(fft->post_re);
+	g_free(fft->post_im);
+	g_free(fft);
+}
+
+gint eq_conv_fft_size(const EqConvFft *fft)
+{
+	return fft->size;
+}
+
+/* In place radix-2 complex FFT of bit reversed input */
+static void _fft_core(const EqConvFft *fft, gfloat *re, gfloat *im)
+{
+	const gint n = fft->half;
+	gint h, i, j, a, b;
+
+	for (h = 1; h < n; h <<= 1) {
+		const gfloat *wr = fft->tw_re + h - 1;
+		const gfloat *wi = fft->tw_im + h - 1;
+
+		for (i = 0; i < n; i += 2 * h) {
+			j = 0;
+#if EQ_CONV_LANES > 1
+			for (; j + EQ_CONV_LANES <= h; j += EQ_CONV_LANES) {
+				eq_conv_vec ar, ai, br, bi, vr, vi, tr, ti;
+
+				a = i + j;
+				b = a + h;
+				ar = _vec_load(re + a);
+				ai = _vec_load(im + a);
+				br = _vec_load(re + b);
+				bi = _vec_load(im + b);
+				vr = _vec_load(wr + j);
+				vi = _vec_load(wi + j);
+				tr = _vec_sub(_vec_mul(br, vr), _vec_mul(bi, vi));
+				ti = _vec_add(_vec_mul(br, vi), _vec_mul(bi, vr));
+				_vec_store(re + b, _vec_sub(ar, tr));
+				_vec_store(im + b, _vec_sub(ai, ti));
+				_vec_store(re + a, _vec_add(ar, tr));
+				_vec_store(im + a, _vec_add(ai, ti));
+			}
+#endif
+			for (; j < h; j++) {
+				gfloat tr, ti;
+
+				a = i + j;
+				b = a + h;
+				tr = re[b] * wr[j] - im[b] * wi[j];
+				ti = re[b] * wi[j] + im[b] * wr[j];
+				re[b] = re[a] - tr;
+				im[b] = im[a] - ti;
+				re[a] += tr;
+				im[a] += ti;
+			}
+		}
+	}
+}
+
+/*
+ * Forward transform of the @size real samples of @in into the size / 2 + 1
+ * bins of @re and @im.
+ */
+void eq_conv_fft_forward(const EqConvFft *fft, const gfloat *in,
+			 gfloat *re, gfloat *im)
+{
+	const gint m = fft->half;
+	gint k, j;
+
+	/* Even samples as real part, odd ones as imaginary part */
+	for (k = 0; k < m; k++) {
+		re[fft->rev[k]] = in[2 * k];
+		im[fft->rev[k]] = in[2 * k + 1];
+	}
+
+	_fft_core(fft, re, im);
+
+	/* Split the spectra of even and odd samples and merge them */
+	for (k = 1; k < m / 2; k++) {
+		gdouble er, ei, or, oi, tr, ti;
+
+		j = m - k;
+		er = 0.5 * (re[k] + re[j]);
+		ei = 0.5 * (im[k] - im[j]);
+		or = 0.5 * (im[k] + im[j]);
+		oi = -0.5 * (re[k] - re[j]);
+		tr = fft->post_re[k] * or - fft->post_im[k] * oi;
+		ti = fft->post_re[k] * oi + fft->post_im[k] * or;
+		re[k] = er + tr;
+		im[k] = ei + ti;
+		re[j] = er - tr;
+		im[j] = -(ei - ti);
+	}
+
+	im[m / 2] = -im[m / 2];
+	re[m] = re[0] - im[0];
+	im[m] = 0.0f;
+	re[0] = re[0] + im[0];
+	im[0] = 0.0f;
+}
+
+/*
+ * Inverse transform of the size / 2 + 1 bins of @re and @im, which are
+ * overwritten, into @size real samples.  It is not normalized: the output
+ * is size / 2 times the signal.
+ */
+void eq_conv_fft_inverse(const EqConvFft *fft, gfloat *re, gfloat *im,
+			 gfloat *out)
+{
+	const gint m = fft->half;
+	gint k, j;
+	gfloat t;
+
+	/* Rebuild the spectrum of even samples plus i times the one of odd
+	 * samples */
+	for (k = 1; k < m / 2; k++) {
+		gdouble er, ei, dr, di, or, oi;
+
+		j = m - k;
+		er = 0.5 * (re[k] + re[j]);
+		ei = 0.5 * (im[k] - im[j]);
+		dr = 0.5 * (re[k] - re[j]);
+		di = 0.5 * (im[k] + im[j]);
+		/* times exp(2 pi i k / N) */
+		or = dr * fft->post_re[k] + di * fft->post_im[k];
+		oi = di * fft->post_re[k] - dr * fft->post_im[k];
+		re[k] = er - oi;
+		im[k] = ei + or;
+		re[j] = er + oi;
+		im[j] = -(ei - or);
+	}
+
+	t = re[0];
+	re[0] = 0.5f * (t + re[m]);
+	im[0] = 0.5f * (t - re[m]);
+	im[m / 2] = -im[m / 2];
+
+	/* Bit reversal in place */
+	for (k = 0; k < m; k++) {
+		j = fft->rev[k];
+		if (k < j) {
+			t = re[k]; re[k] = re[j]; re[j] = t;
+			t = im[k]; im[k] = im[j]; im[j] = t;
+		}
+	}
+
+	/* Swapping real and imaginary parts, on the way in and on the way
+	 * out, turns the forward transform into the inverse one */
+	_fft_core(fft, im, re);
+
+	for (k = 0; k < m; k++) {
+		out[2 * k] = re[k];
+		out[2 * k + 1] = im[k];
+	}
+}
+
+/*----------------------------------------------------------------------------
+  Filters
+  ----------------------------------------------------------------------------*/
+
+/*
+ * Builds the partition spectra of the @n_channels impulse responses of
+ * @taps taps in @ir, one after the other.  The spectra are scaled so that
+ * eq_conv_process() needs no normalization.
+ */
+EqConvFilter *eq_conv_filter_new(const gfloat *ir, gint taps,
+				 gint n_channels, gint block)
+{
+	EqConvFilter *filter;
+	EqConvFft *fft;
+	gfloat *time, *re, *im;
+	gfloat scale;
+	gint c, p, n, i;
+
+	g_return_val_if_fail(ir != NULL && taps > 0 && n_channels > 0, NULL);
+	g_return_val_if_fail(block >= EQ_CONV_MIN_BLOCK &&
+			     block <= EQ_CONV_MAX_BLOCK &&
+			     (block & (block - 1)) == 0, NULL);
+
+	filter = g_new0(EqConvFilter, 1);
+	filter->block = block;
+	filter->bins = block + 1;
+	filter->n_partitions = (taps + block - 1) / block;
+	filter->n_channels = n_channels;
+	filter->re = g_new(gfloat, n_channels * filter->n_partitions *
+			   filter->bins);
+	filter->im = g_new(gfloat, n_channels * filter->n_partitions *
+			   filter->bins);
+
+	fft = eq_conv_fft_new(2 * block);
+	time = g_new0(gfloat, 2 * block);
+	scale = 1.0f / block;
+
+	for (c = 0; c < n_channels; c++) {
+		for (p = 0; p < filter->n_partitions; p++) {
+			n = MIN(block, taps - p * block);
+			for (i = 0; i < n; i++)
+				time[i] = ir[c * taps + p * block + i] * scale;
+			for (; i < 2 * block; i++)
+				time[i] = 0.0f;
+
+			i = (c * filter->n_partitions + p) * filter->bins;
+			re = filter->re + i;
+			im = filter->im + i;
+			eq_conv_fft_forward(fft, time, re, im);
+		}
+	}
+
+	g_free(time);
+	eq_conv_fft_free(fft);
+
+	return filter;
+}
+
+void eq_conv_filter_free(EqConvFilter *filter)
+{
+	if (!filter)
+		return;
+
+	g_free(filter->re);
+	g_free(filter->im);
+	g_free(filter);
+}
+
+/*----------------------------------------------------------------------------
+  Streaming
+  ----------------------------------------------------------------------------*/
+
+/* Can run filters of up to @max_partitions partitions of @block frames on
+ * @channels channels */
+EqConv *eq_conv_new(gint block, gint channels, gint max_partitions)
+{
+	EqConv *conv;
+
+	g_return_val_if_fail(block >= EQ_CONV_MIN_BLOCK &&
+			     block <= EQ_CONV_MAX_BLOCK &&
+			     (block & (block - 1)) == 0, NULL);
+	g_return_val_if_fail(channels > 0 && max_partitions > 0, NULL);
+
+	conv = g_new0(EqConv, 1);
+	conv->block = block;
+	conv->bins = block + 1;
+	conv->channels = channels;
+	conv->max_partitions = max_partitions;
+	conv->fft = eq_conv_fft_new(2 * block);
+
+	conv->input = g_new(gfloat, channels * 2 * block);
+	conv->output = g_new(gfloat, channels * block);
+	conv->fdl_re = g_new(gfloat, channels * max_partitions * conv->bins);
+	conv->fdl_im = g_new(gfloat, channels * max_partitions * conv->bins);
+	conv->acc_re = g_new(gfloat, conv->bins);
+	conv->acc_im = g_new(gfloat, conv->bins);
+	conv->scratch = g_new(gfloat, 2 * block);
+
+	eq_conv_reset(conv);
+
+	return conv;
+}
+
+void eq_conv_free(EqConv *conv)
+{
+	if (!conv)
+		return;
+
+	eq_conv_fft_free(conv->fft);
+	g_free(conv->input);
+	g_free(conv->output);
+	g_free(conv->fdl_re);
+	g_free(conv->fdl_im);
+	g_free(conv->acc_re);
+	g_free(conv->acc_im);
+	g_free(conv->scratch);
+	g_free(conv);
+}
+
+/* Clears the history, as if silence had been played for ever */
+void eq_conv_reset(EqConv *conv)
+{
+	gsize fdl = conv->channels * conv->max_partitions * conv->bins;
+
+	memset(conv->input, 0, conv->channels * 2 * conv->block *
+	       sizeof(gfloat));
+	memset(conv->output, 0, conv->channels * conv->block *
+	       sizeof(gfloat));
+	memset(conv->fdl_re, 0, fdl * sizeof(gfloat));
+	memset(conv->fdl_im, 0, fdl * sizeof(gfloat));
+	conv->head = 0;
+}
+
+/* acc += x * h, over @n complex bins */
+static void _cmac(gfloat *acc_re, gfloat *acc_im,
+		  const gfloat *x_re, const gfloat *x_im,
+		  const gfloat *h_re, const gfloat *h_im, gint n)
+{
+	gint i = 0;
+
+#if EQ_CONV_LANES > 1
+	for (; i + EQ_CONV_LANES <= n; i += EQ_CONV_LANES) {
+		eq_conv_vec xr, xi, hr, hi;
+
+		xr = _vec_load(x_re + i);
+		xi = _vec_load(x_im + i);
+		hr = _vec_load(h_re + i);
+		hi = _vec_load(h_im + i);
+		_vec_store(acc_re + i,
+			   _vec_add(_vec_load(acc_re + i),
+				    _vec_sub(_vec_mul(xr, hr),
+					     _vec_mul(xi, hi))));
+		_vec_store(acc_im + i,
+			   _vec_add(_vec_load(acc_im + i),
+				    _vec_add(_vec_mul(xr, hi),
+					     _vec_mul(xi, hr))));
+	}
+#endif
+	for (; i < n; i++) {
+		acc_re[i] += x_re[i] * h_re[i] - x_im[i] * h_im[i];
+		acc_im[i] += x_re[i] * h_im[i] + x_im[i] * h_re[i];
+	}
+}
+
+/* Runs the delay line of @channel through @filter into conv->scratch;
+ * the new block of output is in its second half */
+static void _convolve(EqConv *conv, const EqConvFilter *filter,
+		      gint channel)
+{
+	const gint bins = conv->bins;
+	const gfloat *fdl_re, *fdl_im, *h_re, *h_im;
+	gint p, slot, n_partitions, hc;
+
+	memset(conv->acc_re, 0, bins * sizeof(gfloat));
+	memset(conv->acc_im, 0, bins * sizeof(gfloat));
+
+	hc = channel % filter->n_channels;
+	n_partitions = MIN(filter->n_partitions, conv->max_partitions);
+	fdl_re = conv->fdl_re + channel * conv->max_partitions * bins;
+	fdl_im = conv->fdl_im + channel * conv->max_partitions * bins;
+	h_re = filter->re + hc * filter->n_partitions * bins;
+	h_im = filter->im + hc * filter->n_partitions * bins;
+
+	for (p = 0; p < n_partitions; p++) {
+		slot = conv->head - p;
+		if (slot < 0)
+			slot += conv->max_partitions;
+		_cmac(conv->acc_re, conv->acc_im,
+		      fdl_re + slot * bins, fdl_im + slot * bins,
+		      h_re + p * bins, h_im + p * bins, bins);
+	}
+
+	eq_conv_fft_inverse(conv->fft, conv->acc_re, conv->acc_im,
+			    conv->scratch);
+}
+
+/*
+ * Consumes the block of input in the second half of conv->input and
+ * leaves a new block of output in conv->output.  If @fade_from is not
+ * NULL the output fades linearly from what it would give to what @filter
+ * gives over the block, which makes filter swaps click free; both filters
+ * share the same delay line.  @filter and @fade_from must have the block
+ * size of @conv.
+ */
+void eq_conv_process(EqConv *conv, const EqConvFilter *filter,
+		     const EqConvFilter *fade_from)
+{
+	const gint block = conv->block;
+	gfloat *input, *output;
+	gint c, i, slot;
+	gfloat w;
+
+	g_return_if_fail(filter->block == block);
+	g_return_if_fail(fade_from == NULL || fade_from->block == block);
+
+	conv->head = (conv->head + 1) % conv->max_partitions;
+
+	for (c = 0; c < conv->channels; c++) {
+		input = conv->input + c * 2 * block;
+		output = conv->output + c * block;
+		slot = (c * conv->max_partitions + conv->head) * conv->bins;
+
+		eq_conv_fft_forward(conv->fft, input, conv->fdl_re + slot,
+				    conv->fdl_im + slot);
+
+		if (fade_from) {
+			_convolve(conv, fade_from, c);
+			memcpy(output, conv->scratch + block,
+			       block * sizeof(gfloat));
+			_convolve(conv, filter, c);
+			for (i = 0; i < block; i++) {
+				w = (gfloat) i / block;
+				output[i] += w * (conv->scratch[block + i] -
+						  output[i]);
+			}
+		} else {
+			_convolve(conv, filter, c);
+			memcpy(output, conv->scratch + block,
+			       block * sizeof(gfloat));
+		}
+
+		/* Slide the window by one block */
+		memcpy(input, input + block, block * sizeof(gfloat));
+	}
+}
+
+/*----------------------------------------------------------------------------
+  Impulse responses
+  ----------------------------------------------------------------------------*/
+
+/*
+ * Designs a linear phase FIR of @taps taps with the magnitude response of
+ * the IIR equalizer for @layout and @gains, by frequency sampling and a
+ * Blackman window.  The filter delays the signal by @taps / 2 frames; its
+ * resolution at low frequencies is about 3 * @rate / @taps Hz.  With
+ * @preamp, the response is scaled down so that its peak is unity, as the
+ * IIR equalizer does.  Returns a newly allocated array.
+ */
+gfloat *eq_conv_design_linear_phase(const EqDspLayout *layout,
+				    const gdouble *gains, gint rate,
+				    gint taps, gboolean preamp)
+{
+	EqDspBiquad bq[EQ_DSP_MAX_BANDS];
+	EqConvFft *fft;
+	gfloat *re, *im, *time, *ir;
+	gint size, k, n, delay;
+	gdouble x, scale, peak = 1.0;
+
+	g_return_val_if_fail(taps > 0 && taps <= EQ_CONV_MAX_TAPS, NULL);
+
+	for (size = 256; size < 2 * taps; size <<= 1);
+
+	eq_dsp_design_layout(bq, layout, gains, rate);
+	if (preamp)
+		peak = eq_dsp_peak_gain(bq, layout->n_bands, rate);
+
+	fft = eq_conv_fft_new(size);
+	re = g_new(gfloat, size / 2 + 1);
+	im = g_new0(gfloat, size / 2 + 1);
+	time = g_new(gfloat, size);
+
+	/* Zero phase spectrum */
+	for (k = 0; k <= size / 2; k++)
+		re[k] = eq_dsp_magnitude(bq, layout->n_bands,
+					 2.0 * G_PI * k / size) / peak;
+
+	eq_conv_fft_inverse(fft, re, im, time);
+
+	ir = g_new(gfloat, taps);
+	delay = taps / 2;
+	scale = 2.0 / size;
+	for (n = 0; n < taps; n++) {
+		x = G_PI * (n - delay) / MAX(delay, 1);
+		ir[n] = time[(n - delay + size) % size] * scale *
+			(0.42 + 0.5 * cos(x) + 0.08 * cos(2.0 * x));
+	}
+
+	g_free(re);
+	g_free(im);
+	g_free(time);
+	eq_conv_fft_free(fft);
+
+	return ir;
+}
+
+static guint32 _read_le32(const guint8 *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((guint32) p[3] << 24);
+}
+
+static guint16 _read_le16(const guint8 *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+/* Sample @i of the PCM or IEEE float data @p as a float */
+static gfloat _read_sample(const guint8 *p, gint i, gint bits,
+			   gboolean is_float)
+{
+	guint32 u;
+	gfloat f;
+
+	switch (bits) {
+	case 16:
+		return (gint16) _read_le16(p + 2 * i) / 32768.0f;
+	case 24:
+		p += 3 * i;
+		u = (p[0] << 8) | (p[1] << 16) | ((guint32) p[2] << 24);
+		return (gint32) u / 2147483648.0f;
+	default:
+		u = _read_le32(p + 4 * i);
+		if (is_float) {
+			memcpy(&f, &u, sizeof(f));
+			return f;
+		}
+		return (gint32) u / 2147483648.0f;
+	}
+}
+
+/*
+ * Loads the impulse response in the WAV file @filename (16, 24 or 32 bit
+ * PCM, or 32 bit float; one or more channels) and returns it planar, at
+ * @rate.  A response recorded at another rate is resampled by linear
+ * interpolation, which is fine for the smooth responses of headphone or
+ * room correction.  Responses longer than EQ_CONV_MAX_TAPS are cut.
+ * Returns NULL, with a warning, if the file cannot be used.
+ */
+gfloat *eq_conv_load_wav(const gchar *filename, gint rate, gint *taps,
+			 gint *n_channels)
+{
+	GError *error = NULL;
+	gchar *contents;
+	gsize length, pos, size;
+	const guint8 *p, *data = NULL;
+	guint16 format = 0;
+	gint channels = 0, file_rate = 0, bits = 0;
+	gsize data_len = 0;
+	gint frames, out_frames, c, n, i;
+	gdouble ratio, t, frac;
+	gfloat *ir = NULL;
+
+	if (!g_file_get_contents(filename, &contents, &length, &error)) {
+		g_warning("Cannot read impulse response %s: %s", filename,
+			  error->message);
+		g_error_free(error);
+		return NULL;
+	}
+
+	p = (const guint8 *) contents;
+	if (length < 12 || memcmp(p, "RIFF", 4) != 0 ||
+	    memcmp(p + 8, "WAVE", 4) != 0) {
+		g_warning("%s is not a WAV file", filename);
+		goto out;
+	}
+
+	for (pos = 12; pos + 8 <= length; pos += 8 + size + (size & 1)) {
+		size = _read_le32(p + pos + 4);
+		if (size > length - pos - 8)
+			size = length - pos - 8;
+		if (memcmp(p + pos, "fmt ", 4) == 0 && size >= 16) {
+			format = _read_le16(p + pos + 8);
+			channels = _read_le16(p + pos + 10);
+			file_rate = _read_le32(p + pos + 12);
+			bits = _read_le16(p + pos + 22);
+			/* WAVE_FORMAT_EXTENSIBLE: the format is the start of
+			 * the subformat GUID */
+			if (format == 0xfffe && size >= 26)
+				format = _read_le16(p + pos + 32);
+		} else if (memcmp(p + pos, "data", 4) == 0) {
+			data = p + pos + 8;
+			data_len = size;
+		}
+	}
+
+	if (!data || channels <= 0 || channels > EQ_DSP_MAX_CHANNELS ||
+	    file_rate <= 0 ||
+	    !((format == 1 && (bits == 16 || bits == 24 || bits == 32)) ||
+	      (format == 3 && bits == 32))) {
+		g_warning("Unsupported impulse response %s", filename);
+		goto out;
+	}
+
+	frames = data_len / (channels * bits / 8);
+	if (frames == 0) {
+		g_warning("Impulse response %s is empty", filename);
+		goto out;
+	}
+
+	ratio = (gdouble) file_rate / rate;
+	out_frames = (gint) ceil(frames / ratio);
+	if (out_frames > EQ_CONV_MAX_TAPS) {
+		g_warning("Impulse response %s cut to %d taps", filename,
+			  EQ_CONV_MAX_TAPS);
+		out_frames = EQ_CONV_MAX_TAPS;
+	}
+
+	ir = g_new(gfloat, channels * out_frames);
+	for (c = 0; c < channels; c++) {
+		for (n = 0; n < out_frames; n++) {
+			t = n * ratio;
+			i = (gint) t;
+			frac = t - i;
+			/* Resampling scales the gain by the rate ratio */
+			ir[c * out_frames + n] = ratio *
+				((1.0 - frac) *
+				 _read_sample(data, i * channels + c, bits,
+					      format == 3) +
+				 (i + 1 < frames ?
+				  frac * _read_sample(data,
+						      (i + 1) * channels + c,
+						      bits, format == 3) :
+				  0.0));
+		}
+	}
+
+	*taps = out_frames;
+	*n_channels = channels;
+
+out:
+	g_free(contents);
+	return ir;
+}
+
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
@@ -0,0 +1,114 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef MAFW_GST_RENDERER_CONVOLVER_DSP_H
+#define MAFW_GST_RENDERER_CONVOLVER_DSP_H
+
+#include <glib.h>
+
+#include "mafw-gst-renderer-equalizer-dsp.h"
+
+G_BEGIN_DECLS
+
+/* Range of the partition length, in frames.  The convolution delays the
+ * signal by one partition */
+#define EQ_CONV_MIN_BLOCK 64
+#define EQ_CONV_MAX_BLOCK 4096
+
+/* Longest impulse response, in taps */
+#define EQ_CONV_MAX_TAPS 32768
+
+/* Real FFT plan.  Plans are immutable once created, but the transforms
+ * work in place on the caller's buffers, so a plan can be shared by
+ * several threads */
+typedef struct _EqConvFft EqConvFft;
+
+/* Impulse response cut in partitions of one block, kept as spectra.  It is
+ * read only once built, so it can be swapped under a running EqConv */
+typedef struct {
+	gint block;
+	gint bins;
+	gint n_partitions;
+	gint n_channels;
+	gfloat *re;
+	gfloat *im;
+} EqConvFilter;
+
+/* Streaming state of a uniformly partitioned overlap-save convolution.
+ *
+ * input:          Last two blocks of input of each channel; the caller
+ *                 writes the new block in the second half.
+ * output:         Last block of output of each channel.
+ * fdl_re, fdl_im: Frequency domain delay line: the spectra of the last
+ *                 max_partitions input blocks of each channel.  It does not
+ *                 depend on the filter, so filters can be swapped without
+ *                 losing the history.
+ * head:           Slot of the delay line holding the newest spectrum.
+ */
+typedef struct {
+	gint block;
+	gint bins;
+	gint channels;
+	gint max_partitions;
+	EqConvFft *fft;
+
+	gfloat *input;
+	gfloat *output;
+	gfloat *fdl_re;
+	gfloat *fdl_im;
+	gint head;
+
+	gfloat *acc_re;
+	gfloat *acc_im;
+	gfloat *scratch;
+} EqConv;
+
+EqConvFft *eq_conv_fft_new(gint size);
+void eq_conv_fft_free(EqConvFft *fft);
+gint eq_conv_fft_size(const EqConvFft *fft);
+void eq_conv_fft_forward(const EqConvFft *fft, const gfloat *in,
+			 gfloat *re, gfloat *im);
+void eq_conv_fft_inverse(const EqConvFft *fft, gfloat *re, gfloat *im,
+			 gfloat *out);
+
+EqConvFilter *eq_conv_filter_new(const gfloat *ir, gint taps,
+				 gint n_channels, gint block);
+void eq_conv_filter_free(EqConvFilter *filter);
+
+EqConv *eq_conv_new(gint block, gint channels, gint max_partitions);
+void eq_conv_free(EqConv *conv);
+void eq_conv_reset(EqConv *conv);
+void eq_conv_process(EqConv *conv, const EqConvFilter *filter,
+		     const EqConvFilter *fade_from);
+
+gfloat *eq_conv_design_linear_phase(const EqDspLayout *layout,
+				    const gdouble *gains, gint rate,
+				    gint taps, gboolean preamp);
+gfloat *eq_conv_load_wav(const gchar *filename, gint rate, gint *taps,
+			 gint *n_channels);
+
+G_END_DECLS
+
+#endif
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
@@ -0,0 +1,744 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * FFT convolution stage for the renderer audio bin, run after the IIR
+ * equalizer.  It applies either a linear phase version of the equalizer
+ * curve or a measured impulse response loaded from a WAV file (e.g. for
+ * headphone correction), using the uniformly partitioned convolution of
+ * mafw-gst-renderer-convolver-dsp.c.
+ *
+ * The signal is delayed by block-size frames, plus half the filter length
+ * in the linear phase mode.  When the mode is off the element is in
+ * passthrough and costs nothing; switching it on or off, or changing the
+ * filter, crossfades over one block.
+ *
+ * Once the silence fed in (GAP flagged or all zero buffers) is longer than
+ * the filter, its whole state is known to be silent, so it is cleared once
+ * and the following silent buffers go out untouched.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "mafw-gst-renderer-convolver.h"
+#include "mafw-gst-renderer-eq-layout.h"
+
+#undef  G_LOG_DOMAIN
+#define G_LOG_DOMAIN "mafw-gst-renderer-convolver"
+
+GST_DEBUG_CATEGORY_STATIC(convolver_debug);
+#define GST_CAT_DEFAULT convolver_debug
+
+#define ALLOWED_CAPS							\
+	"audio/x-raw-int, "						\
+	"depth = (int) 16, "						\
+	"width = (int) 16, "						\
+	"endianness = (int) BYTE_ORDER, "				\
+	"signed = (boolean) TRUE, "					\
+	"rate = (int) [ 1, MAX ], "					\
+	"channels = (int) [ 1, 8 ]; "					\
+	"audio/x-raw-float, "						\
+	"width = (int) 32, "						\
+	"endianness = (int) BYTE_ORDER, "				\
+	"rate = (int) [ 1, MAX ], "					\
+	"channels = (int) [ 1, 8 ]"
+
+#define DEFAULT_TAPS		8192
+#define MIN_TAPS		256
+#define DEFAULT_BLOCK_SIZE	256
+
+enum {
+	PROP_0,
+	PROP_MODE,
+	PROP_IR_FILE,
+	PROP_TAPS,
+	PROP_BLOCK_SIZE,
+	PROP_AUTO_PREAMP,
+	PROP_BLOCKS_PROCESSED,
+	PROP_BUFFERS_SKIPPED,
+};
+
+GST_BOILERPLATE(MafwGstRendererConvolver, mafw_gst_renderer_convolver,
+		GstAudioFilter, GST_TYPE_AUDIO_FILTER);
+
+GType mafw_gst_renderer_convolver_mode_get_type(void)
+{
+	static GType type = 0;
+	static const GEnumValue values[] = {
+		{ MAFW_GST_RENDERER_CONVOLVER_OFF, "Off", "off" },
+		{ MAFW_GST_RENDERER_CONVOLVER_LINEAR_PHASE,
+		  "Linear phase equalizer", "linear-phase" },
+		{ MAFW_GST_RENDERER_CONVOLVER_IMPULSE_RESPONSE,
+		  "Impulse response from a WAV file", "impulse-response" },
+		{ 0, NULL, NULL }
+	};
+
+	if (G_UNLIKELY(type == 0)) {
+		type = g_enum_register_static("MafwGstRendererConvolverMode",
+					      values);
+	}
+	return type;
+}
+
+/*----------------------------------------------------------------------------
+  Filter building
+  ----------------------------------------------------------------------------*/
+
+/*
+ * Builds the filter for the current settings and hands it to the streaming
+ * thread.  It can take a few milliseconds for long filters, so it runs in
+ * the thread changing the settings, without the object lock.
+ */
+static void _build(MafwGstRendererConvolver *conv)
+{
+	MafwGstRendererConvolverMode mode;
+	EqDspLayout layout;
+	gdouble gains[EQ_DSP_MAX_BANDS];
+	EqConvFilter *filter = NULL;
+	gfloat *ir = NULL;
+	gchar *ir_file;
+	gint taps, block, rate, n_channels = 1;
+	gboolean preamp;
+	guint seq;
+
+	GST_OBJECT_LOCK(conv);
+	seq = ++conv->build_seq;
+	mode = conv->mode;
+	layout = conv->layout;
+	memcpy(gains, conv->gains, sizeof(gains));
+	ir_file = g_strdup(conv->ir_file);
+	taps = conv->taps;
+	block = conv->block;
+	rate = conv->rate;
+	preamp = conv->auto_preamp;
+	GST_OBJECT_UNLOCK(conv);
+
+	if (rate > 0) {
+		switch (mode) {
+		case MAFW_GST_RENDERER_CONVOLVER_LINEAR_PHASE:
+			ir = eq_conv_design_linear_phase(&layout, gains, rate,
+							 taps, preamp);
+			break;
+		case MAFW_GST_RENDERER_CONVOLVER_IMPULSE_RESPONSE:
+			if (ir_file) {
+				ir = eq_conv_load_wav(ir_file, rate, &taps,
+						      &n_channels);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (ir) {
+		filter = eq_conv_filter_new(ir, taps, n_channels, block);
+		GST_DEBUG_OBJECT(conv, "built filter of %d taps, %d channels, "
+				 "%d partitions", taps, n_channels,
+				 filter->n_partitions);
+	}
+	g_free(ir);
+	g_free(ir_file);
+
+	GST_OBJECT_LOCK(conv);
+	if (seq == conv->build_seq) {
+		eq_conv_filter_free(conv->pending);
+		eq_conv_filter_free(conv->retired);
+		conv->retired = NULL;
+		conv->pending = filter;
+		g_atomic_int_set(&conv->filter_changed, 1);
+	} else {
+		/* A newer build has already run */
+		eq_conv_filter_free(filter);
+	}
+	GST_OBJECT_UNLOCK(conv);
+}
+
+/*----------------------------------------------------------------------------
+  Processing
+  ----------------------------------------------------------------------------*/
+
+/* Starts running @filter, NULL to switch the convolution off */
+static void _switch_filter(MafwGstRendererConvolver *conv,
+			   EqConvFilter *filter)
+{
+	if (filter == NULL) {
+		if (conv->current) {
+			GST_DEBUG_OBJECT(conv, "switching off");
+			conv->mix_dir = -1;
+		}
+	} else if (conv->current == NULL) {
+		GST_DEBUG_OBJECT(conv, "switching on");
+		conv->current = filter;
+		eq_conv_reset(conv->conv);
+		conv->pos = 0;
+		conv->silent_frames = 0;
+		conv->quiet = FALSE;
+		/* Stay dry while the first block goes through */
+		conv->mix_pos = -conv->conv->block;
+		conv->mix_dir = 1;
+		gst_base_transform_set_passthrough(GST_BASE_TRANSFORM(conv),
+						   FALSE);
+	} else {
+		conv->fade_from = conv->current;
+		conv->current = filter;
+		conv->mix_dir = 1;
+	}
+}
+
+/* Picks a new filter if there is one and the lock is free */
+static void _pick_filter(MafwGstRendererConvolver *conv)
+{
+	EqConvFilter *filter;
+
+	if (conv->to_retire == NULL &&
+	    !g_atomic_int_get(&conv->filter_changed))
+		return;
+
+	if (!GST_OBJECT_TRYLOCK(conv))
+		return;
+
+	if (conv->to_retire && conv->retired == NULL) {
+		conv->retired = conv->to_retire;
+		conv->to_retire = NULL;
+	}
+
+	if (conv->to_retire == NULL &&
+	    g_atomic_int_get(&conv->filter_changed)) {
+		filter = conv->pending;
+		conv->pending = NULL;
+		g_atomic_int_set(&conv->filter_changed, 0);
+		GST_OBJECT_UNLOCK(conv);
+		_switch_filter(conv, filter);
+		return;
+	}
+
+	GST_OBJECT_UNLOCK(conv);
+}
+
+/* Runs the block just buffered */
+static void _end_block(MafwGstRendererConvolver *conv)
+{
+	conv->pos = 0;
+
+	_pick_filter(conv);
+	eq_conv_process(conv->conv, conv->current, conv->fade_from);
+	g_atomic_int_inc(&conv->blocks_processed);
+
+	if (conv->fade_from) {
+		conv->to_retire = conv->fade_from;
+		conv->fade_from = NULL;
+	}
+
+	if (conv->mix_dir < 0 && conv->mix_pos <= 0 &&
+	    conv->to_retire == NULL) {
+		GST_DEBUG_OBJECT(conv, "switched off");
+		conv->to_retire = conv->current;
+		conv->current = NULL;
+		gst_base_transform_set_passthrough(GST_BASE_TRANSFORM(conv),
+						   TRUE);
+	}
+}
+
+/*
+ * Feeds @frames frames of @data to the convolution and replaces them with
+ * its output, mixed with the dry signal while switching on or off.
+ */
+static void _process(MafwGstRendererConvolver *conv, guint8 *data,
+		     guint frames)
+{
+	EqConv *c = conv->conv;
+	const gint block = c->block, channels = c->channels;
+	gint16 *s16 = (gint16 *) data;
+	gfloat *f32 = (gfloat *) data;
+	gfloat x, y, wet;
+	gint i, ch, n, j = 0;
+
+	while (frames > 0 && conv->current) {
+		n = MIN(frames, block - conv->pos);
+
+		for (i = conv->pos; i < conv->pos + n; i++) {
+			wet = CLAMP(conv->mix_pos, 0, block) / (gfloat) block;
+			for (ch = 0; ch < channels; ch++, j++) {
+				x = conv->is_s16 ? s16[j] / 32768.0f : f32[j];
+				c->input[ch * 2 * block + block + i] = x;
+				y = c->output[ch * block + i];
+				y = x + wet * (y - x);
+				if (conv->is_s16) {
+					s16[j] = CLAMP(lrintf(y * 32768.0f),
+						       G_MININT16,
+						       G_MAXINT16);
+				} else {
+					f32[j] = y;
+				}
+			}
+			conv->mix_pos = CLAMP(conv->mix_pos + conv->mix_dir,
+					      -block, block);
+		}
+
+		conv->pos += n;
+		frames -= n;
+		if (conv->pos == block)
+			_end_block(conv);
+	}
+}
+
+/* Frees the filters owned by the streaming thread and goes to
+ * passthrough */
+static void _drop_filters(MafwGstRendererConvolver *conv)
+{
+	eq_conv_filter_free(conv->current);
+	eq_conv_filter_free(conv->fade_from);
+	eq_conv_filter_free(conv->to_retire);
+	conv->current = NULL;
+	conv->fade_from = NULL;
+	conv->to_retire = NULL;
+	conv->mix_pos = 0;
+	conv->mix_dir = 1;
+	gst_base_transform_set_passthrough(GST_BASE_TRANSFORM(conv), TRUE);
+}
+
+static gboolean _setup(GstAudioFilter *filter, GstRingBufferSpec *fmt)
+{
+	MafwGstRendererConvolver *conv = MAFW_GST_RENDERER_CONVOLVER(filter);
+	gboolean rebuild;
+	gint block;
+
+	if (fmt->type == GST_BUFTYPE_LINEAR && fmt->width == 16) {
+		conv->is_s16 = TRUE;
+	} else if (fmt->type == GST_BUFTYPE_FLOAT && fmt->width == 32) {
+		conv->is_s16 = FALSE;
+	} else {
+		return FALSE;
+	}
+
+	GST_OBJECT_LOCK(conv);
+	block = conv->block_size;
+	rebuild = conv->rate != fmt->rate || conv->block != block;
+	conv->rate = fmt->rate;
+	conv->channels = fmt->channels;
+	conv->block = block;
+	GST_OBJECT_UNLOCK(conv);
+
+	/* Negotiation is the one place where the streaming thread allocates;
+	 * filters of the old block size or rate are of no use anymore */
+	if (!conv->conv || conv->conv->block != block ||
+	    conv->conv->channels != fmt->channels) {
+		_drop_filters(conv);
+		eq_conv_free(conv->conv);
+		conv->conv = eq_conv_new(block, fmt->channels,
+					 EQ_CONV_MAX_TAPS / block);
+	}
+	if (rebuild) {
+		_drop_filters(conv);
+		_build(conv);
+	}
+
+	eq_conv_reset(conv->conv);
+	conv->pos = 0;
+	conv->silent_frames = 0;
+	conv->quiet = FALSE;
+
+	return TRUE;
+}
+
+static gboolean _is_silent(MafwGstRendererConvolver *conv, GstBuffer *buf)
+{
+	if (GST_BUFFER_FLAG_IS_SET(buf, GST_BUFFER_FLAG_GAP))
+		return TRUE;
+
+	if (conv->is_s16) {
+		return eq_dsp_is_silent_s16((gint16 *) GST_BUFFER_DATA(buf),
+					    GST_BUFFER_SIZE(buf) / 2);
+	} else {
+		return eq_dsp_is_silent_float((gfloat *) GST_BUFFER_DATA(buf),
+					      GST_BUFFER_SIZE(buf) / 4);
+	}
+}
+
+/*
+ * Whether a silent buffer can go out untouched: the silence fed in must
+ * cover the whole filter plus the block being buffered and the one being
+ * output, and no crossfade may be running.
+ */
+static gboolean _can_skip(MafwGstRendererConvolver *conv)
+{
+	const gint block = conv->conv->block;
+
+	if (conv->fade_from || conv->mix_dir < 0 || conv->mix_pos < block)
+		return FALSE;
+
+	return conv->quiet || conv->silent_frames >=
+		(conv->current->n_partitions + 2) * block;
+}
+
+static GstFlowReturn _transform_ip(GstBaseTransform *base, GstBuffer *buf)
+{
+	MafwGstRendererConvolver *conv = MAFW_GST_RENDERER_CONVOLVER(base);
+	guint frame_size, frames;
+
+	if (G_UNLIKELY(conv->conv == NULL))
+		return GST_FLOW_NOT_NEGOTIATED;
+
+	if (conv->current == NULL) {
+		/* In passthrough the buffer may not be writable, so it goes
+		 * out untouched and the convolution starts with the next
+		 * one */
+		_pick_filter(conv);
+		return GST_FLOW_OK;
+	}
+
+	frame_size = conv->conv->channels * (conv->is_s16 ? 2 : 4);
+	frames = GST_BUFFER_SIZE(buf) / frame_size;
+
+	if (!_is_silent(conv, buf)) {
+		conv->silent_frames = 0;
+		conv->quiet = FALSE;
+	} else if (_can_skip(conv)) {
+		if (!conv->quiet) {
+			/* The delay line slots past the filter may still
+			 * hold older sound; a longer filter must not pick
+			 * it up */
+			eq_conv_reset(conv->conv);
+			conv->quiet = TRUE;
+		}
+		g_atomic_int_inc(&conv->buffers_skipped);
+		_pick_filter(conv);
+		return GST_FLOW_OK;
+	} else {
+		conv->silent_frames = MIN(conv->silent_frames + frames,
+					  G_MAXINT / 2);
+	}
+
+	_process(conv, GST_BUFFER_DATA(buf), frames);
+
+	return GST_FLOW_OK;
+}
+
+static gboolean _stop(GstBaseTransform *base)
+{
+	MafwGstRendererConvolver *conv = MAFW_GST_RENDERER_CONVOLVER(base);
+
+	_drop_filters(conv);
+	eq_conv_free(conv->conv);
+	conv->conv = NULL;
+
+	GST_OBJECT_LOCK(conv);
+	/* Forces a build on the next negotiation */
+	conv->rate = 0;
+	conv->build_seq++;
+	eq_conv_filter_free(conv->pending);
+	eq_conv_filter_free(conv->retired);
+	conv->pending = NULL;
+	conv->retired = NULL;
+	g_atomic_int_set(&conv->filter_changed, 0);
+	GST_OBJECT_UNLOCK(conv);
+
+	return TRUE;
+}
+
+/*----------------------------------------------------------------------------
+  Properties
+  ----------------------------------------------------------------------------*/
+
+static void _set_property(GObject *object, guint prop_id,
+			  const GValue *value, GParamSpec *pspec)
+{
+	MafwGstRendererConvolver *conv = MAFW_GST_RENDERER_CONVOLVER(object);
+	gboolean changed = FALSE;
+	gint block;
+
+	/* Filters are only rebuilt when something they depend on changes */
+	switch (prop_id) {
+	case PROP_MODE:
+		GST_OBJECT_LOCK(conv);
+		changed = conv->mode != g_value_get_enum(value);
+		conv->mode = g_value_get_enum(value);
+		GST_OBJECT_UNLOCK(conv);
+		break;
+	case PROP_IR_FILE:
+		GST_OBJECT_LOCK(conv);
+		if (g_strcmp0(conv->ir_file, g_value_get_string(value)) != 0) {
+			g_free(conv->ir_file);
+			conv->ir_file = g_value_dup_string(value);
+			changed = conv->mode ==
+				MAFW_GST_RENDERER_CONVOLVER_IMPULSE_RESPONSE;
+		}
+		GST_OBJECT_UNLOCK(conv);
+		break;
+	case PROP_TAPS:
+		GST_OBJECT_LOCK(conv);
+		changed = conv->taps != g_value_get_int(value) &&
+			conv->mode == MAFW_GST_RENDERER_CONVOLVER_LINEAR_PHASE;
+		conv->taps = g_value_get_int(value);
+		GST_OBJECT_UNLOCK(conv);
+		break;
+	case PROP_BLOCK_SIZE:
+		/* Rounded down to a power of two */
+		for (block = EQ_CONV_MIN_BLOCK;
+		     block * 2 <= g_value_get_int(value); block *= 2);
+		GST_OBJECT_LOCK(conv);
+		conv->block_size = block;
+		GST_OBJECT_UNLOCK(conv);
+		break;
+	case PROP_AUTO_PREAMP:
+		GST_OBJECT_LOCK(conv);
+		changed = conv->auto_preamp != g_value_get_boolean(value) &&
+			conv->mode == MAFW_GST_RENDERER_CONVOLVER_LINEAR_PHASE;
+		conv->auto_preamp = g_value_get_boolean(value);
+		GST_OBJECT_UNLOCK(conv);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+		break;
+	}
+
+	if (changed)
+		_build(conv);
+}
+
+static void _get_property(GObject *object, guint prop_id,
+			  GValue *value, GParamSpec *pspec)
+{
+	MafwGstRendererConvolver *conv = MAFW_GST_RENDERER_CONVOLVER(object);
+
+	switch (prop_id) {
+	case PROP_MODE:
+		GST_OBJECT_LOCK(conv);
+		g_value_set_enum(value, conv->mode);
+		GST_OBJECT_UNLOCK(conv);
+		break;
+	case PROP_IR_FILE:
+		GST_OBJECT_LOCK(conv);
+		g_value_set_string(value, conv->ir_file);
+		GST_OBJECT_UNLOCK(conv);
+		break;
+	case PROP_TAPS:
+		GST_OBJECT_LOCK(conv);
+		g_value_set_int(value, conv->taps);
+		GST_OBJECT_UNLOCK(conv);
+		break;
+	case PROP_BLOCK_SIZE:
+		GST_OBJECT_LOCK(conv);
+		g_value_set_int(value, conv->block_size);
+		GST_OBJECT_UNLOCK(conv);
+		break;
+	case PROP_AUTO_PREAMP:
+		GST_OBJECT_LOCK(conv);
+		g_value_set_boolean(value, conv->auto_preamp);
+		GST_OBJECT_UNLOCK(conv);
+		break;
+	case PROP_BLOCKS_PROCESSED:
+		g_value_set_uint(value,
+				 g_atomic_int_get(&conv->blocks_processed));
+		break;
+	case PROP_BUFFERS_SKIPPED:
+		g_value_set_uint(value,
+				 g_atomic_int_get(&conv->buffers_skipped));
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+		break;
+	}
+}
+
+/*----------------------------------------------------------------------------
+  GObject initialization
+  ----------------------------------------------------------------------------*/
+
+static void _finalize(GObject *object)
+{
+	MafwGstRendererConvolver *conv = MAFW_GST_RENDERER_CONVOLVER(object);
+
+	eq_conv_filter_free(conv->current);
+	eq_conv_filter_free(conv->fade_from);
+	eq_conv_filter_free(conv->to_retire);
+	eq_conv_filter_free(conv->pending);
+	eq_conv_filter_free(conv->retired);
+	eq_conv_free(conv->conv);
+	g_free(conv->ir_file);
+
+	G_OBJECT_CLASS(parent_class)->finalize(object);
+}
+
+static void mafw_gst_renderer_convolver_base_init(gpointer g_class)
+{
+	GstElementClass *element_class = GST_ELEMENT_CLASS(g_class);
+	GstCaps *caps;
+
+	gst_element_class_set_details_simple(
+		element_class,
+		"MAFW renderer convolver",
+		"Filter/Effect/Audio",
+		"Partitioned FFT convolution for linear phase equalization "
+		"and impulse responses",
+		"Juan A. Suarez Romero <jasuarez@igalia.com>");
+
+	caps = gst_caps_from_string(ALLOWED_CAPS);
+	gst_audio_filter_class_add_pad_templates(GST_AUDIO_FILTER_CLASS(g_class),
+						 caps);
+	gst_caps_unref(caps);
+}
+
+static void mafw_gst_renderer_convolver_class_init(
+	MafwGstRendererConvolverClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+	GstBaseTransformClass *trans_class = GST_BASE_TRANSFORM_CLASS(klass);
+	GstAudioFilterClass *filter_class = GST_AUDIO_FILTER_CLASS(klass);
+
+	GST_DEBUG_CATEGORY_INIT(convolver_debug, "mafw-gst-renderer-convolver",
+				0, "MAFW renderer convolver");
+
+	gobject_class->set_property = _set_property;
+	gobject_class->get_property = _get_property;
+	gobject_class->finalize = _finalize;
+
+	g_object_class_install_property(
+		gobject_class, PROP_MODE,
+		g_param_spec_enum("mode", "Mode",
+				  "What the filter is made from",
+				  MAFW_TYPE_GST_RENDERER_CONVOLVER_MODE,
+				  MAFW_GST_RENDERER_CONVOLVER_OFF,
+				  G_PARAM_READWRITE));
+	g_object_class_install_property(
+		gobject_class, PROP_IR_FILE,
+		g_param_spec_string("ir-file", "Impulse response file",
+				    "WAV file with the impulse response, one "
+				    "channel or one per output channel",
+				    NULL, G_PARAM_READWRITE));
+	g_object_class_install_property(
+		gobject_class, PROP_TAPS,
+		g_param_spec_int("taps", "Taps",
+				 "Length of the linear phase filter; longer "
+				 "ones resolve lower frequencies but delay "
+				 "the signal by half their length",
+				 MIN_TAPS, EQ_CONV_MAX_TAPS, DEFAULT_TAPS,
+				 G_PARAM_READWRITE));
+	g_object_class_install_property(
+		gobject_class, PROP_BLOCK_SIZE,
+		g_param_spec_int("block-size", "Block size",
+				 "Partition length in frames, which is also "
+				 "the latency; used from the next "
+				 "negotiation on",
+				 EQ_CONV_MIN_BLOCK, EQ_CONV_MAX_BLOCK,
+				 DEFAULT_BLOCK_SIZE, G_PARAM_READWRITE));
+	g_object_class_install_property(
+		gobject_class, PROP_AUTO_PREAMP,
+		g_param_spec_boolean("auto-preamp", "Automatic preamp",
+				     "Whether to scale linear phase filters "
+				     "down by the peak gain of their curve",
+				     TRUE, G_PARAM_READWRITE));
+	g_object_class_install_property(
+		gobject_class, PROP_BLOCKS_PROCESSED,
+		g_param_spec_uint("blocks-processed", "Blocks processed",
+				  "Blocks run through the convolution",
+				  0, G_MAXUINT, 0, G_PARAM_READABLE));
+	g_object_class_install_property(
+		gobject_class, PROP_BUFFERS_SKIPPED,
+		g_param_spec_uint("buffers-skipped", "Buffers skipped",
+				  "Silent buffers not convolved because the "
+				  "filter state was silent",
+				  0, G_MAXUINT, 0, G_PARAM_READABLE));
+
+	trans_class->stop = _stop;
+	trans_class->transform_ip = _transform_ip;
+	filter_class->setup = _setup;
+}
+
+static void mafw_gst_renderer_convolver_init(MafwGstRendererConvolver *conv,
+					     MafwGstRendererConvolverClass *klass)
+{
+	conv->mode = MAFW_GST_RENDERER_CONVOLVER_OFF;
+	eq_layout_init_default(&conv->layout);
+	memset(conv->gains, 0, sizeof(conv->gains));
+	conv->ir_file = NULL;
+	conv->taps = DEFAULT_TAPS;
+	conv->block_size = DEFAULT_BLOCK_SIZE;
+	conv->auto_preamp = TRUE;
+	conv->block = 0;
+	conv->rate = 0;
+	conv->channels = 0;
+	conv->build_seq = 0;
+	conv->pending = NULL;
+	conv->retired = NULL;
+	conv->filter_changed = 0;
+	conv->conv = NULL;
+	conv->current = NULL;
+	conv->fade_from = NULL;
+	conv->to_retire = NULL;
+	conv->pos = 0;
+	conv->mix_pos = 0;
+	conv->mix_dir = 1;
+	conv->is_s16 = TRUE;
+	conv->silent_frames = 0;
+	conv->quiet = FALSE;
+	conv->blocks_processed = 0;
+	conv->buffers_skipped = 0;
+
+	gst_base_transform_set_in_place(GST_BASE_TRANSFORM(conv), TRUE);
+	gst_base_transform_set_passthrough(GST_BASE_TRANSFORM(conv), TRUE);
+}
+
+GstElement *mafw_gst_renderer_convolver_new(void)
+{
+	return GST_ELEMENT(g_object_new(MAFW_TYPE_GST_RENDERER_CONVOLVER,
+					NULL));
+}
+
+/*
+ * Sets the curve the linear phase mode follows.  It has the same meaning
+ * as for the IIR equalizer.
+ */
+void mafw_gst_renderer_convolver_set_curve(MafwGstRendererConvolver *conv,
+					   const EqDspLayout *layout,
+					   const gdouble *gains)
+{
+	gboolean changed;
+
+	g_return_if_fail(MAFW_IS_GST_RENDERER_CONVOLVER(conv));
+	g_return_if_fail(layout != NULL && gains != NULL);
+	g_return_if_fail(layout->n_bands > 0 &&
+			 layout->n_bands <= EQ_DSP_MAX_BANDS);
+
+	GST_OBJECT_LOCK(conv);
+	changed = !eq_layout_equal(&conv->layout, layout) ||
+		memcmp(conv->gains, gains,
+		       layout->n_bands * sizeof(gdouble)) != 0;
+	conv->layout = *layout;
+	memset(conv->gains, 0, sizeof(conv->gains));
+	memcpy(conv->gains, gains, layout->n_bands * sizeof(gdouble));
+	changed = changed &&
+		conv->mode == MAFW_GST_RENDERER_CONVOLVER_LINEAR_PHASE;
+	GST_OBJECT_UNLOCK(conv);
+
+	if (changed)
+		_build(conv);
+}
+
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
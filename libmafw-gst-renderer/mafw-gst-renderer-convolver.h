@@ -0,0 +1,160 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef MAFW_GST_RENDERER_CONVOLVER_H
+#define MAFW_GST_RENDERER_CONVOLVER_H
+
+#include <gst/gst.h>
+#include <gst/audio/gstaudiofilter.h>
+
+#include "mafw-gst-renderer-convolver-dsp.h"
+
+G_BEGIN_DECLS
+
+/*----------------------------------------------------------------------------
+  GObject type conversion macros
+  ----------------------------------------------------------------------------*/
+
+#define MAFW_TYPE_GST_RENDERER_CONVOLVER                \
+        (mafw_gst_renderer_convolver_get_type())
+#define MAFW_GST_RENDERER_CONVOLVER(obj)                                \
+        (G_TYPE_CHECK_INSTANCE_CAST((obj), MAFW_TYPE_GST_RENDERER_CONVOLVER, \
+				    MafwGstRendererConvolver))
+#define MAFW_IS_GST_RENDERER_CONVOLVER(obj)                             \
+        (G_TYPE_CHECK_INSTANCE_TYPE((obj), MAFW_TYPE_GST_RENDERER_CONVOLVER))
+#define MAFW_GST_RENDERER_CONVOLVER_CLASS(klass)                        \
+	(G_TYPE_CHECK_CLASS_CAST((klass), MAFW_TYPE_GST_RENDERER_CONVOLVER, \
+				 MafwGstRendererConvolverClass))
+#define MAFW_IS_GST_RENDERER_CONVOLVER_CLASS(klass)                     \
+	(G_TYPE_CHECK_CLASS_TYPE((klass), MAFW_TYPE_GST_RENDERER_CONVOLVER))
+
+#define MAFW_TYPE_GST_RENDERER_CONVOLVER_MODE           \
+	(mafw_gst_renderer_convolver_mode_get_type())
+
+/*----------------------------------------------------------------------------
+  Type definitions
+  ----------------------------------------------------------------------------*/
+
+typedef enum {
+	MAFW_GST_RENDERER_CONVOLVER_OFF,
+	MAFW_GST_RENDERER_CONVOLVER_LINEAR_PHASE,
+	MAFW_GST_RENDERER_CONVOLVER_IMPULSE_RESPONSE,
+} MafwGstRendererConvolverMode;
+
+typedef struct _MafwGstRendererConvolver MafwGstRendererConvolver;
+typedef struct _MafwGstRendererConvolverClass MafwGstRendererConvolverClass;
+
+/*
+ * Filters are built out of the streaming thread, by the property setters
+ * or on caps negotiation, and handed over through pending.  The streaming
+ * thread only looks at it at block boundaries, with a trylock, so it never
+ * waits; filters it drops go back through retired and are freed by the
+ * next build.
+ *
+ * The following are protected by the object lock:
+ *
+ * mode:           What the filter is made from.
+ * layout, gains:  Curve for the linear phase mode.
+ * ir_file:        WAV file for the impulse response mode.
+ * taps:           Length of the linear phase filter.
+ * block_size:     Partition length for the next negotiation.
+ * auto_preamp:    Whether linear phase filters are scaled down by the
+ *                 peak gain of their curve, so boosts do not clip.
+ * block:          Partition length of the negotiated convolution.
+ * rate, channels: Negotiated format, 0 before negotiation.
+ * build_seq:      Bumped by every build, so that a slow build does not
+ *                 replace the result of a newer one.
+ * pending:        Last filter built, NULL to switch the convolution off.
+ * retired:        Filter dropped by the streaming thread.
+ * filter_changed: Whether pending holds a new filter.  Atomic, so the
+ *                 streaming thread can check it without the lock.
+ *
+ * The rest is only touched from the streaming thread:
+ *
+ * conv:           Convolution state, NULL before negotiation.
+ * current:        Filter being run, NULL while in passthrough.
+ * fade_from:      Filter to crossfade from in the next block.
+ * to_retire:      Filter no longer used, waiting to be put in retired.
+ * pos:            Frames of the current block already buffered.
+ * mix_pos:        Weight of the filtered signal against the dry one, in
+ *                 frames out of one block; negative while the delay line
+ *                 fills up after switching on.
+ * mix_dir:        1 while switching on or on, -1 while switching off.
+ * is_s16:         Whether samples are int16 rather than float.
+ * silent_frames:  Frames of silence fed in since the last sound.
+ * quiet:          Whether the state was cleared after enough silence, so
+ *                 that silent buffers can go out untouched.
+ * blocks_processed: Blocks run through the convolution.  Atomic.
+ * buffers_skipped: Silent buffers left untouched.  Atomic.
+ */
+struct _MafwGstRendererConvolver {
+	GstAudioFilter parent;
+
+	MafwGstRendererConvolverMode mode;
+	EqDspLayout layout;
+	gdouble gains[EQ_DSP_MAX_BANDS];
+	gchar *ir_file;
+	gint taps;
+	gint block_size;
+	gboolean auto_preamp;
+	gint block;
+	gint rate;
+	gint channels;
+	guint build_seq;
+	EqConvFilter *pending;
+	EqConvFilter *retired;
+	volatile gint filter_changed;
+
+	EqConv *conv;
+	EqConvFilter *current;
+	EqConvFilter *fade_from;
+	EqConvFilter *to_retire;
+	gint pos;
+	gint mix_pos;
+	gint mix_dir;
+	gboolean is_s16;
+	gint silent_frames;
+	gboolean quiet;
+
+	volatile guint blocks_processed;
+	volatile guint buffers_skipped;
+};
+
+struct _MafwGstRendererConvolverClass {
+	GstAudioFilterClass parent_class;
+};
+
+GType mafw_gst_renderer_convolver_get_type(void);
+GType mafw_gst_renderer_convolver_mode_get_type(void);
+
+GstElement *mafw_gst_renderer_convolver_new(void);
+
+void mafw_gst_renderer_convolver_set_curve(MafwGstRendererConvolver *conv,
+					   const EqDspLayout *layout,
+					   const gdouble *gains);
+
+G_END_DECLS
+
+#endif
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
@@ -0,0 +1,193 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mafw-gst-renderer-eq-layout.h"
+
+#undef  G_LOG_DOMAIN
+#define G_LOG_DOMAIN "mafw-gst-renderer-eq-layout"
+
+/* Centre frequencies, in Hz, of equalizer-10bands */
+static const gdouble default_freqs[EQ_DSP_NUM_BANDS] = {
+	29.0, 59.0, 119.0, 237.0, 474.0,
+	947.0, 1889.0, 3770.0, 7523.0, 15011.0
+};
+
+/* Butterworth shelves at the ends, one octave wide peaks in between */
+#define SHELF_Q	0.7071
+#define PEAK_Q	1.4142
+
+static const gchar *type_names[] = {
+	[EQ_DSP_FILTER_LOW_SHELF] = "lowshelf",
+	[EQ_DSP_FILTER_PEAK] = "peak",
+	[EQ_DSP_FILTER_HIGH_SHELF] = "highshelf",
+};
+
+/* Fills @layout with the ten band graphic equalizer */
+void eq_layout_init_default(EqDspLayout *layout)
+{
+	gint i;
+
+	memset(layout, 0, sizeof(EqDspLayout));
+	layout->n_bands = EQ_DSP_NUM_BANDS;
+	for (i = 0; i < EQ_DSP_NUM_BANDS; i++) {
+		if (i == 0) {
+			layout->bands[i].type = EQ_DSP_FILTER_LOW_SHELF;
+		} else if (i == EQ_DSP_NUM_BANDS - 1) {
+			layout->bands[i].type = EQ_DSP_FILTER_HIGH_SHELF;
+		} else {
+			layout->bands[i].type = EQ_DSP_FILTER_PEAK;
+		}
+		layout->bands[i].freq = default_freqs[i];
+		layout->bands[i].q =
+			layout->bands[i].type == EQ_DSP_FILTER_PEAK ?
+			PEAK_Q : SHELF_Q;
+	}
+}
+
+static gboolean _parse_band(const gchar *str, EqDspBand *band)
+{
+	gchar **fields;
+	gchar *end;
+	gboolean ok = FALSE;
+	gint i;
+
+	fields = g_strsplit(str, ":", 0);
+	if (g_strv_length(fields) != 3)
+		goto out;
+
+	for (i = 0; i < G_N_ELEMENTS(type_names); i++) {
+		if (strcmp(g_strstrip(fields[0]), type_names[i]) == 0)
+			break;
+	}
+	if (i == G_N_ELEMENTS(type_names))
+		goto out;
+	band->type = i;
+
+	band->freq = g_ascii_strtod(fields[1], &end);
+	if (end == fields[1] || *end != '\0' || band->freq <= 0.0)
+		goto out;
+
+	band->q = g_ascii_strtod(fields[2], &end);
+	if (end == fields[2] || *end != '\0' || band->q <= 0.0)
+		goto out;
+
+	ok = TRUE;
+out:
+	g_strfreev(fields);
+	return ok;
+}
+
+/*
+ * Parses a layout string into @layout.  Returns FALSE, leaving @layout
+ * untouched, if @str is malformed or has no bands or more than
+ * EQ_DSP_MAX_BANDS.
+ */
+gboolean eq_layout_parse(const gchar *str, EqDspLayout *layout)
+{
+	EqDspLayout parsed;
+	gchar **bands;
+	gint i, n;
+
+	g_return_val_if_fail(layout != NULL, FALSE);
+
+	if (str == NULL)
+		return FALSE;
+
+	memset(&parsed, 0, sizeof(parsed));
+	bands = g_strsplit(str, ";", 0);
+	n = 0;
+	for (i = 0; bands[i] != NULL; i++) {
+		/* Allow a trailing separator */
+		if (*g_strstrip(bands[i]) == '\0' && bands[i + 1] == NULL)
+			break;
+		if (n == EQ_DSP_MAX_BANDS) {
+			g_warning("Equalizer layout has more than %d bands",
+				  EQ_DSP_MAX_BANDS);
+			g_strfreev(bands);
+			return FALSE;
+		}
+		if (!_parse_band(bands[i], &parsed.bands[n])) {
+			g_warning("Wrong equalizer band '%s'", bands[i]);
+			g_strfreev(bands);
+			return FALSE;
+		}
+		n++;
+	}
+	g_strfreev(bands);
+
+	if (n == 0) {
+		g_warning("Equalizer layout has no bands");
+		return FALSE;
+	}
+
+	parsed.n_bands = n;
+	*layout = parsed;
+	return TRUE;
+}
+
+/* Returns @layout as a newly allocated string that eq_layout_parse() can
+ * read back */
+gchar *eq_layout_to_string(const EqDspLayout *layout)
+{
+	gchar freq[G_ASCII_DTOSTR_BUF_SIZE];
+	gchar q[G_ASCII_DTOSTR_BUF_SIZE];
+	GString *str;
+	gint i;
+
+	g_return_val_if_fail(layout != NULL, NULL);
+
+	str = g_string_new(NULL);
+	for (i = 0; i < layout->n_bands; i++) {
+		g_ascii_formatd(freq, sizeof(freq), "%g",
+				layout->bands[i].freq);
+		g_ascii_formatd(q, sizeof(q), "%g", layout->bands[i].q);
+		g_string_append_printf(str, "%s%s:%s:%s", i ? ";" : "",
+				       type_names[layout->bands[i].type],
+				       freq, q);
+	}
+
+	return g_string_free(str, FALSE);
+}
+
+gboolean eq_layout_equal(const EqDspLayout *a, const EqDspLayout *b)
+{
+	gint i;
+
+	if (a->n_bands != b->n_bands)
+		return FALSE;
+
+	for (i = 0; i < a->n_bands; i++) {
+		if (a->bands[i].type != b->bands[i].type ||
+		    a->bands[i].freq != b->bands[i].freq ||
+		    a->bands[i].q != b->bands[i].q)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
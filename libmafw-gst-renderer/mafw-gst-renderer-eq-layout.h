@@ -0,0 +1,53 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef MAFW_GST_RENDERER_EQ_LAYOUT_H
+#define MAFW_GST_RENDERER_EQ_LAYOUT_H
+
+#include <glib.h>
+
+#include "mafw-gst-renderer-equalizer-dsp.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Band layouts are stored in gconf as a single string, so that the applet
+ * and the renderer always agree on it.  Each band is "type:freq:q", bands
+ * are separated by ';' and type is one of "lowshelf", "peak" or
+ * "highshelf", e.g.:
+ *
+ *   lowshelf:60:0.707;peak:1000:1.414;highshelf:12000:0.707
+ *
+ * Gains are kept apart, in the band<N> keys.
+ */
+
+void eq_layout_init_default(EqDspLayout *layout);
+gboolean eq_layout_parse(const gchar *str, EqDspLayout *layout);
+gchar *eq_layout_to_string(const EqDspLayout *layout);
+gboolean eq_layout_equal(const EqDspLayout *a, const EqDspLayout *b);
+
+G_END_DECLS
+
+#endif
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
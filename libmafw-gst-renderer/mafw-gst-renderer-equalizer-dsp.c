@@ -0,0 +1,911 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Biquad cascade kernels for the renderer equalizer.
+ *
+ * Samples are interleaved, so the filters are vectorized across channels:
+ * each SIMD register holds the same instant of up to four channels and the
+ * whole cascade of bands runs on it before moving to the next frame.  This
+ * keeps the recursive part of the filters exact (no reordering of the
+ * per-channel arithmetic) while doing all the channels at once.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "mafw-gst-renderer-equalizer-dsp.h"
+
+#if defined(__SSE__)
+# include <xmmintrin.h>
+#endif
+
+#if defined(__SSE2__) && !defined(MAFW_GST_RENDERER_DISABLE_SIMD)
+# define EQ_DSP_SSE2 1
+# include <emmintrin.h>
+#elif defined(__ARM_NEON__) && !defined(MAFW_GST_RENDERER_DISABLE_SIMD)
+# define EQ_DSP_NEON 1
+# include <arm_neon.h>
+#endif
+
+/*----------------------------------------------------------------------------
+  Filter design
+  ----------------------------------------------------------------------------*/
+
+static void _set_identity(EqDspBiquad *bq)
+{
+	bq->b0 = 1.0f;
+	bq->b1 = bq->b2 = bq->a1 = bq->a2 = 0.0f;
+}
+
+/*
+ * Computes the coefficients of one band, following the RBJ audio EQ
+ * cookbook.  @gain is in dB.  A band with no gain, or that does not fit
+ * below the Nyquist frequency, becomes an exact identity so it does not
+ * color the signal with rounding noise.
+ */
+void eq_dsp_design(EqDspBiquad *bq, EqDspFilterType type, gdouble freq,
+		   gdouble q, gdouble gain, gint rate)
+{
+	gdouble a, w0, cosw, alpha, sqa;
+	gdouble b0, b1, b2, a0, a1, a2;
+
+	if (gain == 0.0 || rate <= 0 || freq <= 0.0 || q <= 0.0 ||
+	    freq >= rate / 2.0) {
+		_set_identity(bq);
+		return;
+	}
+
+	a = pow(10.0, gain / 40.0);
+	w0 = 2.0 * G_PI * freq / rate;
+	cosw = cos(w0);
+	alpha = sin(w0) / (2.0 * q);
+	sqa = 2.0 * sqrt(a) * alpha;
+
+	switch (type) {
+	case EQ_DSP_FILTER_LOW_SHELF:
+		b0 = a * ((a + 1) - (a - 1) * cosw + sqa);
+		b1 = 2 * a * ((a - 1) - (a + 1) * cosw);
+		b2 = a * ((a + 1) - (a - 1) * cosw - sqa);
+		a0 = (a + 1) + (a - 1) * cosw + sqa;
+		a1 = -2 * ((a - 1) + (a + 1) * cosw);
+		a2 = (a + 1) + (a - 1) * cosw - sqa;
+		break;
+	case EQ_DSP_FILTER_HIGH_SHELF:
+		b0 = a * ((a + 1) + (a - 1) * cosw + sqa);
+		b1 = -2 * a * ((a - 1) + (a + 1) * cosw);
+		b2 = a * ((a + 1) + (a - 1) * cosw - sqa);
+		a0 = (a + 1) - (a - 1) * cosw + sqa;
+		a1 = 2 * ((a - 1) - (a + 1) * cosw);
+		a2 = (a + 1) - (a - 1) * cosw - sqa;
+		break;
+	case EQ_DSP_FILTER_PEAK:
+	default:
+		b0 = 1 + alpha * a;
+		b1 = -2 * cosw;
+		b2 = 1 - alpha * a;
+		a0 = 1 + alpha / a;
+		a1 = -2 * cosw;
+		a2 = 1 - alpha / a;
+		break;
+	}
+
+	bq->b0 = b0 / a0;
+	bq->b1 = b1 / a0;
+	bq->b2 = b2 / a0;
+	bq->a1 = a1 / a0;
+	bq->a2 = a2 / a0;
+}
+
+/*
+ * Designs every band of @layout with the matching gain of @gains.  Bands
+ * past the end of the layout are set to the identity, so that a cascade of
+ * EQ_DSP_MAX_BANDS can always run on the result.
+ */
+void eq_dsp_design_layout(EqDspBiquad *bq, const EqDspLayout *layout,
+			  const gdouble *gains, gint rate)
+{
+	const EqDspBand *band;
+	gint i;
+
+	for (i = 0; i < EQ_DSP_MAX_BANDS; i++) {
+		if (i < layout->n_bands) {
+			band = &layout->bands[i];
+			eq_dsp_design(&bq[i], band->type, band->freq, band->q,
+				      gains[i], rate);
+		} else {
+			_set_identity(&bq[i]);
+		}
+	}
+}
+
+/*----------------------------------------------------------------------------
+  Magnitude response
+  ----------------------------------------------------------------------------*/
+
+/* Points of the logarithmic grid eq_dsp_peak_gain() starts from */
+#define PEAK_GRID_POINTS 256
+/* Lowest frequency looked at, in Hz */
+#define PEAK_MIN_FREQ 10.0
+/* Golden section steps refining the best point of the grid */
+#define PEAK_REFINE_STEPS 24
+
+/* Magnitude of the cascade @bq of @n_bands biquads at @w radians/sample */
+gdouble eq_dsp_magnitude(const EqDspBiquad *bq, gint n_bands, gdouble w)
+{
+	gdouble c1 = cos(w), s1 = sin(w), c2 = cos(2.0 * w), s2 = sin(2.0 * w);
+	gdouble mag = 1.0, nr, ni, dr, di;
+	gint b;
+
+	for (b = 0; b < n_bands; b++) {
+		nr = bq[b].b0 + bq[b].b1 * c1 + bq[b].b2 * c2;
+		ni = -(bq[b].b1 * s1 + bq[b].b2 * s2);
+		dr = 1.0 + bq[b].a1 * c1 + bq[b].a2 * c2;
+		di = -(bq[b].a1 * s1 + bq[b].a2 * s2);
+		mag *= sqrt((nr * nr + ni * ni) / (dr * dr + di * di));
+	}
+
+	return mag;
+}
+
+/*
+ * Peak of the magnitude response of the cascade between PEAK_MIN_FREQ and
+ * the Nyquist frequency, never below 1.  The response is sampled on a
+ * logarithmic grid, fine enough for the band widths of the equalizer to
+ * have a single maximum between two points, and the best point is refined
+ * by golden section search between its neighbours.
+ */
+gdouble eq_dsp_peak_gain(const EqDspBiquad *bq, gint n_bands, gint rate)
+{
+	const gdouble ratio = 0.6180339887498949;
+	gdouble w_min, step, lo, hi, a, b, ma, mb, mag, peak = 1.0;
+	gint i, best = -1;
+
+	if (n_bands <= 0 || rate <= 0)
+		return 1.0;
+
+	w_min = log(2.0 * G_PI * PEAK_MIN_FREQ / rate);
+	step = (log(G_PI) - w_min) / (PEAK_GRID_POINTS - 1);
+	for (i = 0; i < PEAK_GRID_POINTS; i++) {
+		mag = eq_dsp_magnitude(bq, n_bands, exp(w_min + i * step));
+		if (mag > peak) {
+			peak = mag;
+			best = i;
+		}
+	}
+
+	if (best < 0)
+		return 1.0;
+
+	lo = w_min + MAX(best - 1, 0) * step;
+	hi = w_min + MIN(best + 1, PEAK_GRID_POINTS - 1) * step;
+	a = hi - ratio * (hi - lo);
+	b = lo + ratio * (hi - lo);
+	ma = eq_dsp_magnitude(bq, n_bands, exp(a));
+	mb = eq_dsp_magnitude(bq, n_bands, exp(b));
+	for (i = 0; i < PEAK_REFINE_STEPS; i++) {
+		if (ma > mb) {
+			hi = b;
+			b = a;
+			mb = ma;
+			a = hi - ratio * (hi - lo);
+			ma = eq_dsp_magnitude(bq, n_bands, exp(a));
+		} else {
+			lo = a;
+			a = b;
+			ma = mb;
+			b = lo + ratio * (hi - lo);
+			mb = eq_dsp_magnitude(bq, n_bands, exp(b));
+		}
+	}
+
+	return MAX(peak, MAX(ma, mb));
+}
+
+/* Scales the first band of @bq so that the peak gain @peak of the cascade
+ * becomes unity.  It costs nothing in the kernels, and the coefficient
+ * ramps move the preamp along with the curve. */
+void eq_dsp_apply_preamp(EqDspBiquad *bq, gdouble peak)
+{
+	gfloat scale;
+
+	if (peak <= 1.0)
+		return;
+
+	scale = (gfloat) (1.0 / peak);
+	bq[0].b0 *= scale;
+	bq[0].b1 *= scale;
+	bq[0].b2 *= scale;
+}
+
+/*----------------------------------------------------------------------------
+  Coefficient cache
+  ----------------------------------------------------------------------------*/
+
+/* Designs kept by the cache, a handful of curves at a couple of rates */
+#define EQ_DSP_CACHE_SIZE 64
+
+/* The curve is quantized (gains to hundredths of dB, frequencies to
+ * hundredths of Hz, Q to thousandths), far below what is audible, so that
+ * a curve read back from gconf finds the entry of the same preset.  The
+ * coefficients do not depend on the channel count, so it is not part of
+ * the key. */
+typedef struct {
+	gint32 type;
+	gint32 freq;
+	gint32 q;
+	gint32 gain;
+} EqDspCacheBand;
+
+typedef struct {
+	gint rate;
+	gint n_bands;
+	EqDspCacheBand bands[EQ_DSP_MAX_BANDS];
+} EqDspCacheKey;
+
+typedef struct {
+	EqDspCacheKey key;
+	EqDspBiquad bq[EQ_DSP_MAX_BANDS];
+	gdouble peak;
+} EqDspCacheEntry;
+
+static GStaticMutex cache_lock = G_STATIC_MUTEX_INIT;
+static GHashTable *cache = NULL;
+static GQueue cache_order = G_QUEUE_INIT;
+static guint cache_hits = 0;
+static guint cache_misses = 0;
+
+static guint _cache_key_hash(gconstpointer key)
+{
+	const guint8 *p = key;
+	guint h = 2166136261U;
+	gsize i;
+
+	/* FNV-1a */
+	for (i = 0; i < sizeof(EqDspCacheKey); i++)
+		h = (h ^ p[i]) * 16777619U;
+	return h;
+}
+
+static gboolean _cache_key_equal(gconstpointer a, gconstpointer b)
+{
+	return memcmp(a, b, sizeof(EqDspCacheKey)) == 0;
+}
+
+/*
+ * Same as eq_dsp_design_layout(), but looks the design up in a process
+ * wide cache first, so switching between known curves or rates costs a
+ * hash lookup instead of the trigonometry.  The peak gain of the curve (see
+ * eq_dsp_peak_gain()) is cached along, and returned in @peak if not NULL.
+ * Safe to call from any thread, but it takes a lock shared by all of them,
+ * so streaming threads should leave it to the control ones.
+ */
+void eq_dsp_design_layout_cached(EqDspBiquad *bq, const EqDspLayout *layout,
+				 const gdouble *gains, gint rate,
+				 gdouble *peak)
+{
+	EqDspCacheKey key;
+	EqDspCacheEntry *entry;
+	EqDspLayout quantized;
+	gdouble quantized_gains[EQ_DSP_MAX_BANDS];
+	gint i;
+
+	memset(&key, 0, sizeof(key));
+	key.rate = rate;
+	key.n_bands = MIN(layout->n_bands, EQ_DSP_MAX_BANDS);
+	quantized.n_bands = key.n_bands;
+	for (i = 0; i < key.n_bands; i++) {
+		key.bands[i].type = layout->bands[i].type;
+		key.bands[i].freq = (gint32) floor(layout->bands[i].freq * 100.0
+						   + 0.5);
+		key.bands[i].q = (gint32) floor(layout->bands[i].q * 1000.0 +
+						0.5);
+		key.bands[i].gain = (gint32) floor(gains[i] * 100.0 + 0.5);
+		quantized.bands[i].type = layout->bands[i].type;
+		quantized.bands[i].freq = key.bands[i].freq / 100.0;
+		quantized.bands[i].q = key.bands[i].q / 1000.0;
+		quantized_gains[i] = key.bands[i].gain / 100.0;
+	}
+
+	g_static_mutex_lock(&cache_lock);
+
+	if (G_UNLIKELY(cache == NULL)) {
+		cache = g_hash_table_new_full(_cache_key_hash,
+					      _cache_key_equal, NULL, g_free);
+	}
+
+	entry = g_hash_table_lookup(cache, &key);
+	if (entry) {
+		cache_hits++;
+	} else {
+		cache_misses++;
+		if (g_queue_get_length(&cache_order) >= EQ_DSP_CACHE_SIZE) {
+			entry = g_queue_pop_head(&cache_order);
+			g_hash_table_remove(cache, &entry->key);
+		}
+		entry = g_new(EqDspCacheEntry, 1);
+		entry->key = key;
+		eq_dsp_design_layout(entry->bq, &quantized, quantized_gains,
+				     rate);
+		entry->peak = eq_dsp_peak_gain(entry->bq, quantized.n_bands,
+					       rate);
+		g_hash_table_insert(cache, &entry->key, entry);
+		g_queue_push_tail(&cache_order, entry);
+	}
+	memcpy(bq, entry->bq, sizeof(entry->bq));
+	if (peak)
+		*peak = entry->peak;
+
+	g_static_mutex_unlock(&cache_lock);
+}
+
+void eq_dsp_cache_stats(guint *hits, guint *misses)
+{
+	g_static_mutex_lock(&cache_lock);
+	if (hits)
+		*hits = cache_hits;
+	if (misses)
+		*misses = cache_misses;
+	g_static_mutex_unlock(&cache_lock);
+}
+
+gboolean eq_dsp_gains_are_flat(const gdouble *gains, gint n_bands)
+{
+	gint i;
+
+	for (i = 0; i < n_bands; i++) {
+		if (gains[i] != 0.0)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+void eq_dsp_reset(EqDspState *state)
+{
+	memset(state, 0, sizeof(EqDspState));
+}
+
+/* Clears the history of bands @first to @last, both included */
+void eq_dsp_reset_bands(EqDspState *state, gint first, gint last)
+{
+	gint b;
+
+	for (b = MAX(first, 0); b <= last && b < EQ_DSP_MAX_BANDS; b++) {
+		memset(state->z1[b], 0, sizeof(state->z1[b]));
+		memset(state->z2[b], 0, sizeof(state->z2[b]));
+		memset(state->w1[b + 1], 0, sizeof(state->w1[b + 1]));
+		memset(state->w2[b + 1], 0, sizeof(state->w2[b + 1]));
+		memset(state->err[b], 0, sizeof(state->err[b]));
+	}
+}
+
+/*----------------------------------------------------------------------------
+  Silence and denormals
+  ----------------------------------------------------------------------------*/
+
+/* MXCSR flush-to-zero and denormals-are-zero bits */
+#define EQ_DSP_MXCSR_FTZ_DAZ	0x8040
+/* FPSCR/FPCR flush-to-zero bit */
+#define EQ_DSP_FPSCR_FZ		(1 << 24)
+
+/*
+ * Makes the floating point unit of the calling thread flush denormal
+ * results and operands to zero.  The history of the filters decays into
+ * denormals on silence, which are very slow to operate on in most FPUs and
+ * far below what any output can render.  It only writes the control
+ * register when the mode is not set yet, so it is cheap enough to be
+ * called for every buffer.  NEON always works this way; the VFP does not.
+ */
+void eq_dsp_flush_denormals(void)
+{
+#if defined(__SSE__)
+	guint csr;
+
+	csr = _mm_getcsr();
+	if ((csr & EQ_DSP_MXCSR_FTZ_DAZ) != EQ_DSP_MXCSR_FTZ_DAZ)
+		_mm_setcsr(csr | EQ_DSP_MXCSR_FTZ_DAZ);
+#elif defined(__aarch64__)
+	guint64 fpcr;
+
+	__asm__ __volatile__("mrs %0, fpcr" : "=r" (fpcr));
+	if (!(fpcr & EQ_DSP_FPSCR_FZ))
+		__asm__ __volatile__("msr fpcr, %0"
+				     : : "r" (fpcr | EQ_DSP_FPSCR_FZ));
+#elif defined(__arm__) && defined(__VFP_FP__) && !defined(__SOFTFP__)
+	guint32 fpscr;
+
+	__asm__ __volatile__("fmrx %0, fpscr" : "=r" (fpscr));
+	if (!(fpscr & EQ_DSP_FPSCR_FZ))
+		__asm__ __volatile__("fmxr fpscr, %0"
+				     : : "r" (fpscr | EQ_DSP_FPSCR_FZ));
+#endif
+}
+
+gboolean eq_dsp_is_silent_s16(const gint16 *data, guint samples)
+{
+	guint i;
+	gint16 acc = 0;
+
+	/* The first sample tells most non silent buffers apart; the rest
+	 * has no early exit so the compiler can vectorize it */
+	if (samples == 0 || data[0] != 0)
+		return samples == 0;
+	for (i = 0; i < samples; i++)
+		acc |= data[i];
+	return acc == 0;
+}
+
+/* Both +0.0 and -0.0 count as silence */
+gboolean eq_dsp_is_silent_float(const gfloat *data, guint samples)
+{
+	const guint32 *bits = (const guint32 *) data;
+	guint32 acc = 0;
+	guint i;
+
+	if (samples == 0 || (bits[0] & 0x7fffffff) != 0)
+		return samples == 0;
+	for (i = 0; i < samples; i++)
+		acc |= bits[i];
+	return (acc & 0x7fffffff) == 0;
+}
+
+/*
+ * Whether the history of the first @n_bands bands has decayed below
+ * EQ_DSP_QUIET_LEVEL, so that clearing it changes the output by less than
+ * the quietest sample any output can render.
+ */
+gboolean eq_dsp_state_is_quiet(const EqDspState *state, gint n_bands)
+{
+	gint b, c;
+
+	for (b = 0; b < n_bands; b++) {
+		for (c = 0; c < EQ_DSP_MAX_CHANNELS; c++) {
+			if (fabsf(state->z1[b][c]) > EQ_DSP_QUIET_LEVEL ||
+			    fabsf(state->z2[b][c]) > EQ_DSP_QUIET_LEVEL)
+				return FALSE;
+		}
+	}
+
+	/* Rounding can leave the fixed point history cycling a few steps
+	 * away from zero; anything below the int16 LSB is silence */
+	for (b = 0; b <= n_bands; b++) {
+		for (c = 0; c < EQ_DSP_MAX_CHANNELS; c++) {
+			if (ABS(state->w1[b][c]) >=
+			    (1 << EQ_DSP_FIXED_SAMPLE_SHIFT) ||
+			    ABS(state->w2[b][c]) >=
+			    (1 << EQ_DSP_FIXED_SAMPLE_SHIFT))
+				return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/*----------------------------------------------------------------------------
+  Vector abstraction
+  ----------------------------------------------------------------------------*/
+
+#if defined(EQ_DSP_SSE2)
+
+#define EQ_LANES 4
+typedef __m128 eq_vec;
+#define _vec_set1(x)		_mm_set1_ps(x)
+#define _vec_add(a, b)		_mm_add_ps((a), (b))
+#define _vec_sub(a, b)		_mm_sub_ps((a), (b))
+#define _vec_mul(a, b)		_mm_mul_ps((a), (b))
+#define _vec_load(p)		_mm_loadu_ps(p)
+#define _vec_store(p, v)	_mm_storeu_ps((p), (v))
+
+#elif defined(EQ_DSP_NEON)
+
+#define EQ_LANES 4
+typedef float32x4_t eq_vec;
+#define _vec_set1(x)		vdupq_n_f32(x)
+#define _vec_add(a, b)		vaddq_f32((a), (b))
+#define _vec_sub(a, b)		vsubq_f32((a), (b))
+#define _vec_mul(a, b)		vmulq_f32((a), (b))
+#define _vec_load(p)		vld1q_f32(p)
+#define _vec_store(p, v)	vst1q_f32((p), (v))
+
+#else
+
+#define EQ_LANES 1
+typedef gfloat eq_vec;
+#define _vec_set1(x)		(x)
+#define _vec_add(a, b)		((a) + (b))
+#define _vec_sub(a, b)		((a) - (b))
+#define _vec_mul(a, b)		((a) * (b))
+#define _vec_load(p)		(*(p))
+#define _vec_store(p, v)	(*(p) = (v))
+
+#endif
+
+/* Coefficients broadcast to every lane */
+typedef struct {
+	eq_vec b0, b1, b2;
+	eq_vec a1, a2;
+} EqVecBiquad;
+
+static inline void _broadcast(EqVecBiquad *vbq, const EqDspBiquad *bq,
+			      gint n_bands)
+{
+	gint b;
+
+	for (b = 0; b < n_bands; b++) {
+		vbq[b].b0 = _vec_set1(bq[b].b0);
+		vbq[b].b1 = _vec_set1(bq[b].b1);
+		vbq[b].b2 = _vec_set1(bq[b].b2);
+		vbq[b].a1 = _vec_set1(bq[b].a1);
+		vbq[b].a2 = _vec_set1(bq[b].a2);
+	}
+}
+
+/* Runs one frame of a lane group through the whole cascade */
+static inline eq_vec _cascade(const EqVecBiquad *c, eq_vec *z1, eq_vec *z2,
+			      gint n_bands, eq_vec x)
+{
+	eq_vec y;
+	gint b;
+
+	for (b = 0; b < n_bands; b++) {
+		y = _vec_add(_vec_mul(c[b].b0, x), z1[b]);
+		z1[b] = _vec_add(_vec_sub(_vec_mul(c[b].b1, x),
+					  _vec_mul(c[b].a1, y)),
+				 z2[b]);
+		z2[b] = _vec_sub(_vec_mul(c[b].b2, x), _vec_mul(c[b].a2, y));
+		x = y;
+	}
+	return x;
+}
+
+/* Lanes beyond the channel count are fed with zeroes, so their history
+ * stays zero and it is safe to always load and store whole vectors */
+static inline void _load_state(const EqDspState *state, gint group,
+			       eq_vec *z1, eq_vec *z2, gint n_bands)
+{
+	gint b;
+
+	for (b = 0; b < n_bands; b++) {
+		z1[b] = _vec_load(&state->z1[b][group]);
+		z2[b] = _vec_load(&state->z2[b][group]);
+	}
+}
+
+static inline void _store_state(EqDspState *state, gint group,
+				const eq_vec *z1, const eq_vec *z2,
+				gint n_bands)
+{
+	gint b;
+
+	for (b = 0; b < n_bands; b++) {
+		_vec_store(&state->z1[b][group], z1[b]);
+		_vec_store(&state->z2[b][group], z2[b]);
+	}
+}
+
+static inline gint16 _clip_s16(gfloat v)
+{
+	v = floorf(v + 0.5f);
+	return (gint16) CLAMP(v, -32768.0f, 32767.0f);
+}
+
+/*----------------------------------------------------------------------------
+  Sample format loaders
+  ----------------------------------------------------------------------------*/
+
+static inline eq_vec _load_float(const gfloat *p, gint lanes)
+{
+	gfloat tmp[EQ_LANES];
+
+	if (lanes == EQ_LANES)
+		return _vec_load(p);
+
+	memset(tmp, 0, sizeof(tmp));
+	memcpy(tmp, p, lanes * sizeof(gfloat));
+	return _vec_load(tmp);
+}
+
+static inline void _store_float(gfloat *p, eq_vec v, gint lanes)
+{
+	gfloat tmp[EQ_LANES];
+
+	if (lanes == EQ_LANES) {
+		_vec_store(p, v);
+	} else {
+		_vec_store(tmp, v);
+		memcpy(p, tmp, lanes * sizeof(gfloat));
+	}
+}
+
+static inline eq_vec _load_s16(const gint16 *p, gint lanes)
+{
+	gfloat tmp[EQ_LANES];
+	gint l;
+
+#if defined(EQ_DSP_SSE2)
+	__m128i i;
+
+	if (lanes == 4) {
+		i = _mm_loadl_epi64((const __m128i *) p);
+		return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(i, i),
+						      16));
+	} else if (lanes == 2) {
+		gint32 pair;
+
+		memcpy(&pair, p, sizeof(pair));
+		i = _mm_cvtsi32_si128(pair);
+		return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(i, i),
+						      16));
+	}
+#elif defined(EQ_DSP_NEON)
+	if (lanes == 4)
+		return vcvtq_f32_s32(vmovl_s16(vld1_s16(p)));
+#endif
+
+	for (l = 0; l < EQ_LANES; l++)
+		tmp[l] = l < lanes ? p[l] : 0.0f;
+	return _vec_load(tmp);
+}
+
+static inline void _store_s16(gint16 *p, eq_vec v, gint lanes)
+{
+	gfloat tmp[EQ_LANES];
+	gint l;
+
+#if defined(EQ_DSP_SSE2)
+	__m128i i;
+
+	if (lanes == 4 || lanes == 2) {
+		v = _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(-32768.0f)),
+			       _mm_set1_ps(32767.0f));
+		i = _mm_cvtps_epi32(v);
+		i = _mm_packs_epi32(i, i);
+		if (lanes == 4) {
+			_mm_storel_epi64((__m128i *) p, i);
+		} else {
+			gint32 pair = _mm_cvtsi128_si32(i);
+
+			memcpy(p, &pair, sizeof(pair));
+		}
+		return;
+	}
+#elif defined(EQ_DSP_NEON)
+	if (lanes == 4) {
+		/* vcvtq truncates, so add 0.5 with the sign of the sample */
+		uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(v),
+					    vdupq_n_u32(0x80000000));
+		float32x4_t half = vreinterpretq_f32_u32(
+			vorrq_u32(sign,
+				  vreinterpretq_u32_f32(vdupq_n_f32(0.5f))));
+
+		vst1_s16(p, vqmovn_s32(vcvtq_s32_f32(vaddq_f32(v, half))));
+		return;
+	}
+#endif
+
+	_vec_store(tmp, v);
+	for (l = 0; l < lanes; l++)
+		p[l] = _clip_s16(tmp[l]);
+}
+
+/*----------------------------------------------------------------------------
+  Kernels
+  ----------------------------------------------------------------------------*/
+
+void eq_dsp_process_float(const EqDspBiquad *bq, gint n_bands,
+			  EqDspState *state, gfloat *data, guint frames,
+			  gint channels)
+{
+	EqVecBiquad c[EQ_DSP_MAX_BANDS];
+	eq_vec z1[EQ_DSP_MAX_BANDS], z2[EQ_DSP_MAX_BANDS];
+	gint group, lanes;
+	gfloat *p;
+	guint i;
+
+	g_return_if_fail(n_bands <= EQ_DSP_MAX_BANDS);
+	g_return_if_fail(channels > 0 && channels <= EQ_DSP_MAX_CHANNELS);
+
+	_broadcast(c, bq, n_bands);
+
+	for (group = 0; group < channels; group += EQ_LANES) {
+		lanes = MIN(EQ_LANES, channels - group);
+		_load_state(state, group, z1, z2, n_bands);
+		for (i = 0, p = data + group; i < frames; i++, p += channels) {
+			_store_float(p, _cascade(c, z1, z2, n_bands,
+						 _load_float(p, lanes)),
+				     lanes);
+		}
+		_store_state(state, group, z1, z2, n_bands);
+	}
+}
+
+void eq_dsp_process_s16(const EqDspBiquad *bq, gint n_bands,
+			EqDspState *state, gint16 *data, guint frames,
+			gint channels)
+{
+	EqVecBiquad c[EQ_DSP_MAX_BANDS];
+	eq_vec z1[EQ_DSP_MAX_BANDS], z2[EQ_DSP_MAX_BANDS];
+	gint group, lanes;
+	gint16 *p;
+	guint i;
+
+	g_return_if_fail(n_bands <= EQ_DSP_MAX_BANDS);
+	g_return_if_fail(channels > 0 && channels <= EQ_DSP_MAX_CHANNELS);
+
+	_broadcast(c, bq, n_bands);
+
+	for (group = 0; group < channels; group += EQ_LANES) {
+		lanes = MIN(EQ_LANES, channels - group);
+		_load_state(state, group, z1, z2, n_bands);
+		for (i = 0, p = data + group; i < frames; i++, p += channels) {
+			_store_s16(p, _cascade(c, z1, z2, n_bands,
+					       _load_s16(p, lanes)),
+				   lanes);
+		}
+		_store_state(state, group, z1, z2, n_bands);
+	}
+}
+
+gboolean eq_dsp_has_simd(void)
+{
+#if defined(EQ_DSP_SSE2) || defined(EQ_DSP_NEON)
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+/*----------------------------------------------------------------------------
+  Fixed point kernel
+  ----------------------------------------------------------------------------*/
+
+/* Biggest intermediate sample; keeps every product below 2^61 so the five
+ * terms of a band add up in 64 bits without overflowing */
+#define FIXED_SAMPLE_MAX	((1 << 30) - 1)
+
+typedef struct {
+	gint32 b0, b1, b2;
+	gint32 a1, a2;
+} EqFixedBiquad;
+
+static inline gint32 _to_fixed(gfloat c)
+{
+	gdouble v = floor(c * (gdouble) (1 << EQ_DSP_FIXED_COEFF_BITS) + 0.5);
+
+	return (gint32) CLAMP(v, -2147483647.0, 2147483647.0);
+}
+
+/*
+ * Runs int16 samples through the cascade in integer arithmetic only, for
+ * CPUs with no fast floating point: Q3.28 coefficients times Q8.23 samples
+ * accumulate in 64 bits and every band output is truncated and saturated
+ * back to Q8.23.  It is direct form I, so the history holds samples (not
+ * partial sums, as in transposed form II) and can not overflow by itself.
+ *
+ * The poles of the low bands sit close to z = 1, where they amplify the
+ * truncation noise by tens of dB.  Feeding the truncated bits back into the
+ * next output of the band (first order error feedback) puts a zero at z = 1
+ * in the noise path, which brings the error back below one int16 LSB.
+ */
+void eq_dsp_process_s16_fixed(const EqDspBiquad *bq, gint n_bands,
+			      EqDspState *state, gint16 *data, guint frames,
+			      gint channels)
+{
+	EqFixedBiquad c[EQ_DSP_MAX_BANDS];
+	gint32 w1[EQ_DSP_MAX_BANDS + 1], w2[EQ_DSP_MAX_BANDS + 1];
+	gint32 err[EQ_DSP_MAX_BANDS];
+	gint32 x, y;
+	gint64 acc;
+	gint b, ch;
+	gint16 *p;
+	guint i;
+
+	g_return_if_fail(n_bands <= EQ_DSP_MAX_BANDS);
+	g_return_if_fail(channels > 0 && channels <= EQ_DSP_MAX_CHANNELS);
+
+	for (b = 0; b < n_bands; b++) {
+		c[b].b0 = _to_fixed(bq[b].b0);
+		c[b].b1 = _to_fixed(bq[b].b1);
+		c[b].b2 = _to_fixed(bq[b].b2);
+		c[b].a1 = _to_fixed(bq[b].a1);
+		c[b].a2 = _to_fixed(bq[b].a2);
+	}
+
+	for (ch = 0; ch < channels; ch++) {
+		for (b = 0; b <= n_bands; b++) {
+			w1[b] = state->w1[b][ch];
+			w2[b] = state->w2[b][ch];
+		}
+		for (b = 0; b < n_bands; b++)
+			err[b] = state->err[b][ch];
+
+		for (i = 0, p = data + ch; i < frames; i++, p += channels) {
+			x = (gint32) *p << EQ_DSP_FIXED_SAMPLE_SHIFT;
+			for (b = 0; b < n_bands; b++) {
+				acc = (gint64) c[b].b0 * x +
+					(gint64) c[b].b1 * w1[b] +
+					(gint64) c[b].b2 * w2[b] -
+					(gint64) c[b].a1 * w1[b + 1] -
+					(gint64) c[b].a2 * w2[b + 1] + err[b];
+				err[b] = (gint32) (acc &
+					((1 << EQ_DSP_FIXED_COEFF_BITS) - 1));
+				acc >>= EQ_DSP_FIXED_COEFF_BITS;
+				y = (gint32) CLAMP(acc, -FIXED_SAMPLE_MAX,
+						   FIXED_SAMPLE_MAX);
+				w2[b] = w1[b];
+				w1[b] = x;
+				x = y;
+			}
+			w2[n_bands] = w1[n_bands];
+			w1[n_bands] = x;
+
+			x = (x + (1 << (EQ_DSP_FIXED_SAMPLE_SHIFT - 1))) >>
+				EQ_DSP_FIXED_SAMPLE_SHIFT;
+			*p = (gint16) CLAMP(x, G_MININT16, G_MAXINT16);
+		}
+
+		for (b = 0; b <= n_bands; b++) {
+			state->w1[b][ch] = w1[b];
+			state->w2[b][ch] = w2[b];
+		}
+		for (b = 0; b < n_bands; b++)
+			state->err[b][ch] = err[b];
+	}
+}
+
+/*----------------------------------------------------------------------------
+  Coefficient ramps
+  ----------------------------------------------------------------------------*/
+
+/*
+ * Linear interpolation between two sets of coefficients, @t going from 0
+ * (@from) to 1 (@to).  The region of stable (a1, a2) pairs is convex, so
+ * every step between two stable filters is stable too.
+ */
+void eq_dsp_interpolate(EqDspBiquad *out, const EqDspBiquad *from,
+			const EqDspBiquad *to, gint n_bands, gfloat t)
+{
+	gint b;
+
+	for (b = 0; b < n_bands; b++) {
+		out[b].b0 = from[b].b0 + t * (to[b].b0 - from[b].b0);
+		out[b].b1 = from[b].b1 + t * (to[b].b1 - from[b].b1);
+		out[b].b2 = from[b].b2 + t * (to[b].b2 - from[b].b2);
+		out[b].a1 = from[b].a1 + t * (to[b].a1 - from[b].a1);
+		out[b].a2 = from[b].a2 + t * (to[b].a2 - from[b].a2);
+	}
+}
+
+void eq_dsp_set_identity(EqDspBiquad *bq, gint n_bands)
+{
+	gint b;
+
+	for (b = 0; b < n_bands; b++)
+		_set_identity(&bq[b]);
+}
+
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
@@ -0,0 +1,151 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef MAFW_GST_RENDERER_EQUALIZER_DSP_H
+#define MAFW_GST_RENDERER_EQUALIZER_DSP_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Number of bands of the default graphic equalizer layout (same as the
+ * stock equalizer-10bands element) */
+#define EQ_DSP_NUM_BANDS 10
+
+/* Biggest number of bands of a layout.  Everything is sized for it, so
+ * that the streaming thread never allocates */
+#define EQ_DSP_MAX_BANDS 32
+
+/* Biggest number of interleaved channels the kernels can run; must be a
+ * multiple of 4 so every SIMD lane group has room in the state */
+#define EQ_DSP_MAX_CHANNELS 8
+
+/* Shortest coefficient ramp, in frames, used when the equalizer is switched
+ * in or out of the signal path */
+#define EQ_DSP_FADE_FRAMES 256
+
+/* Frames processed with the same coefficients during a ramp */
+#define EQ_DSP_RAMP_BLOCK 32
+
+/* Filter history below this level is taken as silence: about -180 dBFS for
+ * float samples, and far below one LSB for int16 ones */
+#define EQ_DSP_QUIET_LEVEL 1e-9f
+
+/* Fixed point kernel formats: coefficients are Q3.28 (every RBJ design in
+ * the equalizer gain range fits in +-8), samples are int16 scaled up to
+ * Q8.23, which leaves 48 dB of headroom between bands and 8 bits below the
+ * int16 LSB */
+#define EQ_DSP_FIXED_COEFF_BITS 28
+#define EQ_DSP_FIXED_SAMPLE_SHIFT 8
+
+/* Biggest difference, in int16 LSBs, allowed between the output of the
+ * fixed point kernel and an exact run of the same filters on the same
+ * curve.  The error feedback keeps the rounding of every band from adding
+ * up, so it stays within the rounding of the output itself */
+#define EQ_DSP_FIXED_MAX_ERROR 2
+
+typedef enum {
+	EQ_DSP_FILTER_LOW_SHELF,
+	EQ_DSP_FILTER_PEAK,
+	EQ_DSP_FILTER_HIGH_SHELF,
+} EqDspFilterType;
+
+/* One band of a layout; its gain is set apart */
+typedef struct {
+	EqDspFilterType type;
+	gdouble freq;
+	gdouble q;
+} EqDspBand;
+
+/* Band layout of the equalizer */
+typedef struct {
+	gint n_bands;
+	EqDspBand bands[EQ_DSP_MAX_BANDS];
+} EqDspLayout;
+
+/* Normalized (a0 == 1) biquad coefficients, transposed direct form II */
+typedef struct {
+	gfloat b0, b1, b2;
+	gfloat a1, a2;
+} EqDspBiquad;
+
+/*
+ * Filter history.  The float kernels keep one z1/z2 pair per band and
+ * channel.  The fixed point kernel runs in direct form I, where the output
+ * of a band is the input of the next one, so it keeps the last two samples
+ * between every pair of bands instead: w1[0]/w2[0] are the input, w1[b + 1]
+ * and w2[b + 1] the output of band b.  err holds the rounding error of the
+ * last output of every band, fed back into the next one.
+ */
+typedef struct {
+	gfloat z1[EQ_DSP_MAX_BANDS][EQ_DSP_MAX_CHANNELS];
+	gfloat z2[EQ_DSP_MAX_BANDS][EQ_DSP_MAX_CHANNELS];
+	gint32 w1[EQ_DSP_MAX_BANDS + 1][EQ_DSP_MAX_CHANNELS];
+	gint32 w2[EQ_DSP_MAX_BANDS + 1][EQ_DSP_MAX_CHANNELS];
+	gint32 err[EQ_DSP_MAX_BANDS][EQ_DSP_MAX_CHANNELS];
+} EqDspState;
+
+void eq_dsp_design(EqDspBiquad *bq, EqDspFilterType type, gdouble freq,
+		   gdouble q, gdouble gain, gint rate);
+void eq_dsp_design_layout(EqDspBiquad *bq, const EqDspLayout *layout,
+			  const gdouble *gains, gint rate);
+
+void eq_dsp_design_layout_cached(EqDspBiquad *bq, const EqDspLayout *layout,
+				 const gdouble *gains, gint rate,
+				 gdouble *peak);
+void eq_dsp_cache_stats(guint *hits, guint *misses);
+
+gdouble eq_dsp_magnitude(const EqDspBiquad *bq, gint n_bands, gdouble w);
+gdouble eq_dsp_peak_gain(const EqDspBiquad *bq, gint n_bands, gint rate);
+void eq_dsp_apply_preamp(EqDspBiquad *bq, gdouble peak);
+
+gboolean eq_dsp_gains_are_flat(const gdouble *gains, gint n_bands);
+
+void eq_dsp_reset(EqDspState *state);
+void eq_dsp_reset_bands(EqDspState *state, gint first, gint last);
+
+void eq_dsp_flush_denormals(void);
+gboolean eq_dsp_is_silent_s16(const gint16 *data, guint samples);
+gboolean eq_dsp_is_silent_float(const gfloat *data, guint samples);
+gboolean eq_dsp_state_is_quiet(const EqDspState *state, gint n_bands);
+
+void eq_dsp_process_float(const EqDspBiquad *bq, gint n_bands,
+			  EqDspState *state, gfloat *data, guint frames,
+			  gint channels);
+void eq_dsp_process_s16(const EqDspBiquad *bq, gint n_bands,
+			EqDspState *state, gint16 *data, guint frames,
+			gint channels);
+void eq_dsp_process_s16_fixed(const EqDspBiquad *bq, gint n_bands,
+			      EqDspState *state, gint16 *data, guint frames,
+			      gint channels);
+gboolean eq_dsp_has_simd(void);
+
+void eq_dsp_interpolate(EqDspBiquad *out, const EqDspBiquad *from,
+			const EqDspBiquad *to, gint n_bands, gfloat t);
+void eq_dsp_set_identity(EqDspBiquad *bq, gint n_bands);
+
+G_END_DECLS
+
+#endif
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
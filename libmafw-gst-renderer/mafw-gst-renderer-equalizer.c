@@ -0,0 +1,739 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * In-place equalizer for the renderer audio bin.  By default it is a 10
+ * band graphic equalizer with the same band0..band9 properties as
+ * equalizer-10bands, so it is a drop-in replacement for it, but runs the
+ * vectorized kernels from mafw-gst-renderer-equalizer-dsp.c directly on
+ * interleaved int16 or float32 buffers.
+ *
+ * Setting the layout property turns it into a parametric equalizer of up
+ * to EQ_DSP_MAX_BANDS bands, each with its own filter type, frequency and
+ * Q (see mafw-gst-renderer-eq-layout.h); band<N> is then the gain of the
+ * N-th band of the layout.  All the state is sized for EQ_DSP_MAX_BANDS,
+ * so changing the layout does not allocate in the streaming thread.
+ *
+ * Curve changes never step the filters: the streaming thread ramps the
+ * coefficients linearly to the new ones over ramp-time milliseconds,
+ * updating them every EQ_DSP_RAMP_BLOCK frames.
+ *
+ * When every band is at 0 dB the element switches itself to passthrough,
+ * so buffers are neither made writable nor touched.  The filters ramp from
+ * or to the identity when entering and leaving bypass, which makes the
+ * switch inaudible.
+ *
+ * Silent buffers (GAP flagged or all zeros) are not filtered once the
+ * filter history has decayed: it is cleared instead, which is what the
+ * filters would converge to anyway, and the buffer goes out as it came.
+ * This also keeps the history from lingering in denormals.
+ *
+ * With fixed-point set, int16 buffers go through an integer only kernel
+ * instead, and float caps are refused so that int16 decoders are not
+ * converted to float and back around the equalizer.  It defaults to TRUE
+ * when the float kernels are not vectorized.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "mafw-gst-renderer-equalizer.h"
+#include "mafw-gst-renderer-eq-layout.h"
+#include "../constants.h"
+
+#undef  G_LOG_DOMAIN
+#define G_LOG_DOMAIN "mafw-gst-renderer-equalizer"
+
+GST_DEBUG_CATEGORY_STATIC(equalizer_debug);
+#define GST_CAT_DEFAULT equalizer_debug
+
+#define INT_CAPS							\
+	"audio/x-raw-int, "						\
+	"depth = (int) 16, "						\
+	"width = (int) 16, "						\
+	"endianness = (int) BYTE_ORDER, "				\
+	"signed = (boolean) TRUE, "					\
+	"rate = (int) [ 1, MAX ], "					\
+	"channels = (int) [ 1, 8 ]"
+
+#define ALLOWED_CAPS							\
+	INT_CAPS "; "							\
+	"audio/x-raw-float, "						\
+	"width = (int) 32, "						\
+	"endianness = (int) BYTE_ORDER, "				\
+	"rate = (int) [ 1, MAX ], "					\
+	"channels = (int) [ 1, 8 ]"
+
+#define DEFAULT_RAMP_TIME	50
+#define MAX_RAMP_TIME		1000
+
+enum {
+	PROP_0,
+	PROP_RAMP_TIME,
+	PROP_BUFFERS_BYPASSED,
+	PROP_BUFFERS_PROCESSED,
+	PROP_BUFFERS_SKIPPED,
+	PROP_FIXED_POINT,
+	PROP_AUTO_PREAMP,
+	PROP_LAYOUT,
+	PROP_BAND0,
+	/* PROP_BAND1 .. PROP_BAND<EQ_DSP_MAX_BANDS - 1> follow */
+};
+
+GST_BOILERPLATE(MafwGstRendererEqualizer, mafw_gst_renderer_equalizer,
+		GstAudioFilter, GST_TYPE_AUDIO_FILTER);
+
+/*----------------------------------------------------------------------------
+  Curve publishing
+  ----------------------------------------------------------------------------*/
+
+/* Called with the object lock held, which serializes the setters */
+static void _publish_gains(MafwGstRendererEqualizer *eq)
+{
+	EqDspBiquad bq[EQ_DSP_MAX_BANDS];
+	gdouble peak = 1.0;
+	gint slot = 1 - g_atomic_int_get(&eq->pub_index);
+	gint rate = g_atomic_int_get(&eq->design_rate);
+
+	/* Designed before the slot is touched, to keep pub_seq odd for as
+	 * short as possible */
+	if (rate > 0)
+		eq_dsp_design_layout_cached(bq, &eq->layout, eq->gains, rate,
+					    &peak);
+
+	g_atomic_int_inc(&eq->pub_seq);
+	memcpy(eq->pub_gains[slot], eq->gains, sizeof(eq->gains));
+	eq->pub_layout[slot] = eq->layout;
+	memcpy(eq->pub_bq[slot], bq, sizeof(bq));
+	eq->pub_peak[slot] = peak;
+	eq->pub_rate[slot] = rate;
+	g_atomic_int_set(&eq->pub_index, slot);
+	g_atomic_int_inc(&eq->pub_seq);
+}
+
+/* Copies the last published curve into active_gains and active_layout,
+ * if there is a new one and it could be read consistently */
+static gboolean _fetch_gains(MafwGstRendererEqualizer *eq)
+{
+	gdouble gains[EQ_DSP_MAX_BANDS];
+	EqDspLayout layout;
+	EqDspBiquad bq[EQ_DSP_MAX_BANDS];
+	gdouble peak;
+	gint seq, slot, rate;
+
+	seq = g_atomic_int_get(&eq->pub_seq);
+	if (seq == eq->seen_seq || (seq & 1))
+		return FALSE;
+
+	slot = g_atomic_int_get(&eq->pub_index);
+	memcpy(gains, eq->pub_gains[slot], sizeof(gains));
+	layout = eq->pub_layout[slot];
+	memcpy(bq, eq->pub_bq[slot], sizeof(bq));
+	peak = eq->pub_peak[slot];
+	rate = eq->pub_rate[slot];
+	if (g_atomic_int_get(&eq->pub_seq) != seq)
+		return FALSE;
+
+	eq->seen_seq = seq;
+	memcpy(eq->active_gains, gains, sizeof(gains));
+	eq->active_layout = layout;
+	memcpy(eq->active_bq, bq, sizeof(bq));
+	eq->active_peak = peak;
+	eq->active_rate = rate;
+	eq->flat = eq_dsp_gains_are_flat(gains, layout.n_bands);
+	return TRUE;
+}
+
+/*----------------------------------------------------------------------------
+  Processing
+  ----------------------------------------------------------------------------*/
+
+static void _process_s16(MafwGstRendererEqualizer *eq, guint8 *data,
+			 guint frames)
+{
+	eq_dsp_process_s16(eq->coeffs, eq->n_active, &eq->state,
+			   (gint16 *) data, frames,
+			   GST_AUDIO_FILTER(eq)->format.channels);
+}
+
+static void _process_s16_fixed(MafwGstRendererEqualizer *eq, guint8 *data,
+			       guint frames)
+{
+	eq_dsp_process_s16_fixed(eq->coeffs, eq->n_active, &eq->state,
+				 (gint16 *) data, frames,
+				 GST_AUDIO_FILTER(eq)->format.channels);
+}
+
+static void _process_float(MafwGstRendererEqualizer *eq, guint8 *data,
+			   guint frames)
+{
+	eq_dsp_process_float(eq->coeffs, eq->n_active, &eq->state,
+			     (gfloat *) data, frames,
+			     GST_AUDIO_FILTER(eq)->format.channels);
+}
+
+static gboolean _setup(GstAudioFilter *filter, GstRingBufferSpec *fmt)
+{
+	MafwGstRendererEqualizer *eq = MAFW_GST_RENDERER_EQUALIZER(filter);
+
+	if (fmt->type == GST_BUFTYPE_LINEAR && fmt->width == 16) {
+		eq->process = g_atomic_int_get(&eq->fixed_point) ?
+			_process_s16_fixed : _process_s16;
+	} else if (fmt->type == GST_BUFTYPE_FLOAT && fmt->width == 32) {
+		eq->process = _process_float;
+	} else {
+		eq->process = NULL;
+		return FALSE;
+	}
+
+	eq->rate = fmt->rate;
+	eq->need_design = TRUE;
+	g_atomic_int_set(&eq->design_rate, fmt->rate);
+	eq_dsp_reset(&eq->state);
+
+	return TRUE;
+}
+
+/* Designs the coefficients of the active curve into @bq, scaled down by
+ * its peak gain if auto_preamp is set.  The ones published along with the
+ * curve are taken if they are for the negotiated rate; otherwise they are
+ * designed here, without the cache, which is not to be locked from the
+ * streaming thread */
+static void _design_curve(MafwGstRendererEqualizer *eq, EqDspBiquad *bq)
+{
+	gdouble peak;
+
+	if (G_LIKELY(eq->active_rate == eq->rate)) {
+		memcpy(bq, eq->active_bq, sizeof(eq->active_bq));
+		peak = eq->active_peak;
+	} else {
+		eq_dsp_design_layout(bq, &eq->active_layout, eq->active_gains,
+				     eq->rate);
+		peak = eq_dsp_peak_gain(bq, eq->active_layout.n_bands,
+					eq->rate);
+	}
+	if (g_atomic_int_get(&eq->auto_preamp))
+		eq_dsp_apply_preamp(bq, peak);
+}
+
+/* Designs the coefficients of the active curve straight into coeffs */
+static void _design(MafwGstRendererEqualizer *eq)
+{
+	_design_curve(eq, eq->coeffs);
+	eq->n_active = eq->active_layout.n_bands;
+	eq->ramp_len = 0;
+}
+
+/* Ends the running ramp at its target coefficients */
+static void _end_ramp(MafwGstRendererEqualizer *eq)
+{
+	memcpy(eq->coeffs, eq->ramp_to, sizeof(eq->coeffs));
+	eq->n_active = eq->active_layout.n_bands;
+	eq->ramp_len = 0;
+}
+
+/* Starts a ramp from the current coefficients to the ones of the active
+ * curve, lasting at least @min_frames frames.  Bands only in the new layout
+ * ramp from the identity with a clean history; bands only in the old one
+ * ramp to the identity and are dropped once the ramp is done */
+static void _start_ramp(MafwGstRendererEqualizer *eq, guint min_frames)
+{
+	guint frames;
+	gint n_bands;
+
+	frames = (guint) ((gint64) g_atomic_int_get(&eq->ramp_time) *
+			  eq->rate / 1000);
+	memcpy(eq->ramp_from, eq->coeffs, sizeof(eq->coeffs));
+	_design_curve(eq, eq->ramp_to);
+
+	n_bands = eq->active_layout.n_bands;
+	if (n_bands > eq->n_active) {
+		eq_dsp_reset_bands(&eq->state, eq->n_active, n_bands - 1);
+		eq->n_active = n_bands;
+	}
+
+	eq->ramp_pos = 0;
+	eq->ramp_len = MAX(frames, min_frames);
+	if (eq->ramp_len == 0)
+		_end_ramp(eq);
+}
+
+/* Filters @frames frames of @data, moving the coefficients along the
+ * running ramp every EQ_DSP_RAMP_BLOCK frames */
+static void _process(MafwGstRendererEqualizer *eq, guint8 *data,
+		     guint frames)
+{
+	guint frame_size, n;
+
+	frame_size = GST_AUDIO_FILTER(eq)->format.channels *
+		(GST_AUDIO_FILTER(eq)->format.width / 8);
+
+	while (eq->ramp_len > 0 && frames > 0) {
+		n = MIN(frames, EQ_DSP_RAMP_BLOCK);
+		n = MIN(n, eq->ramp_len - eq->ramp_pos);
+		eq->ramp_pos += n;
+		if (eq->ramp_pos >= eq->ramp_len) {
+			_end_ramp(eq);
+		} else {
+			eq_dsp_interpolate(eq->coeffs, eq->ramp_from,
+					   eq->ramp_to, eq->n_active,
+					   (gfloat) eq->ramp_pos /
+					   eq->ramp_len);
+		}
+		eq->process(eq, data, n);
+		data += n * frame_size;
+		frames -= n;
+	}
+
+	if (frames > 0)
+		eq->process(eq, data, frames);
+}
+
+/* Moves the running ramp along @frames frames of silence.  The history is
+ * clear, so the filters would output silence whatever their coefficients */
+static void _skip(MafwGstRendererEqualizer *eq, guint frames)
+{
+	if (eq->ramp_len == 0)
+		return;
+
+	eq->ramp_pos += MIN(frames, eq->ramp_len - eq->ramp_pos);
+	if (eq->ramp_pos >= eq->ramp_len) {
+		_end_ramp(eq);
+	} else {
+		eq_dsp_interpolate(eq->coeffs, eq->ramp_from, eq->ramp_to,
+				   eq->n_active,
+				   (gfloat) eq->ramp_pos / eq->ramp_len);
+	}
+}
+
+static gboolean _is_silent(GstAudioFilter *filter, GstBuffer *buf)
+{
+	if (GST_BUFFER_FLAG_IS_SET(buf, GST_BUFFER_FLAG_GAP))
+		return TRUE;
+
+	if (filter->format.width == 16) {
+		return eq_dsp_is_silent_s16((gint16 *) GST_BUFFER_DATA(buf),
+					    GST_BUFFER_SIZE(buf) / 2);
+	} else {
+		return eq_dsp_is_silent_float((gfloat *) GST_BUFFER_DATA(buf),
+					      GST_BUFFER_SIZE(buf) / 4);
+	}
+}
+
+static GstFlowReturn _transform_ip(GstBaseTransform *base, GstBuffer *buf)
+{
+	MafwGstRendererEqualizer *eq = MAFW_GST_RENDERER_EQUALIZER(base);
+	GstAudioFilter *filter = GST_AUDIO_FILTER(base);
+	guint frame_size, frames;
+	gboolean changed;
+
+	if (G_UNLIKELY(eq->process == NULL))
+		return GST_FLOW_NOT_NEGOTIATED;
+
+	frame_size = filter->format.channels * (filter->format.width / 8);
+	if (G_UNLIKELY(frame_size == 0))
+		return GST_FLOW_NOT_NEGOTIATED;
+
+	changed = _fetch_gains(eq);
+
+	if (eq->bypass) {
+		g_atomic_int_inc(&eq->buffers_bypassed);
+		/* In passthrough the buffer may not be writable, so it goes
+		 * out untouched and the ramp starts with the next one */
+		if (G_UNLIKELY(!eq->flat)) {
+			GST_DEBUG_OBJECT(eq, "curve is not flat, leaving bypass");
+			eq->bypass = FALSE;
+			eq->need_design = FALSE;
+			eq_dsp_reset(&eq->state);
+			eq_dsp_set_identity(eq->coeffs, EQ_DSP_MAX_BANDS);
+			eq->n_active = 0;
+			_start_ramp(eq, EQ_DSP_FADE_FRAMES);
+			gst_base_transform_set_passthrough(base, FALSE);
+		}
+		return GST_FLOW_OK;
+	}
+
+	if (G_UNLIKELY(eq->need_design)) {
+		/* New rate: there is nothing to ramp from */
+		eq->need_design = FALSE;
+		_design(eq);
+	} else if (changed) {
+		_start_ramp(eq, eq->flat ? EQ_DSP_FADE_FRAMES : 0);
+	}
+
+	frames = GST_BUFFER_SIZE(buf) / frame_size;
+	if (_is_silent(filter, buf) &&
+	    eq_dsp_state_is_quiet(&eq->state, eq->n_active)) {
+		g_atomic_int_inc(&eq->buffers_skipped);
+		eq_dsp_reset(&eq->state);
+		_skip(eq, frames);
+	} else {
+		g_atomic_int_inc(&eq->buffers_processed);
+		_process(eq, GST_BUFFER_DATA(buf), frames);
+	}
+
+	/* Once at the identity, the history is clean and passthrough is
+	 * exactly what the filters output */
+	if (G_UNLIKELY(eq->flat) && eq->ramp_len == 0) {
+		GST_DEBUG_OBJECT(eq, "curve is flat, entering bypass");
+		eq->bypass = TRUE;
+		gst_base_transform_set_passthrough(base, TRUE);
+	}
+
+	return GST_FLOW_OK;
+}
+
+/* Only int16 goes through when the fixed point kernel is selected */
+static GstCaps *_transform_caps(GstBaseTransform *base,
+				GstPadDirection direction, GstCaps *caps)
+{
+	MafwGstRendererEqualizer *eq = MAFW_GST_RENDERER_EQUALIZER(base);
+	GstCaps *int_caps, *ret;
+
+	if (!g_atomic_int_get(&eq->fixed_point))
+		return gst_caps_copy(caps);
+
+	int_caps = gst_caps_from_string(INT_CAPS);
+	ret = gst_caps_intersect(caps, int_caps);
+	gst_caps_unref(int_caps);
+
+	return ret;
+}
+
+static gboolean _start(GstBaseTransform *base)
+{
+	eq_dsp_reset(&MAFW_GST_RENDERER_EQUALIZER(base)->state);
+	return TRUE;
+}
+
+/*----------------------------------------------------------------------------
+  Properties
+  ----------------------------------------------------------------------------*/
+
+static void _set_property(GObject *object, guint prop_id,
+			  const GValue *value, GParamSpec *pspec)
+{
+	MafwGstRendererEqualizer *eq = MAFW_GST_RENDERER_EQUALIZER(object);
+	gint band = prop_id - PROP_BAND0;
+
+	if (band >= 0 && band < EQ_DSP_MAX_BANDS) {
+		gdouble gain = g_value_get_double(value);
+
+		GST_OBJECT_LOCK(eq);
+		if (eq->gains[band] != gain) {
+			eq->gains[band] = gain;
+			_publish_gains(eq);
+		}
+		GST_OBJECT_UNLOCK(eq);
+		return;
+	}
+
+	switch (prop_id) {
+	case PROP_RAMP_TIME:
+		g_atomic_int_set(&eq->ramp_time, g_value_get_int(value));
+		break;
+	case PROP_FIXED_POINT:
+		g_atomic_int_set(&eq->fixed_point, g_value_get_boolean(value));
+		break;
+	case PROP_AUTO_PREAMP:
+		/* Published again so that the streaming thread ramps to the
+		 * curve with the new preamp */
+		GST_OBJECT_LOCK(eq);
+		if (g_atomic_int_get(&eq->auto_preamp) !=
+		    g_value_get_boolean(value)) {
+			g_atomic_int_set(&eq->auto_preamp,
+					 g_value_get_boolean(value));
+			_publish_gains(eq);
+		}
+		GST_OBJECT_UNLOCK(eq);
+		break;
+	case PROP_LAYOUT: {
+		EqDspLayout layout;
+
+		if (g_value_get_string(value) == NULL) {
+			eq_layout_init_default(&layout);
+		} else if (!eq_layout_parse(g_value_get_string(value),
+					    &layout)) {
+			break;
+		}
+		mafw_gst_renderer_equalizer_set_layout(eq, &layout);
+		break;
+	}
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+		break;
+	}
+}
+
+static void _get_property(GObject *object, guint prop_id,
+			  GValue *value, GParamSpec *pspec)
+{
+	MafwGstRendererEqualizer *eq = MAFW_GST_RENDERER_EQUALIZER(object);
+	gint band = prop_id - PROP_BAND0;
+
+	if (band >= 0 && band < EQ_DSP_MAX_BANDS) {
+		GST_OBJECT_LOCK(eq);
+		g_value_set_double(value, eq->gains[band]);
+		GST_OBJECT_UNLOCK(eq);
+		return;
+	}
+
+	switch (prop_id) {
+	case PROP_RAMP_TIME:
+		g_value_set_int(value, g_atomic_int_get(&eq->ramp_time));
+		break;
+	case PROP_FIXED_POINT:
+		g_value_set_boolean(value, g_atomic_int_get(&eq->fixed_point));
+		break;
+	case PROP_AUTO_PREAMP:
+		g_value_set_boolean(value, g_atomic_int_get(&eq->auto_preamp));
+		break;
+	case PROP_LAYOUT:
+		GST_OBJECT_LOCK(eq);
+		g_value_take_string(value, eq_layout_to_string(&eq->layout));
+		GST_OBJECT_UNLOCK(eq);
+		break;
+	case PROP_BUFFERS_BYPASSED:
+		g_value_set_uint(value,
+				 g_atomic_int_get(&eq->buffers_bypassed));
+		break;
+	case PROP_BUFFERS_PROCESSED:
+		g_value_set_uint(value,
+				 g_atomic_int_get(&eq->buffers_processed));
+		break;
+	case PROP_BUFFERS_SKIPPED:
+		g_value_set_uint(value,
+				 g_atomic_int_get(&eq->buffers_skipped));
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+		break;
+	}
+}
+
+/*----------------------------------------------------------------------------
+  GObject initialization
+  ----------------------------------------------------------------------------*/
+
+static void mafw_gst_renderer_equalizer_base_init(gpointer g_class)
+{
+	GstElementClass *element_class = GST_ELEMENT_CLASS(g_class);
+	GstCaps *caps;
+
+	gst_element_class_set_details_simple(
+		element_class,
+		"MAFW renderer equalizer",
+		"Filter/Effect/Audio",
+		"Vectorized in-place graphic and parametric equalizer",
+		"Juan A. Suarez Romero <jasuarez@igalia.com>");
+
+	caps = gst_caps_from_string(ALLOWED_CAPS);
+	gst_audio_filter_class_add_pad_templates(GST_AUDIO_FILTER_CLASS(g_class),
+						 caps);
+	gst_caps_unref(caps);
+}
+
+static void mafw_gst_renderer_equalizer_class_init(
+	MafwGstRendererEqualizerClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+	GstBaseTransformClass *trans_class = GST_BASE_TRANSFORM_CLASS(klass);
+	GstAudioFilterClass *filter_class = GST_AUDIO_FILTER_CLASS(klass);
+	gint i;
+
+	GST_DEBUG_CATEGORY_INIT(equalizer_debug, "mafw-gst-renderer-equalizer",
+				0, "MAFW renderer equalizer");
+
+	gobject_class->set_property = _set_property;
+	gobject_class->get_property = _get_property;
+
+	g_object_class_install_property(
+		gobject_class, PROP_RAMP_TIME,
+		g_param_spec_int("ramp-time", "Ramp time",
+				 "Length of the transition to a new curve, "
+				 "in milliseconds",
+				 0, MAX_RAMP_TIME, DEFAULT_RAMP_TIME,
+				 G_PARAM_READWRITE));
+	g_object_class_install_property(
+		gobject_class, PROP_BUFFERS_BYPASSED,
+		g_param_spec_uint("buffers-bypassed", "Buffers bypassed",
+				  "Buffers passed through untouched because "
+				  "the curve was flat",
+				  0, G_MAXUINT, 0, G_PARAM_READABLE));
+	g_object_class_install_property(
+		gobject_class, PROP_BUFFERS_PROCESSED,
+		g_param_spec_uint("buffers-processed", "Buffers processed",
+				  "Buffers run through the filters",
+				  0, G_MAXUINT, 0, G_PARAM_READABLE));
+	g_object_class_install_property(
+		gobject_class, PROP_BUFFERS_SKIPPED,
+		g_param_spec_uint("buffers-skipped", "Buffers skipped",
+				  "Silent buffers not filtered because the "
+				  "filter history had decayed",
+				  0, G_MAXUINT, 0, G_PARAM_READABLE));
+	g_object_class_install_property(
+		gobject_class, PROP_FIXED_POINT,
+		g_param_spec_boolean("fixed-point", "Fixed point",
+				     "Whether to only accept int16 and run it "
+				     "through the integer kernel.  Takes "
+				     "effect on the next caps negotiation",
+				     !eq_dsp_has_simd(), G_PARAM_READWRITE));
+	g_object_class_install_property(
+		gobject_class, PROP_AUTO_PREAMP,
+		g_param_spec_boolean("auto-preamp", "Automatic preamp",
+				     "Whether to scale the curve down by its "
+				     "peak gain, so that boosts do not clip",
+				     TRUE, G_PARAM_READWRITE));
+	g_object_class_install_property(
+		gobject_class, PROP_LAYOUT,
+		g_param_spec_string("layout", "Layout",
+				    "Band layout, as 'type:freq:q' bands "
+				    "separated by ';'.  NULL restores the "
+				    "10 band graphic equalizer",
+				    NULL, G_PARAM_READWRITE));
+
+	for (i = 0; i < EQ_DSP_MAX_BANDS; i++) {
+		gchar *name, *blurb;
+
+		name = g_strdup_printf("band%d", i);
+		blurb = g_strdup_printf("Gain for the band %d of the layout, "
+					"ranging from %d dB to +%d dB",
+					i, EQ_GAIN_MIN, EQ_GAIN_MAX);
+		g_object_class_install_property(
+			gobject_class, PROP_BAND0 + i,
+			g_param_spec_double(name, name, blurb,
+					    EQ_GAIN_MIN, EQ_GAIN_MAX, 0.0,
+					    G_PARAM_READWRITE));
+		g_free(name);
+		g_free(blurb);
+	}
+
+	trans_class->start = _start;
+	trans_class->transform_caps = _transform_caps;
+	trans_class->transform_ip = _transform_ip;
+	filter_class->setup = _setup;
+}
+
+static void mafw_gst_renderer_equalizer_init(MafwGstRendererEqualizer *eq,
+					     MafwGstRendererEqualizerClass *klass)
+{
+	memset(eq->gains, 0, sizeof(eq->gains));
+	memset(eq->pub_gains, 0, sizeof(eq->pub_gains));
+	memset(eq->active_gains, 0, sizeof(eq->active_gains));
+	eq_layout_init_default(&eq->layout);
+	eq->pub_layout[0] = eq->layout;
+	eq->pub_layout[1] = eq->layout;
+	eq->active_layout = eq->layout;
+	eq->n_active = 0;
+	eq->pub_index = 0;
+	eq->pub_seq = 0;
+	eq->pub_rate[0] = 0;
+	eq->pub_rate[1] = 0;
+	eq->design_rate = 0;
+	eq->seen_seq = 0;
+	eq->active_rate = 0;
+	eq->ramp_time = DEFAULT_RAMP_TIME;
+	eq->fixed_point = !eq_dsp_has_simd();
+	eq->auto_preamp = TRUE;
+	eq->ramp_pos = 0;
+	eq->ramp_len = 0;
+	eq->rate = 0;
+	eq->need_design = TRUE;
+	eq->process = NULL;
+	eq->buffers_bypassed = 0;
+	eq->buffers_processed = 0;
+	eq->buffers_skipped = 0;
+	eq_dsp_set_identity(eq->coeffs, EQ_DSP_MAX_BANDS);
+	eq_dsp_reset(&eq->state);
+
+	/* All gains are zero, so start in bypass */
+	eq->flat = TRUE;
+	eq->bypass = TRUE;
+
+	gst_base_transform_set_in_place(GST_BASE_TRANSFORM(eq), TRUE);
+	gst_base_transform_set_passthrough(GST_BASE_TRANSFORM(eq), TRUE);
+}
+
+GstElement *mafw_gst_renderer_equalizer_new(void)
+{
+	return GST_ELEMENT(g_object_new(MAFW_TYPE_GST_RENDERER_EQUALIZER,
+					NULL));
+}
+
+/*
+ * Sets the gains of the first @n_bands bands at once.  The streaming thread
+ * sees either the old or the new curve, never a mix of both, and ramps to
+ * it in a single transition.
+ */
+void mafw_gst_renderer_equalizer_set_gains(MafwGstRendererEqualizer *eq,
+					   const gdouble *gains,
+					   gint n_bands)
+{
+	gboolean changed = FALSE;
+	gint i;
+
+	g_return_if_fail(MAFW_IS_GST_RENDERER_EQUALIZER(eq));
+	g_return_if_fail(gains != NULL);
+
+	n_bands = MIN(n_bands, EQ_DSP_MAX_BANDS);
+
+	GST_OBJECT_LOCK(eq);
+	for (i = 0; i < n_bands; i++) {
+		gdouble gain = CLAMP(gains[i], EQ_GAIN_MIN, EQ_GAIN_MAX);
+
+		if (eq->gains[i] != gain) {
+			eq->gains[i] = gain;
+			changed = TRUE;
+		}
+	}
+	if (changed)
+		_publish_gains(eq);
+	GST_OBJECT_UNLOCK(eq);
+}
+
+/*
+ * Switches to the band layout @layout.  Gains stay attached to band
+ * numbers, and the streaming thread ramps from the old filters to the new
+ * ones as for any other curve change.
+ */
+void mafw_gst_renderer_equalizer_set_layout(MafwGstRendererEqualizer *eq,
+					    const EqDspLayout *layout)
+{
+	g_return_if_fail(MAFW_IS_GST_RENDERER_EQUALIZER(eq));
+	g_return_if_fail(layout != NULL);
+	g_return_if_fail(layout->n_bands > 0 &&
+			 layout->n_bands <= EQ_DSP_MAX_BANDS);
+
+	GST_OBJECT_LOCK(eq);
+	if (!eq_layout_equal(&eq->layout, layout)) {
+		eq->layout = *layout;
+		_publish_gains(eq);
+	}
+	GST_OBJECT_UNLOCK(eq);
+}
+
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
@@ -0,0 +1,183 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef MAFW_GST_RENDERER_EQUALIZER_H
+#define MAFW_GST_RENDERER_EQUALIZER_H
+
+#include <gst/gst.h>
+#include <gst/audio/gstaudiofilter.h>
+
+#include "mafw-gst-renderer-equalizer-dsp.h"
+
+G_BEGIN_DECLS
+
+/*----------------------------------------------------------------------------
+  GObject type conversion macros
+  ----------------------------------------------------------------------------*/
+
+#define MAFW_TYPE_GST_RENDERER_EQUALIZER                \
+        (mafw_gst_renderer_equalizer_get_type())
+#define MAFW_GST_RENDERER_EQUALIZER(obj)                                \
+        (G_TYPE_CHECK_INSTANCE_CAST((obj), MAFW_TYPE_GST_RENDERER_EQUALIZER, \
+				    MafwGstRendererEqualizer))
+#define MAFW_IS_GST_RENDERER_EQUALIZER(obj)                             \
+        (G_TYPE_CHECK_INSTANCE_TYPE((obj), MAFW_TYPE_GST_RENDERER_EQUALIZER))
+#define MAFW_GST_RENDERER_EQUALIZER_CLASS(klass)                        \
+	(G_TYPE_CHECK_CLASS_CAST((klass), MAFW_TYPE_GST_RENDERER_EQUALIZER, \
+				 MafwGstRendererEqualizerClass))
+#define MAFW_IS_GST_RENDERER_EQUALIZER_CLASS(klass)                     \
+	(G_TYPE_CHECK_CLASS_TYPE((klass), MAFW_TYPE_GST_RENDERER_EQUALIZER))
+
+/*----------------------------------------------------------------------------
+  Type definitions
+  ----------------------------------------------------------------------------*/
+
+typedef struct _MafwGstRendererEqualizer MafwGstRendererEqualizer;
+typedef struct _MafwGstRendererEqualizerClass MafwGstRendererEqualizerClass;
+
+typedef void (*MafwGstRendererEqualizerProcessFunc)(
+	MafwGstRendererEqualizer *eq, guint8 *data, guint frames);
+
+/*
+ * The curve goes from the control threads (property setters) to the
+ * streaming thread without locks: setters write the new gains and layout
+ * into the spare slot of pub_gains and pub_layout and flip pub_index,
+ * bumping pub_seq before and after, seqlock style.  The streaming thread
+ * copies the published slot and drops the copy if pub_seq moved
+ * meanwhile; it retries on the next buffer, so it never waits.  At most
+ * one new curve is picked per buffer, which bounds the coefficient design
+ * cost whatever the update rate.
+ * Setters also design the coefficients of the curve for the negotiated
+ * rate and publish them along, so that the streaming thread does not go
+ * through the design cache and its lock; it only designs a curve itself
+ * when the rate changed after the curve was published.
+ *
+ * gains:          Last gains set, in dB.  Protected by the object lock,
+ *                 which only serializes the setters.
+ * layout:         Last band layout set.  Protected by the object lock.
+ * pub_gains:      Published gains, double buffered.
+ * pub_layout:     Published layouts, double buffered.
+ * pub_index:      Slot of pub_gains and pub_layout holding the last
+ *                 published curve.
+ * pub_seq:        Odd while a curve is being published.
+ * pub_bq:         Published coefficients, double buffered.
+ * pub_peak:       Peak gains of the published coefficients.
+ * pub_rate:       Rates the published coefficients were designed for, 0
+ *                 if they were not.
+ * design_rate:    Negotiated sample rate, for the setters to design for.
+ * ramp_time:      Length of the gain transitions, in milliseconds.
+ * fixed_point:    Whether int16 is run through the fixed point kernel and
+ *                 float caps are refused.
+ * auto_preamp:    Whether the coefficients are scaled down by the peak
+ *                 gain of the curve, so that boosts do not clip.
+ *
+ * The rest is only touched from the streaming thread:
+ *
+ * seen_seq:       pub_seq of the curve being rendered.
+ * active_gains:   Gains being rendered.
+ * active_layout:  Layout being rendered.
+ * active_bq:      Coefficients published with active_gains.
+ * active_peak:    Peak gain of active_bq.
+ * active_rate:    Rate active_bq was designed for.
+ * n_active:       Bands run by the kernels; bigger than the active layout
+ *                 while ramping out of a layout with more bands.  The
+ *                 coefficients past it are always the identity.
+ * flat:           Whether all the active gains are zero.
+ * bypass:         Whether the element is in passthrough because the curve
+ *                 is flat.
+ * need_design:    Whether the coefficients must be designed again without a
+ *                 ramp (i.e. the rate changed).
+ * rate:           Negotiated sample rate.
+ * coeffs:         Coefficients used for the next frames.
+ * ramp_from:      Coefficients at the start of the running ramp.
+ * ramp_to:        Coefficients for active_gains and active_layout.
+ * ramp_pos:       Frames already done of the running ramp.
+ * ramp_len:       Length of the running ramp in frames, 0 if none.
+ * state:          Filter history.
+ * process:        Kernel for the negotiated sample format.
+ * buffers_bypassed: Buffers passed through untouched.  Atomic.
+ * buffers_processed: Buffers run through the filters.  Atomic.
+ * buffers_skipped: Silent buffers left untouched, with a quiet history,
+ *                 while not in bypass.  Atomic.
+ */
+struct _MafwGstRendererEqualizer {
+	GstAudioFilter parent;
+
+	gdouble gains[EQ_DSP_MAX_BANDS];
+	EqDspLayout layout;
+	gdouble pub_gains[2][EQ_DSP_MAX_BANDS];
+	EqDspLayout pub_layout[2];
+	volatile gint pub_index;
+	volatile gint pub_seq;
+	EqDspBiquad pub_bq[2][EQ_DSP_MAX_BANDS];
+	gdouble pub_peak[2];
+	gint pub_rate[2];
+	volatile gint design_rate;
+	volatile gint ramp_time;
+	volatile gint fixed_point;
+	volatile gint auto_preamp;
+
+	gint seen_seq;
+	gdouble active_gains[EQ_DSP_MAX_BANDS];
+	EqDspLayout active_layout;
+	EqDspBiquad active_bq[EQ_DSP_MAX_BANDS];
+	gdouble active_peak;
+	gint active_rate;
+	gint n_active;
+	gboolean flat;
+	gboolean bypass;
+	gboolean need_design;
+	gint rate;
+
+	EqDspBiquad coeffs[EQ_DSP_MAX_BANDS];
+	EqDspBiquad ramp_from[EQ_DSP_MAX_BANDS];
+	EqDspBiquad ramp_to[EQ_DSP_MAX_BANDS];
+	guint ramp_pos;
+	guint ramp_len;
+	EqDspState state;
+	MafwGstRendererEqualizerProcessFunc process;
+
+	volatile guint buffers_bypassed;
+	volatile guint buffers_processed;
+	volatile guint buffers_skipped;
+};
+
+struct _MafwGstRendererEqualizerClass {
+	GstAudioFilterClass parent_class;
+};
+
+GType mafw_gst_renderer_equalizer_get_type(void);
+
+GstElement *mafw_gst_renderer_equalizer_new(void);
+
+void mafw_gst_renderer_equalizer_set_gains(MafwGstRendererEqualizer *eq,
+					   const gdouble *gains,
+					   gint n_bands);
+void mafw_gst_renderer_equalizer_set_layout(MafwGstRendererEqualizer *eq,
+					    const EqDspLayout *layout);
+
+G_END_DECLS
+
+#endif
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
@@ -0,0 +1,243 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Gain ramps for the renderer fader.
+ *
+ * A ramp goes linearly from one gain to another over a number of frames,
+ * every frame getting its own gain, and may start anywhere within a
+ * buffer.  Outside of a ramp the gain is constant, and unity gain leaves
+ * the samples untouched.
+ *
+ * Float samples are scaled with SSE2 or NEON when available, for mono and
+ * stereo; int16 samples go through a Q15 gain per frame.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+
+#include "mafw-gst-renderer-fader-dsp.h"
+
+#undef  G_LOG_DOMAIN
+#define G_LOG_DOMAIN "mafw-gst-renderer-fader"
+
+#if defined(__SSE2__) && !defined(MAFW_GST_RENDERER_DISABLE_SIMD)
+# define EQ_FADER_SSE2 1
+# include <emmintrin.h>
+#elif defined(__ARM_NEON__) && !defined(MAFW_GST_RENDERER_DISABLE_SIMD)
+# define EQ_FADER_NEON 1
+# include <arm_neon.h>
+#endif
+
+/*----------------------------------------------------------------------------
+  Vector abstraction
+  ----------------------------------------------------------------------------*/
+
+#if defined(EQ_FADER_SSE2)
+
+#define EQ_FADER_LANES 4
+typedef __m128 eq_fader_vec;
+#define _vec_add(a, b)		_mm_add_ps((a), (b))
+#define _vec_mul(a, b)		_mm_mul_ps((a), (b))
+#define _vec_set1(x)		_mm_set1_ps(x)
+#define _vec_load(p)		_mm_loadu_ps(p)
+#define _vec_store(p, v)	_mm_storeu_ps((p), (v))
+
+#elif defined(EQ_FADER_NEON)
+
+#define EQ_FADER_LANES 4
+typedef float32x4_t eq_fader_vec;
+#define _vec_add(a, b)		vaddq_f32((a), (b))
+#define _vec_mul(a, b)		vmulq_f32((a), (b))
+#define _vec_set1(x)		vdupq_n_f32(x)
+#define _vec_load(p)		vld1q_f32(p)
+#define _vec_store(p, v)	vst1q_f32((p), (v))
+
+#else
+
+#define EQ_FADER_LANES 1
+
+#endif
+
+/*----------------------------------------------------------------------------
+  Kernels
+  ----------------------------------------------------------------------------*/
+
+/* Scales @frames interleaved frames of @data, frame i by gain + i * step */
+void eq_fader_ramp_float(gfloat *data, gint channels, gint frames,
+			 gfloat gain, gfloat step)
+{
+	gint i = 0, c, k;
+
+#if EQ_FADER_LANES > 1
+	if (channels <= 2) {
+		const gint per = EQ_FADER_LANES / channels;
+		gfloat lanes[EQ_FADER_LANES];
+		eq_fader_vec g, inc;
+		gint end, l;
+
+		inc = _vec_set1(step * per);
+		while (i + per <= frames) {
+			end = MIN(frames, i + EQ_FADER_CHUNK);
+			end -= (end - i) % per;
+
+			for (l = 0; l < EQ_FADER_LANES; l++)
+				lanes[l] = gain + step * (i + l / channels);
+			g = _vec_load(lanes);
+
+			for (k = i * channels; i < end;
+			     i += per, k += EQ_FADER_LANES) {
+				_vec_store(data + k,
+					   _vec_mul(_vec_load(data + k), g));
+				g = _vec_add(g, inc);
+			}
+		}
+	}
+#endif
+	for (k = i * channels; i < frames; i++) {
+		gfloat g = gain + step * i;
+
+		for (c = 0; c < channels; c++, k++)
+			data[k] *= g;
+	}
+}
+
+/* As eq_fader_ramp_float(), for int16 samples */
+void eq_fader_ramp_s16(gint16 *data, gint channels, gint frames,
+		       gfloat gain, gfloat step)
+{
+	gint i, c, k;
+	gint32 q, v;
+
+	for (i = 0, k = 0; i < frames; i++) {
+		q = (gint32) lrintf(CLAMP(gain + step * i, 0.0f, 1.0f) *
+				    32768.0f);
+		for (c = 0; c < channels; c++, k++) {
+			v = (data[k] * q + (1 << 14)) >> 15;
+			data[k] = (gint16) CLAMP(v, G_MININT16, G_MAXINT16);
+		}
+	}
+}
+
+/*----------------------------------------------------------------------------
+  State
+  ----------------------------------------------------------------------------*/
+
+void eq_fader_init(EqFader *fader, gint channels)
+{
+	fader->channels = channels;
+	fader->gain = 1.0f;
+	fader->from = 1.0f;
+	fader->to = 1.0f;
+	fader->pos = 0;
+	fader->len = 0;
+}
+
+/* Starts a ramp of @len frames from @from to @to, the next frame being
+ * frame @pos of the ramp.  @pos may be negative, for a ramp starting
+ * further on, or beyond @len, for one already over */
+void eq_fader_start(EqFader *fader, gfloat from, gfloat to, gint64 pos,
+		    gint64 len)
+{
+	fader->from = from;
+	fader->to = to;
+	fader->pos = pos;
+	fader->len = len;
+
+	if (len <= 0 || pos >= len) {
+		fader->gain = to;
+		fader->len = 0;
+	} else if (pos < 0) {
+		/* Frames before the ramp already have its first gain */
+		fader->gain = from;
+	}
+}
+
+/*----------------------------------------------------------------------------
+  Processing
+  ----------------------------------------------------------------------------*/
+
+static gboolean _process(EqFader *fader, gpointer data, gint frames,
+			 gboolean is_s16)
+{
+	const gint channels = fader->channels;
+	gboolean touched = FALSE;
+	gfloat gain, step;
+	gint n;
+
+	for (; frames > 0; frames -= n) {
+		if (fader->len > 0 && fader->pos >= 0) {
+			n = (gint) MIN(frames, fader->len - fader->pos);
+			step = (fader->to - fader->from) / fader->len;
+			gain = fader->from + step * fader->pos;
+			fader->pos += n;
+			if (fader->pos >= fader->len) {
+				fader->gain = fader->to;
+				fader->len = 0;
+			}
+		} else {
+			n = frames;
+			if (fader->len > 0) {
+				n = (gint) MIN(frames, -fader->pos);
+				fader->pos += n;
+			}
+			gain = fader->gain;
+			step = 0.0f;
+			if (gain == 1.0f)
+				goto next;
+		}
+
+		if (is_s16) {
+			eq_fader_ramp_s16(data, channels, n, gain, step);
+		} else {
+			eq_fader_ramp_float(data, channels, n, gain, step);
+		}
+		touched = TRUE;
+
+	next:
+		data = (guint8 *) data +
+			n * channels * (is_s16 ? sizeof(gint16) :
+					sizeof(gfloat));
+	}
+
+	return touched;
+}
+
+/* Applies the gains to @frames interleaved frames of @data in place.
+ * Returns whether the samples had to be touched */
+gboolean eq_fader_process_float(EqFader *fader, gfloat *data, gint frames)
+{
+	return _process(fader, data, frames, FALSE);
+}
+
+/* As eq_fader_process_float(), for int16 samples */
+gboolean eq_fader_process_s16(EqFader *fader, gint16 *data, gint frames)
+{
+	return _process(fader, data, frames, TRUE);
+}
+
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
@@ -0,0 +1,67 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef MAFW_GST_RENDERER_FADER_DSP_H
+#define MAFW_GST_RENDERER_FADER_DSP_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Frames whose gains are worked out from the ramp start rather than from
+ * the previous frame, so rounding errors do not build up */
+#define EQ_FADER_CHUNK 64
+
+/* Streaming state of a gain ramp.
+ *
+ * gain:           Gain applied outside of a ramp.
+ * from, to:       Gains at the first and past the last frame of the ramp.
+ * pos:            Frames into the ramp, negative while it is still to
+ *                 start.
+ * len:            Length of the ramp in frames, 0 if there is none.
+ */
+typedef struct {
+	gint channels;
+	gfloat gain;
+	gfloat from;
+	gfloat to;
+	gint64 pos;
+	gint64 len;
+} EqFader;
+
+void eq_fader_init(EqFader *fader, gint channels);
+void eq_fader_start(EqFader *fader, gfloat from, gfloat to, gint64 pos,
+		    gint64 len);
+gboolean eq_fader_process_float(EqFader *fader, gfloat *data, gint frames);
+gboolean eq_fader_process_s16(EqFader *fader, gint16 *data, gint frames);
+
+void eq_fader_ramp_float(gfloat *data, gint channels, gint frames,
+			 gfloat gain, gfloat step);
+void eq_fader_ramp_s16(gint16 *data, gint channels, gint frames,
+		       gfloat gain, gfloat step);
+
+G_END_DECLS
+
+#endif
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
@@ -0,0 +1,343 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Gain stage at the tail of the renderer audio bin, fading the stream in
+ * and out for crossfades.  A ramp is asked for from the main thread and
+ * picked up by the streaming thread on the next buffer; its start is a
+ * stream time, so it falls on the same sample whatever the buffering, and
+ * every sample of it gets its own gain.  At unity gain buffers go out
+ * untouched.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mafw-gst-renderer-fader.h"
+
+#undef  G_LOG_DOMAIN
+#define G_LOG_DOMAIN "mafw-gst-renderer-fader"
+
+GST_DEBUG_CATEGORY_STATIC(fader_debug);
+#define GST_CAT_DEFAULT fader_debug
+
+#define ALLOWED_CAPS							\
+	"audio/x-raw-int, "						\
+	"depth = (int) 16, "						\
+	"width = (int) 16, "						\
+	"endianness = (int) BYTE_ORDER, "				\
+	"signed = (boolean) TRUE, "					\
+	"rate = (int) [ 1, MAX ], "					\
+	"channels = (int) [ 1, 8 ]; "					\
+	"audio/x-raw-float, "						\
+	"width = (int) 32, "						\
+	"endianness = (int) BYTE_ORDER, "				\
+	"rate = (int) [ 1, MAX ], "					\
+	"channels = (int) [ 1, 8 ]"
+
+#define DEFAULT_GAIN		1.0
+
+enum {
+	PROP_0,
+	PROP_GAIN,
+	PROP_BUFFERS_FADED,
+};
+
+GST_BOILERPLATE(MafwGstRendererFader, mafw_gst_renderer_fader,
+		GstAudioFilter, GST_TYPE_AUDIO_FILTER);
+
+/*----------------------------------------------------------------------------
+  Processing
+  ----------------------------------------------------------------------------*/
+
+/* Gain of the next frame */
+static gfloat _current_gain(const EqFader *fader)
+{
+	if (fader->len > 0 && fader->pos >= 0)
+		return fader->from +
+			(fader->to - fader->from) * fader->pos / fader->len;
+	return fader->gain;
+}
+
+/* Frames from @from to @to, negative if @to comes first */
+static gint64 _frames_between(GstClockTime from, GstClockTime to, gint rate)
+{
+	if (to >= from)
+		return gst_util_uint64_scale_int(to - from, rate, GST_SECOND);
+	else
+		return -(gint64) gst_util_uint64_scale_int(from - to, rate,
+							   GST_SECOND);
+}
+
+/* Starts the ramp asked for, if there is one and the lock is free.  @buf
+ * is the next buffer, which the ramp start is measured from */
+static void _pick_ramp(MafwGstRendererFader *fader, GstBuffer *buf)
+{
+	GstBaseTransform *base = GST_BASE_TRANSFORM(fader);
+	GstClockTime start, duration, now;
+	gdouble from, to;
+	gint64 pos;
+
+	if (!g_atomic_int_get(&fader->ramp_changed) ||
+	    !GST_OBJECT_TRYLOCK(fader))
+		return;
+
+	from = fader->ramp_from;
+	to = fader->gain;
+	start = fader->ramp_start;
+	duration = fader->ramp_duration;
+	g_atomic_int_set(&fader->ramp_changed, 0);
+	GST_OBJECT_UNLOCK(fader);
+
+	if (from < 0.0)
+		from = _current_gain(&fader->fader);
+
+	pos = 0;
+	if (GST_CLOCK_TIME_IS_VALID(start) &&
+	    GST_BUFFER_TIMESTAMP_IS_VALID(buf)) {
+		now = gst_segment_to_stream_time(&base->segment,
+						 GST_FORMAT_TIME,
+						 GST_BUFFER_TIMESTAMP(buf));
+		if (GST_CLOCK_TIME_IS_VALID(now))
+			pos = _frames_between(start, now, fader->rate);
+	}
+
+	GST_DEBUG_OBJECT(fader, "ramp from %f to %f, %" G_GINT64_FORMAT
+			 " frames in", from, to, pos);
+	eq_fader_start(&fader->fader, from, to, pos,
+		       gst_util_uint64_scale_int(duration, fader->rate,
+						 GST_SECOND));
+}
+
+static gboolean _setup(GstAudioFilter *filter, GstRingBufferSpec *fmt)
+{
+	MafwGstRendererFader *fader = MAFW_GST_RENDERER_FADER(filter);
+
+	if (fmt->type == GST_BUFTYPE_LINEAR && fmt->width == 16) {
+		fader->is_s16 = TRUE;
+	} else if (fmt->type == GST_BUFTYPE_FLOAT && fmt->width == 32) {
+		fader->is_s16 = FALSE;
+	} else {
+		return FALSE;
+	}
+
+	/* A ramp under way is cut short; one not picked up yet still
+	 * starts where it was asked to */
+	eq_fader_init(&fader->fader, fmt->channels);
+	GST_OBJECT_LOCK(fader);
+	fader->fader.gain = fader->gain;
+	GST_OBJECT_UNLOCK(fader);
+	fader->rate = fmt->rate;
+
+	return TRUE;
+}
+
+static GstFlowReturn _transform_ip(GstBaseTransform *base, GstBuffer *buf)
+{
+	MafwGstRendererFader *fader = MAFW_GST_RENDERER_FADER(base);
+	guint frame_size;
+	gboolean faded;
+
+	if (G_UNLIKELY(fader->rate == 0))
+		return GST_FLOW_NOT_NEGOTIATED;
+
+	_pick_ramp(fader, buf);
+
+	frame_size = fader->fader.channels * (fader->is_s16 ? 2 : 4);
+	if (fader->is_s16) {
+		faded = eq_fader_process_s16(&fader->fader,
+					     (gint16 *) GST_BUFFER_DATA(buf),
+					     GST_BUFFER_SIZE(buf) / frame_size);
+	} else {
+		faded = eq_fader_process_float(&fader->fader,
+					       (gfloat *) GST_BUFFER_DATA(buf),
+					       GST_BUFFER_SIZE(buf) /
+					       frame_size);
+	}
+	if (faded)
+		g_atomic_int_inc(&fader->buffers_faded);
+
+	return GST_FLOW_OK;
+}
+
+static gboolean _stop(GstBaseTransform *base)
+{
+	MafwGstRendererFader *fader = MAFW_GST_RENDERER_FADER(base);
+
+	fader->rate = 0;
+
+	return TRUE;
+}
+
+/*----------------------------------------------------------------------------
+  Ramps
+  ----------------------------------------------------------------------------*/
+
+/**
+ * mafw_gst_renderer_fader_ramp:
+ * @fader: A #MafwGstRendererFader.
+ * @from:  Gain at the start of the ramp, or a negative value for the gain
+ *         the stream is at.
+ * @to:    Gain at the end of the ramp, and from then on.
+ * @start: Stream time of the first sample of the ramp, or
+ *         GST_CLOCK_TIME_NONE for the next one going through.
+ * @duration: Length of the ramp.
+ *
+ * Makes the gain go linearly from @from to @to.  Samples before @start get
+ * @from, so a ramp may be set up ahead of the stream reaching it; if
+ * @start has already gone by, the ramp is joined where it would be by now.
+ * The ramp replaces any other under way.
+ */
+void mafw_gst_renderer_fader_ramp(MafwGstRendererFader *fader,
+				  gdouble from, gdouble to,
+				  GstClockTime start, GstClockTime duration)
+{
+	g_return_if_fail(MAFW_IS_GST_RENDERER_FADER(fader));
+
+	GST_OBJECT_LOCK(fader);
+	fader->gain = CLAMP(to, 0.0, 1.0);
+	fader->ramp_from = from < 0.0 ? -1.0 : MIN(from, 1.0);
+	fader->ramp_start = start;
+	fader->ramp_duration = duration;
+	g_atomic_int_set(&fader->ramp_changed, 1);
+	GST_OBJECT_UNLOCK(fader);
+}
+
+/*----------------------------------------------------------------------------
+  Properties
+  ----------------------------------------------------------------------------*/
+
+static void _set_property(GObject *object, guint prop_id,
+			  const GValue *value, GParamSpec *pspec)
+{
+	MafwGstRendererFader *fader = MAFW_GST_RENDERER_FADER(object);
+
+	switch (prop_id) {
+	case PROP_GAIN:
+		mafw_gst_renderer_fader_ramp(fader, -1.0,
+					     g_value_get_double(value),
+					     GST_CLOCK_TIME_NONE, 0);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+		break;
+	}
+}
+
+static void _get_property(GObject *object, guint prop_id,
+			  GValue *value, GParamSpec *pspec)
+{
+	MafwGstRendererFader *fader = MAFW_GST_RENDERER_FADER(object);
+
+	switch (prop_id) {
+	case PROP_GAIN:
+		GST_OBJECT_LOCK(fader);
+		g_value_set_double(value, fader->gain);
+		GST_OBJECT_UNLOCK(fader);
+		break;
+	case PROP_BUFFERS_FADED:
+		g_value_set_uint(value,
+				 g_atomic_int_get(&fader->buffers_faded));
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+		break;
+	}
+}
+
+/*----------------------------------------------------------------------------
+  GObject initialization
+  ----------------------------------------------------------------------------*/
+
+static void mafw_gst_renderer_fader_base_init(gpointer g_class)
+{
+	GstElementClass *element_class = GST_ELEMENT_CLASS(g_class);
+	GstCaps *caps;
+
+	gst_element_class_set_details_simple(
+		element_class,
+		"MAFW renderer fader",
+		"Filter/Effect/Audio",
+		"Sample accurate gain ramps for crossfading tracks",
+		"Juan A. Suarez Romero <jasuarez@igalia.com>");
+
+	caps = gst_caps_from_string(ALLOWED_CAPS);
+	gst_audio_filter_class_add_pad_templates(GST_AUDIO_FILTER_CLASS(g_class),
+						 caps);
+	gst_caps_unref(caps);
+}
+
+static void mafw_gst_renderer_fader_class_init(
+	MafwGstRendererFaderClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+	GstBaseTransformClass *trans_class = GST_BASE_TRANSFORM_CLASS(klass);
+	GstAudioFilterClass *filter_class = GST_AUDIO_FILTER_CLASS(klass);
+
+	GST_DEBUG_CATEGORY_INIT(fader_debug, "mafw-gst-renderer-fader",
+				0, "MAFW renderer fader");
+
+	gobject_class->set_property = _set_property;
+	gobject_class->get_property = _get_property;
+
+	g_object_class_install_property(
+		gobject_class, PROP_GAIN,
+		g_param_spec_double("gain", "Gain",
+				    "Linear gain, once any ramp is over",
+				    0.0, 1.0, DEFAULT_GAIN,
+				    G_PARAM_READWRITE));
+	g_object_class_install_property(
+		gobject_class, PROP_BUFFERS_FADED,
+		g_param_spec_uint("buffers-faded", "Buffers faded",
+				  "Buffers whose gain was not 1",
+				  0, G_MAXUINT, 0, G_PARAM_READABLE));
+
+	trans_class->stop = _stop;
+	trans_class->transform_ip = _transform_ip;
+	filter_class->setup = _setup;
+}
+
+static void mafw_gst_renderer_fader_init(MafwGstRendererFader *fader,
+					 MafwGstRendererFaderClass *klass)
+{
+	fader->gain = DEFAULT_GAIN;
+	fader->ramp_from = -1.0;
+	fader->ramp_start = GST_CLOCK_TIME_NONE;
+	fader->ramp_duration = 0;
+	fader->ramp_changed = 0;
+	eq_fader_init(&fader->fader, 1);
+	fader->rate = 0;
+	fader->is_s16 = TRUE;
+	fader->buffers_faded = 0;
+
+	gst_base_transform_set_in_place(GST_BASE_TRANSFORM(fader), TRUE);
+}
+
+GstElement *mafw_gst_renderer_fader_new(void)
+{
+	return GST_ELEMENT(g_object_new(MAFW_TYPE_GST_RENDERER_FADER, NULL));
+}
+
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
@@ -0,0 +1,109 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef MAFW_GST_RENDERER_FADER_H
+#define MAFW_GST_RENDERER_FADER_H
+
+#include <gst/gst.h>
+#include <gst/audio/gstaudiofilter.h>
+
+#include "mafw-gst-renderer-fader-dsp.h"
+
+G_BEGIN_DECLS
+
+/*----------------------------------------------------------------------------
+  GObject type conversion macros
+  ----------------------------------------------------------------------------*/
+
+#define MAFW_TYPE_GST_RENDERER_FADER                  \
+        (mafw_gst_renderer_fader_get_type())
+#define MAFW_GST_RENDERER_FADER(obj)                                  \
+        (G_TYPE_CHECK_INSTANCE_CAST((obj), MAFW_TYPE_GST_RENDERER_FADER, \
+				    MafwGstRendererFader))
+#define MAFW_IS_GST_RENDERER_FADER(obj)                               \
+        (G_TYPE_CHECK_INSTANCE_TYPE((obj), MAFW_TYPE_GST_RENDERER_FADER))
+#define MAFW_GST_RENDERER_FADER_CLASS(klass)                          \
+	(G_TYPE_CHECK_CLASS_CAST((klass), MAFW_TYPE_GST_RENDERER_FADER, \
+				 MafwGstRendererFaderClass))
+#define MAFW_IS_GST_RENDERER_FADER_CLASS(klass)                       \
+	(G_TYPE_CHECK_CLASS_TYPE((klass), MAFW_TYPE_GST_RENDERER_FADER))
+
+/*----------------------------------------------------------------------------
+  Type definitions
+  ----------------------------------------------------------------------------*/
+
+typedef struct _MafwGstRendererFader MafwGstRendererFader;
+typedef struct _MafwGstRendererFaderClass MafwGstRendererFaderClass;
+
+/*
+ * The following are protected by the object lock:
+ *
+ * gain:           Gain once the last ramp asked for is over.
+ * ramp_from:      Gain at the start of the ramp asked for, negative for
+ *                 the gain the stream is at.
+ * ramp_start:     Stream time the ramp starts at, GST_CLOCK_TIME_NONE for
+ *                 the next buffer.
+ * ramp_duration:  Length of the ramp, 0 for a gain change right away.
+ * ramp_changed:   Whether a ramp was asked for since the streaming thread
+ *                 last read it.  Atomic, so the streaming thread can check
+ *                 it without the lock.
+ *
+ * The rest is only touched from the streaming thread:
+ *
+ * fader:          Ramp state.
+ * rate:           Negotiated sample rate, 0 before negotiation.
+ * is_s16:         Whether samples are int16 rather than float.
+ * buffers_faded:  Buffers whose gain was not 1.  Atomic.
+ */
+struct _MafwGstRendererFader {
+	GstAudioFilter parent;
+
+	gdouble gain;
+	gdouble ramp_from;
+	GstClockTime ramp_start;
+	GstClockTime ramp_duration;
+	volatile gint ramp_changed;
+
+	EqFader fader;
+	gint rate;
+	gboolean is_s16;
+
+	volatile guint buffers_faded;
+};
+
+struct _MafwGstRendererFaderClass {
+	GstAudioFilterClass parent_class;
+};
+
+GType mafw_gst_renderer_fader_get_type(void);
+
+GstElement *mafw_gst_renderer_fader_new(void);
+void mafw_gst_renderer_fader_ramp(MafwGstRendererFader *fader,
+				  gdouble from, gdouble to,
+				  GstClockTime start, GstClockTime duration);
+
+G_END_DECLS
+
+#endif
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
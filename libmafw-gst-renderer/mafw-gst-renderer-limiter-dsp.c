@@ -0,0 +1,348 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Lookahead peak limiter for the renderer limiter.
+ *
+ * Every frame gets the gain r that brings its loudest channel down to the
+ * threshold (1 if it is already below).  The minimum of r over the last
+ * L + 1 frames, L being the lookahead, goes through an instant attack and
+ * exponential release, and the result is averaged over the last L + 1
+ * frames again.  The average is applied to the input of L frames ago: all
+ * the values averaged are at most the gain that frame needs, so no sample
+ * gets out above the threshold, and the gain moves smoothly towards it
+ * over the whole lookahead instead of jumping.
+ *
+ * The delay line is swapped with the buffer in place, and the absolute
+ * value and gain passes work on whole chunks of samples, with SSE2 or NEON
+ * when available.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "mafw-gst-renderer-limiter-dsp.h"
+
+#undef  G_LOG_DOMAIN
+#define G_LOG_DOMAIN "mafw-gst-renderer-limiter"
+
+#if defined(__SSE2__) && !defined(MAFW_GST_RENDERER_DISABLE_SIMD)
+# define EQ_LIMITER_SSE2 1
+# include <emmintrin.h>
+#elif defined(__ARM_NEON__) && !defined(MAFW_GST_RENDERER_DISABLE_SIMD)
+# define EQ_LIMITER_NEON 1
+# include <arm_neon.h>
+#endif
+
+/*----------------------------------------------------------------------------
+  Vector abstraction
+  ----------------------------------------------------------------------------*/
+
+#if defined(EQ_LIMITER_SSE2)
+
+#define EQ_LIMITER_LANES 4
+typedef __m128 eq_limiter_vec;
+#define _vec_mul(a, b)		_mm_mul_ps((a), (b))
+#define _vec_abs(a)		_mm_andnot_ps(_mm_set1_ps(-0.0f), (a))
+#define _vec_load(p)		_mm_loadu_ps(p)
+#define _vec_store(p, v)	_mm_storeu_ps((p), (v))
+
+#elif defined(EQ_LIMITER_NEON)
+
+#define EQ_LIMITER_LANES 4
+typedef float32x4_t eq_limiter_vec;
+#define _vec_mul(a, b)		vmulq_f32((a), (b))
+#define _vec_abs(a)		vabsq_f32(a)
+#define _vec_load(p)		vld1q_f32(p)
+#define _vec_store(p, v)	vst1q_f32((p), (v))
+
+#else
+
+#define EQ_LIMITER_LANES 1
+
+#endif
+
+/*----------------------------------------------------------------------------
+  State
+  ----------------------------------------------------------------------------*/
+
+EqLimiter *eq_limiter_new(gint channels, gint lookahead)
+{
+	EqLimiter *lim;
+
+	g_return_val_if_fail(channels > 0, NULL);
+	g_return_val_if_fail(lookahead > 0 &&
+			     lookahead <= EQ_LIMITER_MAX_LOOKAHEAD, NULL);
+
+	lim = g_new0(EqLimiter, 1);
+	lim->channels = channels;
+	lim->lookahead = lookahead;
+	lim->threshold = 1.0f;
+	lim->release = 1.0f;
+
+	lim->delay = g_new(gfloat, lookahead * channels);
+	lim->win_gain = g_new(gfloat, lookahead + 1);
+	lim->win_frame = g_new(guint, lookahead + 1);
+	lim->hist = g_new(gfloat, lookahead + 1);
+	lim->gains = g_new(gfloat, EQ_LIMITER_CHUNK);
+	lim->scratch = g_new(gfloat, EQ_LIMITER_CHUNK * channels);
+	lim->convert = g_new(gfloat, EQ_LIMITER_CHUNK * channels);
+
+	eq_limiter_reset(lim);
+
+	return lim;
+}
+
+void eq_limiter_free(EqLimiter *lim)
+{
+	if (!lim)
+		return;
+
+	g_free(lim->delay);
+	g_free(lim->win_gain);
+	g_free(lim->win_frame);
+	g_free(lim->hist);
+	g_free(lim->gains);
+	g_free(lim->scratch);
+	g_free(lim->convert);
+	g_free(lim);
+}
+
+/* Clears the history, as if silence had been played for ever */
+void eq_limiter_reset(EqLimiter *lim)
+{
+	gint i;
+
+	memset(lim->delay, 0, lim->lookahead * lim->channels * sizeof(gfloat));
+	lim->pos = 0;
+	lim->win_head = 0;
+	lim->win_len = 0;
+	lim->frame = 0;
+	lim->env = 1.0f;
+	for (i = 0; i <= lim->lookahead; i++)
+		lim->hist[i] = 1.0f;
+	lim->hist_pos = 0;
+}
+
+/* Sets the highest level let out, in dBFS */
+void eq_limiter_set_threshold(EqLimiter *lim, gdouble db)
+{
+	lim->threshold = pow(10.0, MIN(db, 0.0) / 20.0);
+}
+
+/* Sets the time constant of the gain going back up, in milliseconds */
+void eq_limiter_set_release(EqLimiter *lim, gdouble ms, gint rate)
+{
+	if (ms <= 0.0 || rate <= 0)
+		lim->release = 1.0f;
+	else
+		lim->release = 1.0 - exp(-1000.0 / (ms * rate));
+}
+
+/*----------------------------------------------------------------------------
+  Processing
+  ----------------------------------------------------------------------------*/
+
+/* Stores in scratch the absolute value of the @n samples of @data */
+static void _abs(EqLimiter *lim, const gfloat *data, gint n)
+{
+	gint i = 0;
+
+#if EQ_LIMITER_LANES > 1
+	for (; i + EQ_LIMITER_LANES <= n; i += EQ_LIMITER_LANES)
+		_vec_store(lim->scratch + i, _vec_abs(_vec_load(data + i)));
+#endif
+	for (; i < n; i++)
+		lim->scratch[i] = fabsf(data[i]);
+}
+
+/* Computes into gains the gain of the @frames frames going out for the
+ * @frames frames of @data coming in.  Returns the smallest one */
+static gfloat _gains(EqLimiter *lim, const gfloat *data, gint frames)
+{
+	const gint channels = lim->channels;
+	const gint size = lim->lookahead + 1;
+	const gfloat scale = 1.0f / size;
+	gdouble sum = 0.0;
+	gfloat peak, r, min = 1.0f;
+	gint i, c, tail;
+
+	_abs(lim, data, frames * channels);
+
+	/* Summed again every chunk, so rounding errors do not build up */
+	for (i = 0; i < size; i++)
+		sum += lim->hist[i];
+
+	for (i = 0; i < frames; i++) {
+		peak = lim->scratch[i * channels];
+		for (c = 1; c < channels; c++)
+			peak = MAX(peak, lim->scratch[i * channels + c]);
+		r = peak > lim->threshold ? lim->threshold / peak : 1.0f;
+
+		/* Running minimum of r over the window */
+		while (lim->win_len > 0) {
+			tail = (lim->win_head + lim->win_len - 1) % size;
+			if (lim->win_gain[tail] < r)
+				break;
+			lim->win_len--;
+		}
+		tail = (lim->win_head + lim->win_len) % size;
+		lim->win_gain[tail] = r;
+		lim->win_frame[tail] = lim->frame;
+		lim->win_len++;
+		if (lim->frame - lim->win_frame[lim->win_head] >=
+		    (guint) size) {
+			lim->win_head = (lim->win_head + 1) % size;
+			lim->win_len--;
+		}
+		lim->frame++;
+
+		r = lim->win_gain[lim->win_head];
+		if (r < lim->env)
+			lim->env = r;
+		else
+			lim->env += (r - lim->env) * lim->release;
+
+		sum += lim->env - lim->hist[lim->hist_pos];
+		lim->hist[lim->hist_pos] = lim->env;
+		if (++lim->hist_pos == size)
+			lim->hist_pos = 0;
+
+		lim->gains[i] = MIN((gfloat) sum * scale, 1.0f);
+		min = MIN(min, lim->gains[i]);
+	}
+
+	return min;
+}
+
+/* Swaps the @frames frames of @data with the delay line, applying gains to
+ * the ones going out.  If @unity, gains are all 1 and are not applied */
+static void _apply(EqLimiter *lim, gfloat *data, gint frames,
+		   gboolean unity)
+{
+	const gint channels = lim->channels;
+	gfloat *delay, tmp;
+	gint i, j, k, run, n;
+
+	for (j = 0; j < frames; j += run) {
+		run = MIN(frames - j, lim->lookahead - lim->pos);
+		n = run * channels;
+		delay = lim->delay + lim->pos * channels;
+
+		if (unity) {
+			for (i = 0; i < n; i++) {
+				tmp = data[i];
+				data[i] = delay[i];
+				delay[i] = tmp;
+			}
+		} else {
+			/* Gains spread to every sample, so the products
+			 * vectorize whatever the number of channels */
+			for (i = 0, k = 0; i < run; i++) {
+				gint c;
+
+				for (c = 0; c < channels; c++)
+					lim->scratch[k++] = lim->gains[j + i];
+			}
+
+			i = 0;
+#if EQ_LIMITER_LANES > 1
+			for (; i + EQ_LIMITER_LANES <= n;
+			     i += EQ_LIMITER_LANES) {
+				eq_limiter_vec a, d;
+
+				a = _vec_load(data + i);
+				d = _vec_load(delay + i);
+				_vec_store(delay + i, a);
+				_vec_store(data + i,
+					   _vec_mul(d,
+						    _vec_load(lim->scratch +
+							      i)));
+			}
+#endif
+			for (; i < n; i++) {
+				tmp = data[i];
+				data[i] = delay[i] * lim->scratch[i];
+				delay[i] = tmp;
+			}
+		}
+
+		data += n;
+		lim->pos += run;
+		if (lim->pos == lim->lookahead)
+			lim->pos = 0;
+	}
+}
+
+/* Limits @frames interleaved frames of @data in place.  Returns whether
+ * the gain went below 1 */
+gboolean eq_limiter_process_float(EqLimiter *lim, gfloat *data,
+				  gint frames)
+{
+	gfloat min = 1.0f, g;
+	gint n;
+
+	for (; frames > 0; frames -= n) {
+		n = MIN(frames, EQ_LIMITER_CHUNK);
+		g = _gains(lim, data, n);
+		_apply(lim, data, n, g >= 1.0f);
+		min = MIN(min, g);
+		data += n * lim->channels;
+	}
+
+	return min < 1.0f;
+}
+
+/* Limits @frames interleaved int16 frames of @data in place, going through
+ * float one chunk at a time.  Returns whether the gain went below 1 */
+gboolean eq_limiter_process_s16(EqLimiter *lim, gint16 *data, gint frames)
+{
+	gfloat *tmp = lim->convert, min = 1.0f, g;
+	gint i, n, samples;
+
+	for (; frames > 0; frames -= n) {
+		n = MIN(frames, EQ_LIMITER_CHUNK);
+		samples = n * lim->channels;
+		for (i = 0; i < samples; i++)
+			tmp[i] = data[i] * (1.0f / 32768.0f);
+
+		g = _gains(lim, tmp, n);
+		_apply(lim, tmp, n, g >= 1.0f);
+		min = MIN(min, g);
+
+		for (i = 0; i < samples; i++) {
+			data[i] = (gint16) CLAMP(lrintf(tmp[i] * 32768.0f),
+						 G_MININT16, G_MAXINT16);
+		}
+		data += samples;
+	}
+
+	return min < 1.0f;
+}
+
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
@@ -0,0 +1,94 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef MAFW_GST_RENDERER_LIMITER_DSP_H
+#define MAFW_GST_RENDERER_LIMITER_DSP_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Longest lookahead, in frames */
+#define EQ_LIMITER_MAX_LOOKAHEAD 1024
+
+/* Frames whose gains are computed in one go */
+#define EQ_LIMITER_CHUNK 256
+
+/* Streaming state of a lookahead peak limiter.  Samples are delayed by
+ * lookahead frames, so the gain can come down before a peak gets out.
+ *
+ * threshold:      Highest absolute sample value let out, linear.
+ * release:        Fraction of the distance to the target gain recovered
+ *                 every frame.
+ * delay:          Last lookahead frames of input, a ring of interleaved
+ *                 frames.
+ * pos:            Frame of delay holding the oldest input.
+ * win_gain, win_frame: Monotonic deque of the gains needed by the last
+ *                 lookahead + 1 frames, for their running minimum; a ring
+ *                 of lookahead + 1 entries starting at win_head.
+ * frame:          Number of frames fed in, wrapping around.
+ * env:            Gain after the release.
+ * hist:           Last lookahead + 1 values of env, a ring at hist_pos;
+ *                 their average is the gain applied.
+ * gains:          Gain of each frame of the chunk.
+ * scratch:        One chunk of samples.
+ * convert:        One chunk of int16 samples turned into float.
+ */
+typedef struct {
+	gint channels;
+	gint lookahead;
+	gfloat threshold;
+	gfloat release;
+
+	gfloat *delay;
+	gint pos;
+
+	gfloat *win_gain;
+	guint *win_frame;
+	gint win_head;
+	gint win_len;
+	guint frame;
+
+	gfloat env;
+	gfloat *hist;
+	gint hist_pos;
+
+	gfloat *gains;
+	gfloat *scratch;
+	gfloat *convert;
+} EqLimiter;
+
+EqLimiter *eq_limiter_new(gint channels, gint lookahead);
+void eq_limiter_free(EqLimiter *lim);
+void eq_limiter_reset(EqLimiter *lim);
+void eq_limiter_set_threshold(EqLimiter *lim, gdouble db);
+void eq_limiter_set_release(EqLimiter *lim, gdouble ms, gint rate);
+gboolean eq_limiter_process_float(EqLimiter *lim, gfloat *data,
+				  gint frames);
+gboolean eq_limiter_process_s16(EqLimiter *lim, gint16 *data, gint frames);
+
+G_END_DECLS
+
+#endif
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
@@ -0,0 +1,363 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Lookahead peak limiter, the last stage of the renderer audio bin.  The
+ * equalizer and the convolver scale their curves down by their peak gain,
+ * but a boosted band can still push a loud recording over full scale; this
+ * catches what is left, turning the gain down smoothly before each peak
+ * instead of letting the sink clip it.
+ *
+ * The signal is delayed by the lookahead, LOOKAHEAD_MS.  The work per
+ * buffer is linear in its length whatever the signal, and once a whole
+ * lookahead of silence has gone through, silent buffers go out untouched.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mafw-gst-renderer-limiter.h"
+#include "mafw-gst-renderer-equalizer-dsp.h"
+
+#undef  G_LOG_DOMAIN
+#define G_LOG_DOMAIN "mafw-gst-renderer-limiter"
+
+GST_DEBUG_CATEGORY_STATIC(limiter_debug);
+#define GST_CAT_DEFAULT limiter_debug
+
+#define ALLOWED_CAPS							\
+	"audio/x-raw-int, "						\
+	"depth = (int) 16, "						\
+	"width = (int) 16, "						\
+	"endianness = (int) BYTE_ORDER, "				\
+	"signed = (boolean) TRUE, "					\
+	"rate = (int) [ 1, MAX ], "					\
+	"channels = (int) [ 1, 8 ]; "					\
+	"audio/x-raw-float, "						\
+	"width = (int) 32, "						\
+	"endianness = (int) BYTE_ORDER, "				\
+	"rate = (int) [ 1, MAX ], "					\
+	"channels = (int) [ 1, 8 ]"
+
+#define LOOKAHEAD_MS		2
+#define DEFAULT_THRESHOLD	-0.3
+#define MIN_THRESHOLD		-24.0
+#define DEFAULT_RELEASE_TIME	50
+#define MAX_RELEASE_TIME	1000
+
+enum {
+	PROP_0,
+	PROP_THRESHOLD,
+	PROP_RELEASE_TIME,
+	PROP_BUFFERS_LIMITED,
+	PROP_BUFFERS_SKIPPED,
+};
+
+GST_BOILERPLATE(MafwGstRendererLimiter, mafw_gst_renderer_limiter,
+		GstAudioFilter, GST_TYPE_AUDIO_FILTER);
+
+/*----------------------------------------------------------------------------
+  Processing
+  ----------------------------------------------------------------------------*/
+
+/* Applies new settings if there are some and the lock is free */
+static void _pick_params(MafwGstRendererLimiter *limiter, gboolean force)
+{
+	if (!force && !g_atomic_int_get(&limiter->params_changed))
+		return;
+
+	if (force)
+		GST_OBJECT_LOCK(limiter);
+	else if (!GST_OBJECT_TRYLOCK(limiter))
+		return;
+
+	eq_limiter_set_threshold(limiter->lim, limiter->threshold);
+	eq_limiter_set_release(limiter->lim, limiter->release_time,
+			       limiter->rate);
+	g_atomic_int_set(&limiter->params_changed, 0);
+	GST_OBJECT_UNLOCK(limiter);
+}
+
+static gboolean _setup(GstAudioFilter *filter, GstRingBufferSpec *fmt)
+{
+	MafwGstRendererLimiter *limiter = MAFW_GST_RENDERER_LIMITER(filter);
+	gint lookahead;
+
+	if (fmt->type == GST_BUFTYPE_LINEAR && fmt->width == 16) {
+		limiter->is_s16 = TRUE;
+	} else if (fmt->type == GST_BUFTYPE_FLOAT && fmt->width == 32) {
+		limiter->is_s16 = FALSE;
+	} else {
+		return FALSE;
+	}
+
+	lookahead = CLAMP(fmt->rate * LOOKAHEAD_MS / 1000, 1,
+			  EQ_LIMITER_MAX_LOOKAHEAD);
+
+	/* Negotiation is the one place where the streaming thread
+	 * allocates */
+	if (!limiter->lim || limiter->lim->channels != fmt->channels ||
+	    limiter->lim->lookahead != lookahead) {
+		eq_limiter_free(limiter->lim);
+		limiter->lim = eq_limiter_new(fmt->channels, lookahead);
+	}
+
+	limiter->rate = fmt->rate;
+	_pick_params(limiter, TRUE);
+
+	eq_limiter_reset(limiter->lim);
+	limiter->silent_frames = 0;
+	limiter->quiet = FALSE;
+
+	return TRUE;
+}
+
+static gboolean _is_silent(MafwGstRendererLimiter *limiter, GstBuffer *buf)
+{
+	if (GST_BUFFER_FLAG_IS_SET(buf, GST_BUFFER_FLAG_GAP))
+		return TRUE;
+
+	if (limiter->is_s16) {
+		return eq_dsp_is_silent_s16((gint16 *) GST_BUFFER_DATA(buf),
+					    GST_BUFFER_SIZE(buf) / 2);
+	} else {
+		return eq_dsp_is_silent_float((gfloat *) GST_BUFFER_DATA(buf),
+					      GST_BUFFER_SIZE(buf) / 4);
+	}
+}
+
+static GstFlowReturn _transform_ip(GstBaseTransform *base, GstBuffer *buf)
+{
+	MafwGstRendererLimiter *limiter = MAFW_GST_RENDERER_LIMITER(base);
+	guint frame_size, frames;
+	gboolean limited;
+
+	if (G_UNLIKELY(limiter->lim == NULL))
+		return GST_FLOW_NOT_NEGOTIATED;
+
+	_pick_params(limiter, FALSE);
+
+	frame_size = limiter->lim->channels * (limiter->is_s16 ? 2 : 4);
+	frames = GST_BUFFER_SIZE(buf) / frame_size;
+
+	if (!_is_silent(limiter, buf)) {
+		limiter->silent_frames = 0;
+		limiter->quiet = FALSE;
+	} else if (limiter->quiet ||
+		   limiter->silent_frames >= limiter->lim->lookahead) {
+		if (!limiter->quiet) {
+			/* The delay line only holds silence, but the gain
+			 * may still be down from the last peak */
+			eq_limiter_reset(limiter->lim);
+			limiter->quiet = TRUE;
+		}
+		g_atomic_int_inc(&limiter->buffers_skipped);
+		return GST_FLOW_OK;
+	} else {
+		limiter->silent_frames = MIN(limiter->silent_frames + frames,
+					     G_MAXINT / 2);
+	}
+
+	if (limiter->is_s16) {
+		limited = eq_limiter_process_s16(limiter->lim,
+						 (gint16 *) GST_BUFFER_DATA(buf),
+						 frames);
+	} else {
+		limited = eq_limiter_process_float(
+			limiter->lim, (gfloat *) GST_BUFFER_DATA(buf), frames);
+	}
+	if (limited)
+		g_atomic_int_inc(&limiter->buffers_limited);
+
+	return GST_FLOW_OK;
+}
+
+static gboolean _stop(GstBaseTransform *base)
+{
+	MafwGstRendererLimiter *limiter = MAFW_GST_RENDERER_LIMITER(base);
+
+	eq_limiter_free(limiter->lim);
+	limiter->lim = NULL;
+
+	return TRUE;
+}
+
+/*----------------------------------------------------------------------------
+  Properties
+  ----------------------------------------------------------------------------*/
+
+static void _set_property(GObject *object, guint prop_id,
+			  const GValue *value, GParamSpec *pspec)
+{
+	MafwGstRendererLimiter *limiter = MAFW_GST_RENDERER_LIMITER(object);
+
+	switch (prop_id) {
+	case PROP_THRESHOLD:
+		GST_OBJECT_LOCK(limiter);
+		limiter->threshold = g_value_get_double(value);
+		g_atomic_int_set(&limiter->params_changed, 1);
+		GST_OBJECT_UNLOCK(limiter);
+		break;
+	case PROP_RELEASE_TIME:
+		GST_OBJECT_LOCK(limiter);
+		limiter->release_time = g_value_get_int(value);
+		g_atomic_int_set(&limiter->params_changed, 1);
+		GST_OBJECT_UNLOCK(limiter);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+		break;
+	}
+}
+
+static void _get_property(GObject *object, guint prop_id,
+			  GValue *value, GParamSpec *pspec)
+{
+	MafwGstRendererLimiter *limiter = MAFW_GST_RENDERER_LIMITER(object);
+
+	switch (prop_id) {
+	case PROP_THRESHOLD:
+		GST_OBJECT_LOCK(limiter);
+		g_value_set_double(value, limiter->threshold);
+		GST_OBJECT_UNLOCK(limiter);
+		break;
+	case PROP_RELEASE_TIME:
+		GST_OBJECT_LOCK(limiter);
+		g_value_set_int(value, limiter->release_time);
+		GST_OBJECT_UNLOCK(limiter);
+		break;
+	case PROP_BUFFERS_LIMITED:
+		g_value_set_uint(value,
+				 g_atomic_int_get(&limiter->buffers_limited));
+		break;
+	case PROP_BUFFERS_SKIPPED:
+		g_value_set_uint(value,
+				 g_atomic_int_get(&limiter->buffers_skipped));
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+		break;
+	}
+}
+
+/*----------------------------------------------------------------------------
+  GObject initialization
+  ----------------------------------------------------------------------------*/
+
+static void _finalize(GObject *object)
+{
+	MafwGstRendererLimiter *limiter = MAFW_GST_RENDERER_LIMITER(object);
+
+	eq_limiter_free(limiter->lim);
+
+	G_OBJECT_CLASS(parent_class)->finalize(object);
+}
+
+static void mafw_gst_renderer_limiter_base_init(gpointer g_class)
+{
+	GstElementClass *element_class = GST_ELEMENT_CLASS(g_class);
+	GstCaps *caps;
+
+	gst_element_class_set_details_simple(
+		element_class,
+		"MAFW renderer limiter",
+		"Filter/Effect/Audio",
+		"Lookahead peak limiter keeping the equalized signal from "
+		"clipping",
+		"Juan A. Suarez Romero <jasuarez@igalia.com>");
+
+	caps = gst_caps_from_string(ALLOWED_CAPS);
+	gst_audio_filter_class_add_pad_templates(GST_AUDIO_FILTER_CLASS(g_class),
+						 caps);
+	gst_caps_unref(caps);
+}
+
+static void mafw_gst_renderer_limiter_class_init(
+	MafwGstRendererLimiterClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+	GstBaseTransformClass *trans_class = GST_BASE_TRANSFORM_CLASS(klass);
+	GstAudioFilterClass *filter_class = GST_AUDIO_FILTER_CLASS(klass);
+
+	GST_DEBUG_CATEGORY_INIT(limiter_debug, "mafw-gst-renderer-limiter",
+				0, "MAFW renderer limiter");
+
+	gobject_class->set_property = _set_property;
+	gobject_class->get_property = _get_property;
+	gobject_class->finalize = _finalize;
+
+	g_object_class_install_property(
+		gobject_class, PROP_THRESHOLD,
+		g_param_spec_double("threshold", "Threshold",
+				    "Highest level let out, in dBFS",
+				    MIN_THRESHOLD, 0.0, DEFAULT_THRESHOLD,
+				    G_PARAM_READWRITE));
+	g_object_class_install_property(
+		gobject_class, PROP_RELEASE_TIME,
+		g_param_spec_int("release-time", "Release time",
+				 "Time constant of the gain going back up "
+				 "after a peak, in milliseconds",
+				 1, MAX_RELEASE_TIME, DEFAULT_RELEASE_TIME,
+				 G_PARAM_READWRITE));
+	g_object_class_install_property(
+		gobject_class, PROP_BUFFERS_LIMITED,
+		g_param_spec_uint("buffers-limited", "Buffers limited",
+				  "Buffers whose gain had to be turned down",
+				  0, G_MAXUINT, 0, G_PARAM_READABLE));
+	g_object_class_install_property(
+		gobject_class, PROP_BUFFERS_SKIPPED,
+		g_param_spec_uint("buffers-skipped", "Buffers skipped",
+				  "Silent buffers left untouched because the "
+				  "delay line was silent",
+				  0, G_MAXUINT, 0, G_PARAM_READABLE));
+
+	trans_class->stop = _stop;
+	trans_class->transform_ip = _transform_ip;
+	filter_class->setup = _setup;
+}
+
+static void mafw_gst_renderer_limiter_init(MafwGstRendererLimiter *limiter,
+					   MafwGstRendererLimiterClass *klass)
+{
+	limiter->threshold = DEFAULT_THRESHOLD;
+	limiter->release_time = DEFAULT_RELEASE_TIME;
+	limiter->params_changed = 0;
+	limiter->lim = NULL;
+	limiter->rate = 0;
+	limiter->is_s16 = TRUE;
+	limiter->silent_frames = 0;
+	limiter->quiet = FALSE;
+	limiter->buffers_limited = 0;
+	limiter->buffers_skipped = 0;
+
+	gst_base_transform_set_in_place(GST_BASE_TRANSFORM(limiter), TRUE);
+}
+
+GstElement *mafw_gst_renderer_limiter_new(void)
+{
+	return GST_ELEMENT(g_object_new(MAFW_TYPE_GST_RENDERER_LIMITER, NULL));
+}
+
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
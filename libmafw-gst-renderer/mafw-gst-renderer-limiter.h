@@ -0,0 +1,107 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef MAFW_GST_RENDERER_LIMITER_H
+#define MAFW_GST_RENDERER_LIMITER_H
+
+#include <gst/gst.h>
+#include <gst/audio/gstaudiofilter.h>
+
+#include "mafw-gst-renderer-limiter-dsp.h"
+
+G_BEGIN_DECLS
+
+/*----------------------------------------------------------------------------
+  GObject type conversion macros
+  ----------------------------------------------------------------------------*/
+
+#define MAFW_TYPE_GST_RENDERER_LIMITER                  \
+        (mafw_gst_renderer_limiter_get_type())
+#define MAFW_GST_RENDERER_LIMITER(obj)                                  \
+        (G_TYPE_CHECK_INSTANCE_CAST((obj), MAFW_TYPE_GST_RENDERER_LIMITER, \
+				    MafwGstRendererLimiter))
+#define MAFW_IS_GST_RENDERER_LIMITER(obj)                               \
+        (G_TYPE_CHECK_INSTANCE_TYPE((obj), MAFW_TYPE_GST_RENDERER_LIMITER))
+#define MAFW_GST_RENDERER_LIMITER_CLASS(klass)                          \
+	(G_TYPE_CHECK_CLASS_CAST((klass), MAFW_TYPE_GST_RENDERER_LIMITER, \
+				 MafwGstRendererLimiterClass))
+#define MAFW_IS_GST_RENDERER_LIMITER_CLASS(klass)                       \
+	(G_TYPE_CHECK_CLASS_TYPE((klass), MAFW_TYPE_GST_RENDERER_LIMITER))
+
+/*----------------------------------------------------------------------------
+  Type definitions
+  ----------------------------------------------------------------------------*/
+
+typedef struct _MafwGstRendererLimiter MafwGstRendererLimiter;
+typedef struct _MafwGstRendererLimiterClass MafwGstRendererLimiterClass;
+
+/*
+ * The following are protected by the object lock:
+ *
+ * threshold:      Highest level let out, in dBFS.
+ * release_time:   Time constant of the gain recovery, in milliseconds.
+ * params_changed: Whether threshold or release_time changed since the
+ *                 streaming thread last read them.  Atomic, so the
+ *                 streaming thread can check it without the lock.
+ *
+ * The rest is only touched from the streaming thread:
+ *
+ * lim:            Limiter state, NULL before negotiation.
+ * rate:           Negotiated sample rate.
+ * is_s16:         Whether samples are int16 rather than float.
+ * silent_frames:  Frames of silence fed in since the last sound.
+ * quiet:          Whether the state was cleared after a whole lookahead of
+ *                 silence, so that silent buffers can go out untouched.
+ * buffers_limited: Buffers whose gain went below 1.  Atomic.
+ * buffers_skipped: Silent buffers left untouched.  Atomic.
+ */
+struct _MafwGstRendererLimiter {
+	GstAudioFilter parent;
+
+	gdouble threshold;
+	gint release_time;
+	volatile gint params_changed;
+
+	EqLimiter *lim;
+	gint rate;
+	gboolean is_s16;
+	gint silent_frames;
+	gboolean quiet;
+
+	volatile guint buffers_limited;
+	volatile guint buffers_skipped;
+};
+
+struct _MafwGstRendererLimiterClass {
+	GstAudioFilterClass parent_class;
+};
+
+GType mafw_gst_renderer_limiter_get_type(void);
+
+GstElement *mafw_gst_renderer_limiter_new(void);
+
+G_END_DECLS
+
+#endif
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
@@ -0,0 +1,307 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * On-disk cache of parsed playlist files.
+ *
+ * Every playlist file gets a cache file of its own, named after the MD5 of
+ * its URI, holding the modification time and size the file had when it was
+ * parsed and its entries.  An entry is only good while the file has the
+ * same modification time and size.  A cache file is read with a single
+ * mapping, and written to a temporary file renamed over the old one, so
+ * that a lookup never sees half of it.  Once the cache files take more
+ * than CACHE_MAX_BYTES, the ones written longest ago are removed.
+ *
+ * Layout, in host byte order:
+ *
+ *   magic      4 bytes, "MGPC"
+ *   version    guint32
+ *   mtime      gint64, -1 if unknown
+ *   size       gint64, -1 if unknown
+ *   count      guint32, number of entries
+ *   uri_len    guint32
+ *   uri        uri_len bytes, no terminator
+ *   entries    count NUL terminated strings
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <glib/gstdio.h>
+
+#include "mafw-gst-renderer-playlist-cache.h"
+
+#undef  G_LOG_DOMAIN
+#define G_LOG_DOMAIN "mafw-gst-renderer-playlist-cache"
+
+#define CACHE_MAGIC "MGPC"
+#define CACHE_VERSION 1
+#define CACHE_MAX_BYTES (2 * 1024 * 1024)
+
+typedef struct {
+	gchar magic[4];
+	guint32 version;
+	gint64 mtime;
+	gint64 size;
+	guint32 count;
+	guint32 uri_len;
+} CacheHeader;
+
+static gint hits = 0;
+static gint misses = 0;
+
+/*----------------------------------------------------------------------------
+  Cache files
+  ----------------------------------------------------------------------------*/
+
+/* Directory the renderer keeps its cache in.  Free it after use */
+gchar *mafw_gst_renderer_playlist_cache_dir(void)
+{
+	return g_build_filename(g_get_user_cache_dir(), "mafw-gst-renderer",
+				"playlists", NULL);
+}
+
+static gchar *_cache_file(const gchar *dir, const gchar *uri)
+{
+	gchar *name, *file;
+
+	name = g_compute_checksum_for_string(G_CHECKSUM_MD5, uri, -1);
+	file = g_build_filename(dir, name, NULL);
+	g_free(name);
+
+	return file;
+}
+
+/* Splits the entries of a cache file, NULL if they are not @count
+ * terminated strings exactly filling @len bytes */
+static gchar **_split_entries(const gchar *data, gsize len, guint32 count)
+{
+	gchar **entries;
+	const gchar *end;
+	guint32 i;
+
+	if (count == 0 || len == 0 || data[len - 1] != '\0')
+		return NULL;
+
+	entries = g_new0(gchar *, count + 1);
+	for (i = 0; i < count; i++) {
+		end = memchr(data, '\0', len);
+		if (end == NULL) {
+			g_strfreev(entries);
+			return NULL;
+		}
+		entries[i] = g_strndup(data, end - data);
+		len -= end - data + 1;
+		data = end + 1;
+	}
+
+	if (len != 0) {
+		g_strfreev(entries);
+		return NULL;
+	}
+	return entries;
+}
+
+typedef struct {
+	gchar *file;
+	time_t mtime;
+	goffset size;
+} CacheFile;
+
+static gint _compare_cache_files(const CacheFile *a, const CacheFile *b)
+{
+	if (a->mtime != b->mtime)
+		return a->mtime < b->mtime ? -1 : 1;
+	return 0;
+}
+
+/* Removes the cache files in @dir written longest ago but @keep, until the
+ * rest take CACHE_MAX_BYTES at most */
+static void _prune(const gchar *dir, const gchar *keep)
+{
+	GDir *gdir;
+	const gchar *name;
+	GSList *files = NULL, *l;
+	CacheFile *cf;
+	struct stat st;
+	goffset total = 0;
+	gchar *file;
+
+	gdir = g_dir_open(dir, 0, NULL);
+	if (gdir == NULL)
+		return;
+
+	while ((name = g_dir_read_name(gdir)) != NULL) {
+		file = g_build_filename(dir, name, NULL);
+		if (g_stat(file, &st) != 0 || !S_ISREG(st.st_mode)) {
+			g_free(file);
+			continue;
+		}
+		cf = g_new(CacheFile, 1);
+		cf->file = file;
+		cf->mtime = st.st_mtime;
+		cf->size = st.st_size;
+		total += cf->size;
+		files = g_slist_prepend(files, cf);
+	}
+	g_dir_close(gdir);
+
+	files = g_slist_sort(files, (GCompareFunc) _compare_cache_files);
+	for (l = files; l != NULL; l = l->next) {
+		cf = l->data;
+		if (total > CACHE_MAX_BYTES && strcmp(cf->file, keep) != 0 &&
+		    g_unlink(cf->file) == 0) {
+			g_debug("pruned %s", cf->file);
+			total -= cf->size;
+		}
+		g_free(cf->file);
+		g_free(cf);
+	}
+	g_slist_free(files);
+}
+
+/*----------------------------------------------------------------------------
+  Lookup and storage
+  ----------------------------------------------------------------------------*/
+
+/*
+ * Gets the entries cached in @dir for the playlist file at @uri, with
+ * @mtime and @size being those it has now.  Returns a NULL terminated array
+ * to be freed with g_strfreev(), or NULL if there is no cache file for it or
+ * it is stale.
+ */
+gchar **mafw_gst_renderer_playlist_cache_lookup(const gchar *dir,
+						const gchar *uri,
+						gint64 mtime, gint64 size)
+{
+	GMappedFile *mapped;
+	const gchar *data;
+	CacheHeader header;
+	gchar **entries = NULL;
+	gchar *file;
+	gsize len;
+
+	file = _cache_file(dir, uri);
+	mapped = g_mapped_file_new(file, FALSE, NULL);
+	g_free(file);
+
+	if (mapped != NULL) {
+		data = g_mapped_file_get_contents(mapped);
+		len = g_mapped_file_get_length(mapped);
+
+		if (len >= sizeof(header)) {
+			memcpy(&header, data, sizeof(header));
+			data += sizeof(header);
+			len -= sizeof(header);
+
+			if (!memcmp(header.magic, CACHE_MAGIC, 4) &&
+			    header.version == CACHE_VERSION &&
+			    header.mtime == mtime && header.size == size &&
+			    header.uri_len <= len &&
+			    header.uri_len == strlen(uri) &&
+			    !memcmp(data, uri, header.uri_len)) {
+				entries = _split_entries(
+					data + header.uri_len,
+					len - header.uri_len, header.count);
+			}
+		}
+		g_mapped_file_free(mapped);
+	}
+
+	if (entries != NULL) {
+		g_atomic_int_inc(&hits);
+	} else {
+		g_atomic_int_inc(&misses);
+	}
+	g_debug("%s for %s: %d hits, %d misses",
+		entries != NULL ? "hit" : "miss", uri,
+		g_atomic_int_get(&hits), g_atomic_int_get(&misses));
+
+	return entries;
+}
+
+/*
+ * Caches in @dir the @entries, a list of strings, parsed from the playlist
+ * file at @uri, which had @mtime and @size.  Returns whether they could be
+ * written.  The cache is pruned afterwards.
+ */
+gboolean mafw_gst_renderer_playlist_cache_store(const gchar *dir,
+						const gchar *uri,
+						gint64 mtime, gint64 size,
+						GSList *entries)
+{
+	CacheHeader header;
+	GError *error = NULL;
+	GString *data;
+	gchar *file;
+	gboolean ret;
+
+	g_return_val_if_fail(entries != NULL, FALSE);
+
+	if (g_mkdir_with_parents(dir, 0700) != 0) {
+		g_warning("cannot create %s", dir);
+		return FALSE;
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CACHE_MAGIC, 4);
+	header.version = CACHE_VERSION;
+	header.mtime = mtime;
+	header.size = size;
+	header.count = g_slist_length(entries);
+	header.uri_len = strlen(uri);
+
+	data = g_string_new_len((const gchar *) &header, sizeof(header));
+	g_string_append_len(data, uri, header.uri_len);
+	for (; entries != NULL; entries = entries->next)
+		g_string_append_len(data, entries->data,
+				    strlen(entries->data) + 1);
+
+	file = _cache_file(dir, uri);
+	ret = g_file_set_contents(file, data->str, data->len, &error);
+	if (!ret) {
+		g_warning("cannot cache %s: %s", uri, error->message);
+		g_error_free(error);
+	}
+	g_string_free(data, TRUE);
+
+	_prune(dir, file);
+	g_free(file);
+
+	return ret;
+}
+
+/* Lookups that were answered from the cache, and those that were not */
+void mafw_gst_renderer_playlist_cache_get_stats(guint *hit_count,
+						guint *miss_count)
+{
+	if (hit_count != NULL)
+		*hit_count = g_atomic_int_get(&hits);
+	if (miss_count != NULL)
+		*miss_count = g_atomic_int_get(&misses);
+}
+
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
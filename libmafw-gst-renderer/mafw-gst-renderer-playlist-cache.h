@@ -0,0 +1,46 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef MAFW_GST_RENDERER_PLAYLIST_CACHE_H
+#define MAFW_GST_RENDERER_PLAYLIST_CACHE_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+gchar *mafw_gst_renderer_playlist_cache_dir(void);
+gchar **mafw_gst_renderer_playlist_cache_lookup(const gchar *dir,
+						const gchar *uri,
+						gint64 mtime, gint64 size);
+gboolean mafw_gst_renderer_playlist_cache_store(const gchar *dir,
+						const gchar *uri,
+						gint64 mtime, gint64 size,
+						GSList *entries);
+void mafw_gst_renderer_playlist_cache_get_stats(guint *hit_count,
+						guint *miss_count);
+
+G_END_DECLS
+
+#endif
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
@@ -70,6 +70,7 @@ static void _notify_play(MafwGstRendererState *self, GError **error);
 static void _notify_seek(MafwGstRendererState *self, GError **error);
 static void _notify_buffer_status(MafwGstRendererState *self, gdouble percent,
 				  GError **error);
+static void _notify_next(MafwGstRendererState *self, GError **error);
 
 /*----------------------------------------------------------------------------
   Playlist editing signals
@@ -139,6 +140,7 @@ static void mafw_gst_renderer_state_paused_class_init(
         /* state_class->notify_pause is not allowed */
         state_class->notify_seek = _notify_seek;
         state_class->notify_buffer_status = _notify_buffer_status;
+        state_class->notify_next = _notify_next;
 
 	/* Playlist editing signals */
 
@@ -182,7 +184,7 @@ static void _do_play_object(MafwGstRendererState *self, const gchar *object_id,
 
         g_return_if_fail(MAFW_IS_GST_RENDERER_STATE_PAUSED(self));
 
-	self->renderer->worker->stay_paused = FALSE;
+	mafw_gst_renderer_set_stay_paused(self->renderer, FALSE);
 	prev_mode = mafw_gst_renderer_get_playback_mode(self->renderer);
 	mafw_gst_renderer_state_do_play_object(self, object_id, error);
 	cur_mode = mafw_gst_renderer_get_playback_mode(self->renderer);
@@ -198,7 +200,7 @@ static void _do_stop(MafwGstRendererState *self, GError **error)
 {
         g_return_if_fail(MAFW_IS_GST_RENDERER_STATE_PAUSED(self));
 
-	self->renderer->worker->stay_paused = FALSE;
+	mafw_gst_renderer_set_stay_paused(self->renderer, FALSE);
 	/* Stop playback */
         mafw_gst_renderer_state_do_stop(self, error);
 }
@@ -208,7 +210,7 @@ static void _do_resume(MafwGstRendererState *self, GError **error)
         g_return_if_fail(MAFW_IS_GST_RENDERER_STATE_PAUSED(self));
 
         MafwGstRenderer *renderer = MAFW_GST_RENDERER_STATE(self)->renderer;
-	self->renderer->worker->stay_paused = FALSE;
+	mafw_gst_renderer_set_stay_paused(self->renderer, FALSE);
         mafw_gst_renderer_worker_resume(renderer->worker);
 
         /* Transition will be done after receiving notify_play */
@@ -219,7 +221,7 @@ static void _do_set_position(MafwGstRendererState *self,
 			     GError **error)
 {
         g_return_if_fail(MAFW_IS_GST_RENDERER_STATE_PAUSED(self));
-	self->renderer->worker->stay_paused = TRUE;
+	mafw_gst_renderer_set_stay_paused(self->renderer, TRUE);
 	mafw_gst_renderer_state_do_set_position(self, mode, seconds, error);
 }
 
@@ -238,14 +240,14 @@ static void _do_get_position(MafwGstRendererState *self,
 static void _do_next(MafwGstRendererState *self, GError **error)
 {
         g_return_if_fail(MAFW_IS_GST_RENDERER_STATE_PAUSED(self));
-	self->renderer->worker->stay_paused = TRUE;
+	mafw_gst_renderer_set_stay_paused(self->renderer, TRUE);
 	mafw_gst_renderer_state_do_next(self, error);
 }
 
 static void _do_previous(MafwGstRendererState *self, GError **error)
 {
         g_return_if_fail(MAFW_IS_GST_RENDERER_STATE_PAUSED(self));
-	self->renderer->worker->stay_paused = TRUE;
+	mafw_gst_renderer_set_stay_paused(self->renderer, TRUE);
 	mafw_gst_renderer_state_do_prev(self, error);
 }
 
@@ -253,7 +255,7 @@ static void _do_goto_index(MafwGstRendererState *self, guint index,
 			   GError **error)
 {
         g_return_if_fail(MAFW_IS_GST_RENDERER_STATE_PAUSED(self));
-	self->renderer->worker->stay_paused = TRUE;
+	mafw_gst_renderer_set_stay_paused(self->renderer, TRUE);
 	mafw_gst_renderer_state_do_goto_index(self, index, error);
 }
 
@@ -298,6 +300,12 @@ static void _notify_buffer_status(MafwGstRendererState *self, gdouble percent,
 	mafw_gst_renderer_state_do_notify_buffer_status (self, percent, error);
 }
 
+static void _notify_next(MafwGstRendererState *self, GError **error)
+{
+	/* Paused just as the next media was starting */
+	mafw_gst_renderer_state_do_notify_next(self, error);
+}
+
 /*----------------------------------------------------------------------------
   Playlist editing signals
   ----------------------------------------------------------------------------*/
@@ -315,7 +323,7 @@ static void _playlist_contents_changed(MafwGstRendererState *self,
 	   played if that's been suggested with renderer->resume_playlist */
 	mode = mafw_gst_renderer_get_playback_mode(self->renderer);
 	if (clip_changed && mode == MAFW_GST_RENDERER_MODE_PLAYLIST) {
-                self->renderer->worker->stay_paused = TRUE;
+                mafw_gst_renderer_set_stay_paused(self->renderer, TRUE);
 		mafw_gst_renderer_state_do_play(self, error);
 	}
 }
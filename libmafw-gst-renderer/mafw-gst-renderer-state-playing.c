@@ -73,6 +73,7 @@ static void _notify_seek(MafwGstRendererState *self, GError **error);
 static void _notify_buffer_status(MafwGstRendererState *self, gdouble percent,
 				  GError **error);
 static void _notify_eos(MafwGstRendererState *self, GError **error);
+static void _notify_next(MafwGstRendererState *self, GError **error);
 
 /*----------------------------------------------------------------------------
   Playlist editing signals
@@ -144,6 +145,7 @@ static void mafw_gst_renderer_state_playing_class_init(
         state_class->notify_seek          = _notify_seek;
         state_class->notify_buffer_status = _notify_buffer_status;
         state_class->notify_eos           = _notify_eos;
+        state_class->notify_next          = _notify_next;
 
 	/* Playlist editing signals */
 
@@ -306,6 +308,11 @@ static void _notify_buffer_status(MafwGstRendererState *self, gdouble percent,
 	mafw_gst_renderer_state_do_notify_buffer_status (self, percent, error);
 }
 
+static void _notify_next(MafwGstRendererState *self, GError **error)
+{
+	mafw_gst_renderer_state_do_notify_next(self, error);
+}
+
 static void _notify_eos(MafwGstRendererState *self, GError **error)
 {
         MafwGstRenderer *renderer;
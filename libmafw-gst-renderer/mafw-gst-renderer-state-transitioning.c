@@ -28,8 +28,6 @@
 #undef  G_LOG_DOMAIN
 #define G_LOG_DOMAIN "mafw-gst-renderer-state-transitioning"
 
-#define UPDATE_DELAY 10
-
 /*----------------------------------------------------------------------------
   Playback
   ----------------------------------------------------------------------------*/
@@ -196,15 +194,15 @@ static void _do_pause(MafwGstRendererState *self, GError **error)
 {
         g_return_if_fail(MAFW_IS_GST_RENDERER_STATE_TRANSITIONING(self));
 	g_debug("Got pause while transitioning");
-	self->renderer->worker->stay_paused = TRUE;
+	mafw_gst_renderer_set_stay_paused(self->renderer, TRUE);
 }
 
 static void _do_resume(MafwGstRendererState *self, GError **error)
 {
         g_return_if_fail(MAFW_IS_GST_RENDERER_STATE_TRANSITIONING(self));
-	if (self->renderer->worker->stay_paused) {
+	if (self->renderer->stay_paused) {
 		g_debug("Got resume while transitioning/paused");
-		self->renderer->worker->stay_paused = FALSE;
+		mafw_gst_renderer_set_stay_paused(self->renderer, FALSE);
 	} else {
 		g_set_error(error, MAFW_RENDERER_ERROR,
 			    MAFW_RENDERER_ERROR_CANNOT_PLAY,
@@ -311,6 +309,8 @@ static void _notify_metadata(MafwGstRendererState *self,
                         renderer->media->seekability = SEEKABILITY_UNKNOWN;
                         g_debug("_notify_metadata: source seekability unknown");
                 }
+                mafw_gst_renderer_worker_set_source_seekability(
+                        renderer->worker, renderer->media->seekability);
 
 		/* Check for source duration to keep it updated if needed */
                 mval = mafw_metadata_first(metadata,
@@ -355,6 +355,9 @@ static void _notify_play(MafwGstRendererState *self, GError **error)
 	}
 
 	mafw_gst_renderer_set_state(renderer, Playing);
+
+	/* Get the next item ready to follow without a gap */
+	mafw_gst_renderer_prefetch_next(renderer);
 }
 
 static void _notify_pause(MafwGstRendererState *self, GError **error)
@@ -362,7 +365,7 @@ static void _notify_pause(MafwGstRendererState *self, GError **error)
 	g_return_if_fail(MAFW_IS_GST_RENDERER_STATE_TRANSITIONING(self));
 
 	MafwGstRenderer *renderer = MAFW_GST_RENDERER_STATE(self)->renderer;
-	self->renderer->worker->stay_paused = FALSE;
+	mafw_gst_renderer_set_stay_paused(self->renderer, FALSE);
         mafw_gst_renderer_set_state(renderer, Paused);
 }
 
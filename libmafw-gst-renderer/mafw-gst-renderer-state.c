@@ -173,6 +173,12 @@ static void _default_notify_eos(MafwGstRendererState *self, GError **error)
 		   MAFW_GST_RENDERER_STATE_GET_CLASS(self)->name);
 }
 
+static void _default_notify_next(MafwGstRendererState *self, GError **error)
+{
+	g_critical("Notify next: incorrect operation in %s state",
+		   MAFW_GST_RENDERER_STATE_GET_CLASS(self)->name);
+}
+
 /*----------------------------------------------------------------------------
   Default playlist editing signal handlers implementation
   ----------------------------------------------------------------------------*/
@@ -248,6 +254,7 @@ static void mafw_gst_renderer_state_class_init(MafwGstRendererStateClass *klass)
 	klass->notify_seek          = _default_notify_seek;
 	klass->notify_buffer_status = _default_notify_buffer_status;
 	klass->notify_eos           = _default_notify_eos;
+	klass->notify_next          = _default_notify_next;
 
 	klass->notify_eos           = _default_notify_eos;
 
@@ -386,6 +393,12 @@ void mafw_gst_renderer_state_notify_eos(MafwGstRendererState *self,
 	MAFW_GST_RENDERER_STATE_GET_CLASS(self)->notify_eos(self, error);
 }
 
+void mafw_gst_renderer_state_notify_next(MafwGstRendererState *self,
+					GError **error)
+{
+	MAFW_GST_RENDERER_STATE_GET_CLASS(self)->notify_next(self, error);
+}
+
 /*----------------------------------------------------------------------------
   Playlist editing handlers
   ----------------------------------------------------------------------------*/
@@ -823,3 +836,98 @@ void mafw_gst_renderer_state_do_notify_buffer_status(MafwGstRendererState *self,
 
 	mafw_renderer_emit_buffering_info(MAFW_RENDERER(renderer), percent / 100.0);
 }
+
+/*
+ * The worker has gone on to the item prefetched with
+ * mafw_gst_renderer_prefetch_next() without stopping.  Move the playlist to
+ * it and take its details from the metadata got then, as the Transitioning
+ * state does for a regular play.
+ */
+void mafw_gst_renderer_state_do_notify_next(MafwGstRendererState *self,
+					   GError **error)
+{
+	MafwGstRenderer *renderer;
+	GHashTable *metadata;
+	GValue *mval;
+	gchar *location;
+	GError *move_error = NULL;
+	gint index;
+
+	g_return_if_fail(MAFW_IS_GST_RENDERER_STATE(self));
+
+	renderer = MAFW_GST_RENDERER_STATE(self)->renderer;
+
+	/* Moving clears them */
+	metadata = renderer->next_metadata;
+	renderer->next_metadata = NULL;
+	index = renderer->next_index;
+
+	/* Update playcount of the media that has just finished */
+	if (renderer->update_playcount_id > 0) {
+		g_source_remove(renderer->update_playcount_id);
+		mafw_gst_renderer_update_stats(renderer);
+	}
+
+	/* The worker tells which media it went on to */
+	if (metadata != NULL) {
+		mval = mafw_metadata_first(metadata, MAFW_METADATA_KEY_URI);
+		location = mafw_gst_renderer_worker_get_location(
+			renderer->worker);
+		if (g_strcmp0(g_value_get_string(mval), location) != 0) {
+			g_hash_table_unref(metadata);
+			metadata = NULL;
+		}
+		g_free(location);
+	}
+
+	if (metadata == NULL ||
+	    mafw_gst_renderer_move(renderer,
+				   MAFW_GST_RENDERER_MOVE_TYPE_INDEX,
+				   index, &move_error) !=
+	    MAFW_GST_RENDERER_MOVE_RESULT_OK) {
+		/* The playlist changed after the media was queued, so it
+		 * is not the next item anymore: play the right one */
+		g_debug("gapless media is stale, playing next item");
+		g_clear_error(&move_error);
+		if (metadata != NULL) {
+			g_hash_table_unref(metadata);
+		}
+		if (mafw_gst_renderer_move(renderer,
+					   MAFW_GST_RENDERER_MOVE_TYPE_NEXT,
+					   0, NULL) ==
+		    MAFW_GST_RENDERER_MOVE_RESULT_OK) {
+			mafw_gst_renderer_state_do_play(self, error);
+		} else {
+			mafw_gst_renderer_state_do_stop(self, error);
+		}
+		return;
+	}
+
+	mval = mafw_metadata_first(metadata, MAFW_METADATA_KEY_URI);
+	g_free(renderer->media->uri);
+	renderer->media->uri = g_strdup(g_value_get_string(mval));
+
+	mval = mafw_metadata_first(metadata, MAFW_METADATA_KEY_IS_SEEKABLE);
+	if (mval != NULL) {
+		renderer->media->seekability = g_value_get_boolean(mval) ?
+			SEEKABILITY_SEEKABLE : SEEKABILITY_NO_SEEKABLE;
+	} else {
+		renderer->media->seekability = SEEKABILITY_UNKNOWN;
+	}
+	mafw_gst_renderer_worker_set_source_seekability(
+		renderer->worker, renderer->media->seekability);
+
+	mval = mafw_metadata_first(metadata, MAFW_METADATA_KEY_DURATION);
+	renderer->media->duration = mval != NULL ? g_value_get_int(mval) : -1;
+
+	g_hash_table_unref(metadata);
+
+	if (renderer->media->object_id) {
+		renderer->update_playcount_id = g_timeout_add_seconds(
+			UPDATE_DELAY,
+			mafw_gst_renderer_update_stats,
+			renderer);
+	}
+
+	mafw_gst_renderer_prefetch_next(renderer);
+}
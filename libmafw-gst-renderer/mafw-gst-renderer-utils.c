@@ -27,8 +27,11 @@
 #endif
 
 #include <glib.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "mafw-gst-renderer-utils.h"
+#include "mafw-gst-renderer-eq-layout.h"
 
 #undef  G_LOG_DOMAIN
 #define G_LOG_DOMAIN "mafw-gst-renderer-utils"
@@ -102,4 +105,122 @@ gboolean uri_is_stream(const gchar *uri)
 	}
 }
 
+/* Parser state for load_eq_preset() */
+typedef struct {
+	gdouble *gains;
+	gint n_bands;
+	gint band;
+	gboolean found;
+	EqDspLayout *layout;
+} EqPresetParser;
+
+static void _eq_preset_start(GMarkupParseContext *context,
+			     const gchar *element_name,
+			     const gchar **attribute_names,
+			     const gchar **attribute_values,
+			     gpointer user_data, GError **error)
+{
+	EqPresetParser *parser = user_data;
+	gint i;
+
+	parser->band = -1;
+	if (strcmp(element_name, "equalizer") == 0 && parser->layout) {
+		for (i = 0; attribute_names[i]; i++) {
+			if (strcmp(attribute_names[i], "layout") == 0) {
+				eq_layout_parse(attribute_values[i],
+						parser->layout);
+				break;
+			}
+		}
+		return;
+	}
+	if (strcmp(element_name, "band") != 0)
+		return;
+
+	for (i = 0; attribute_names[i]; i++) {
+		if (strcmp(attribute_names[i], "num") == 0) {
+			parser->band = atoi(attribute_values[i]);
+			break;
+		}
+	}
+	if (parser->band >= parser->n_bands)
+		parser->band = -1;
+}
+
+static void _eq_preset_end(GMarkupParseContext *context,
+			   const gchar *element_name,
+			   gpointer user_data, GError **error)
+{
+	((EqPresetParser *) user_data)->band = -1;
+}
+
+static void _eq_preset_text(GMarkupParseContext *context,
+			    const gchar *text, gsize text_len,
+			    gpointer user_data, GError **error)
+{
+	EqPresetParser *parser = user_data;
+	gchar *value;
+
+	if (parser->band < 0)
+		return;
+
+	value = g_strndup(text, text_len);
+	parser->gains[parser->band] = g_ascii_strtod(value, NULL);
+	parser->found = TRUE;
+	g_free(value);
+}
+
+/**
+ * load_eq_preset:
+ * @filename: equalizer preset file, as written by the control panel applet.
+ * @gains: location for the gain of each band, in dB.
+ * @n_bands: number of elements of @gains.
+ * @layout: location for the band layout of the preset, or %NULL.
+ *
+ * Reads the band gains of an equalizer preset.  Bands missing in the
+ * preset are set to 0 dB.  @layout is left untouched if the preset does
+ * not store a valid one, as those saved before layouts were.
+ *
+ * Returns: TRUE if the preset could be read and had some band.
+ */
+gboolean load_eq_preset(const gchar *filename, gdouble *gains, gint n_bands,
+			EqDspLayout *layout)
+{
+	static const GMarkupParser parser_funcs = {
+		_eq_preset_start, _eq_preset_end, _eq_preset_text, NULL, NULL
+	};
+	EqPresetParser parser;
+	GMarkupParseContext *context;
+	GError *error = NULL;
+	gchar *contents;
+	gsize length;
+	gboolean ok;
+
+	if (!g_file_get_contents(filename, &contents, &length, &error)) {
+		g_warning("Cannot read preset %s: %s", filename,
+			  error->message);
+		g_error_free(error);
+		return FALSE;
+	}
+
+	memset(gains, 0, n_bands * sizeof(gdouble));
+	parser.gains = gains;
+	parser.n_bands = n_bands;
+	parser.band = -1;
+	parser.found = FALSE;
+	parser.layout = layout;
+
+	context = g_markup_parse_context_new(&parser_funcs, 0, &parser, NULL);
+	ok = g_markup_parse_context_parse(context, contents, length, &error) &&
+		g_markup_parse_context_end_parse(context, &error);
+	if (!ok) {
+		g_warning("Wrong preset %s: %s", filename, error->message);
+		g_error_free(error);
+	}
+	g_markup_parse_context_free(context);
+	g_free(contents);
+
+	return ok && parser.found;
+}
+
 /* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
@@ -23,11 +23,15 @@
 #ifndef MAFW_GST_RENDERER_UTILS_H
 #define MAFW_GST_RENDERER_UTILS_H
 
+#include "mafw-gst-renderer-equalizer-dsp.h"
+
 G_BEGIN_DECLS
 
 gboolean convert_utf8(const gchar *src, gchar **dst);
 gboolean uri_is_playlist(const gchar *uri);
 gboolean uri_is_stream(const gchar *uri);
+gboolean load_eq_preset(const gchar *filename, gdouble *gains, gint n_bands,
+			EqDspLayout *layout);
 
 G_END_DECLS
 #endif
@@ -31,6 +31,7 @@
 
 #include <string.h>
 #include <glib.h>
+#include <gobject/gvaluecollector.h>
 #include <X11/Xlib.h>
 #include <gst/interfaces/xoverlay.h>
 #include <gst/pbutils/missing-plugins.h>
@@ -45,9 +46,15 @@
 #endif
 
 #include <totem-pl-parser.h>
+#include <libgnomevfs/gnome-vfs.h>
 #include "mafw-gst-renderer.h"
 #include "mafw-gst-renderer-worker.h"
+#include "mafw-gst-renderer-equalizer.h"
+#include "mafw-gst-renderer-convolver.h"
+#include "mafw-gst-renderer-limiter.h"
+#include "mafw-gst-renderer-fader.h"
 #include "mafw-gst-renderer-utils.h"
+#include "mafw-gst-renderer-playlist-cache.h"
 #include "blanking.h"
 #include "keypad.h"
 #include "../constants.h"
@@ -57,6 +64,8 @@
 
 #define MAFW_GST_RENDERER_WORKER_SECONDS_READY 60
 #define MAFW_GST_RENDERER_WORKER_SECONDS_DURATION_AND_SEEKABILITY 4
+/* Longest wait for a seek to land before giving up on it */
+#define MAFW_GST_RENDERER_WORKER_SECONDS_SEEK 10
 
 #define MAFW_GST_MISSING_TYPE_DECODER "decoder"
 #define MAFW_GST_MISSING_TYPE_ENCODER "encoder"
@@ -64,18 +73,36 @@
 #define MAFW_GST_BUFFER_TIME  600000L
 #define MAFW_GST_LATENCY_TIME (MAFW_GST_BUFFER_TIME / 2)
 
+/* Memory budget of the standby pipeline, in KB, and the least one it is
+ * built with: below it there is hardly room for the sink and the filters */
+#define MAFW_GST_RENDERER_WORKER_STANDBY_BUDGET 2048
+#define MAFW_GST_RENDERER_WORKER_STANDBY_MIN_BUDGET 256
+
+/* playbin2 flags of the standby pipeline: audio and native audio, that is,
+ * the usual 99 without video */
+#define MAFW_GST_RENDERER_WORKER_STANDBY_FLAGS 0x22
+
+/* Longest crossfade, in milliseconds; how early its timeout may fire and
+ * still start it; and how long the old pipeline is kept after its fade
+ * should have ended, should its EOS not come */
+#define MAFW_GST_RENDERER_WORKER_MAX_CROSSFADE 12000
+#define MAFW_GST_RENDERER_WORKER_CROSSFADE_SLACK 50
+#define MAFW_GST_RENDERER_WORKER_FADEOUT_LINGER 1000
+
 #define NSECONDS_TO_SECONDS(ns) ((ns)%1000000000 < 500000000?\
                                  GST_TIME_AS_SECONDS((ns)):\
                                  GST_TIME_AS_SECONDS((ns))+1)
 
 #define _current_metadata_add(worker, key, type, value)        \
                do { \
+                       g_mutex_lock(worker->media_lock); \
                        if (!worker->current_metadata) \
                                worker->current_metadata = mafw_metadata_new(); \
                        /* At first remove old value */ \
                        g_hash_table_remove(worker->current_metadata, key); \
                        mafw_metadata_add_something(worker->current_metadata, \
                                        key, type, 1, value); \
+                       g_mutex_unlock(worker->media_lock); \
                } while (0)
 
 
@@ -87,53 +114,457 @@ static MafwGstRendererWorker *Global_worker = NULL;
 static void _do_play(MafwGstRendererWorker *worker);
 static void _do_seek(MafwGstRendererWorker *worker, GstSeekType seek_type,
 		     gint position, GError **error);
+static gboolean _send_seek(MafwGstRendererWorker *worker, gint position);
+static void _seek_landed(MafwGstRendererWorker *worker);
+static void _reset_seeks(MafwGstRendererWorker *worker);
 static void _play_pl_next(MafwGstRendererWorker *worker);
+static void _stop(MafwGstRendererWorker *worker);
+static void _reset_media_info(MafwGstRendererWorker *worker);
+static void _set_location(MafwGstRendererWorker *worker, const gchar *uri);
+static void _set_eos(MafwGstRendererWorker *worker, gboolean eos);
+static void _clear_current_metadata(MafwGstRendererWorker *worker);
+static void _set_seek_position(MafwGstRendererWorker *worker, gint position);
+static void _set_length(MafwGstRendererWorker *worker, gint64 length);
+static void _start_parse(MafwGstRendererWorker *worker, const gchar *uri,
+			 GError *fallback);
+static void _cancel_parse(MafwGstRendererWorker *worker);
+static void _update_gapless_next(MafwGstRendererWorker *worker);
+static void _handle_gapless_msg(MafwGstRendererWorker *worker,
+				const GstStructure *structure);
+static gboolean _start_standby(MafwGstRendererWorker *worker,
+			       const gchar *uri);
+static void _update_standby(MafwGstRendererWorker *worker);
+static void _schedule_crossfade(MafwGstRendererWorker *worker);
+static void _cancel_crossfade(MafwGstRendererWorker *worker);
+static void _handover_crossfade(MafwGstRendererWorker *worker);
+static void _discard_fadeout(MafwGstRendererWorker *worker);
+static gboolean _fadeout_bus_cb(GstBus *bus, GstMessage *msg,
+				MafwGstRendererWorker *worker);
 
 static void _emit_metadatas(MafwGstRendererWorker *worker);
 
-/* Playlist parsing */
-static void _on_pl_entry_parsed(TotemPlParser *parser, gchar *uri,
-                                gpointer metadata, GSList **plitems)
+/*----------------------------------------------------------------------------
+  Threading
+
+  The worker runs on its own main context.  Unless it is threaded, that is
+  the context of the owner, and everything below comes down to direct
+  calls.  Otherwise, the public calls made from other threads are queued
+  as commands to the worker thread, and the notifications for the owner,
+  including the metadata and property changes, are delivered on the owner
+  context, in the order they were sent.
+  ----------------------------------------------------------------------------*/
+
+typedef struct _WorkerCommand WorkerCommand;
+
+typedef void (*WorkerCommandFunc)(MafwGstRendererWorker *worker,
+				  WorkerCommand *cmd);
+
+/*
+ * A call queued to the worker thread, with its arguments.  done and result
+ * are only used if the caller waits for it.  data is freed along with it.
+ */
+struct _WorkerCommand {
+	WorkerCommandFunc func;
+	gchar *uri;
+	GSList *plitems;
+	gchar **uris;
+	gpointer data;
+	GstSeekType seek_type;
+	gint value;
+	gint result;
+	gboolean wait;
+	gboolean done;
+};
+
+typedef enum {
+	WORKER_NOTIFY_PLAY,
+	WORKER_NOTIFY_PAUSE,
+	WORKER_NOTIFY_SEEK,
+	WORKER_NOTIFY_EOS,
+	WORKER_NOTIFY_NEXT,
+	WORKER_NOTIFY_BUFFER_STATUS,
+	WORKER_NOTIFY_ERROR,
+	WORKER_NOTIFY_METADATA,
+	WORKER_NOTIFY_PROPERTY,
+	/* The duration of the media is known */
+	WORKER_NOTIFY_DURATION,
+	/* The media started to play */
+	WORKER_NOTIFY_PLAYABLE,
+	/* The media is loading */
+	WORKER_NOTIFY_LOADING,
+} WorkerNotifyType;
+
+/* A notification for the owner, with the data it needs */
+typedef struct {
+	MafwGstRendererWorker *worker;
+	GSource *source;
+	guint generation;
+	WorkerNotifyType type;
+	gint value;
+	GError *error;
+	gchar *name;
+	GValueArray *values;
+} WorkerNotify;
+
+/* Whether the caller has to go through the command queue */
+static gboolean _foreign_thread(MafwGstRendererWorker *worker)
 {
-        if (uri != NULL) {
-                *plitems = g_slist_append(*plitems, g_strdup(uri));
-        }
+	return worker->thread != NULL && g_thread_self() != worker->thread;
 }
-static GSList *_parse_playlist(const gchar *uri)
+
+static guint _attach_source(MafwGstRendererWorker *worker, GSource *source,
+			    GSourceFunc func, gpointer data)
 {
-        static TotemPlParser *pl_parser = NULL;
-        GSList *plitems = NULL;
-        gulong handler_id;
+	guint id;
 
-        /* Initialize the playlist parser */
-        if (!pl_parser)
-        {
-                pl_parser = totem_pl_parser_new ();
-                g_object_set(pl_parser, "recurse", TRUE, "disable-unsafe",
-                     TRUE, NULL);
-        }
-        handler_id = g_signal_connect(G_OBJECT(pl_parser), "entry-parsed",
-                         G_CALLBACK(_on_pl_entry_parsed), &plitems);
-        /* Parsing */
-        if (totem_pl_parser_parse(pl_parser, uri, FALSE) !=
-            TOTEM_PL_PARSER_RESULT_SUCCESS) {
-                /* An error happens while parsing */
+	g_source_set_callback(source, func, data, NULL);
+	id = g_source_attach(source, worker->context);
+	g_source_unref(source);
 
-        }
-        g_signal_handler_disconnect(pl_parser, handler_id);
-        return plitems;
+	return id;
+}
+
+static guint _timeout_add(MafwGstRendererWorker *worker, guint interval,
+			  GSourceFunc func, gpointer data)
+{
+	return _attach_source(worker, g_timeout_source_new(interval), func,
+			      data);
+}
+
+static guint _timeout_add_seconds(MafwGstRendererWorker *worker,
+				  guint interval, GSourceFunc func,
+				  gpointer data)
+{
+	return _attach_source(worker, g_timeout_source_new_seconds(interval),
+			      func, data);
+}
+
+static guint _bus_add_watch(MafwGstRendererWorker *worker, GstBus *bus,
+			    gint priority, GstBusFunc func, gpointer data)
+{
+	GSource *source;
+
+	source = gst_bus_create_watch(bus);
+	g_source_set_priority(source, priority);
+	return _attach_source(worker, source, (GSourceFunc) func, data);
+}
+
+/* As g_source_remove(), for the sources of the worker context */
+static void _remove_source(MafwGstRendererWorker *worker, guint id)
+{
+	GSource *source;
+
+	source = g_main_context_find_source_by_id(worker->context, id);
+	if (source != NULL)
+		g_source_destroy(source);
+}
+
+static WorkerCommand *_command_new(WorkerCommandFunc func)
+{
+	WorkerCommand *cmd;
+
+	cmd = g_new0(WorkerCommand, 1);
+	cmd->func = func;
+
+	return cmd;
+}
+
+static void _command_free(WorkerCommand *cmd)
+{
+	g_free(cmd->uri);
+	g_strfreev(cmd->uris);
+	g_free(cmd->data);
+	g_free(cmd);
+}
+
+static gboolean _run_commands(gpointer data)
+{
+	MafwGstRendererWorker *worker = data;
+	WorkerCommand *cmd;
+
+	for (;;) {
+		g_mutex_lock(worker->thread_lock);
+		cmd = g_queue_pop_head(worker->commands);
+		if (cmd == NULL) {
+			worker->command_id = 0;
+			g_mutex_unlock(worker->thread_lock);
+			break;
+		}
+		g_mutex_unlock(worker->thread_lock);
+
+		cmd->func(worker, cmd);
+
+		if (cmd->wait) {
+			g_mutex_lock(worker->thread_lock);
+			cmd->done = TRUE;
+			g_cond_broadcast(worker->command_cond);
+			g_mutex_unlock(worker->thread_lock);
+		} else {
+			_command_free(cmd);
+		}
+	}
+
+	return FALSE;
+}
+
+/* Queues @cmd to the worker thread, which frees it */
+static void _queue_command(MafwGstRendererWorker *worker, WorkerCommand *cmd)
+{
+	g_mutex_lock(worker->thread_lock);
+	g_queue_push_tail(worker->commands, cmd);
+	if (worker->command_id == 0) {
+		worker->command_id = _attach_source(worker, g_idle_source_new(),
+						    _run_commands, worker);
+	}
+	g_mutex_unlock(worker->thread_lock);
+}
+
+/* Runs @cmd on the worker thread, and returns its result once it is done */
+static gint _call_command(MafwGstRendererWorker *worker, WorkerCommand *cmd)
+{
+	gint result;
+
+	cmd->wait = TRUE;
+	_queue_command(worker, cmd);
+
+	g_mutex_lock(worker->thread_lock);
+	while (!cmd->done)
+		g_cond_wait(worker->command_cond, worker->thread_lock);
+	g_mutex_unlock(worker->thread_lock);
+
+	result = cmd->result;
+	_command_free(cmd);
+
+	return result;
+}
+
+static gboolean _dispatch_notify(gpointer data)
+{
+	WorkerNotify *notify = data;
+	MafwGstRendererWorker *worker = notify->worker;
+	MafwGstRenderer *renderer = (MafwGstRenderer *) worker->owner;
+	gboolean stale = FALSE;
+
+	if (notify->source != NULL) {
+		g_mutex_lock(worker->thread_lock);
+		worker->notifications = g_slist_remove(worker->notifications,
+						       notify->source);
+		stale = notify->generation != worker->notify_generation;
+		g_mutex_unlock(worker->thread_lock);
+	}
+
+	/* Properties are not about the media */
+	if (stale && notify->type != WORKER_NOTIFY_PROPERTY) {
+		g_debug("dropping notification %d posted before play or stop",
+			notify->type);
+		return FALSE;
+	}
+
+	switch (notify->type) {
+	case WORKER_NOTIFY_PLAY:
+		if (worker->notify_play_handler)
+			worker->notify_play_handler(worker, worker->owner);
+		break;
+	case WORKER_NOTIFY_PAUSE:
+		if (worker->notify_pause_handler)
+			worker->notify_pause_handler(worker, worker->owner);
+		break;
+	case WORKER_NOTIFY_SEEK:
+		if (worker->notify_seek_handler)
+			worker->notify_seek_handler(worker, worker->owner);
+		break;
+	case WORKER_NOTIFY_EOS:
+		if (worker->notify_eos_handler)
+			worker->notify_eos_handler(worker, worker->owner);
+		break;
+	case WORKER_NOTIFY_NEXT:
+		if (worker->notify_next_handler)
+			worker->notify_next_handler(worker, worker->owner);
+		break;
+	case WORKER_NOTIFY_BUFFER_STATUS:
+		if (worker->notify_buffer_status_handler)
+			worker->notify_buffer_status_handler(worker,
+							     worker->owner,
+							     notify->value);
+		break;
+	case WORKER_NOTIFY_ERROR:
+		if (worker->notify_error_handler)
+			worker->notify_error_handler(worker, worker->owner,
+						     notify->error);
+		break;
+	case WORKER_NOTIFY_METADATA:
+		g_signal_emit_by_name(worker->owner, "metadata-changed",
+				      notify->name, notify->values);
+		break;
+	case WORKER_NOTIFY_PROPERTY:
+		mafw_extension_emit_property_changed(
+			MAFW_EXTENSION(worker->owner), notify->name,
+			g_value_array_get_nth(notify->values, 0));
+		break;
+	case WORKER_NOTIFY_DURATION:
+		/* We compare this duration we just got with the
+		 * source one and update it in the source if needed */
+		if (notify->value > 0 &&
+		    notify->value != renderer->media->duration) {
+			mafw_gst_renderer_update_source_duration(
+				renderer, notify->value);
+		}
+		break;
+	case WORKER_NOTIFY_PLAYABLE:
+		renderer->play_failed_count = 0;
+		break;
+	case WORKER_NOTIFY_LOADING:
+		if (renderer->update_playcount_id > 0) {
+			g_source_remove(renderer->update_playcount_id);
+			renderer->update_playcount_id = 0;
+		}
+		break;
+	}
+
+	return FALSE;
+}
+
+static void _free_notify(gpointer data)
+{
+	WorkerNotify *notify = data;
+
+	if (notify->error)
+		g_error_free(notify->error);
+	if (notify->values)
+		g_value_array_free(notify->values);
+	g_free(notify->name);
+	g_free(notify);
+}
+
+static WorkerNotify *_notify_new(MafwGstRendererWorker *worker,
+				 WorkerNotifyType type)
+{
+	WorkerNotify *notify;
+
+	notify = g_new0(WorkerNotify, 1);
+	notify->worker = worker;
+	notify->type = type;
+
+	return notify;
+}
+
+/* Delivers @notify to the owner, and frees it */
+static void _post_notify(MafwGstRendererWorker *worker, WorkerNotify *notify)
+{
+	if (worker->thread == NULL) {
+		_dispatch_notify(notify);
+		_free_notify(notify);
+		return;
+	}
+
+	notify->source = g_idle_source_new();
+	g_source_set_callback(notify->source, _dispatch_notify, notify,
+			      _free_notify);
+	g_mutex_lock(worker->thread_lock);
+	notify->generation = worker->notify_generation;
+	worker->notifications = g_slist_append(worker->notifications,
+					       notify->source);
+	g_mutex_unlock(worker->thread_lock);
+	g_source_attach(notify->source, worker->owner_context);
+	g_source_unref(notify->source);
+}
+
+/* Makes the notifications not delivered yet stale, for a play or stop */
+static void _new_notify_generation(MafwGstRendererWorker *worker)
+{
+	g_mutex_lock(worker->thread_lock);
+	worker->notify_generation++;
+	g_mutex_unlock(worker->thread_lock);
+}
+
+static void _notify(MafwGstRendererWorker *worker, WorkerNotifyType type)
+{
+	_post_notify(worker, _notify_new(worker, type));
+}
+
+static void _notify_value(MafwGstRendererWorker *worker,
+			  WorkerNotifyType type, gint value)
+{
+	WorkerNotify *notify;
+
+	notify = _notify_new(worker, type);
+	notify->value = value;
+	_post_notify(worker, notify);
+}
+
+/* Emits metadata-changed for @key, with @values, which are freed */
+static void _emit_metadata_values(MafwGstRendererWorker *worker,
+				  const gchar *key, GValueArray *values)
+{
+	WorkerNotify *notify;
+
+	notify = _notify_new(worker, WORKER_NOTIFY_METADATA);
+	notify->name = g_strdup(key);
+	notify->values = values;
+	_post_notify(worker, notify);
+}
+
+/* Emits metadata-changed for @key, with a single value of @type */
+static void _emit_metadata(MafwGstRendererWorker *worker, const gchar *key,
+			   GType type, ...)
+{
+	GValueArray *values;
+	GValue value = {0};
+	gchar *error = NULL;
+	va_list args;
+
+	g_value_init(&value, type);
+	va_start(args, type);
+	G_VALUE_COLLECT(&value, args, 0, &error);
+	va_end(args);
+	if (error != NULL) {
+		g_warning("%s", error);
+		g_free(error);
+		g_value_unset(&value);
+		return;
+	}
+
+	values = g_value_array_new(1);
+	g_value_array_append(values, &value);
+	g_value_unset(&value);
+	_emit_metadata_values(worker, key, values);
+}
+
+static void _emit_property(MafwGstRendererWorker *worker, const gchar *name,
+			   const GValue *value)
+{
+	WorkerNotify *notify;
+
+	notify = _notify_new(worker, WORKER_NOTIFY_PROPERTY);
+	notify->name = g_strdup(name);
+	notify->values = g_value_array_new(1);
+	g_value_array_append(notify->values, value);
+	_post_notify(worker, notify);
+}
+
+static gpointer _thread_main(gpointer data)
+{
+	MafwGstRendererWorker *worker = data;
+
+	g_debug("worker thread running");
+	g_main_loop_run(worker->loop);
+	g_debug("worker thread done");
+
+	return NULL;
 }
 
 /*
- * Sends @error to MafwGstRenderer.  Only call this from the glib main thread, or
- * face the consequences.  @err is free'd.
+ * Sends @error to MafwGstRenderer.  Only call this from the thread running the
+ * worker context, or face the consequences.  @err is free'd.
  */
 static void _send_error(MafwGstRendererWorker *worker, GError *err)
 {
+	WorkerNotify *notify;
+
 	worker->is_error = TRUE;
-        if (worker->notify_error_handler)
-                worker->notify_error_handler(worker, worker->owner, err);
-	g_error_free(err);
+	notify = _notify_new(worker, WORKER_NOTIFY_ERROR);
+	notify->error = err;
+	_post_notify(worker, notify);
 }
 
 /*
@@ -260,9 +691,8 @@ static void _emit_gst_buffer_as_graphic_file_cb(GstBuffer *new_buffer,
 					      (gchar *) filename);
 
 			/* Emit the metadata. */
-			mafw_renderer_emit_metadata_string(sgd->worker->owner,
-							   sgd->metadata_key,
-							   (gchar *) filename);
+			_emit_metadata(sgd->worker, sgd->metadata_key,
+				       G_TYPE_STRING, (gchar *) filename);
 		} else {
 			if (error != NULL) {
 				g_warning ("%s\n", error->message);
@@ -401,8 +831,11 @@ static gboolean _go_to_gst_ready(gpointer user_data)
 	g_return_val_if_fail(worker->state == GST_STATE_PAUSED ||
 			     worker->prerolling, FALSE);
 
-	worker->seek_position =
-		mafw_gst_renderer_worker_get_position(worker);
+	_set_seek_position(worker,
+			   mafw_gst_renderer_worker_get_position(worker));
+	/* Seeks under way are lost in READY; the last one is redone when
+	 * waking up, from seek_position */
+	_reset_seeks(worker);
 
 	g_debug("going to GST_STATE_READY");
 	gst_element_set_state(worker->pipeline, GST_STATE_READY);
@@ -419,7 +852,8 @@ static void _add_ready_timeout(MafwGstRendererWorker *worker)
 		{
 			g_debug("Adding timeout to go to GST_STATE_READY");
 			worker->ready_timeout =
-				g_timeout_add_seconds(
+				_timeout_add_seconds(
+					worker,
 					MAFW_GST_RENDERER_WORKER_SECONDS_READY,
 					_go_to_gst_ready,
 					worker);
@@ -435,26 +869,12 @@ static void _remove_ready_timeout(MafwGstRendererWorker *worker)
 {
 	if (worker->ready_timeout != 0) {
                 g_debug("removing timeout for READY");
-		g_source_remove(worker->ready_timeout);
+		_remove_source(worker, worker->ready_timeout);
 		worker->ready_timeout = 0;
 	}
 	worker->in_ready = FALSE;
 }
 
-static gboolean _emit_video_info(MafwGstRendererWorker *worker)
-{
-	mafw_renderer_emit_metadata_int(worker->owner,
-				    MAFW_METADATA_KEY_RES_X,
-				    worker->media.video_width);
-	mafw_renderer_emit_metadata_int(worker->owner,
-				    MAFW_METADATA_KEY_RES_Y,
-				    worker->media.video_height);
-	mafw_renderer_emit_metadata_double(worker->owner,
-				       MAFW_METADATA_KEY_VIDEO_FRAMERATE,
-				       worker->media.fps);
-	return FALSE;
-}
-
 /*
  * Checks if the video details are supported.  It also extracts other useful
  * information (such as PAR and framerate) from the caps, if available.  NOTE:
@@ -466,21 +886,20 @@ static gboolean _emit_video_info(MafwGstRendererWorker *worker)
 static gboolean _handle_video_info(MafwGstRendererWorker *worker,
 				   const GstStructure *structure)
 {
-	gint width, height;
+	gint width, height, par_n, par_d;
 	gdouble fps;
 
 	width = height = 0;
+	par_n = par_d = 1;
 	gst_structure_get_int(structure, "width", &width);
 	gst_structure_get_int(structure, "height", &height);
 	g_debug("video size: %d x %d", width, height);
 	if (gst_structure_has_field(structure, "pixel-aspect-ratio"))
 	{
 		gst_structure_get_fraction(structure, "pixel-aspect-ratio",
-					   &worker->media.par_n,
-					   &worker->media.par_d);
-		g_debug("video PAR: %d:%d", worker->media.par_n,
-			worker->media.par_d);
-		width = width * worker->media.par_n / worker->media.par_d;
+					   &par_n, &par_d);
+		g_debug("video PAR: %d:%d", par_n, par_d);
+		width = width * par_n / par_d;
 	}
 
 	fps = 1.0;
@@ -495,28 +914,27 @@ static gboolean _handle_video_info(MafwGstRendererWorker *worker,
 		g_debug("video fps: %f", fps);
 	}
 
+	g_mutex_lock(worker->media_lock);
+	worker->media.par_n = par_n;
+	worker->media.par_d = par_d;
 	worker->media.video_width = width;
 	worker->media.video_height = height;
 	worker->media.fps = fps;
+	g_mutex_unlock(worker->media_lock);
 
 	/* Add the info to the current metadata. */
-        gint p_width, p_height, p_fps;
-
-        p_width = width;
-        p_height = height;
-        p_fps = fps;
-
 	_current_metadata_add(worker, MAFW_METADATA_KEY_RES_X, G_TYPE_INT,
-			      p_width);
+			      width);
 	_current_metadata_add(worker, MAFW_METADATA_KEY_RES_Y, G_TYPE_INT,
-			      p_height);
+			      height);
 	_current_metadata_add(worker, MAFW_METADATA_KEY_VIDEO_FRAMERATE,
-			      G_TYPE_DOUBLE,
-			      p_fps);
+			      G_TYPE_DOUBLE, fps);
 
-
-	/* Emit the metadata.*/
-	g_idle_add((GSourceFunc)_emit_video_info, worker);
+	/* Emit the metadata, on the owner context */
+	_emit_metadata(worker, MAFW_METADATA_KEY_RES_X, G_TYPE_INT, width);
+	_emit_metadata(worker, MAFW_METADATA_KEY_RES_Y, G_TYPE_INT, height);
+	_emit_metadata(worker, MAFW_METADATA_KEY_VIDEO_FRAMERATE,
+		       G_TYPE_DOUBLE, fps);
 
 	return TRUE;
 }
@@ -611,7 +1029,9 @@ static GstBusSyncReply _sync_bus_handler(GstBus *bus, GstMessage *msg,
 	    gst_structure_has_name(msg->structure, "prepare-xwindow-id"))
 	{
 		g_debug("got prepare-xwindow-id");
+		g_mutex_lock(worker->media_lock);
 		worker->media.has_visual_content = TRUE;
+		g_mutex_unlock(worker->media_lock);
 		/* The user has to preset the XID, we don't create windows by
 		 * ourselves. */
 		if (!worker->xid) {
@@ -689,7 +1109,6 @@ static gboolean _seconds_duration_equal(gint64 duration1, gint64 duration2)
 
 static void _check_duration(MafwGstRendererWorker *worker, gint64 value)
 {
-	MafwGstRenderer *renderer = worker->owner;
 	gboolean right_query = TRUE;
 
 	if (value == -1) {
@@ -709,35 +1128,27 @@ static void _check_duration(MafwGstRendererWorker *worker, gint64 value)
                                                 G_TYPE_INT64,
                                                 (gint64)duration_seconds);
 			/* Emit the duration. */
-			mafw_renderer_emit_metadata_int64(
-				worker->owner, MAFW_METADATA_KEY_DURATION,
-                                (gint64)duration_seconds);
+			_emit_metadata(worker, MAFW_METADATA_KEY_DURATION,
+				       G_TYPE_INT64, (gint64)duration_seconds);
 		}
 
-		/* We compare this duration we just got with the
-		 * source one and update it in the source if needed */
-                if (duration_seconds > 0 &&
-                        duration_seconds != renderer->media->duration) {
-			mafw_gst_renderer_update_source_duration(
-				renderer,
-				duration_seconds);
-		}
+		_notify_value(worker, WORKER_NOTIFY_DURATION,
+			      duration_seconds);
 	}
 
-	worker->media.length_nanos = value;
+	_set_length(worker, value);
 	g_debug("media duration: %lld", worker->media.length_nanos);
 }
 
 static void _check_seekability(MafwGstRendererWorker *worker)
 {
-	MafwGstRenderer *renderer = worker->owner;
 	SeekabilityType seekable = SEEKABILITY_NO_SEEKABLE;
 
 	if (worker->media.length_nanos != -1)
 	{
-		g_debug("source seekability %d", renderer->media->seekability);
+		g_debug("source seekability %d", worker->media.source_seekable);
 
-		if (renderer->media->seekability != SEEKABILITY_NO_SEEKABLE) {
+		if (worker->media.source_seekable != SEEKABILITY_NO_SEEKABLE) {
 			g_debug("Quering GStreamer for seekability");
 			GstQuery *seek_query;
 			GstFormat format = GST_FORMAT_TIME;
@@ -765,13 +1176,14 @@ static void _check_seekability(MafwGstRendererWorker *worker)
 			G_TYPE_BOOLEAN, is_seekable);
 
 		/* Emit. */
-		mafw_renderer_emit_metadata_boolean(
-			worker->owner, MAFW_METADATA_KEY_IS_SEEKABLE,
-			is_seekable);
+		_emit_metadata(worker, MAFW_METADATA_KEY_IS_SEEKABLE,
+			       G_TYPE_BOOLEAN, is_seekable);
 	}
 
 	g_debug("media seekable: %d", seekable);
+	g_mutex_lock(worker->media_lock);
 	worker->media.seekable = seekable;
+	g_mutex_unlock(worker->media_lock);
 }
 
 static gboolean _query_duration_and_seekability_timeout(gpointer data)
@@ -786,12 +1198,195 @@ static gboolean _query_duration_and_seekability_timeout(gpointer data)
 	return FALSE;
 }
 
+/*
+ * Ends the measure of a track switch started by stop(), once the new track
+ * has prerolled, and logs it along with the running figures.
+ */
+static void _end_track_switch(MafwGstRendererWorker *worker)
+{
+	gdouble ms;
+
+	if (!worker->switch_pending)
+		return;
+
+	worker->switch_pending = FALSE;
+	ms = 1000.0 * g_timer_elapsed(worker->switch_timer, NULL);
+	g_mutex_lock(worker->stats_lock);
+	worker->switch_count++;
+	worker->switch_total += ms;
+	worker->switch_max = MAX(worker->switch_max, ms);
+	g_mutex_unlock(worker->stats_lock);
+
+	g_debug("track switch: %.1f ms, %.1f ms of them in stop "
+		"(%s pipeline); mean %.1f ms, max %.1f ms over %u switches",
+		ms, worker->switch_stop,
+		worker->reuse_pipeline ? "reusing" : "rebuilding",
+		worker->switch_total / worker->switch_count,
+		worker->switch_max, worker->switch_count);
+}
+
+/*
+ * Starts timing a section run from the main loop.  Sections nest, the
+ * outermost one being the one timed.
+ */
+static void _stall_begin(MafwGstRendererWorker *worker)
+{
+	if (worker->stall_depth++ == 0)
+		g_timer_start(worker->stall_timer);
+}
+
+/*
+ * Ends a section started by _stall_begin(), keeping it as the longest stall
+ * of the session if it is.  @what names the section.
+ */
+static void _stall_end(MafwGstRendererWorker *worker, const gchar *what)
+{
+	gdouble ms;
+
+	g_assert(worker->stall_depth > 0);
+	if (--worker->stall_depth > 0)
+		return;
+
+	ms = 1000.0 * g_timer_elapsed(worker->stall_timer, NULL);
+	if (ms > worker->stall_max) {
+		worker->stall_max = ms;
+		worker->stall_where = what;
+	}
+	if (ms > worker->stall_peak) {
+		g_mutex_lock(worker->stats_lock);
+		worker->stall_peak = ms;
+		worker->stall_peak_where = what;
+		g_mutex_unlock(worker->stats_lock);
+	}
+}
+
+/*
+ * Gets the longest section run from the main loop since the worker was
+ * created, in milliseconds, and its name, NULL if none was timed.  Either
+ * may be NULL.
+ */
+void mafw_gst_renderer_worker_get_stall_stats(MafwGstRendererWorker *worker,
+					      gdouble *max_ms,
+					      const gchar **where)
+{
+	g_assert(worker != NULL);
+
+	g_mutex_lock(worker->stats_lock);
+	if (max_ms != NULL)
+		*max_ms = worker->stall_peak;
+	if (where != NULL)
+		*where = worker->stall_peak_where;
+	g_mutex_unlock(worker->stats_lock);
+}
+
+/*
+ * The position is queried from the pipeline only at points where it may
+ * jump or stop moving: state changes, prerolls (seeks landing among them),
+ * buffering and media switches.  In between, it is worked out from the
+ * time the pipeline clock has run since, so that polling it is cheap and
+ * can be done from any thread.
+ */
+
+/* The seek position and the length are only written by the worker, but
+ * read along with the anchor from any thread */
+static void _set_seek_position(MafwGstRendererWorker *worker, gint position)
+{
+	g_mutex_lock(worker->position_lock);
+	worker->seek_position = position;
+	g_mutex_unlock(worker->position_lock);
+}
+
+static void _set_length(MafwGstRendererWorker *worker, gint64 length)
+{
+	g_mutex_lock(worker->position_lock);
+	worker->media.length_nanos = length;
+	g_mutex_unlock(worker->position_lock);
+}
+
+static void _drop_position(MafwGstRendererWorker *worker)
+{
+	g_mutex_lock(worker->position_lock);
+	worker->position_valid = FALSE;
+	if (worker->position_clock != NULL) {
+		gst_object_unref(worker->position_clock);
+		worker->position_clock = NULL;
+	}
+	g_mutex_unlock(worker->position_lock);
+}
+
+/*
+ * Queries the position and anchors it to the pipeline clock, which it
+ * follows if @running, the pipeline being in PLAYING.
+ */
+static void _anchor_position(MafwGstRendererWorker *worker, gboolean running)
+{
+	GstFormat format = GST_FORMAT_TIME;
+	GstClock *clock = NULL;
+	gint64 time;
+
+	if (worker->pipeline == NULL ||
+	    !gst_element_query_position(worker->pipeline, &format, &time) ||
+	    time < 0) {
+		_drop_position(worker);
+		return;
+	}
+
+	if (running)
+		clock = gst_element_get_clock(worker->pipeline);
+
+	g_mutex_lock(worker->position_lock);
+	if (worker->position_clock != NULL)
+		gst_object_unref(worker->position_clock);
+	worker->position_clock = clock;
+	worker->position_base = time;
+	if (clock != NULL)
+		worker->position_base_time = gst_clock_get_time(clock);
+	worker->position_valid = TRUE;
+	g_mutex_unlock(worker->position_lock);
+}
+
+static gboolean _pipeline_running(MafwGstRendererWorker *worker)
+{
+	return worker->pipeline != NULL &&
+		GST_STATE(worker->pipeline) == GST_STATE_PLAYING;
+}
+
+/*
+ * Works the position out from the anchor, in nanoseconds.  Returns FALSE if
+ * there is no anchor.
+ */
+static gboolean _interpolate_position(MafwGstRendererWorker *worker,
+				      gint64 *time)
+{
+	gboolean valid;
+
+	g_mutex_lock(worker->position_lock);
+	valid = worker->position_valid;
+	if (valid) {
+		*time = worker->position_base;
+		if (worker->position_clock != NULL) {
+			GstClockTime now;
+
+			now = gst_clock_get_time(worker->position_clock);
+			if (now > worker->position_base_time)
+				*time += now - worker->position_base_time;
+		}
+	}
+	if (valid && worker->media.length_nanos > 0)
+		*time = MIN(*time, worker->media.length_nanos);
+	g_mutex_unlock(worker->position_lock);
+
+	return valid;
+}
+
 /*
  * Called when the pipeline transitions into PAUSED state.  It extracts more
  * information from Gst.
  */
 static void _finalize_startup(MafwGstRendererWorker *worker)
 {
+	_end_track_switch(worker);
+
 	/* Check video caps */
 	if (worker->media.has_visual_content) {
 		GstPad *pad = GST_BASE_SINK_PAD(worker->vsink);
@@ -820,19 +1415,24 @@ static void _finalize_startup(MafwGstRendererWorker *worker)
 
 	/* Check duration and seekability */
 	if (worker->duration_seek_timeout != 0) {
-		g_source_remove(worker->duration_seek_timeout);
+		_remove_source(worker, worker->duration_seek_timeout);
 		worker->duration_seek_timeout = 0;
 	}
 	_check_duration(worker, -1);
 	_check_seekability(worker);
+
+	/* Now that we know whether there is video */
+	_update_gapless_next(worker);
+	_update_standby(worker);
 }
 
 static void _add_duration_seek_query_timeout(MafwGstRendererWorker *worker)
 {
 	if (worker->duration_seek_timeout != 0) {
-		g_source_remove(worker->duration_seek_timeout);
+		_remove_source(worker, worker->duration_seek_timeout);
 	}
-	worker->duration_seek_timeout = g_timeout_add_seconds(
+	worker->duration_seek_timeout = _timeout_add_seconds(
+		worker,
 		MAFW_GST_RENDERER_WORKER_SECONDS_DURATION_AND_SEEKABILITY,
 		_query_duration_and_seekability_timeout,
 		worker);
@@ -840,9 +1440,8 @@ static void _add_duration_seek_query_timeout(MafwGstRendererWorker *worker)
 
 static void _do_pause_postprocessing(MafwGstRendererWorker *worker)
 {
-	if (worker->notify_pause_handler) {
-		worker->notify_pause_handler(worker, worker->owner);
-	}
+	worker->pause_pending = FALSE;
+	_notify(worker, WORKER_NOTIFY_PAUSE);
 
 #ifdef HAVE_GDKPIXBUF
 	if (worker->media.has_visual_content &&
@@ -869,10 +1468,7 @@ static void _report_playing_state(MafwGstRendererWorker * worker)
 		case WORKER_MODE_SINGLE_PLAY:
 			/* Notify play if we are playing in
 			 * single mode */
-			if (worker->notify_play_handler)
-				worker->notify_play_handler(
-					worker,
-					worker->owner);
+			_notify(worker, WORKER_NOTIFY_PLAY);
 			break;
 		case WORKER_MODE_PLAYLIST:
 		case WORKER_MODE_REDUNDANT:
@@ -880,10 +1476,7 @@ static void _report_playing_state(MafwGstRendererWorker * worker)
 			   playback starts, don't notify play for each
 			   individual element of the playlist. */
 			if (worker->pl.notify_play_pending) {
-				if (worker->notify_play_handler)
-					worker->notify_play_handler(
-						worker,
-						worker->owner);
+				_notify(worker, WORKER_NOTIFY_PLAY);
 				worker->pl.notify_play_pending = FALSE;
 			}
 			break;
@@ -896,7 +1489,6 @@ static void _handle_state_changed(GstMessage *msg, MafwGstRendererWorker *worker
 {
 	GstState newstate, oldstate;
 	GstStateChange statetrans;
-	MafwGstRenderer *renderer = (MafwGstRenderer*)worker->owner;
 
 	gst_message_parse_state_changed(msg, &oldstate, &newstate, NULL);
 	statetrans = GST_STATE_TRANSITION(oldstate, newstate);
@@ -961,7 +1553,7 @@ static void _handle_state_changed(GstMessage *msg, MafwGstRendererWorker *worker
 			g_debug ("Prerolling done, finalizaing startup");
 			_finalize_startup(worker);
 			_do_play(worker);
-			renderer->play_failed_count = 0;
+			_notify(worker, WORKER_NOTIFY_PLAYABLE);
 
 			if (worker->stay_paused) {
 				_do_pause_postprocessing(worker);
@@ -978,9 +1570,11 @@ static void _handle_state_changed(GstMessage *msg, MafwGstRendererWorker *worker
 		}
 		break;
 	case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
-		/* if seek was called, at this point it is really ended */
-		worker->seek_position = -1;
-                worker->eos = FALSE;
+		/* if seek was called, at this point it is really ended,
+		 * unless another one has been sent meanwhile */
+		if (!worker->seek_in_flight)
+			_set_seek_position(worker, -1);
+		_set_eos(worker, FALSE);
 
 		/* Signal state change if needed */
 		_report_playing_state(worker);
@@ -996,10 +1590,8 @@ static void _handle_state_changed(GstMessage *msg, MafwGstRendererWorker *worker
                  * candidates, so when we get a successful playback, we notify
                  * the real URI that we are playing */
                 if (worker->mode == WORKER_MODE_REDUNDANT) {
-                        mafw_renderer_emit_metadata_string(
-                                worker->owner,
-                                MAFW_METADATA_KEY_URI,
-                                worker->media.location);
+                        _emit_metadata(worker, MAFW_METADATA_KEY_URI,
+                                       G_TYPE_STRING, worker->media.location);
                 }
 
 		/* Emit metadata. We wait until we reach the playing
@@ -1008,6 +1600,7 @@ static void _handle_state_changed(GstMessage *msg, MafwGstRendererWorker *worker
 		/* Query duration and seekability. Useful for vbr
 		 * clips or streams. */
 		_add_duration_seek_query_timeout(worker);
+		_schedule_crossfade(worker);
 		break;
 	case GST_STATE_CHANGE_PAUSED_TO_READY:
 		/* If we went to READY, we free the taglist and
@@ -1030,7 +1623,7 @@ static void _handle_duration(MafwGstRendererWorker *worker, GstMessage *msg)
 	gst_message_parse_duration(msg, &fmt, &duration);
 
 	if (worker->duration_seek_timeout != 0) {
-		g_source_remove(worker->duration_seek_timeout);
+		_remove_source(worker, worker->duration_seek_timeout);
 		worker->duration_seek_timeout = 0;
 	}
 
@@ -1172,10 +1765,7 @@ static void _emit_tag(const GstTagList *list, const gchar *tag,
 	}
 
 	/* Emit the metadata. */
-	g_signal_emit_by_name(worker->owner, "metadata-changed", mafwtag,
-			      values);
-
-	g_value_array_free(values);
+	_emit_metadata_values(worker, mafwtag, values);
 }
 
 /**
@@ -1190,8 +1780,9 @@ static void _handle_tag(MafwGstRendererWorker *worker, GstMessage *msg)
 	g_ptr_array_add(worker->tag_list, gst_message_ref(msg));
 
 	/* Some tags come in playing state, so in this case we have
-	   to emit them right away (example: radio stations) */
-	if (worker->state == GST_STATE_PLAYING) {
+	   to emit them right away (example: radio stations).  Those of
+	   a media queued for gapless playback wait until it starts. */
+	if (worker->state == GST_STATE_PLAYING && !worker->gapless_pending) {
 		_emit_metadatas(worker);
 	}
 }
@@ -1239,10 +1830,49 @@ static void _reset_volume_and_mute_to_pipeline(MafwGstRendererWorker *worker)
 #endif
 }
 
+/*
+ * Moves the pipeline to @state for the buffering handler, without waiting
+ * for it to get there: until its STATE_CHANGED or ASYNC_DONE message
+ * comes, the state asked for is kept in buffering_state, and taken as the
+ * current one by further buffering messages.
+ */
+static void _set_buffering_state(MafwGstRendererWorker *worker,
+				 GstState state)
+{
+	if (gst_element_set_state(worker->pipeline, state) ==
+	    GST_STATE_CHANGE_ASYNC) {
+		worker->buffering_state = state;
+	} else {
+		worker->buffering_state = GST_STATE_VOID_PENDING;
+	}
+}
+
+/* State of the pipeline as far as the buffering handler is concerned */
+static GstState _get_buffering_state(MafwGstRendererWorker *worker)
+{
+	if (worker->buffering_state != GST_STATE_VOID_PENDING)
+		return worker->buffering_state;
+	return worker->state;
+}
+
+/*
+ * The pipeline got to @state: a state change of the buffering handler
+ * aiming at it is over.
+ */
+static void _buffering_state_reached(MafwGstRendererWorker *worker,
+				     GstState state)
+{
+	if (worker->buffering_state == state) {
+		g_debug("buffering state change to %s done",
+			gst_element_state_get_name(state));
+		worker->buffering_state = GST_STATE_VOID_PENDING;
+	}
+}
+
 static void _handle_buffering(MafwGstRendererWorker *worker, GstMessage *msg)
 {
 	gint percent;
-	MafwGstRenderer *renderer = (MafwGstRenderer*)worker->owner;
+	GstState state;
 
 	gst_message_parse_buffering(msg, &percent);
 	g_debug("buffering: %d", percent);
@@ -1250,7 +1880,8 @@ static void _handle_buffering(MafwGstRendererWorker *worker, GstMessage *msg)
         /* No state management needed for live pipelines */
         if (!worker->is_live) {
 		worker->buffering = TRUE;
-                if (percent < 100 && worker->state == GST_STATE_PLAYING) {
+		state = _get_buffering_state(worker);
+                if (percent < 100 && state == GST_STATE_PLAYING) {
 			g_debug("setting pipeline to PAUSED not to wolf the "
 				"buffer down");
 			worker->report_statechanges = FALSE;
@@ -1259,22 +1890,15 @@ static void _handle_buffering(MafwGstRendererWorker *worker, GstMessage *msg)
 			 * want that, application doesn't need to know
 			 * that internally the state changed to
 			 * PAUSED. */
-			if (gst_element_set_state(worker->pipeline,
-					      GST_STATE_PAUSED) ==
-		    			GST_STATE_CHANGE_ASYNC)
-			{
-				/* XXX this blocks at most 2 seconds. */
-				gst_element_get_state(worker->pipeline, NULL,
-					      NULL,
-					      2 * GST_SECOND);
-			}
+			_set_buffering_state(worker, GST_STATE_PAUSED);
+			state = GST_STATE_PAUSED;
 		}
 
                 if (percent >= 100) {
                         /* On buffering we go to PAUSED, so here we move back to
                            PLAYING */
                         worker->buffering = FALSE;
-                        if (worker->state == GST_STATE_PAUSED) {
+                        if (state == GST_STATE_PAUSED) {
                                 /* If buffering more than once, do this only the
                                    first time we are done with buffering */
                                 if (worker->prerolling) {
@@ -1282,13 +1906,11 @@ static void _handle_buffering(MafwGstRendererWorker *worker, GstMessage *msg)
 						"prerolling");
 					_finalize_startup(worker);
 					_do_play(worker);
-					renderer->play_failed_count = 0;
+					_notify(worker, WORKER_NOTIFY_PLAYABLE);
 					/* Send the paused notification */
-					if (worker->stay_paused &&
-					    worker->notify_pause_handler) {
-						worker->notify_pause_handler(
-							worker,
-							worker->owner);
+					if (worker->stay_paused) {
+						_notify(worker,
+							WORKER_NOTIFY_PAUSE);
 					}
 					worker->prerolling = FALSE;
                                 } else if (worker->in_ready) {
@@ -1311,18 +1933,10 @@ static void _handle_buffering(MafwGstRendererWorker *worker, GstMessage *msg)
 						"pipeline to PLAYING again");
 					_reset_volume_and_mute_to_pipeline(
 						worker);
-					if (gst_element_set_state(
-						worker->pipeline,
-						GST_STATE_PLAYING) ==
-		    					GST_STATE_CHANGE_ASYNC)
-					{
-						/* XXX this blocks at most 2 seconds. */
-						gst_element_get_state(
-							worker->pipeline, NULL, NULL,
-							2 * GST_SECOND);
-					}
+					_set_buffering_state(worker,
+							     GST_STATE_PLAYING);
 				}
-                        } else if (worker->state == GST_STATE_PLAYING) {
+                        } else if (state == GST_STATE_PLAYING) {
 				g_debug("buffering concluded, signalling "
 					"state change");
 				/* In this case we got a PLAY command while 
@@ -1337,31 +1951,21 @@ static void _handle_buffering(MafwGstRendererWorker *worker, GstMessage *msg)
                                 /* Set the pipeline to playing. This is an async
                                    handler, it could be, that the reported state
                                    is not the real-current state */
-                                if (gst_element_set_state(
-                                                worker->pipeline,
-                                                GST_STATE_PLAYING) ==
-                                                        GST_STATE_CHANGE_ASYNC)
-                                {
-                                        /* XXX this blocks at most 2 seconds. */
-                                        gst_element_get_state(
-                                                worker->pipeline, NULL, NULL,
-                                                2 * GST_SECOND);
-                                }
-				if (worker->report_statechanges &&
-                		    worker->notify_play_handler) {
-					worker->notify_play_handler(
-                                               		worker,
-	                                                worker->owner);
+                                _set_buffering_state(worker,
+                                                     GST_STATE_PLAYING);
+				if (worker->report_statechanges) {
+					_notify(worker, WORKER_NOTIFY_PLAY);
 				}
                                 _add_duration_seek_query_timeout(worker);
                         }
                 }
         }
 
+	/* Playback may have stalled or resumed */
+	_anchor_position(worker, _pipeline_running(worker));
+
 	/* Send buffer percentage */
-        if (worker->notify_buffer_status_handler)
-                worker->notify_buffer_status_handler(worker, worker->owner,
-						     percent);
+        _notify_value(worker, WORKER_NOTIFY_BUFFER_STATUS, percent);
 }
 
 static void _handle_element_msg(MafwGstRendererWorker *worker, GstMessage *msg)
@@ -1370,22 +1974,47 @@ static void _handle_element_msg(MafwGstRendererWorker *worker, GstMessage *msg)
 	if (gst_structure_has_name(msg->structure, "resolution") &&
 	    _handle_video_info(worker, msg->structure))
 	{
+		g_mutex_lock(worker->media_lock);
 		worker->media.has_visual_content = TRUE;
+		g_mutex_unlock(worker->media_lock);
 	}
 }
 
+static void _free_pl_items(MafwGstRendererWorker *worker)
+{
+	g_ptr_array_foreach(worker->pl.items, (GFunc) g_free, NULL);
+	g_ptr_array_free(worker->pl.items, TRUE);
+	worker->pl.items = NULL;
+}
+
 static void _reset_pl_info(MafwGstRendererWorker *worker)
 {
-	if (worker->pl.items) {
-		g_slist_foreach(worker->pl.items, (GFunc) g_free, NULL);
-		g_slist_free(worker->pl.items);
-		worker->pl.items = NULL;
+	_cancel_parse(worker);
+	if (worker->pl.items->len > 0) {
+		_free_pl_items(worker);
+		worker->pl.items = g_ptr_array_new();
 	}
 
 	worker->pl.current = 0;
 	worker->pl.notify_play_pending = TRUE;
 }
 
+/* Whether there are entries after the current one */
+static gboolean _pl_has_next(MafwGstRendererWorker *worker)
+{
+	return worker->pl.current + 1 < (gint) worker->pl.items->len;
+}
+
+/* Appends the entries in @items to the playlist, which takes them */
+static void _append_pl_items(MafwGstRendererWorker *worker, GSList *items)
+{
+	GSList *l;
+
+	for (l = items; l != NULL; l = l->next)
+		g_ptr_array_add(worker->pl.items, l->data);
+	g_slist_free(items);
+}
+
 static GError * _get_specific_missing_plugin_error(GstMessage *msg)
 {
 	const GstStructure *gst_struct;
@@ -1442,11 +2071,8 @@ static GError * _get_specific_missing_plugin_error(GstMessage *msg)
 	return error;
 }
 
-/*
- * Asynchronous message handler.  It gets removed from if it returns FALSE.
- */
-static gboolean _async_bus_handler(GstBus *bus, GstMessage *msg,
-				   MafwGstRendererWorker *worker)
+static gboolean _handle_bus_message(GstMessage *msg,
+				    MafwGstRendererWorker *worker)
 {
 	/* No need to handle message if error has already occured. */
 	if (worker->is_error)
@@ -1466,6 +2092,9 @@ static gboolean _async_bus_handler(GstBus *bus, GstMessage *msg,
 
 	switch (GST_MESSAGE_TYPE(msg)) {
 	case GST_MESSAGE_ERROR:
+		/* The seek in flight, if any, is not landing anymore */
+		_reset_seeks(worker);
+		_set_seek_position(worker, -1);
 		if (!worker->is_error) {
 			gchar *debug;
 			GError *err;
@@ -1486,8 +2115,7 @@ static gboolean _async_bus_handler(GstBus *bus, GstMessage *msg,
 
 			if (worker->mode == WORKER_MODE_PLAYLIST ||
                             worker->mode == WORKER_MODE_REDUNDANT) {
-				if (worker->pl.current <
-				    (g_slist_length(worker->pl.items) - 1)) {
+				if (_pl_has_next(worker)) {
 					/* If the error is "no space left"
 					   notify, otherwise try to play the
 					   next item */
@@ -1498,6 +2126,10 @@ static gboolean _async_bus_handler(GstBus *bus, GstMessage *msg,
 					} else {
 						_play_pl_next(worker);
 					}
+				} else if (worker->pl.parse != NULL) {
+					/* More entries are on their way */
+					worker->pl.stalled = TRUE;
+					worker->pl.stalled_error = err;
 				} else {
                                         /* Playlist EOS. We cannot try another
                                          * URI, so we have to go back to normal
@@ -1511,17 +2143,17 @@ static gboolean _async_bus_handler(GstBus *bus, GstMessage *msg,
 			if (worker->mode == WORKER_MODE_SINGLE_PLAY) {
                                 if (err->domain == GST_STREAM_ERROR &&
                                         err->code == GST_STREAM_ERROR_WRONG_TYPE)
-                                {/* Maybe it is a playlist? */
-                                        GSList *plitems = _parse_playlist(worker->media.location);
-
-                                        if (plitems)
-                                        {/* Yes, it is a plitem */
-                                                g_error_free(err);
-                                                mafw_gst_renderer_worker_play(worker, NULL, plitems);
-                                                break;
-                                        }
-
+                                {/* Maybe it is a playlist?  If it has no
+                                    entries, the error is sent then */
+                                        gchar *location;
 
+                                        location = g_strdup(worker->media.location);
+                                        mafw_gst_renderer_worker_stop(worker);
+                                        _reset_media_info(worker);
+                                        _reset_pl_info(worker);
+                                        _start_parse(worker, location, err);
+                                        g_free(location);
+                                        break;
                                 }
 				_send_error(worker, err);
 			}
@@ -1529,14 +2161,16 @@ static gboolean _async_bus_handler(GstBus *bus, GstMessage *msg,
 		break;
 	case GST_MESSAGE_EOS:
 		if (!worker->is_error) {
-			worker->eos = TRUE;
+			_set_eos(worker, TRUE);
 
 			if (worker->mode == WORKER_MODE_PLAYLIST) {
-				if (worker->pl.current <
-				    (g_slist_length(worker->pl.items) - 1)) {
+				if (_pl_has_next(worker)) {
 					/* If the playlist EOS is not reached
 					   continue playing */
 					_play_pl_next(worker);
+				} else if (worker->pl.parse != NULL) {
+					/* More entries are on their way */
+					worker->pl.stalled = TRUE;
 				} else {
 					/* Playlist EOS, go back to normal
 					   mode */
@@ -1547,10 +2181,7 @@ static gboolean _async_bus_handler(GstBus *bus, GstMessage *msg,
 
 			if (worker->mode == WORKER_MODE_SINGLE_PLAY ||
                             worker->mode == WORKER_MODE_REDUNDANT) {
-				if (worker->notify_eos_handler)
-					worker->notify_eos_handler(
-						worker,
-						worker->owner);
+				_notify(worker, WORKER_NOTIFY_EOS);
 
 				/* We can remove the message handlers now, we
 				   are not interested in bus messages
@@ -1561,7 +2192,7 @@ static gboolean _async_bus_handler(GstBus *bus, GstMessage *msg,
 								 NULL);
 				}
 				if (worker->async_bus_id) {
-					g_source_remove(worker->async_bus_id);
+					_remove_source(worker, worker->async_bus_id);
 					worker->async_bus_id = 0;
 				}
 
@@ -1586,8 +2217,34 @@ static gboolean _async_bus_handler(GstBus *bus, GstMessage *msg,
 		_handle_element_msg(worker, msg);
 		break;
 	case GST_MESSAGE_STATE_CHANGED:
-		if ((GstElement *)GST_MESSAGE_SRC(msg) == worker->pipeline)
+		if ((GstElement *)GST_MESSAGE_SRC(msg) == worker->pipeline) {
+			GstState newstate;
+
+			gst_message_parse_state_changed(msg, NULL, &newstate,
+							NULL);
+			_buffering_state_reached(worker, newstate);
+			if (newstate >= GST_STATE_PAUSED)
+				_anchor_position(worker,
+						 newstate == GST_STATE_PLAYING);
+			else
+				_drop_position(worker);
 			_handle_state_changed(msg, worker);
+		}
+		break;
+	case GST_MESSAGE_ASYNC_DONE:
+		/* The pipeline prerolled: a change to PAUSED is over, one to
+		 * PLAYING goes on without blocking */
+		if ((GstElement *)GST_MESSAGE_SRC(msg) == worker->pipeline) {
+			_buffering_state_reached(worker, GST_STATE_PAUSED);
+			_anchor_position(worker, _pipeline_running(worker));
+			_seek_landed(worker);
+			/* A pause asked for before the pipeline got to
+			 * PLAYING posts no PLAYING -> PAUSED change */
+			if (worker->pause_pending &&
+			    worker->state == GST_STATE_PAUSED &&
+			    worker->report_statechanges)
+				_do_pause_postprocessing(worker);
+		}
 		break;
 	case GST_MESSAGE_APPLICATION:
 		if (gst_structure_has_name(gst_message_get_structure(msg),
@@ -1596,16 +2253,32 @@ static gboolean _async_bus_handler(GstBus *bus, GstMessage *msg,
 			GValue v = {0};
 			g_value_init(&v, G_TYPE_INT);
 			g_value_set_int(&v, worker->colorkey);
-			mafw_extension_emit_property_changed(
-				MAFW_EXTENSION(worker->owner),
-				MAFW_PROPERTY_RENDERER_COLORKEY,
-				&v);
+			_emit_property(worker,
+				       MAFW_PROPERTY_RENDERER_COLORKEY, &v);
+		} else {
+			_handle_gapless_msg(worker,
+					    gst_message_get_structure(msg));
 		}
 	default: break;
 	}
 	return TRUE;
 }
 
+/*
+ * Asynchronous message handler.  It gets removed from if it returns FALSE.
+ */
+static gboolean _async_bus_handler(GstBus *bus, GstMessage *msg,
+				   MafwGstRendererWorker *worker)
+{
+	gboolean ret;
+
+	_stall_begin(worker);
+	ret = _handle_bus_message(msg, worker);
+	_stall_end(worker, GST_MESSAGE_TYPE_NAME(msg));
+
+	return ret;
+}
+
 /* NOTE this function will possibly be called from a different thread than the
  * glib main thread. */
 static void _stream_info_cb(GstObject *pipeline, GParamSpec *unused,
@@ -1615,13 +2288,32 @@ static void _stream_info_cb(GstObject *pipeline, GParamSpec *unused,
 	_parse_stream_info(worker);
 }
 
+static void _reset_volume_cmd(MafwGstRendererWorker *worker,
+			      WorkerCommand *cmd)
+{
+	_reset_volume_and_mute_to_pipeline(worker);
+}
+
+/*
+ * The volume manager stays on the owner context, its I/O being
+ * non-blocking: only the pipeline is set on the worker thread.
+ */
+static void _apply_volume(MafwGstRendererWorker *worker)
+{
+	if (_foreign_thread(worker)) {
+		_queue_command(worker, _command_new(_reset_volume_cmd));
+	} else {
+		_reset_volume_and_mute_to_pipeline(worker);
+	}
+}
+
 static void _volume_cb(MafwGstRendererWorkerVolume *wvolume, gdouble volume,
 		       gpointer data)
 {
 	MafwGstRendererWorker *worker = data;
 	GValue value = {0, };
 
-	_reset_volume_and_mute_to_pipeline(worker);
+	_apply_volume(worker);
 
 	g_value_init(&value, G_TYPE_UINT);
 	g_value_set_uint(&value, (guint) (volume * 100.0));
@@ -1638,7 +2330,7 @@ static void _mute_cb(MafwGstRendererWorkerVolume *wvolume, gboolean mute,
 	MafwGstRendererWorker *worker = data;
 	GValue value = {0, };
 
-	_reset_volume_and_mute_to_pipeline(worker);
+	_apply_volume(worker);
 
 	g_value_init(&value, G_TYPE_BOOLEAN);
 	g_value_set_boolean(&value, mute);
@@ -1682,21 +2374,301 @@ static int xerror(Display *dpy, XErrorEvent *xev)
 	return 0;
 }
 
+/*
+ * Sets the location of the media, which the owner may be reading from its
+ * own thread.
+ */
+static void _set_location(MafwGstRendererWorker *worker, const gchar *uri)
+{
+	gchar *old;
+
+	g_mutex_lock(worker->media_lock);
+	old = worker->media.location;
+	worker->media.location = g_strdup(uri);
+	g_mutex_unlock(worker->media_lock);
+	g_free(old);
+}
+
+/* Sets eos, which the owner may be reading from its own thread */
+static void _set_eos(MafwGstRendererWorker *worker, gboolean eos)
+{
+	g_mutex_lock(worker->media_lock);
+	worker->eos = eos;
+	g_mutex_unlock(worker->media_lock);
+}
+
+static void _clear_current_metadata(MafwGstRendererWorker *worker)
+{
+	GHashTable *old;
+
+	g_mutex_lock(worker->media_lock);
+	old = worker->current_metadata;
+	worker->current_metadata = NULL;
+	g_mutex_unlock(worker->media_lock);
+	if (old != NULL)
+		g_hash_table_destroy(old);
+}
+
 /*
  * Resets the media information.
  */
 static void _reset_media_info(MafwGstRendererWorker *worker)
 {
-	if (worker->media.location) {
-		g_free(worker->media.location);
-		worker->media.location = NULL;
-	}
-	worker->media.length_nanos = -1;
+	_set_location(worker, NULL);
+	_set_length(worker, -1);
+	g_mutex_lock(worker->media_lock);
 	worker->media.has_visual_content = FALSE;
 	worker->media.seekable = SEEKABILITY_UNKNOWN;
 	worker->media.video_width = 0;
 	worker->media.video_height = 0;
 	worker->media.fps = 0.0;
+	g_mutex_unlock(worker->media_lock);
+}
+
+/*----------------------------------------------------------------------------
+  Gapless playback
+  ----------------------------------------------------------------------------*/
+
+/*
+ * playbin2 emits about-to-finish from its streaming thread once the current
+ * media has been read completely.  Setting the uri from there makes it carry
+ * on with the next media into the same sinks, without draining them.  The
+ * main thread publishes the URI to use in gapless_next, and the streaming
+ * thread moves it to gapless_queued when it queues it; both are protected
+ * by gapless_lock.  Everything else is done back in the main thread, from
+ * the application messages posted here.
+ */
+static void _about_to_finish_cb(GstElement *playbin,
+				MafwGstRendererWorker *worker)
+{
+	g_mutex_lock(worker->gapless_lock);
+	if (worker->gapless_next != NULL) {
+		g_debug("about to finish, queueing %s", worker->gapless_next);
+		g_free(worker->gapless_queued);
+		worker->gapless_queued = worker->gapless_next;
+		worker->gapless_next = NULL;
+		g_object_set(playbin, "uri", worker->gapless_queued, NULL);
+		gst_element_post_message(
+			playbin,
+			gst_message_new_application(
+				GST_OBJECT(playbin),
+				gst_structure_new("mafw-about-to-finish",
+						  NULL)));
+	}
+	g_mutex_unlock(worker->gapless_lock);
+}
+
+/*
+ * The first new segment reaching the audio bin after about-to-finish is the
+ * start of the queued media, unless a flushing seek came in between: the
+ * segment following the flush is the one of the seek, in the media still
+ * playing.  It is only a few buffers ahead of what is being heard, which is
+ * close enough to switch the metadata over.  The message goes to the bus
+ * of the pipeline the pad is in, which may not be worker->pipeline any
+ * more by the time it is handled.
+ */
+static gboolean _gapless_segment_cb(GstPad *pad, GstEvent *event,
+				    MafwGstRendererWorker *worker)
+{
+	GstElement *element;
+	gboolean update;
+	gchar *uri;
+
+	if (GST_EVENT_TYPE(event) == GST_EVENT_FLUSH_STOP) {
+		g_mutex_lock(worker->gapless_lock);
+		worker->gapless_flushed = worker->gapless_queued != NULL;
+		g_mutex_unlock(worker->gapless_lock);
+		return TRUE;
+	}
+
+	if (GST_EVENT_TYPE(event) != GST_EVENT_NEWSEGMENT)
+		return TRUE;
+
+	gst_event_parse_new_segment(event, &update, NULL, NULL, NULL, NULL,
+				    NULL);
+	if (update)
+		return TRUE;
+
+	g_mutex_lock(worker->gapless_lock);
+	if (worker->gapless_flushed) {
+		worker->gapless_flushed = FALSE;
+		uri = NULL;
+	} else {
+		uri = worker->gapless_queued;
+		worker->gapless_queued = NULL;
+	}
+	g_mutex_unlock(worker->gapless_lock);
+
+	if (uri == NULL)
+		return TRUE;
+
+	element = gst_pad_get_parent_element(pad);
+	if (element != NULL) {
+		gst_element_post_message(
+			element,
+			gst_message_new_application(
+				GST_OBJECT(element),
+				gst_structure_new("mafw-track-changed",
+						  "uri", G_TYPE_STRING, uri,
+						  NULL)));
+		gst_object_unref(element);
+	}
+	g_free(uri);
+
+	return TRUE;
+}
+
+/* Stops watching the audio bin for the start of queued media */
+static void _detach_gapless_probe(MafwGstRendererWorker *worker)
+{
+	if (worker->gapless_pad == NULL)
+		return;
+
+	gst_pad_remove_event_probe(worker->gapless_pad,
+				   worker->gapless_probe_id);
+	gst_object_unref(worker->gapless_pad);
+	worker->gapless_pad = NULL;
+	worker->gapless_probe_id = 0;
+}
+
+/*
+ * Watches the audio bin of the current pipeline for the start of queued
+ * media.  Only that one: a standby bin prerolling, or a fadeout one, have
+ * nothing to do with the media queued.
+ */
+static void _attach_gapless_probe(MafwGstRendererWorker *worker)
+{
+	GstPad *ghost;
+
+	_detach_gapless_probe(worker);
+	if (worker->abin == NULL)
+		return;
+
+	ghost = gst_element_get_static_pad(worker->abin, "sink");
+	worker->gapless_pad = gst_ghost_pad_get_target(GST_GHOST_PAD(ghost));
+	gst_object_unref(ghost);
+	if (worker->gapless_pad != NULL) {
+		worker->gapless_probe_id = gst_pad_add_event_probe(
+			worker->gapless_pad,
+			G_CALLBACK(_gapless_segment_cb), worker);
+	}
+}
+
+/*
+ * Whether the pipeline can take the next media gaplessly: it needs
+ * playbin2 and our audio bin, where the track change is seen.  Video goes
+ * through the EOS path, as the video sink has to be set up again anyway.
+ */
+static gboolean _gapless_supported(MafwGstRendererWorker *worker)
+{
+	return worker->gapless && worker->pipeline != NULL &&
+		worker->abin != NULL &&
+		!worker->media.has_visual_content &&
+		g_signal_lookup("about-to-finish",
+				G_OBJECT_TYPE(worker->pipeline)) != 0;
+}
+
+/*
+ * Gets the URI to continue with when the current media ends.  Within a
+ * playlist file that is its next entry; after its last one, or for single
+ * media, it is the one given by the owner with
+ * mafw_gst_renderer_worker_set_next_uri().
+ */
+static const gchar *_next_media(MafwGstRendererWorker *worker)
+{
+	if (worker->mode == WORKER_MODE_PLAYLIST && _pl_has_next(worker))
+		return g_ptr_array_index(worker->pl.items,
+					 worker->pl.current + 1);
+	return worker->next_uri;
+}
+
+/*
+ * Publishes the URI to continue with when the current media ends, for the
+ * pipeline to queue it gaplessly.
+ */
+static void _update_gapless_next(MafwGstRendererWorker *worker)
+{
+	const gchar *next = NULL;
+
+	if (_gapless_supported(worker))
+		next = _next_media(worker);
+
+	/* A prerolled standby is crossfaded into instead */
+	if (next != NULL && worker->crossfade > 0 &&
+	    worker->standby.prerolled &&
+	    strcmp(next, worker->standby.uri) == 0)
+		next = NULL;
+
+	g_mutex_lock(worker->gapless_lock);
+	g_free(worker->gapless_next);
+	worker->gapless_next = g_strdup(next);
+	g_mutex_unlock(worker->gapless_lock);
+}
+
+static void _clear_gapless(MafwGstRendererWorker *worker)
+{
+	g_mutex_lock(worker->gapless_lock);
+	g_free(worker->gapless_next);
+	worker->gapless_next = NULL;
+	g_free(worker->gapless_queued);
+	worker->gapless_queued = NULL;
+	worker->gapless_flushed = FALSE;
+	g_mutex_unlock(worker->gapless_lock);
+	worker->gapless_pending = FALSE;
+}
+
+/*
+ * The pipeline is already playing the queued media.  Reset what is known
+ * about the previous one and report the new one as if it had been started
+ * from scratch, except for the state, which stays PLAYING.
+ */
+static void _handle_track_changed(MafwGstRendererWorker *worker,
+				  const gchar *uri)
+{
+	gboolean own_item;
+
+	g_debug("switching to %s", uri);
+	worker->gapless_pending = FALSE;
+
+	/* Entries of a playlist file are not the owner's business */
+	own_item = worker->mode == WORKER_MODE_PLAYLIST &&
+		_pl_has_next(worker);
+	if (own_item) {
+		worker->pl.current++;
+	} else if (worker->mode != WORKER_MODE_SINGLE_PLAY) {
+		worker->mode = WORKER_MODE_SINGLE_PLAY;
+		_reset_pl_info(worker);
+	}
+
+	_reset_media_info(worker);
+	_set_location(worker, uri);
+	_clear_current_metadata(worker);
+	if (!own_item) {
+		g_free(worker->next_uri);
+		worker->next_uri = NULL;
+		_notify(worker, WORKER_NOTIFY_NEXT);
+	}
+
+	/* Tags of the new media were held back until now */
+	_emit_metadatas(worker);
+	_check_duration(worker, -1);
+	_anchor_position(worker, _pipeline_running(worker));
+	_check_seekability(worker);
+	_add_duration_seek_query_timeout(worker);
+
+	_update_gapless_next(worker);
+	_update_standby(worker);
+}
+
+static void _handle_gapless_msg(MafwGstRendererWorker *worker,
+				const GstStructure *structure)
+{
+	if (gst_structure_has_name(structure, "mafw-about-to-finish")) {
+		worker->gapless_pending = TRUE;
+	} else if (gst_structure_has_name(structure, "mafw-track-changed")) {
+		_handle_track_changed(
+			worker, gst_structure_get_string(structure, "uri"));
+	}
 }
 
 static void _set_volume_and_mute(MafwGstRendererWorker *worker, gdouble vol,
@@ -1730,7 +2702,6 @@ static void _set_mute(MafwGstRendererWorker *worker, gboolean mute)
  */
 static void _start_play(MafwGstRendererWorker *worker)
 {
-	MafwGstRenderer *renderer = (MafwGstRenderer*) worker->owner;
 	GstStateChangeReturn state_change_info;
 
 	g_assert(worker->pipeline);
@@ -1753,18 +2724,86 @@ static void _start_play(MafwGstRendererWorker *worker)
 
 	worker->is_stream = uri_is_stream(worker->media.location);
 
-        if (renderer->update_playcount_id > 0) {
-                g_source_remove(renderer->update_playcount_id);
-                renderer->update_playcount_id = 0;
+	_notify(worker, WORKER_NOTIFY_LOADING);
+}
+
+/*
+ * Makes the streaming thread of the audio bin flush denormals to zero
+ * before the equalizer and the convolver run.  Threads are not ours to
+ * set up, so this is checked on every buffer; it only costs a register
+ * read once the mode is set.
+ */
+static gboolean _flush_denormals_cb(GstPad *pad, GstBuffer *buffer,
+                                    gpointer user_data)
+{
+        eq_dsp_flush_denormals();
+        return TRUE;
+}
+
+/*
+ * Puts queue + equalizer + convolver + limiter + fader + asink in a bin,
+ * linked in that order.  The queue, the convolver, the limiter and the
+ * fader may be missing.
+ */
+static GstElement *_make_audio_bin(MafwGstRendererWorker *worker,
+                                   GstElement *queue,
+                                   GstElement *fader,
+                                   GstElement *equalizer,
+                                   GstElement *convolver,
+                                   GstElement *limiter,
+                                   GstElement *asink)
+{
+        GstElement *abin;
+        GstElement *last;
+        GstPad *pad;
+
+        abin = gst_bin_new("audiobin");
+        gst_object_ref(abin);
+
+        gst_bin_add_many(GST_BIN(abin), equalizer, asink, NULL);
+        if (fader) {
+                gst_bin_add(GST_BIN(abin), fader);
+        }
+        if (convolver) {
+                gst_bin_add(GST_BIN(abin), convolver);
+        }
+        if (limiter) {
+                gst_bin_add(GST_BIN(abin), limiter);
+        }
+
+        /* The filters run on the thread of the queue, if there is one */
+        pad = gst_element_get_pad(equalizer, "sink");
+        gst_pad_add_buffer_probe(pad, G_CALLBACK(_flush_denormals_cb), NULL);
+        if (queue) {
+                gst_object_unref(pad);
+                gst_bin_add(GST_BIN(abin), queue);
+                gst_element_link(queue, equalizer);
+                pad = gst_element_get_pad(queue, "sink");
+        }
+        gst_element_add_pad(abin, gst_ghost_pad_new("sink", pad));
+        gst_object_unref(pad);
+
+        last = equalizer;
+        if (convolver) {
+                gst_element_link(last, convolver);
+                last = convolver;
+        }
+        if (limiter) {
+                gst_element_link(last, limiter);
+                last = limiter;
         }
+        if (fader) {
+                gst_element_link(last, fader);
+                last = fader;
+        }
+        gst_element_link(last, asink);
 
+        return abin;
 }
 
 /*
- * Constructs gst pipeline
- *
- * FIXME: Could the same pipeline be used for playing all media instead of
- *  constantly deleting and reconstructing it again?
+ * Constructs gst pipeline.  It is only built once if reuse_pipeline is set,
+ * see mafw_gst_renderer_worker_stop().
  */
 static void _construct_pipeline(MafwGstRendererWorker *worker)
 {
@@ -1823,9 +2862,10 @@ static void _construct_pipeline(MafwGstRendererWorker *worker)
 	worker->bus = gst_pipeline_get_bus(GST_PIPELINE(worker->pipeline));
 	gst_bus_set_sync_handler(worker->bus,
 				 (GstBusSyncHandler)_sync_bus_handler, worker);
-	worker->async_bus_id = gst_bus_add_watch_full(worker->bus,G_PRIORITY_HIGH,
-						 (GstBusFunc)_async_bus_handler,
-						 worker, NULL);
+	worker->async_bus_id = _bus_add_watch(worker, worker->bus,
+					      G_PRIORITY_HIGH,
+					      (GstBusFunc)_async_bus_handler,
+					      worker);
 
 	/* Listen for changes in stream-info object to find out whether the
 	 * media contains video and throw error if application has not provided
@@ -1833,10 +2873,16 @@ static void _construct_pipeline(MafwGstRendererWorker *worker)
 	g_signal_connect(worker->pipeline, "notify::stream-info",
 			 G_CALLBACK(_stream_info_cb), worker);
 
+	/* playbin2 asks for the next media to play gaplessly */
+	if (g_signal_lookup("about-to-finish",
+			    G_OBJECT_TYPE(worker->pipeline)) != 0) {
+		g_signal_connect(worker->pipeline, "about-to-finish",
+				 G_CALLBACK(_about_to_finish_cb), worker);
+	}
+
         /* Add an equalizer */
         if (!worker->equalizer) {
-                worker->equalizer =
-                        gst_element_factory_make("equalizer-10bands", NULL);
+                worker->equalizer = mafw_gst_renderer_equalizer_new();
                 if (!worker->equalizer) {
                         g_critical("Failed to create pipeline equalizer");
                 } else {
@@ -1844,6 +2890,38 @@ static void _construct_pipeline(MafwGstRendererWorker *worker)
                 }
         }
 
+        /* And the convolution stage, in passthrough until a linear phase
+         * curve or an impulse response is selected */
+        if (worker->equalizer && !worker->convolver) {
+                worker->convolver = mafw_gst_renderer_convolver_new();
+                if (!worker->convolver) {
+                        g_critical("Failed to create pipeline convolver");
+                } else {
+                        gst_object_ref(worker->convolver);
+                }
+        }
+
+        /* And the limiter, to catch what the preamp of the curve leaves
+         * over full scale */
+        if (worker->equalizer && !worker->limiter) {
+                worker->limiter = mafw_gst_renderer_limiter_new();
+                if (!worker->limiter) {
+                        g_critical("Failed to create pipeline limiter");
+                } else {
+                        gst_object_ref(worker->limiter);
+                }
+        }
+
+        /* And the fader after them all, for crossfades */
+        if (worker->equalizer && !worker->fader) {
+                worker->fader = mafw_gst_renderer_fader_new();
+                if (!worker->fader) {
+                        g_critical("Failed to create pipeline fader");
+                } else {
+                        gst_object_ref(worker->fader);
+                }
+        }
+
 #ifndef MAFW_GST_RENDERER_DISABLE_PULSE_VOLUME
 
 	/* Set audio and video sinks ourselves. We create and configure
@@ -1866,24 +2944,14 @@ static void _construct_pipeline(MafwGstRendererWorker *worker)
                                 NULL);
 
                 if (worker->equalizer) {
-                        /* Put equalizer + asink in the bin */
-                        worker->abin = gst_bin_new("audiobin");
-                        gst_object_ref(worker->abin);
-
-                        gst_bin_add_many(GST_BIN(worker->abin),
-                                         worker->equalizer,
-                                         worker->asink,
-                                         NULL);
-
-                        GstPad *pad = gst_element_get_pad(worker->equalizer,
-                                                          "sink");
-                        gst_element_add_pad(worker->abin,
-                                            gst_ghost_pad_new("sink", pad));
-                        gst_object_unref(pad);
-
-                        gst_element_link_many(worker->equalizer,
-                                              worker->asink,
-                                              NULL);
+                        worker->abin = _make_audio_bin(worker,
+                                                       NULL,
+                                                       worker->fader,
+                                                       worker->equalizer,
+                                                       worker->convolver,
+                                                       worker->limiter,
+                                                       worker->asink);
+                        _attach_gapless_probe(worker);
                 }
 	}
 #endif
@@ -1919,6 +2987,123 @@ static void _construct_pipeline(MafwGstRendererWorker *worker)
                      NULL);
 }
 
+/*
+ * Seeks are scheduled so that there is a single flushing seek in flight at a
+ * time: one asked for meanwhile waits for it to land, replacing any other
+ * one waiting, so that scrubbing does not flood the pipeline with flushes.
+ * A seek lands when the pipeline has prerolled again, that is, when the
+ * first frame at the new position is ready; the time it took is its
+ * latency.  Should it not land, e.g. because the pipeline errors out or
+ * goes away meanwhile, it is given up on after a while.
+ */
+
+static void _remove_seek_timeout(MafwGstRendererWorker *worker)
+{
+	if (worker->seek_timeout != 0) {
+		_remove_source(worker, worker->seek_timeout);
+		worker->seek_timeout = 0;
+	}
+}
+
+static void _reset_seeks(MafwGstRendererWorker *worker)
+{
+	_remove_seek_timeout(worker);
+	worker->seek_in_flight = FALSE;
+	worker->seek_queued = -1;
+}
+
+/* Sends the seek waiting for the one in flight, if any */
+static void _send_queued_seek(MafwGstRendererWorker *worker)
+{
+	gint position;
+
+	if (worker->seek_queued != -1) {
+		position = worker->seek_queued;
+		worker->seek_queued = -1;
+		if (!_send_seek(worker, position)) {
+			g_warning("Seeking to %d failed", position);
+			_set_seek_position(worker, -1);
+		}
+	}
+}
+
+static gboolean _seek_timeout_cb(gpointer data)
+{
+	MafwGstRendererWorker *worker = data;
+
+	worker->seek_timeout = 0;
+	g_warning("seek: not landed after %d s, giving up on it",
+		  MAFW_GST_RENDERER_WORKER_SECONDS_SEEK);
+	worker->seek_in_flight = FALSE;
+	if (worker->seek_queued != -1)
+		_send_queued_seek(worker);
+	else
+		_set_seek_position(worker, -1);
+
+	return FALSE;
+}
+
+/*
+ * Sends a flushing seek to @position seconds, to the keyframe before it
+ * unless seek_accurate is set.
+ */
+static gboolean _send_seek(MafwGstRendererWorker *worker, gint position)
+{
+	GstSeekFlags flags = GST_SEEK_FLAG_FLUSH;
+	gint64 spos = (gint64)position * GST_SECOND;
+
+	if (worker->seek_accurate)
+		flags |= GST_SEEK_FLAG_ACCURATE;
+	else
+		flags |= GST_SEEK_FLAG_KEY_UNIT;
+
+	g_debug("seek: offset = %lld, %s", spos,
+		worker->seek_accurate ? "accurate" : "key unit");
+
+	if (!gst_element_seek(worker->pipeline, 1.0, GST_FORMAT_TIME, flags,
+			      GST_SEEK_TYPE_SET, spos,
+			      GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE))
+		return FALSE;
+
+	worker->seek_in_flight = TRUE;
+	g_timer_start(worker->seek_timer);
+	_remove_seek_timeout(worker);
+	worker->seek_timeout = _timeout_add_seconds(
+		worker, MAFW_GST_RENDERER_WORKER_SECONDS_SEEK,
+		_seek_timeout_cb, worker);
+	_drop_position(worker);
+	return TRUE;
+}
+
+/*
+ * Called when the pipeline has prerolled.  Ends the measure of the seek in
+ * flight, if any, and sends the one waiting for it.
+ */
+static void _seek_landed(MafwGstRendererWorker *worker)
+{
+	gdouble ms;
+
+	if (!worker->seek_in_flight)
+		return;
+
+	_remove_seek_timeout(worker);
+	worker->seek_in_flight = FALSE;
+	ms = 1000.0 * g_timer_elapsed(worker->seek_timer, NULL);
+	g_mutex_lock(worker->stats_lock);
+	worker->seek_count++;
+	worker->seek_total += ms;
+	worker->seek_max = MAX(worker->seek_max, ms);
+	g_mutex_unlock(worker->stats_lock);
+
+	g_debug("seek: %.1f ms to first frame (%s); mean %.1f ms, "
+		"max %.1f ms over %u seeks, %u merged",
+		ms, worker->seek_accurate ? "accurate" : "key unit",
+		worker->seek_total / worker->seek_count, worker->seek_max,
+		worker->seek_count, worker->seek_merged);
+
+	_send_queued_seek(worker);
+}
+
 /*
  * @seek_type: GstSeekType
  * @position: Time in seconds where to seek
@@ -1926,9 +3111,6 @@ static void _construct_pipeline(MafwGstRendererWorker *worker)
 static void _do_seek(MafwGstRendererWorker *worker, GstSeekType seek_type,
 		     gint position, GError **error)
 {
-	gboolean ret;
-	gint64 spos;
-
 	g_assert(worker != NULL);
 
 	if (worker->eos || !worker->media.seekable)
@@ -1938,7 +3120,8 @@ static void _do_seek(MafwGstRendererWorker *worker, GstSeekType seek_type,
 	GST_SEEK_TYPE_CUR - change relative to currently configured segment.
 	This can't be used to seek relative to the current playback position -
 	do a position query, calculate the desired position and then do an
-	absolute position seek instead if that's what you want to do. */
+	absolute position seek instead if that's what you want to do.  While
+	a seek is under way, the position is the one it goes to. */
 	if (seek_type == GST_SEEK_TYPE_CUR)
 	{
 		gint curpos = mafw_gst_renderer_worker_get_position(worker);
@@ -1950,10 +3133,8 @@ static void _do_seek(MafwGstRendererWorker *worker, GstSeekType seek_type,
 		position = 0;
 	}
 
-	worker->seek_position = position;
+	_set_seek_position(worker, position);
 	worker->report_statechanges = FALSE;
-	spos = (gint64)position * GST_SECOND;
-	g_debug("seek: type = %d, offset = %lld", seek_type, spos);
 
         /* If the pipeline has been set to READY by us, then wake it up by
 	   setting it to PAUSED (when we get the READY->PAUSED transition
@@ -1963,16 +3144,19 @@ static void _do_seek(MafwGstRendererWorker *worker, GstSeekType seek_type,
 	   video playback */
         if (worker->in_ready && worker->state == GST_STATE_READY) {
                 gst_element_set_state(worker->pipeline, GST_STATE_PAUSED);
-        } else {
-                ret = gst_element_seek(worker->pipeline, 1.0, GST_FORMAT_TIME,
-                                       GST_SEEK_FLAG_FLUSH|GST_SEEK_FLAG_KEY_UNIT,
-                                       seek_type, spos,
-                                       GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE);
-                if (!ret) {
-                        /* Seeking is async, so seek_position should not be
-                           invalidated here */
-                        goto err;
-                }
+        } else if (worker->seek_in_flight) {
+		/* Wait for the seek in flight to land */
+		if (worker->seek_queued != -1) {
+			g_mutex_lock(worker->stats_lock);
+			worker->seek_merged++;
+			g_mutex_unlock(worker->stats_lock);
+		}
+		worker->seek_queued = position;
+		g_debug("seek: to %d s after the one in flight", position);
+	} else if (!_send_seek(worker, position)) {
+		/* Seeking is async, so seek_position should not be
+		   invalidated here */
+		goto err;
 	}
         return;
 
@@ -2021,10 +3205,46 @@ gboolean mafw_gst_renderer_worker_get_current_frame_on_pause(MafwGstRendererWork
 }
 #endif
 
+static void _set_position_cmd(MafwGstRendererWorker *worker,
+			      WorkerCommand *cmd)
+{
+	GError *error = NULL;
+
+	mafw_gst_renderer_worker_set_position(worker, cmd->seek_type,
+					      cmd->value, &error);
+	if (error != NULL) {
+		g_warning("%s", error->message);
+		g_error_free(error);
+	}
+}
+
 void mafw_gst_renderer_worker_set_position(MafwGstRendererWorker *worker,
 					  GstSeekType seek_type,
 					  gint position, GError **error)
 {
+	if (_foreign_thread(worker)) {
+		WorkerCommand *cmd;
+		gboolean can_seek;
+
+		/* Only what is known beforehand can be reported */
+		g_mutex_lock(worker->media_lock);
+		can_seek = !worker->eos &&
+			worker->media.seekable != SEEKABILITY_NO_SEEKABLE;
+		g_mutex_unlock(worker->media_lock);
+		if (!can_seek) {
+			g_set_error(error,
+				    MAFW_RENDERER_ERROR,
+				    MAFW_RENDERER_ERROR_CANNOT_SET_POSITION,
+				    "Seeking to %d failed", position);
+			return;
+		}
+		cmd = _command_new(_set_position_cmd);
+		cmd->seek_type = seek_type;
+		cmd->value = position;
+		_queue_command(worker, cmd);
+		return;
+	}
+
         /* If player is paused and we have a timeout for going to ready
 	 * restart it. This is logical, since the user is seeking and
 	 * thus, the player is not idle anymore. Also this prevents that
@@ -2038,41 +3258,102 @@ void mafw_gst_renderer_worker_set_position(MafwGstRendererWorker *worker,
                 _add_ready_timeout(worker);
         }
 
+	_stall_begin(worker);
         _do_seek(worker, seek_type, position, error);
-        if (worker->notify_seek_handler)
-                worker->notify_seek_handler(worker, worker->owner);
+	_stall_end(worker, "set_position");
+        _notify(worker, WORKER_NOTIFY_SEEK);
 }
 
 /*
- * Gets current position, rounded down into precision of one second.  If a seek
+ * Gets current position, rounded into precision of one second.  If a seek
  * is pending, returns the position we are going to seek.  Returns -1 on
  * failure.
  */
 gint mafw_gst_renderer_worker_get_position(MafwGstRendererWorker *worker)
 {
-	GstFormat format;
-	gint64 time = 0;
+	gint64 ms;
+
+	g_assert(worker != NULL);
+
+	ms = mafw_gst_renderer_worker_get_position_ms(worker);
+	if (ms < 0)
+		return -1;
+	return (gint) ((ms + 500) / 1000);
+}
+
+/*
+ * As mafw_gst_renderer_worker_get_position(), in milliseconds.  It may be
+ * called from any thread, the pipeline being queried only when the position
+ * has not been anchored yet.
+ */
+static void _get_position_ms_cmd(MafwGstRendererWorker *worker,
+				 WorkerCommand *cmd)
+{
+	cmd->result = mafw_gst_renderer_worker_get_position_ms(worker);
+}
+
+gint64 mafw_gst_renderer_worker_get_position_ms(MafwGstRendererWorker *worker)
+{
+	gint64 time;
+	gint seek_position;
+
 	g_assert(worker != NULL);
 
 	/* If seek is ongoing, return the position where we are seeking. */
-	if (worker->seek_position != -1)
-	{
-		return worker->seek_position;
+	g_mutex_lock(worker->position_lock);
+	seek_position = worker->seek_position;
+	g_mutex_unlock(worker->position_lock);
+	if (seek_position != -1)
+		return (gint64) seek_position * 1000;
+
+	if (!_interpolate_position(worker, &time)) {
+		if (_foreign_thread(worker))
+			return _call_command(worker,
+					     _command_new(_get_position_ms_cmd));
+
+		_anchor_position(worker, _pipeline_running(worker));
+		if (!_interpolate_position(worker, &time))
+			return -1;
 	}
-	/* Otherwise query position from pipeline. */
-	format = GST_FORMAT_TIME;
-	if (worker->pipeline &&
-            gst_element_query_position(worker->pipeline, &format, &time))
-	{
-		return (gint)(NSECONDS_TO_SECONDS(time));
+	return GST_TIME_AS_MSECONDS(time);
+}
+
+static void _copy_metadata_item(const gchar *key, gpointer value,
+				GHashTable *copy)
+{
+	if (G_IS_VALUE(value)) {
+		mafw_metadata_add_something(copy, key, G_TYPE_VALUE, 1,
+					    value);
+	} else {
+		GValueArray *values = value;
+		guint i;
+
+		for (i = 0; i < values->n_values; i++) {
+			mafw_metadata_add_something(
+				copy, key, G_TYPE_VALUE, 1,
+				g_value_array_get_nth(values, i));
+		}
 	}
-	return -1;
 }
 
+/*
+ * Returns a copy of the metadata of the current media, which the caller
+ * unrefs, or NULL if there is none.  It may be called from any thread.
+ */
 GHashTable *mafw_gst_renderer_worker_get_current_metadata(
 	MafwGstRendererWorker *worker)
 {
-	return worker->current_metadata;
+	GHashTable *copy = NULL;
+
+	g_mutex_lock(worker->media_lock);
+	if (worker->current_metadata != NULL) {
+		copy = mafw_metadata_new();
+		g_hash_table_foreach(worker->current_metadata,
+				     (GHFunc) _copy_metadata_item, copy);
+	}
+	g_mutex_unlock(worker->media_lock);
+
+	return copy;
 }
 
 void mafw_gst_renderer_worker_set_xid(MafwGstRendererWorker *worker, XID xid)
@@ -2124,242 +3405,2013 @@ void mafw_gst_renderer_worker_set_colorkey(
 
 gboolean mafw_gst_renderer_worker_get_seekable(MafwGstRendererWorker *worker)
 {
-	return worker->media.seekable;
+	SeekabilityType seekable;
+
+	g_mutex_lock(worker->media_lock);
+	seekable = worker->media.seekable;
+	g_mutex_unlock(worker->media_lock);
+
+	return seekable;
 }
 
-static void _play_pl_next(MafwGstRendererWorker *worker) {
-	gchar *next;
+/*
+ * Sets the seekability the source gives for the media about to be played,
+ * which the pipeline is only asked about if it is not
+ * SEEKABILITY_NO_SEEKABLE.
+ */
+static void _set_source_seekability_cmd(MafwGstRendererWorker *worker,
+					WorkerCommand *cmd)
+{
+	mafw_gst_renderer_worker_set_source_seekability(worker, cmd->value);
+}
 
+void mafw_gst_renderer_worker_set_source_seekability(
+	MafwGstRendererWorker *worker, SeekabilityType seekability)
+{
 	g_assert(worker != NULL);
-	g_return_if_fail(worker->pl.items != NULL);
 
-	next = (gchar *) g_slist_nth_data(worker->pl.items,
-					  ++worker->pl.current);
+	if (_foreign_thread(worker)) {
+		WorkerCommand *cmd;
+
+		cmd = _command_new(_set_source_seekability_cmd);
+		cmd->value = seekability;
+		_queue_command(worker, cmd);
+		return;
+	}
+
+	worker->media.source_seekable = seekability;
+}
+
+/* Returns a copy of the location of the current media, which the caller
+ * frees.  It may be called from any thread. */
+gchar *mafw_gst_renderer_worker_get_location(MafwGstRendererWorker *worker)
+{
+	gchar *location;
+
+	g_mutex_lock(worker->media_lock);
+	location = g_strdup(worker->media.location);
+	g_mutex_unlock(worker->media_lock);
+
+	return location;
+}
+
+gboolean mafw_gst_renderer_worker_get_has_visual_content(
+	MafwGstRendererWorker *worker)
+{
+	gboolean has_visual_content;
+
+	g_mutex_lock(worker->media_lock);
+	has_visual_content = worker->media.has_visual_content;
+	g_mutex_unlock(worker->media_lock);
+
+	return has_visual_content;
+}
+
+static void _play_pl_next(MafwGstRendererWorker *worker) {
+	gchar *next;
+
+	g_assert(worker != NULL);
+	g_return_if_fail(_pl_has_next(worker));
+
+	next = g_ptr_array_index(worker->pl.items, ++worker->pl.current);
+	_stop(worker);
+	_reset_media_info(worker);
+
+	_set_location(worker, next);
+	if (_start_standby(worker, next))
+		return;
+	_construct_pipeline(worker);
+	_start_play(worker);
+}
+
+/*
+ * Playlist files are parsed on a thread of their own, so that a large or
+ * remote one does not hold the worker up.  Entries are handed over to the
+ * worker context in batches as they come, and the first one is played as
+ * soon as it is there.  A parse is dropped by clearing its worker, which is
+ * only done on the worker context, and setting cancelled, after which the
+ * thread ignores the entries still coming from the parser, stores nothing
+ * in the cache and ends as soon as the parser returns.
+ *
+ * lock protects pending, scheduled, finished, cancelled, entries and
+ * first_entry, which are set from the thread.  cacheable and parsed are
+ * only used by the thread, to fill the playlist cache in; a parse that
+ * went into nested playlists is not cacheable.
+ */
+struct _WorkerPlaylistParse {
+	gint ref_count;
+	MafwGstRendererWorker *worker;
+	GMainContext *context;
+	gchar *uri;
+	GError *fallback;
+	GTimer *timer;
+	GMutex *lock;
+	GSList *pending;
+	gboolean scheduled;
+	gboolean finished;
+	gboolean cancelled;
+	guint entries;
+	gdouble first_entry;
+	gboolean cacheable;
+	GSList *parsed;
+};
+
+static WorkerPlaylistParse *_parse_ref(WorkerPlaylistParse *parse)
+{
+	g_atomic_int_inc(&parse->ref_count);
+	return parse;
+}
+
+static void _parse_unref(WorkerPlaylistParse *parse)
+{
+	if (!g_atomic_int_dec_and_test(&parse->ref_count))
+		return;
+
+	g_slist_foreach(parse->pending, (GFunc) g_free, NULL);
+	g_slist_free(parse->pending);
+	g_slist_foreach(parse->parsed, (GFunc) g_free, NULL);
+	g_slist_free(parse->parsed);
+	if (parse->fallback)
+		g_error_free(parse->fallback);
+	g_mutex_free(parse->lock);
+	g_timer_destroy(parse->timer);
+	g_main_context_unref(parse->context);
+	g_free(parse->uri);
+	g_free(parse);
+}
+
+/*
+ * Ends a parse which has delivered all of its entries: playback goes on if
+ * it was waiting for more, and if there were none at all the error is
+ * sent.
+ */
+static void _end_parse(MafwGstRendererWorker *worker,
+		       WorkerPlaylistParse *parse)
+{
+	GError *error;
+	gdouble ms;
+
+	ms = 1000.0 * g_timer_elapsed(parse->timer, NULL);
+	g_debug("playlist %s: %u entries, first one after %.1f ms, parsed in "
+		"%.1f ms", parse->uri, parse->entries, parse->first_entry, ms);
+
+	if (parse->entries > 0) {
+		g_mutex_lock(worker->stats_lock);
+		worker->pl.parse_count++;
+		worker->pl.parse_first_total += parse->first_entry;
+		worker->pl.parse_first_max = MAX(worker->pl.parse_first_max,
+						 parse->first_entry);
+		worker->pl.parse_total += ms;
+		g_mutex_unlock(worker->stats_lock);
+	}
+
+	worker->pl.parse = NULL;
+	parse->worker = NULL;
+
+	if (parse->entries == 0) {
+		error = parse->fallback;
+		parse->fallback = NULL;
+		if (error == NULL)
+			error = g_error_new(MAFW_RENDERER_ERROR,
+					    MAFW_RENDERER_ERROR_PLAYLIST_PARSING,
+					    "Playlist parsing failed: %s",
+					    parse->uri);
+		_send_error(worker, error);
+	} else if (worker->pl.stalled) {
+		/* Playlist EOS, go back to normal mode */
+		error = worker->pl.stalled_error;
+		worker->pl.stalled_error = NULL;
+		worker->mode = WORKER_MODE_SINGLE_PLAY;
+		_reset_pl_info(worker);
+		if (error != NULL)
+			_send_error(worker, error);
+		else
+			_notify(worker, WORKER_NOTIFY_EOS);
+	}
+
+	_parse_unref(parse);
+}
+
+/*
+ * Appends entries to the playlist, starting playback with the first one.
+ */
+static void _add_pl_items(MafwGstRendererWorker *worker, GSList *items)
+{
+	if (worker->pl.items->len == 0) {
+		_append_pl_items(worker, items);
+
+		/* Set the playback mode */
+		worker->mode = WORKER_MODE_PLAYLIST;
+		worker->pl.notify_play_pending = TRUE;
+
+		/* Set the item to be played */
+		worker->pl.current = 0;
+		_set_location(worker,
+			      g_ptr_array_index(worker->pl.items, 0));
+		_construct_pipeline(worker);
+		_start_play(worker);
+		return;
+	}
+
+	_append_pl_items(worker, items);
+	if (worker->pl.stalled) {
+		worker->pl.stalled = FALSE;
+		if (worker->pl.stalled_error != NULL) {
+			g_error_free(worker->pl.stalled_error);
+			worker->pl.stalled_error = NULL;
+		}
+		_play_pl_next(worker);
+	} else {
+		_update_gapless_next(worker);
+		_update_standby(worker);
+	}
+}
+
+static gboolean _parse_deliver_cb(WorkerPlaylistParse *parse)
+{
+	MafwGstRendererWorker *worker = parse->worker;
+	GSList *items;
+	gboolean finished;
+
+	g_mutex_lock(parse->lock);
+	items = g_slist_reverse(parse->pending);
+	parse->pending = NULL;
+	parse->scheduled = FALSE;
+	finished = parse->finished;
+	g_mutex_unlock(parse->lock);
+
+	if (worker == NULL) {
+		/* Dropped */
+		g_slist_foreach(items, (GFunc) g_free, NULL);
+		g_slist_free(items);
+		return FALSE;
+	}
+
+	if (items != NULL)
+		_add_pl_items(worker, items);
+	if (finished)
+		_end_parse(worker, parse);
+
+	return FALSE;
+}
+
+/*
+ * Has what the thread has got so far delivered, unless it already is going
+ * to be.  Called with lock held.
+ */
+static void _parse_schedule(WorkerPlaylistParse *parse)
+{
+	GSource *source;
+
+	if (parse->scheduled)
+		return;
+
+	parse->scheduled = TRUE;
+	source = g_idle_source_new();
+	g_source_set_callback(source, (GSourceFunc) _parse_deliver_cb,
+			      _parse_ref(parse), (GDestroyNotify) _parse_unref);
+	g_source_attach(source, parse->context);
+	g_source_unref(source);
+}
+
+static void _parse_add_entry(WorkerPlaylistParse *parse, const gchar *uri)
+{
+	g_mutex_lock(parse->lock);
+	if (parse->entries++ == 0)
+		parse->first_entry = 1000.0 * g_timer_elapsed(parse->timer,
+							      NULL);
+	parse->pending = g_slist_prepend(parse->pending, g_strdup(uri));
+	_parse_schedule(parse);
+	g_mutex_unlock(parse->lock);
+}
+
+static gboolean _parse_cancelled(WorkerPlaylistParse *parse)
+{
+	gboolean cancelled;
+
+	g_mutex_lock(parse->lock);
+	cancelled = parse->cancelled;
+	g_mutex_unlock(parse->lock);
+
+	return cancelled;
+}
+
+static void _on_pl_entry_parsed(TotemPlParser *parser, gchar *uri,
+                                gpointer metadata, WorkerPlaylistParse *parse)
+{
+	if (uri == NULL || _parse_cancelled(parse))
+		return;
+
+	_parse_add_entry(parse, uri);
+	if (parse->cacheable)
+		parse->parsed = g_slist_prepend(parse->parsed, g_strdup(uri));
+}
+
+/*
+ * The entries of a playlist nested in the one parsed depend on a file
+ * whose changes the cache does not see, so the parse is not cached then.
+ */
+static void _on_pl_started(TotemPlParser *parser, gchar *uri,
+			   gpointer metadata, WorkerPlaylistParse *parse)
+{
+	if (parse->cacheable && g_strcmp0(uri, parse->uri) != 0) {
+		g_debug("%s nests %s, not caching it", parse->uri, uri);
+		parse->cacheable = FALSE;
+	}
+}
+
+/*
+ * Gets what tells whether the playlist file at @uri has changed: its
+ * modification time (the Last-Modified of HTTP ones) and its size, -1 if
+ * unknown.  Returns FALSE if there is no modification time, the file not
+ * being cacheable then.
+ */
+static gboolean _playlist_validator(const gchar *uri, gint64 *mtime,
+				    gint64 *size)
+{
+	GnomeVFSFileInfo *info;
+	gboolean ret = FALSE;
+
+	info = gnome_vfs_file_info_new();
+	if (gnome_vfs_get_file_info(uri, info, GNOME_VFS_FILE_INFO_DEFAULT) ==
+	    GNOME_VFS_OK &&
+	    (info->valid_fields & GNOME_VFS_FILE_INFO_FIELDS_MTIME)) {
+		*mtime = info->mtime;
+		*size = (info->valid_fields & GNOME_VFS_FILE_INFO_FIELDS_SIZE) ?
+			(gint64) info->size : -1;
+		ret = TRUE;
+	}
+	gnome_vfs_file_info_unref(info);
+
+	return ret;
+}
+
+/*
+ * Parses the playlist file, unless its entries are in the playlist cache
+ * and it has not changed since.
+ */
+static gpointer _parse_thread(WorkerPlaylistParse *parse)
+{
+	TotemPlParser *pl_parser;
+	gchar **entries = NULL;
+	gchar *dir;
+	gint64 mtime, size;
+	gint i;
+
+	if (_parse_cancelled(parse))
+		goto out;
+
+	dir = mafw_gst_renderer_playlist_cache_dir();
+	parse->cacheable = _playlist_validator(parse->uri, &mtime, &size);
+	if (parse->cacheable)
+		entries = mafw_gst_renderer_playlist_cache_lookup(
+			dir, parse->uri, mtime, size);
+
+	if (entries != NULL) {
+		for (i = 0; entries[i] != NULL && !_parse_cancelled(parse);
+		     i++)
+			_parse_add_entry(parse, entries[i]);
+		g_strfreev(entries);
+	} else {
+		pl_parser = totem_pl_parser_new();
+		g_object_set(pl_parser, "recurse", TRUE, "disable-unsafe",
+			     TRUE, NULL);
+		g_signal_connect(G_OBJECT(pl_parser), "entry-parsed",
+				 G_CALLBACK(_on_pl_entry_parsed), parse);
+		/* Without it, nested playlists cannot be told */
+		if (g_signal_lookup("playlist-started",
+				    G_OBJECT_TYPE(pl_parser)) != 0) {
+			g_signal_connect(G_OBJECT(pl_parser),
+					 "playlist-started",
+					 G_CALLBACK(_on_pl_started), parse);
+		} else {
+			parse->cacheable = FALSE;
+		}
+		if (totem_pl_parser_parse(pl_parser, parse->uri, FALSE) !=
+		    TOTEM_PL_PARSER_RESULT_SUCCESS) {
+			g_debug("parsing %s failed", parse->uri);
+		} else if (parse->cacheable && parse->parsed != NULL &&
+			   !_parse_cancelled(parse)) {
+			parse->parsed = g_slist_reverse(parse->parsed);
+			mafw_gst_renderer_playlist_cache_store(
+				dir, parse->uri, mtime, size, parse->parsed);
+		}
+		g_object_unref(pl_parser);
+	}
+	g_free(dir);
+
+out:
+	g_mutex_lock(parse->lock);
+	g_timer_stop(parse->timer);
+	parse->finished = TRUE;
+	_parse_schedule(parse);
+	g_mutex_unlock(parse->lock);
+
+	_parse_unref(parse);
+	return NULL;
+}
+
+/*
+ * Starts parsing the playlist file at @uri, whose entries are played as
+ * they come.  If it has none, @fallback is sent as the error, or a parsing
+ * error if it is NULL; it is taken over.
+ */
+static void _start_parse(MafwGstRendererWorker *worker, const gchar *uri,
+			 GError *fallback)
+{
+	WorkerPlaylistParse *parse;
+	GError *error = NULL;
+
+	_cancel_parse(worker);
+
+	parse = g_new0(WorkerPlaylistParse, 1);
+	/* The worker's reference and the thread's */
+	parse->ref_count = 2;
+	parse->worker = worker;
+	parse->context = g_main_context_ref(worker->context);
+	parse->uri = g_strdup(uri);
+	parse->fallback = fallback;
+	parse->timer = g_timer_new();
+	parse->lock = g_mutex_new();
+	worker->pl.parse = parse;
+
+	if (!g_thread_create((GThreadFunc) _parse_thread, parse, FALSE,
+			     &error)) {
+		g_warning("cannot parse %s on a thread: %s", uri,
+			  error->message);
+		g_error_free(error);
+		_parse_thread(parse);
+	}
+}
+
+static void _cancel_parse(MafwGstRendererWorker *worker)
+{
+	if (worker->pl.parse != NULL) {
+		worker->pl.parse->worker = NULL;
+		g_mutex_lock(worker->pl.parse->lock);
+		worker->pl.parse->cancelled = TRUE;
+		g_mutex_unlock(worker->pl.parse->lock);
+		_parse_unref(worker->pl.parse);
+		worker->pl.parse = NULL;
+	}
+
+	worker->pl.stalled = FALSE;
+	if (worker->pl.stalled_error != NULL) {
+		g_error_free(worker->pl.stalled_error);
+		worker->pl.stalled_error = NULL;
+	}
+}
+
+static void _do_play(MafwGstRendererWorker *worker)
+{
+	g_assert(worker != NULL);
+
+	if (worker->pipeline == NULL) {
+		g_debug("play without a pipeline!");
+		return;
+	}
+	worker->report_statechanges = TRUE;
+	worker->pause_pending = FALSE;
+
+	/* If we have to stay paused, we do and add the ready
+	 * timeout. Otherwise, we move the pipeline */
+	if (!worker->stay_paused) {
+		/* If pipeline is READY, we move it to PAUSED,
+		 * otherwise, to PLAYING */
+		if (worker->state == GST_STATE_READY) {
+			gst_element_set_state(worker->pipeline,
+					      GST_STATE_PAUSED);
+			g_debug("setting pipeline to PAUSED");
+		} else {
+			_reset_volume_and_mute_to_pipeline(worker);
+			gst_element_set_state(worker->pipeline,
+					      GST_STATE_PLAYING);
+			g_debug("setting pipeline to PLAYING");
+		}
+	}
+	else {
+		g_debug("staying in PAUSED state");
+		_add_ready_timeout(worker);
+	}
+}
+
+static void _play(MafwGstRendererWorker *worker, const gchar *uri,
+		  GSList *plitems)
+{
+	g_assert(uri || plitems);
+
+	mafw_gst_renderer_worker_stop(worker);
+	_reset_seeks(worker);
+	_set_seek_position(worker, -1);
+	_reset_media_info(worker);
+	_reset_pl_info(worker);
+	/* Check if the item to play is a single item or a playlist. */
+	if (plitems || uri_is_playlist(uri)){
+               gchar *item;
+		/* In case of a playlist file we parse it in the background,
+		   and start playing its first item as soon as it is
+		   parsed. */
+               if (!plitems)
+                {
+                        _start_parse(worker, uri, NULL);
+                        return;
+                }
+		_append_pl_items(worker, plitems);
+
+		/* Set the playback mode */
+		worker->mode = WORKER_MODE_PLAYLIST;
+		worker->pl.notify_play_pending = TRUE;
+
+		/* Set the item to be played */
+		worker->pl.current = 0;
+		item = g_ptr_array_index(worker->pl.items, 0);
+		_set_location(worker, item);
+	} else {
+		/* Single item. Set the playback mode according to that */
+		worker->mode = WORKER_MODE_SINGLE_PLAY;
+
+		/* Set the item to be played */
+		_set_location(worker, uri);
+
+		if (_start_standby(worker, uri))
+			return;
+	}
+	_construct_pipeline(worker);
+	_start_play(worker);
+}
+
+/*
+ * Gets how many playlist files were parsed to the end, the mean and longest
+ * time to their first entry, and their mean parse time, in milliseconds.
+ * Any of them may be NULL.
+ */
+void mafw_gst_renderer_worker_get_parse_stats(MafwGstRendererWorker *worker,
+					      guint *parse_count,
+					      gdouble *first_entry_ms,
+					      gdouble *first_entry_max_ms,
+					      gdouble *parse_ms)
+{
+	guint count;
+
+	g_assert(worker != NULL);
+
+	g_mutex_lock(worker->stats_lock);
+	count = worker->pl.parse_count;
+	if (parse_count != NULL)
+		*parse_count = count;
+	if (first_entry_ms != NULL)
+		*first_entry_ms = count > 0 ?
+			worker->pl.parse_first_total / count : 0.0;
+	if (first_entry_max_ms != NULL)
+		*first_entry_max_ms = worker->pl.parse_first_max;
+	if (parse_ms != NULL)
+		*parse_ms = count > 0 ? worker->pl.parse_total / count : 0.0;
+	g_mutex_unlock(worker->stats_lock);
+}
+
+static void _play_cmd(MafwGstRendererWorker *worker, WorkerCommand *cmd)
+{
+	mafw_gst_renderer_worker_play(worker, cmd->uri, cmd->plitems);
+}
+
+void mafw_gst_renderer_worker_play(MafwGstRendererWorker *worker,
+                                   const gchar *uri,
+                                   GSList *plitems)
+{
+	if (_foreign_thread(worker)) {
+		WorkerCommand *cmd;
+
+		cmd = _command_new(_play_cmd);
+		cmd->uri = g_strdup(uri);
+		cmd->plitems = plitems;
+		_queue_command(worker, cmd);
+		return;
+	}
+
+	_new_notify_generation(worker);
+	_stall_begin(worker);
+	_play(worker, uri, plitems);
+	_stall_end(worker, "play");
+}
+
+static void _play_alternatives_cmd(MafwGstRendererWorker *worker,
+				   WorkerCommand *cmd)
+{
+	mafw_gst_renderer_worker_play_alternatives(worker, cmd->uris);
+}
+
+void mafw_gst_renderer_worker_play_alternatives(MafwGstRendererWorker *worker,
+                                                gchar **uris)
+{
+        gint i;
+        gchar *item;
+
+        g_assert(uris && uris[0]);
+
+	if (_foreign_thread(worker)) {
+		WorkerCommand *cmd;
+
+		cmd = _command_new(_play_alternatives_cmd);
+		cmd->uris = g_strdupv(uris);
+		_queue_command(worker, cmd);
+		return;
+	}
+
+        mafw_gst_renderer_worker_stop(worker);
+        _reset_media_info(worker);
+        _reset_pl_info(worker);
+
+        /* Add the uris to playlist */
+        i = 0;
+        while (uris[i]) {
+                g_ptr_array_add(worker->pl.items, g_strdup(uris[i]));
+                i++;
+        }
+
+        /* Set the playback mode */
+        worker->mode = WORKER_MODE_REDUNDANT;
+        worker->pl.notify_play_pending = TRUE;
+
+        /* Set the item to be played */
+        worker->pl.current = 0;
+        item = g_ptr_array_index(worker->pl.items, 0);
+        _set_location(worker, item);
+
+        /* Start playing */
+        _construct_pipeline(worker);
+        _start_play(worker);
+}
+
+static void _destroy_pipeline(MafwGstRendererWorker *worker)
+{
+	if (!worker->pipeline)
+		return;
+
+	g_debug("destroying pipeline");
+	if (worker->async_bus_id) {
+		_remove_source(worker, worker->async_bus_id);
+		worker->async_bus_id = 0;
+	}
+	gst_bus_set_sync_handler(worker->bus, NULL, NULL);
+	gst_element_set_state(worker->pipeline, GST_STATE_NULL);
+	if (worker->bus) {
+		gst_object_unref(GST_OBJECT_CAST(worker->bus));
+		worker->bus = NULL;
+	}
+	gst_object_unref(GST_OBJECT(worker->pipeline));
+	worker->pipeline = NULL;
+	_drop_position(worker);
+}
+
+/*
+ * Whether the pipeline can be kept for the next media.  The modified
+ * playbin fallback picks its network queue from the location when built,
+ * so only playbin2 qualifies.
+ */
+static gboolean _can_reuse_pipeline(MafwGstRendererWorker *worker)
+{
+	return worker->reuse_pipeline && worker->pipeline && worker->bus &&
+		g_object_class_find_property(
+			G_OBJECT_GET_CLASS(worker->pipeline),
+			"nw-queue") == NULL;
+}
+
+/*
+ * Takes the pipeline back to READY so that a new URI can be set.  The
+ * sinks keep their devices open, and the bus, its watch and the audio bin
+ * stay in place.  Messages of the old media still queued are dropped, so
+ * the bus handlers never see them mixed with the ones of the new media.
+ */
+static void _reset_pipeline(MafwGstRendererWorker *worker)
+{
+	g_debug("resetting pipeline");
+	gst_element_set_state(worker->pipeline, GST_STATE_READY);
+	gst_bus_set_flushing(worker->bus, TRUE);
+	gst_bus_set_flushing(worker->bus, FALSE);
+}
+
+/*----------------------------------------------------------------------------
+  Standby pipeline
+  ----------------------------------------------------------------------------*/
+
+static gint _compare_param_ids(gconstpointer a, gconstpointer b,
+			       gpointer user_data)
+{
+	const GParamSpec *spec_a = *(GParamSpec * const *) a;
+	const GParamSpec *spec_b = *(GParamSpec * const *) b;
+
+	return (gint) spec_a->param_id - (gint) spec_b->param_id;
+}
+
+/*
+ * Copies the settings of one of our elements to its twin in another
+ * pipeline.  They go in the order they were installed, so that e.g. the
+ * equalizer layout is set before its bands.
+ */
+static void _copy_settings(GstElement *from, GstElement *to)
+{
+	GParamSpec **specs;
+	guint n, i;
+
+	if (from == NULL || to == NULL)
+		return;
+
+	specs = g_object_class_list_properties(G_OBJECT_GET_CLASS(from), &n);
+	g_qsort_with_data(specs, n, sizeof(GParamSpec *), _compare_param_ids,
+			  NULL);
+
+	for (i = 0; i < n; i++) {
+		GValue value = { 0, };
+
+		if (specs[i]->owner_type != G_OBJECT_TYPE(from) ||
+		    (specs[i]->flags & G_PARAM_READWRITE) != G_PARAM_READWRITE ||
+		    (specs[i]->flags & G_PARAM_CONSTRUCT_ONLY))
+			continue;
+
+		g_value_init(&value, specs[i]->value_type);
+		g_object_get_property(G_OBJECT(from), specs[i]->name, &value);
+		g_object_set_property(G_OBJECT(to), specs[i]->name, &value);
+		g_value_unset(&value);
+	}
+
+	g_free(specs);
+}
+
+static void _unref_element(GstElement **element)
+{
+	if (*element != NULL) {
+		gst_object_unref(*element);
+		*element = NULL;
+	}
+}
+
+static void _discard_standby(MafwGstRendererWorker *worker)
+{
+	if (worker->standby.pipeline == NULL)
+		return;
+
+	g_debug("discarding standby pipeline of %s", worker->standby.uri);
+
+	/* It was being faded in: the current media has to be heard again */
+	if (worker->crossfade_pending) {
+		worker->crossfade_pending = FALSE;
+		if (worker->fader) {
+			mafw_gst_renderer_fader_ramp(
+				MAFW_GST_RENDERER_FADER(worker->fader), -1.0,
+				1.0, GST_CLOCK_TIME_NONE, 0);
+		}
+	}
+
+	if (worker->standby.bus_id != 0) {
+		_remove_source(worker, worker->standby.bus_id);
+		worker->standby.bus_id = 0;
+	}
+	gst_element_set_state(worker->standby.pipeline, GST_STATE_NULL);
+	gst_object_unref(worker->standby.bus);
+	worker->standby.bus = NULL;
+	_unref_element(&worker->standby.pipeline);
+	_unref_element(&worker->standby.abin);
+	_unref_element(&worker->standby.equalizer);
+	_unref_element(&worker->standby.convolver);
+	_unref_element(&worker->standby.limiter);
+	_unref_element(&worker->standby.fader);
+	_unref_element(&worker->standby.asink);
+
+	if (worker->standby.tag_list != NULL) {
+		g_ptr_array_foreach(worker->standby.tag_list,
+				    (GFunc) _free_taglist_item, NULL);
+		g_ptr_array_free(worker->standby.tag_list, TRUE);
+		worker->standby.tag_list = NULL;
+	}
+
+	g_free(worker->standby.uri);
+	worker->standby.uri = NULL;
+	worker->standby.prerolled = FALSE;
+}
+
+/*
+ * Watches the standby pipeline until it is prerolled, and until it plays
+ * when a crossfade starts it.  Tags are kept for when it is taken; on
+ * errors, it is dropped and the media will be played the usual way, which
+ * reports them.
+ */
+static gboolean _standby_bus_cb(GstBus *bus, GstMessage *msg,
+				MafwGstRendererWorker *worker)
+{
+	GstElement *pipeline = worker->standby.pipeline;
+	GstState newstate;
+	gint n_video = 0;
+
+	switch (GST_MESSAGE_TYPE(msg)) {
+	case GST_MESSAGE_STATE_CHANGED:
+		if ((GstElement *) GST_MESSAGE_SRC(msg) != pipeline)
+			break;
+		gst_message_parse_state_changed(msg, NULL, &newstate, NULL);
+		if (newstate == GST_STATE_PLAYING &&
+		    worker->crossfade_pending) {
+			/* The swap removes this watch before the bus gets
+			 * its usual one */
+			_handover_crossfade(worker);
+			return FALSE;
+		}
+		if (newstate != GST_STATE_PAUSED || worker->standby.prerolled)
+			break;
+
+		/* Video needs its sink, which is in the current pipeline */
+		g_object_get(pipeline, "n-video", &n_video, NULL);
+		if (n_video > 0) {
+			worker->standby.bus_id = 0;
+			_discard_standby(worker);
+			_update_gapless_next(worker);
+			return FALSE;
+		}
+
+		g_debug("standby pipeline of %s prerolled",
+			worker->standby.uri);
+		worker->standby.prerolled = TRUE;
+		_update_gapless_next(worker);
+		_schedule_crossfade(worker);
+		break;
+	case GST_MESSAGE_TAG:
+		if (worker->standby.tag_list == NULL)
+			worker->standby.tag_list = g_ptr_array_new();
+		g_ptr_array_add(worker->standby.tag_list,
+				gst_message_ref(msg));
+		break;
+	case GST_MESSAGE_ERROR:
+		worker->standby.bus_id = 0;
+		_discard_standby(worker);
+		_update_gapless_next(worker);
+		return FALSE;
+	default: break;
+	}
+
+	return TRUE;
+}
+
+/*
+ * Builds a second playbin2 with its own audio bin for @uri, and prerolls it
+ * while the current media plays.  Its elements take the settings of the
+ * current ones.  The data it buffers is bound by standby_budget: playbin2
+ * buffers that much of a stream at most, and a queue at the head of the
+ * audio bin holds that much decoded audio at most, which holds the
+ * decoders back once the sink has prerolled.
+ */
+static void _build_standby(MafwGstRendererWorker *worker, const gchar *uri)
+{
+	GstStateChangeReturn ret;
+	GstElement *queue;
+
+	g_debug("building standby pipeline for %s", uri);
+
+	queue = gst_element_factory_make("queue", NULL);
+	worker->standby.pipeline = gst_element_factory_make("playbin2", NULL);
+	worker->standby.equalizer = mafw_gst_renderer_equalizer_new();
+	worker->standby.asink = gst_element_factory_make("pulsesink", NULL);
+	if (worker->convolver)
+		worker->standby.convolver = mafw_gst_renderer_convolver_new();
+	if (worker->limiter)
+		worker->standby.limiter = mafw_gst_renderer_limiter_new();
+	if (worker->fader)
+		worker->standby.fader = mafw_gst_renderer_fader_new();
+
+	if (!queue || !worker->standby.pipeline ||
+	    !worker->standby.equalizer || !worker->standby.asink ||
+	    (worker->convolver && !worker->standby.convolver) ||
+	    (worker->limiter && !worker->standby.limiter) ||
+	    (worker->fader && !worker->standby.fader)) {
+		g_warning("could not build a standby pipeline");
+		_unref_element(&queue);
+		_unref_element(&worker->standby.pipeline);
+		_unref_element(&worker->standby.equalizer);
+		_unref_element(&worker->standby.asink);
+		_unref_element(&worker->standby.convolver);
+		_unref_element(&worker->standby.limiter);
+		_unref_element(&worker->standby.fader);
+		return;
+	}
+
+	/* Same references as the ones of the current pipeline */
+	gst_object_ref(worker->standby.equalizer);
+	gst_object_ref(worker->standby.asink);
+	if (worker->standby.convolver)
+		gst_object_ref(worker->standby.convolver);
+	if (worker->standby.limiter)
+		gst_object_ref(worker->standby.limiter);
+	if (worker->standby.fader)
+		gst_object_ref(worker->standby.fader);
+
+	g_object_set(worker->standby.asink,
+		     "buffer-time", (gint64) MAFW_GST_BUFFER_TIME,
+		     "latency-time", (gint64) MAFW_GST_LATENCY_TIME,
+		     NULL);
+	g_object_set(queue,
+		     "max-size-bytes", worker->standby_budget * 1024,
+		     "max-size-buffers", 0,
+		     "max-size-time", (guint64) 0,
+		     NULL);
+	_copy_settings(worker->equalizer, worker->standby.equalizer);
+	_copy_settings(worker->convolver, worker->standby.convolver);
+	_copy_settings(worker->limiter, worker->standby.limiter);
+
+	/* The fader is not copied.  The standby prerolls silent if it may be
+	 * faded in, so that the prerolled buffer does not blast out ahead of
+	 * the fade */
+	if (worker->standby.fader && worker->crossfade > 0)
+		g_object_set(worker->standby.fader, "gain", 0.0, NULL);
+
+	worker->standby.abin = _make_audio_bin(worker,
+					       queue,
+					       worker->standby.fader,
+					       worker->standby.equalizer,
+					       worker->standby.convolver,
+					       worker->standby.limiter,
+					       worker->standby.asink);
+
+	g_object_set(worker->standby.pipeline,
+		     "audio-sink", worker->standby.abin,
+		     "flags", MAFW_GST_RENDERER_WORKER_STANDBY_FLAGS,
+		     "uri", uri,
+		     NULL);
+	if (g_object_class_find_property(
+		    G_OBJECT_GET_CLASS(worker->standby.pipeline),
+		    "buffer-size")) {
+		g_object_set(worker->standby.pipeline, "buffer-size",
+			     (gint) worker->standby_budget * 1024, NULL);
+	}
+
+	worker->standby.uri = g_strdup(uri);
+	worker->standby.bus =
+		gst_pipeline_get_bus(GST_PIPELINE(worker->standby.pipeline));
+	worker->standby.bus_id =
+		_bus_add_watch(worker, worker->standby.bus, G_PRIORITY_DEFAULT,
+			       (GstBusFunc) _standby_bus_cb, worker);
+
+	/* Live sources have nothing to preroll */
+	ret = gst_element_set_state(worker->standby.pipeline,
+				    GST_STATE_PAUSED);
+	if (ret == GST_STATE_CHANGE_FAILURE ||
+	    ret == GST_STATE_CHANGE_NO_PREROLL) {
+		_discard_standby(worker);
+	}
+}
+
+/*
+ * Keeps the standby pipeline in line with the media to continue with.  It
+ * is kept across stops, as next() stops before playing the next media.
+ * There is none when that media is going to be queued gaplessly on the
+ * current pipeline anyway; only a crossfade needs it then.
+ */
+static void _update_standby(MafwGstRendererWorker *worker)
+{
+	const gchar *uri = _next_media(worker);
+
+	if (worker->crossfade == 0 && _gapless_supported(worker))
+		uri = NULL;
+
+	if (uri != NULL && worker->standby.uri != NULL &&
+	    strcmp(uri, worker->standby.uri) == 0)
+		return;
+
+	_discard_standby(worker);
+
+	if (uri == NULL || worker->abin == NULL ||
+	    worker->standby_budget <
+	    MAFW_GST_RENDERER_WORKER_STANDBY_MIN_BUDGET ||
+	    uri_is_playlist(uri))
+		return;
+
+	_build_standby(worker, uri);
+}
+
+/*
+ * Makes the standby pipeline the current one, in place of the current one
+ * and its audio bin, which are destroyed, or handed over to the fadeout
+ * if @keep_old.  Everything is swapped by pointer, so it takes the same
+ * time whatever the media.
+ */
+static void _swap_standby(MafwGstRendererWorker *worker, gboolean keep_old)
+{
+	GstElement *pipeline = worker->pipeline;
+	GstBus *bus = worker->bus;
+	GstElement *abin = worker->abin;
+	GstElement *equalizer = worker->equalizer;
+	GstElement *convolver = worker->convolver;
+	GstElement *limiter = worker->limiter;
+	GstElement *fader = worker->fader;
+	GstElement *asink = worker->asink;
+
+	if (worker->async_bus_id) {
+		_remove_source(worker, worker->async_bus_id);
+		worker->async_bus_id = 0;
+	}
+	if (bus)
+		gst_bus_set_sync_handler(bus, NULL, NULL);
+	if (worker->standby.bus_id) {
+		_remove_source(worker, worker->standby.bus_id);
+		worker->standby.bus_id = 0;
+	}
+
+	worker->pipeline = worker->standby.pipeline;
+	worker->bus = worker->standby.bus;
+	_drop_position(worker);
+	/* Seeks were for the old pipeline */
+	_reset_seeks(worker);
+	_set_seek_position(worker, -1);
+	_detach_gapless_probe(worker);
+	worker->abin = worker->standby.abin;
+	worker->equalizer = worker->standby.equalizer;
+	worker->convolver = worker->standby.convolver;
+	worker->limiter = worker->standby.limiter;
+	worker->fader = worker->standby.fader;
+	worker->asink = worker->standby.asink;
+	_attach_gapless_probe(worker);
+	worker->buffering_state = GST_STATE_VOID_PENDING;
+	_free_taglist(worker);
+	worker->tag_list = worker->standby.tag_list;
+	g_free(worker->standby.uri);
+	memset(&worker->standby, 0, sizeof(worker->standby));
+
+	gst_bus_set_sync_handler(worker->bus,
+				 (GstBusSyncHandler)_sync_bus_handler, worker);
+	worker->async_bus_id = _bus_add_watch(worker, worker->bus,
+					      G_PRIORITY_HIGH,
+					      (GstBusFunc)_async_bus_handler,
+					      worker);
+	g_signal_connect(worker->pipeline, "notify::stream-info",
+			 G_CALLBACK(_stream_info_cb), worker);
+	g_signal_connect(worker->pipeline, "about-to-finish",
+			 G_CALLBACK(_about_to_finish_cb), worker);
+
+	/* Video is set up for the media played after this one */
+	g_object_set(worker->pipeline,
+		     "video-sink", worker->vsink,
+		     "flags", 99,
+		     NULL);
+
+	/* The settings may have changed since the standby was built */
+	_copy_settings(equalizer, worker->equalizer);
+	_copy_settings(convolver, worker->convolver);
+	_copy_settings(limiter, worker->limiter);
+
+	if (pipeline && keep_old) {
+		/* It keeps its audio bin until it is discarded */
+		g_signal_handlers_disconnect_by_func(
+			pipeline, _stream_info_cb, worker);
+		g_signal_handlers_disconnect_by_func(
+			pipeline, _about_to_finish_cb, worker);
+		_discard_fadeout(worker);
+		worker->fadeout.pipeline = pipeline;
+		worker->fadeout.bus = bus;
+		worker->fadeout.bus_id =
+			_bus_add_watch(worker, bus, G_PRIORITY_DEFAULT,
+				       (GstBusFunc) _fadeout_bus_cb, worker);
+	} else if (pipeline) {
+		gst_element_set_state(pipeline, GST_STATE_NULL);
+		gst_object_unref(bus);
+		gst_object_unref(pipeline);
+	}
+	_unref_element(&abin);
+	_unref_element(&equalizer);
+	_unref_element(&convolver);
+	_unref_element(&limiter);
+	_unref_element(&fader);
+	_unref_element(&asink);
+}
+
+/*
+ * Plays @uri from the standby pipeline, if it is the one prerolled there.
+ * As _start_play(), except that the preroll is already done or under way.
+ */
+static gboolean _start_standby(MafwGstRendererWorker *worker,
+			       const gchar *uri)
+{
+	gboolean prerolled;
+
+	if (worker->standby.pipeline == NULL ||
+	    strcmp(worker->standby.uri, uri) != 0) {
+		if (worker->standby.pipeline != NULL) {
+			g_mutex_lock(worker->stats_lock);
+			worker->standby_misses++;
+			g_mutex_unlock(worker->stats_lock);
+		}
+		return FALSE;
+	}
+
+	prerolled = worker->standby.prerolled;
+	_swap_standby(worker, FALSE);
+	/* It is not faded in: only its prerolled buffer is lost, if it
+	 * prerolled silent */
+	if (worker->fader)
+		g_object_set(worker->fader, "gain", 1.0, NULL);
+	g_mutex_lock(worker->stats_lock);
+	worker->standby_hits++;
+	g_mutex_unlock(worker->stats_lock);
+	g_debug("playing %s from the standby pipeline (%s); %u hits, "
+		"%u misses", uri, prerolled ? "prerolled" : "prerolling",
+		worker->standby_hits, worker->standby_misses);
+
+	worker->report_statechanges = TRUE;
+	worker->is_stream = uri_is_stream(uri);
+
+	_notify(worker, WORKER_NOTIFY_LOADING);
+
+	if (prerolled) {
+		/* As when the READY to PAUSED state change comes */
+		worker->state = GST_STATE_PAUSED;
+		_finalize_startup(worker);
+		_do_play(worker);
+		_notify(worker, WORKER_NOTIFY_PLAYABLE);
+		if (worker->stay_paused) {
+			_do_pause_postprocessing(worker);
+		}
+	} else {
+		/* Which is still to be dispatched to _async_bus_handler */
+		worker->state = GST_STATE_READY;
+		worker->prerolling = TRUE;
+	}
+
+	return TRUE;
+}
+
+/*----------------------------------------------------------------------------
+  Crossfade
+  ----------------------------------------------------------------------------*/
+
+/*
+ * A crossfade plays the standby pipeline over the end of the current one,
+ * the fader at the tail of each audio bin ramping its gain, and both sinks
+ * are mixed by the sound server.  The equalizer and the limiter of each
+ * bin see the stream at its own level, as when it plays alone.  What each
+ * bin lets out is held under the limiter threshold and the two gains add
+ * up to 1 at most, so the mix stays under it too.  Once the standby plays
+ * it becomes the current pipeline, as in a gapless switch, and the old one
+ * is kept as the fadeout until it ends.
+ */
+
+static void _discard_fadeout(MafwGstRendererWorker *worker)
+{
+	if (worker->fadeout.pipeline == NULL)
+		return;
+
+	if (worker->fadeout.bus_id != 0) {
+		_remove_source(worker, worker->fadeout.bus_id);
+		worker->fadeout.bus_id = 0;
+	}
+	if (worker->fadeout.timeout_id != 0) {
+		_remove_source(worker, worker->fadeout.timeout_id);
+		worker->fadeout.timeout_id = 0;
+	}
+	gst_element_set_state(worker->fadeout.pipeline, GST_STATE_NULL);
+	gst_object_unref(worker->fadeout.bus);
+	worker->fadeout.bus = NULL;
+	_unref_element(&worker->fadeout.pipeline);
+}
+
+static gboolean _fadeout_bus_cb(GstBus *bus, GstMessage *msg,
+				MafwGstRendererWorker *worker)
+{
+	switch (GST_MESSAGE_TYPE(msg)) {
+	case GST_MESSAGE_EOS:
+	case GST_MESSAGE_ERROR:
+		g_debug("fadeout over");
+		worker->fadeout.bus_id = 0;
+		_discard_fadeout(worker);
+		return FALSE;
+	default: break;
+	}
+
+	return TRUE;
+}
+
+static gboolean _fadeout_timeout_cb(MafwGstRendererWorker *worker)
+{
+	worker->fadeout.timeout_id = 0;
+	_discard_fadeout(worker);
+	return FALSE;
+}
+
+static void _remove_crossfade_timeout(MafwGstRendererWorker *worker)
+{
+	if (worker->crossfade_id != 0) {
+		_remove_source(worker, worker->crossfade_id);
+		worker->crossfade_id = 0;
+	}
+}
+
+/*
+ * Whether the current media may be crossfaded into the standby.  Video
+ * goes through the usual switch.
+ */
+static gboolean _crossfade_possible(MafwGstRendererWorker *worker)
+{
+	return worker->crossfade > 0 && !worker->crossfade_pending &&
+		worker->pipeline != NULL && worker->fader != NULL &&
+		worker->state == GST_STATE_PLAYING &&
+		!worker->media.has_visual_content &&
+		worker->standby.pipeline != NULL &&
+		worker->standby.fader != NULL;
+}
+
+/*
+ * Gets the position of the current media, the stream time its fade out
+ * starts at, and its length: crossfade, or half the media if shorter.
+ */
+static gboolean _crossfade_times(MafwGstRendererWorker *worker,
+				 GstClockTime *position, GstClockTime *start,
+				 GstClockTime *length)
+{
+	GstFormat format = GST_FORMAT_TIME;
+	gint64 pos, dur;
+
+	if (!gst_element_query_position(worker->pipeline, &format, &pos) ||
+	    !gst_element_query_duration(worker->pipeline, &format, &dur) ||
+	    pos < 0 || dur <= 0)
+		return FALSE;
+
+	*position = pos;
+	*length = MIN((GstClockTime) worker->crossfade * GST_MSECOND,
+		      (GstClockTime) dur / 2);
+	*start = dur - *length;
+
+	return TRUE;
+}
+
+/*
+ * Starts the crossfade when it is time.  The standby has to be prerolled
+ * by then, and the fade in has to last at least half the crossfade;
+ * otherwise the media switch the usual way, without a fade.
+ */
+static gboolean _crossfade_cb(MafwGstRendererWorker *worker)
+{
+	GstClockTime position, start, length, remaining;
+
+	worker->crossfade_id = 0;
+
+	if (!_crossfade_possible(worker) ||
+	    !_crossfade_times(worker, &position, &start, &length))
+		return FALSE;
+
+	if (start > position + MAFW_GST_RENDERER_WORKER_CROSSFADE_SLACK *
+	    GST_MSECOND) {
+		_schedule_crossfade(worker);
+		return FALSE;
+	}
+
+	remaining = start + length > position ? start + length - position : 0;
+	if (!worker->standby.prerolled || remaining < length / 2) {
+		g_debug("%s not prerolled in time, no crossfade",
+			worker->standby.uri);
+		return FALSE;
+	}
+
+	g_debug("crossfading into %s over %" GST_TIME_FORMAT,
+		worker->standby.uri, GST_TIME_ARGS(remaining));
+
+	/* The fade out is tied to the stream time it should start at, even
+	 * if this timeout comes late; the fade in then ends with it, over
+	 * what is left, so that the gains never add up to more than 1.  The
+	 * standby prerolled silent and goes on from there */
+	mafw_gst_renderer_fader_ramp(MAFW_GST_RENDERER_FADER(worker->fader),
+				     1.0, 0.0, start, length);
+	mafw_gst_renderer_fader_ramp(
+		MAFW_GST_RENDERER_FADER(worker->standby.fader), 0.0, 1.0,
+		GST_CLOCK_TIME_NONE, remaining);
+	gst_element_set_state(worker->standby.pipeline, GST_STATE_PLAYING);
+	worker->crossfade_pending = TRUE;
+	worker->crossfade_length = remaining;
+
+	return FALSE;
+}
+
+/*
+ * Plans the crossfade out of the current media, if the standby may take
+ * over.  It is planned again whenever the position or the standby change.
+ */
+static void _schedule_crossfade(MafwGstRendererWorker *worker)
+{
+	GstClockTime position, start, length;
+
+	_remove_crossfade_timeout(worker);
+
+	if (!_crossfade_possible(worker) ||
+	    !_crossfade_times(worker, &position, &start, &length))
+		return;
+
+	worker->crossfade_id =
+		_timeout_add(worker, start > position ?
+			     (start - position) / GST_MSECOND : 0,
+			     (GSourceFunc) _crossfade_cb, worker);
+}
+
+/*
+ * The standby plays: make it the current pipeline, the old one fading out
+ * on its own, and report the new media as after a gapless switch.
+ */
+static void _handover_crossfade(MafwGstRendererWorker *worker)
+{
+	gchar *uri;
+
+	uri = g_strdup(worker->standby.uri);
+	worker->crossfade_pending = FALSE;
+
+	_swap_standby(worker, TRUE);
+	worker->fadeout.timeout_id =
+		_timeout_add(worker, worker->crossfade_length / GST_MSECOND +
+			     MAFW_GST_RENDERER_WORKER_FADEOUT_LINGER,
+			     (GSourceFunc) _fadeout_timeout_cb, worker);
+
+	worker->state = GST_STATE_PLAYING;
+	_reset_volume_and_mute_to_pipeline(worker);
+	_handle_track_changed(worker, uri);
+	g_free(uri);
+}
+
+/*
+ * Stops any crossfade, for the current media to go on alone.  A standby
+ * already started is discarded, as it is no longer at its start.
+ */
+static void _cancel_crossfade(MafwGstRendererWorker *worker)
+{
+	_remove_crossfade_timeout(worker);
+	if (worker->crossfade_pending)
+		_discard_standby(worker);
+	_discard_fadeout(worker);
+}
+
+/*
+ * Stops playback and resets the worker into default startup configuration.
+ * The Gst pipeline is kept in READY if reuse_pipeline is set, and destroyed
+ * and built again otherwise.
+ */
+static void _stop_cmd(MafwGstRendererWorker *worker, WorkerCommand *cmd)
+{
 	mafw_gst_renderer_worker_stop(worker);
+}
+
+void mafw_gst_renderer_worker_stop(MafwGstRendererWorker *worker)
+{
+	g_debug("worker stop");
+	g_assert(worker != NULL);
+
+	if (_foreign_thread(worker)) {
+		_queue_command(worker, _command_new(_stop_cmd));
+		return;
+	}
+
+	_new_notify_generation(worker);
+
+	/* A playlist file being parsed is not to be played any more */
+	_cancel_parse(worker);
+	_stop(worker);
+}
+
+/*
+ * Stops playback, as mafw_gst_renderer_worker_stop() does, and lets a
+ * playlist file go on being parsed.
+ */
+static void _stop(MafwGstRendererWorker *worker)
+{
+	/* If location is NULL, this is a pre-created pipeline */
+	if (worker->async_bus_id && worker->pipeline && !worker->media.location)
+		return;
+
+	_stall_begin(worker);
+
+	/* Nothing may be queued into the pipeline from now on */
+	_cancel_crossfade(worker);
+	_clear_gapless(worker);
+	g_free(worker->next_uri);
+	worker->next_uri = NULL;
+
+	/* Media was loaded, so this may be a switch to another one; it is
+	 * timed until the next one prerolls */
+	if (worker->media.location) {
+		g_timer_start(worker->switch_timer);
+		worker->switch_pending = TRUE;
+	}
+
+	if (_can_reuse_pipeline(worker)) {
+		_reset_pipeline(worker);
+	} else {
+		_destroy_pipeline(worker);
+	}
+
+	if (worker->equalizer) {
+		guint bypassed, processed, skipped, hits, misses;
+
+		g_object_get(worker->equalizer,
+			     "buffers-bypassed", &bypassed,
+			     "buffers-processed", &processed,
+			     "buffers-skipped", &skipped,
+			     NULL);
+		eq_dsp_cache_stats(&hits, &misses);
+		g_debug("equalizer: %u buffers bypassed, %u processed, "
+			"%u skipped as silent, coefficient cache %u hits, "
+			"%u misses",
+			bypassed, processed, skipped, hits, misses);
+	}
+
+	if (worker->convolver) {
+		guint blocks, skipped;
+
+		g_object_get(worker->convolver,
+			     "blocks-processed", &blocks,
+			     "buffers-skipped", &skipped,
+			     NULL);
+		g_debug("convolver: %u blocks processed, %u buffers skipped "
+			"as silent", blocks, skipped);
+	}
+
+	if (worker->limiter) {
+		guint limited, skipped;
+
+		g_object_get(worker->limiter,
+			     "buffers-limited", &limited,
+			     "buffers-skipped", &skipped,
+			     NULL);
+		g_debug("limiter: %u buffers limited, %u skipped as silent",
+			limited, skipped);
+	}
+
+	if (worker->stall_where) {
+		g_debug("main loop: longest stall %.1f ms, in %s",
+			worker->stall_max, worker->stall_where);
+		worker->stall_max = 0.0;
+		worker->stall_where = NULL;
+	}
+
+	/* Reset worker */
+	worker->report_statechanges = TRUE;
+	worker->pause_pending = FALSE;
+	worker->state = GST_STATE_NULL;
+	worker->buffering_state = GST_STATE_VOID_PENDING;
+	worker->prerolling = FALSE;
+	worker->is_live = FALSE;
+	worker->buffering = FALSE;
+	worker->is_stream = FALSE;
+	worker->is_error = FALSE;
+	_set_eos(worker, FALSE);
+	_set_seek_position(worker, -1);
+	_reset_seeks(worker);
+	_drop_position(worker);
+	_remove_ready_timeout(worker);
+	_free_taglist(worker);
+	_clear_current_metadata(worker);
+
+	if (worker->duration_seek_timeout != 0) {
+		_remove_source(worker, worker->duration_seek_timeout);
+		worker->duration_seek_timeout = 0;
+	}
+
+	/* Reset media iformation */
 	_reset_media_info(worker);
 
-	worker->media.location = g_strdup(next);
-	_construct_pipeline(worker);
-	_start_play(worker);
+	/* We are not playing, so we can let the screen blank */
+	blanking_allow();
+        keypadlocking_allow();
+
+	/* And now get a fresh pipeline ready */
+	_construct_pipeline(worker);
+
+	worker->switch_stop = 1000.0 * g_timer_elapsed(worker->switch_timer,
+						       NULL);
+	_stall_end(worker, "stop");
+}
+
+static void _set_reuse_pipeline(MafwGstRendererWorker *worker,
+				gboolean reuse_pipeline)
+{
+	if (worker->reuse_pipeline == reuse_pipeline)
+		return;
+
+	/* The figures of each mode are kept apart, to compare them */
+	worker->reuse_pipeline = reuse_pipeline;
+	g_mutex_lock(worker->stats_lock);
+	worker->switch_count = 0;
+	worker->switch_total = 0.0;
+	worker->switch_max = 0.0;
+	g_mutex_unlock(worker->stats_lock);
+}
+
+static void _set_reuse_pipeline_cmd(MafwGstRendererWorker *worker,
+				    WorkerCommand *cmd)
+{
+	_set_reuse_pipeline(worker, cmd->value);
+}
+
+void mafw_gst_renderer_worker_set_reuse_pipeline(
+	MafwGstRendererWorker *worker, gboolean reuse_pipeline)
+{
+	worker->config.reuse_pipeline = reuse_pipeline;
+
+	if (_foreign_thread(worker)) {
+		WorkerCommand *cmd;
+
+		cmd = _command_new(_set_reuse_pipeline_cmd);
+		cmd->value = reuse_pipeline;
+		_queue_command(worker, cmd);
+		return;
+	}
+
+	_set_reuse_pipeline(worker, reuse_pipeline);
+}
+
+gboolean mafw_gst_renderer_worker_get_reuse_pipeline(
+	MafwGstRendererWorker *worker)
+{
+	return worker->config.reuse_pipeline;
+}
+
+/*
+ * Gets the track switches timed since the pipeline reuse was last set, and
+ * their mean and longest time from stop to the preroll of the next media,
+ * in milliseconds.  Any of them may be NULL.
+ */
+void mafw_gst_renderer_worker_get_switch_stats(MafwGstRendererWorker *worker,
+					       guint *switch_count,
+					       gdouble *mean_ms,
+					       gdouble *max_ms)
+{
+	g_assert(worker != NULL);
+
+	g_mutex_lock(worker->stats_lock);
+	if (switch_count != NULL)
+		*switch_count = worker->switch_count;
+	if (mean_ms != NULL)
+		*mean_ms = worker->switch_count > 0 ?
+			worker->switch_total / worker->switch_count : 0.0;
+	if (max_ms != NULL)
+		*max_ms = worker->switch_max;
+	g_mutex_unlock(worker->stats_lock);
+}
+
+/*
+ * Sets the URI to continue with, without a gap, when the current media ends,
+ * or NULL for none.  notify_next_handler is called when playback moves on to
+ * it; otherwise, the usual EOS notification comes.  It is forgotten on stop.
+ * It is also prerolled on the standby pipeline, which stays until another
+ * URI is set, so that mafw_gst_renderer_worker_play() starts it at once.
+ */
+static void _set_next_uri_cmd(MafwGstRendererWorker *worker,
+			      WorkerCommand *cmd)
+{
+	mafw_gst_renderer_worker_set_next_uri(worker, cmd->uri);
+}
+
+void mafw_gst_renderer_worker_set_next_uri(MafwGstRendererWorker *worker,
+					   const gchar *uri)
+{
+	g_assert(worker != NULL);
+
+	if (_foreign_thread(worker)) {
+		WorkerCommand *cmd;
+
+		cmd = _command_new(_set_next_uri_cmd);
+		cmd->uri = g_strdup(uri);
+		_queue_command(worker, cmd);
+		return;
+	}
+
+	g_free(worker->next_uri);
+	worker->next_uri = g_strdup(uri);
+	_update_gapless_next(worker);
+	_update_standby(worker);
 }
 
-static void _do_play(MafwGstRendererWorker *worker)
+static void _set_gapless(MafwGstRendererWorker *worker, gboolean gapless)
+{
+	worker->gapless = gapless;
+	_update_gapless_next(worker);
+	_update_standby(worker);
+}
+
+static void _set_gapless_cmd(MafwGstRendererWorker *worker,
+			     WorkerCommand *cmd)
+{
+	_set_gapless(worker, cmd->value);
+}
+
+void mafw_gst_renderer_worker_set_gapless(MafwGstRendererWorker *worker,
+					 gboolean gapless)
 {
 	g_assert(worker != NULL);
 
-	if (worker->pipeline == NULL) {
-		g_debug("play without a pipeline!");
+	worker->config.gapless = gapless;
+
+	if (_foreign_thread(worker)) {
+		WorkerCommand *cmd;
+
+		cmd = _command_new(_set_gapless_cmd);
+		cmd->value = gapless;
+		_queue_command(worker, cmd);
 		return;
 	}
-	worker->report_statechanges = TRUE;
 
-	/* If we have to stay paused, we do and add the ready
-	 * timeout. Otherwise, we move the pipeline */
-	if (!worker->stay_paused) {
-		/* If pipeline is READY, we move it to PAUSED,
-		 * otherwise, to PLAYING */
-		if (worker->state == GST_STATE_READY) {
-			gst_element_set_state(worker->pipeline,
-					      GST_STATE_PAUSED);
-			g_debug("setting pipeline to PAUSED");
-		} else {
-			_reset_volume_and_mute_to_pipeline(worker);
-			gst_element_set_state(worker->pipeline,
-					      GST_STATE_PLAYING);
-			g_debug("setting pipeline to PLAYING");
-		}
-	}
-	else {
-		g_debug("staying in PAUSED state");
-		_add_ready_timeout(worker);
+	_set_gapless(worker, gapless);
+}
+
+gboolean mafw_gst_renderer_worker_get_gapless(MafwGstRendererWorker *worker)
+{
+	return worker->config.gapless;
+}
+
+/*
+ * Sets the memory budget of the standby pipeline, in KB.  Below
+ * MAFW_GST_RENDERER_WORKER_STANDBY_MIN_BUDGET, there is none.
+ */
+static void _set_standby_budget(MafwGstRendererWorker *worker, guint budget)
+{
+	if (worker->standby_budget == budget)
+		return;
+
+	worker->standby_budget = budget;
+	_discard_standby(worker);
+	_update_standby(worker);
+}
+
+static void _set_standby_budget_cmd(MafwGstRendererWorker *worker,
+				    WorkerCommand *cmd)
+{
+	_set_standby_budget(worker, cmd->value);
+}
+
+void mafw_gst_renderer_worker_set_standby_budget(MafwGstRendererWorker *worker,
+						 guint budget)
+{
+	g_assert(worker != NULL);
+
+	worker->config.standby_budget = budget;
+
+	if (_foreign_thread(worker)) {
+		WorkerCommand *cmd;
+
+		cmd = _command_new(_set_standby_budget_cmd);
+		cmd->value = budget;
+		_queue_command(worker, cmd);
+		return;
 	}
+
+	_set_standby_budget(worker, budget);
 }
 
-void mafw_gst_renderer_worker_play(MafwGstRendererWorker *worker,
-                                   const gchar *uri,
-                                   GSList *plitems)
+guint mafw_gst_renderer_worker_get_standby_budget(MafwGstRendererWorker *worker)
 {
-	g_assert(uri || plitems);
+	return worker->config.standby_budget;
+}
 
-	mafw_gst_renderer_worker_stop(worker);
-	_reset_media_info(worker);
-	_reset_pl_info(worker);
-	/* Check if the item to play is a single item or a playlist. */
-	if (plitems || uri_is_playlist(uri)){
-               gchar *item;
-		/* In case of a playlist we parse it and start playing the first
-		   item of the playlist. */
-               if (plitems)
-                {
-                        worker->pl.items = plitems;
-                }
-                else
-                {
-                        worker->pl.items = _parse_playlist(uri);
-		}
-		if (!worker->pl.items) {
-			_send_error(worker,
-                            g_error_new(MAFW_RENDERER_ERROR,
-                                        MAFW_RENDERER_ERROR_PLAYLIST_PARSING,
-                                        "Playlist parsing failed: %s",
-                                        uri));
-			return;
-		}
+/*
+ * Gets how many media were played from the standby pipeline, and how many
+ * were played while another one was on standby.  Either may be NULL.
+ */
+void mafw_gst_renderer_worker_get_standby_stats(MafwGstRendererWorker *worker,
+						guint *hit_count,
+						guint *miss_count)
+{
+	g_assert(worker != NULL);
 
-		/* Set the playback mode */
-		worker->mode = WORKER_MODE_PLAYLIST;
-		worker->pl.notify_play_pending = TRUE;
+	g_mutex_lock(worker->stats_lock);
+	if (hit_count != NULL)
+		*hit_count = worker->standby_hits;
+	if (miss_count != NULL)
+		*miss_count = worker->standby_misses;
+	g_mutex_unlock(worker->stats_lock);
+}
 
-		/* Set the item to be played */
-		worker->pl.current = 0;
-		item = (gchar *) g_slist_nth_data(worker->pl.items, 0);
-		worker->media.location = g_strdup(item);
-	} else {
-		/* Single item. Set the playback mode according to that */
-		worker->mode = WORKER_MODE_SINGLE_PLAY;
+/*
+ * Sets the length of the crossfade between consecutive media, in
+ * milliseconds, up to MAFW_GST_RENDERER_WORKER_MAX_CROSSFADE; 0 switches
+ * crossfades off.  The next media fades in on the standby pipeline, so
+ * there is none without it.
+ */
+static void _set_crossfade(MafwGstRendererWorker *worker, guint crossfade)
+{
+	/* The standby prerolls at another gain with crossfades than
+	 * without */
+	if ((crossfade > 0) != (worker->crossfade > 0) &&
+	    !worker->crossfade_pending)
+		_discard_standby(worker);
+	worker->crossfade = crossfade;
+	_update_standby(worker);
+	_update_gapless_next(worker);
+	_schedule_crossfade(worker);
+}
 
-		/* Set the item to be played */
-		worker->media.location = g_strdup(uri);
+static void _set_crossfade_cmd(MafwGstRendererWorker *worker,
+			       WorkerCommand *cmd)
+{
+	_set_crossfade(worker, cmd->value);
+}
+
+void mafw_gst_renderer_worker_set_crossfade(MafwGstRendererWorker *worker,
+					    guint crossfade)
+{
+	g_assert(worker != NULL);
+
+	crossfade = MIN(crossfade, MAFW_GST_RENDERER_WORKER_MAX_CROSSFADE);
+	worker->config.crossfade = crossfade;
+
+	if (_foreign_thread(worker)) {
+		WorkerCommand *cmd;
+
+		cmd = _command_new(_set_crossfade_cmd);
+		cmd->value = crossfade;
+		_queue_command(worker, cmd);
+		return;
 	}
-	_construct_pipeline(worker);
-	_start_play(worker);
+
+	_set_crossfade(worker, crossfade);
 }
 
-void mafw_gst_renderer_worker_play_alternatives(MafwGstRendererWorker *worker,
-                                                gchar **uris)
+guint mafw_gst_renderer_worker_get_crossfade(MafwGstRendererWorker *worker)
 {
-        gint i;
-        gchar *item;
+	return worker->config.crossfade;
+}
 
-        g_assert(uris && uris[0]);
+/*
+ * Sets whether seeks go to the exact position asked for, decoding from the
+ * keyframe before it, instead of to that keyframe.  Seek latencies are
+ * measured anew from then on.
+ */
+static void _set_accurate_seek(MafwGstRendererWorker *worker,
+			       gboolean accurate)
+{
+	if (worker->seek_accurate == accurate)
+		return;
 
-        mafw_gst_renderer_worker_stop(worker);
-        _reset_media_info(worker);
-        _reset_pl_info(worker);
+	worker->seek_accurate = accurate;
+	g_mutex_lock(worker->stats_lock);
+	worker->seek_count = 0;
+	worker->seek_merged = 0;
+	worker->seek_total = 0.0;
+	worker->seek_max = 0.0;
+	g_mutex_unlock(worker->stats_lock);
+}
 
-        /* Add the uris to playlist */
-        i = 0;
-        while (uris[i]) {
-                worker->pl.items =
-                        g_slist_append(worker->pl.items, g_strdup(uris[i]));
-                i++;
-        }
+static void _set_accurate_seek_cmd(MafwGstRendererWorker *worker,
+				   WorkerCommand *cmd)
+{
+	_set_accurate_seek(worker, cmd->value);
+}
 
-        /* Set the playback mode */
-        worker->mode = WORKER_MODE_REDUNDANT;
-        worker->pl.notify_play_pending = TRUE;
+void mafw_gst_renderer_worker_set_accurate_seek(MafwGstRendererWorker *worker,
+						gboolean accurate)
+{
+	g_assert(worker != NULL);
 
-        /* Set the item to be played */
-        worker->pl.current = 0;
-        item = (gchar *) g_slist_nth_data(worker->pl.items, 0);
-        worker->media.location = g_strdup(item);
+	worker->config.seek_accurate = accurate;
 
-        /* Start playing */
-        _construct_pipeline(worker);
-        _start_play(worker);
+	if (_foreign_thread(worker)) {
+		WorkerCommand *cmd;
+
+		cmd = _command_new(_set_accurate_seek_cmd);
+		cmd->value = accurate;
+		_queue_command(worker, cmd);
+		return;
+	}
+
+	_set_accurate_seek(worker, accurate);
+}
+
+gboolean mafw_gst_renderer_worker_get_accurate_seek(
+	MafwGstRendererWorker *worker)
+{
+	return worker->config.seek_accurate;
 }
 
 /*
- * Currently, stop destroys the Gst pipeline and resets the worker into
- * default startup configuration.
+ * Gets the seeks timed since the seek mode was last set, their mean and
+ * longest time to the first frame in milliseconds, and how many were
+ * replaced by a later one while waiting.  Any of them may be NULL.
  */
-void mafw_gst_renderer_worker_stop(MafwGstRendererWorker *worker)
+void mafw_gst_renderer_worker_get_seek_stats(MafwGstRendererWorker *worker,
+					     guint *seek_count,
+					     gdouble *mean_ms,
+					     gdouble *max_ms,
+					     guint *merged_count)
 {
-	g_debug("worker stop");
 	g_assert(worker != NULL);
 
-	/* If location is NULL, this is a pre-created pipeline */
-	if (worker->async_bus_id && worker->pipeline && !worker->media.location)
+	g_mutex_lock(worker->stats_lock);
+	if (seek_count != NULL)
+		*seek_count = worker->seek_count;
+	if (mean_ms != NULL)
+		*mean_ms = worker->seek_count > 0 ?
+			worker->seek_total / worker->seek_count : 0.0;
+	if (max_ms != NULL)
+		*max_ms = worker->seek_max;
+	if (merged_count != NULL)
+		*merged_count = worker->seek_merged;
+	g_mutex_unlock(worker->stats_lock);
+}
+
+static void _set_stay_paused_cmd(MafwGstRendererWorker *worker,
+				 WorkerCommand *cmd)
+{
+	mafw_gst_renderer_worker_set_stay_paused(worker, cmd->value);
+}
+
+/*
+ * Sets whether the pipeline has to stay in PAUSED when it would otherwise
+ * go on playing, e.g. after a seek or a media change requested while
+ * paused.
+ */
+void mafw_gst_renderer_worker_set_stay_paused(MafwGstRendererWorker *worker,
+					      gboolean stay_paused)
+{
+	g_assert(worker != NULL);
+
+	if (_foreign_thread(worker)) {
+		WorkerCommand *cmd;
+
+		cmd = _command_new(_set_stay_paused_cmd);
+		cmd->value = stay_paused;
+		_queue_command(worker, cmd);
 		return;
+	}
 
-	if (worker->pipeline) {
-		g_debug("destroying pipeline");
-		if (worker->async_bus_id) {
-			g_source_remove(worker->async_bus_id);
-			worker->async_bus_id = 0;
-		}
-		gst_bus_set_sync_handler(worker->bus, NULL, NULL);
-		gst_element_set_state(worker->pipeline, GST_STATE_NULL);
-		if (worker->bus) {
-			gst_object_unref(GST_OBJECT_CAST(worker->bus));
-			worker->bus = NULL;
-		}
-		gst_object_unref(GST_OBJECT(worker->pipeline));
-		worker->pipeline = NULL;
+	worker->stay_paused = stay_paused;
+}
+
+/*----------------------------------------------------------------------------
+  Equalizer settings
+
+  The owner gives the curve and the engine to the worker, which applies
+  them to its elements on its own thread.
+  ----------------------------------------------------------------------------*/
+
+typedef struct {
+	EqDspLayout layout;
+	gdouble gains[EQ_DSP_MAX_BANDS];
+} WorkerEqCurve;
+
+static void _apply_eq_curve(MafwGstRendererWorker *worker)
+{
+	static const gdouble flat[EQ_DSP_MAX_BANDS] = { 0.0 };
+	MafwGstRendererEqualizer *eq;
+	gboolean linear_phase;
+
+	if (worker->equalizer == NULL) {
+		g_debug("There is no equalizer component");
+		return;
 	}
 
-	/* Reset worker */
-	worker->report_statechanges = TRUE;
-	worker->state = GST_STATE_NULL;
-	worker->prerolling = FALSE;
-	worker->is_live = FALSE;
-	worker->buffering = FALSE;
-	worker->is_stream = FALSE;
-	worker->is_error = FALSE;
-	worker->eos = FALSE;
-	worker->seek_position = -1;
-	_remove_ready_timeout(worker);
-	_free_taglist(worker);
-	if (worker->current_metadata) {
-		g_hash_table_destroy(worker->current_metadata);
-		worker->current_metadata = NULL;
+	g_debug("Applying equalizer curve (%d bands, engine %d)",
+		worker->eq_layout.n_bands, worker->eq_engine);
+
+	/* The IIR equalizer goes flat, and so bypassed, when the
+	 * convolver applies the curve */
+	linear_phase = worker->convolver != NULL &&
+		worker->eq_engine == MAFW_GST_RENDERER_CONVOLVER_LINEAR_PHASE;
+	eq = MAFW_GST_RENDERER_EQUALIZER(worker->equalizer);
+	mafw_gst_renderer_equalizer_set_layout(eq, &worker->eq_layout);
+	mafw_gst_renderer_equalizer_set_gains(eq, linear_phase ?
+					      flat : worker->eq_gains,
+					      EQ_DSP_MAX_BANDS);
+
+	if (worker->convolver != NULL) {
+		mafw_gst_renderer_convolver_set_curve(
+			MAFW_GST_RENDERER_CONVOLVER(worker->convolver),
+			&worker->eq_layout, worker->eq_gains);
 	}
+}
 
-	if (worker->duration_seek_timeout != 0) {
-		g_source_remove(worker->duration_seek_timeout);
-		worker->duration_seek_timeout = 0;
+static void _set_eq_curve_cmd(MafwGstRendererWorker *worker,
+			      WorkerCommand *cmd)
+{
+	WorkerEqCurve *curve = cmd->data;
+
+	mafw_gst_renderer_worker_set_eq_curve(worker, &curve->layout,
+					      curve->gains);
+}
+
+/*
+ * Sets the curve of the equalizer: its band @layout, and @gains, which has
+ * EQ_DSP_MAX_BANDS of them, in dB.
+ */
+void mafw_gst_renderer_worker_set_eq_curve(MafwGstRendererWorker *worker,
+					   const EqDspLayout *layout,
+					   const gdouble *gains)
+{
+	g_assert(worker != NULL);
+
+	if (_foreign_thread(worker)) {
+		WorkerCommand *cmd;
+		WorkerEqCurve *curve;
+
+		curve = g_new(WorkerEqCurve, 1);
+		curve->layout = *layout;
+		memcpy(curve->gains, gains, sizeof(curve->gains));
+		cmd = _command_new(_set_eq_curve_cmd);
+		cmd->data = curve;
+		_queue_command(worker, cmd);
+		return;
 	}
 
-	/* Reset media iformation */
-	_reset_media_info(worker);
+	worker->eq_layout = *layout;
+	memcpy(worker->eq_gains, gains, sizeof(worker->eq_gains));
+	_apply_eq_curve(worker);
+}
 
-	/* We are not playing, so we can let the screen blank */
-	blanking_allow();
-        keypadlocking_allow();
+static void _set_eq_engine_cmd(MafwGstRendererWorker *worker,
+			       WorkerCommand *cmd)
+{
+	mafw_gst_renderer_worker_set_eq_engine(worker, cmd->value, cmd->uri);
+}
 
-	/* And now get a fresh pipeline ready */
-	_construct_pipeline(worker);
+/*
+ * Sets how the convolver applies the curve, and the impulse response file
+ * it loads, if any.  As it reloads and partitions the response, it is
+ * only meant to be called when they change.
+ */
+void mafw_gst_renderer_worker_set_eq_engine(MafwGstRendererWorker *worker,
+					    MafwGstRendererConvolverMode engine,
+					    const gchar *ir_file)
+{
+	g_assert(worker != NULL);
+
+	if (_foreign_thread(worker)) {
+		WorkerCommand *cmd;
+
+		cmd = _command_new(_set_eq_engine_cmd);
+		cmd->value = engine;
+		cmd->uri = g_strdup(ir_file);
+		_queue_command(worker, cmd);
+		return;
+	}
+
+	worker->eq_engine = engine;
+	if (worker->convolver != NULL) {
+		g_object_set(worker->convolver,
+			     "ir-file", ir_file,
+			     "mode", engine,
+			     NULL);
+	}
+
+	/* Whether the IIR equalizer applies the curve depends on it */
+	if (worker->eq_layout.n_bands > 0)
+		_apply_eq_curve(worker);
+}
+
+static void _pause_cmd(MafwGstRendererWorker *worker, WorkerCommand *cmd)
+{
+	mafw_gst_renderer_worker_pause(worker);
 }
 
 void mafw_gst_renderer_worker_pause(MafwGstRendererWorker *worker)
 {
 	g_assert(worker != NULL);
 
-	if (worker->buffering && worker->state == GST_STATE_PAUSED &&
+	if (_foreign_thread(worker)) {
+		_queue_command(worker, _command_new(_pause_cmd));
+		return;
+	}
+
+	_stall_begin(worker);
+	_cancel_crossfade(worker);
+
+	if (worker->buffering &&
+	    _get_buffering_state(worker) == GST_STATE_PAUSED &&
 	    !worker->prerolling) {
 		/* If we are buffering and get a pause, we have to
 		 * signal state change and stay_paused */
 		g_debug("Pausing while buffering, signalling state change");
 		worker->stay_paused = TRUE;
-		if (worker->notify_pause_handler) {
-			worker->notify_pause_handler(
-				worker,
-				worker->owner);
-		}
+		_notify(worker, WORKER_NOTIFY_PAUSE);
 	} else {
 		worker->report_statechanges = TRUE;
 
-		if (gst_element_set_state(worker->pipeline, GST_STATE_PAUSED) ==
-		    GST_STATE_CHANGE_ASYNC)
-		{
-			/* XXX this blocks at most 2 seconds. */
-			gst_element_get_state(worker->pipeline, NULL, NULL,
-				      2 * GST_SECOND);
-		}
+		/* The pause is reported from the bus, on the PLAYING ->
+		 * PAUSED change or the ASYNC_DONE after it */
+		worker->pause_pending = TRUE;
+		gst_element_set_state(worker->pipeline, GST_STATE_PAUSED);
+		worker->buffering_state = GST_STATE_VOID_PENDING;
 		blanking_allow();
                 keypadlocking_allow();
 	}
+	_stall_end(worker, "pause");
+}
+
+static void _resume_cmd(MafwGstRendererWorker *worker, WorkerCommand *cmd)
+{
+	mafw_gst_renderer_worker_resume(worker);
 }
 
 void mafw_gst_renderer_worker_resume(MafwGstRendererWorker *worker)
 {
+	if (_foreign_thread(worker)) {
+		_queue_command(worker, _command_new(_resume_cmd));
+		return;
+	}
+
 	if (worker->mode == WORKER_MODE_PLAYLIST ||
             worker->mode == WORKER_MODE_REDUNDANT) {
 		/* We must notify play if the "playlist" playback
 		   is resumed */
 		worker->pl.notify_play_pending = TRUE;
 	}
-	if (worker->buffering && worker->state == GST_STATE_PAUSED &&
+	if (worker->buffering &&
+	    _get_buffering_state(worker) == GST_STATE_PAUSED &&
 	    !worker->prerolling) {
 		/* If we are buffering we cannot resume, but we know
 		 * that the pipeline will be moved to PLAYING as
@@ -2368,6 +5420,7 @@ void mafw_gst_renderer_worker_resume(MafwGstRendererWorker *worker)
 		 * the pipeline will be set to PLAYING and the state
 		 * change will be reported */
 		worker->report_statechanges = TRUE;
+		worker->pause_pending = FALSE;
 		g_debug("Resumed while buffering, activating pipeline state "
 			"changes");
 		/* Notice though that we can receive the Resume before
@@ -2408,17 +5461,36 @@ static void _volume_init_cb(MafwGstRendererWorkerVolume *wvolume,
 }
 
 MafwGstRendererWorker *mafw_gst_renderer_worker_new(gpointer owner)
+{
+	return mafw_gst_renderer_worker_new_full(owner, FALSE);
+}
+
+/*
+ * Creates a worker for @owner.  If @threaded, it runs on a thread of its own,
+ * the public calls made from other threads being queued to it, and the
+ * notifications being delivered on the context that is the default one
+ * now.
+ */
+MafwGstRendererWorker *mafw_gst_renderer_worker_new_full(gpointer owner,
+							 gboolean threaded)
 {
         MafwGstRendererWorker *worker;
-	GMainContext *main_context;
 
 	worker = g_new0(MafwGstRendererWorker, 1);
 	worker->mode = WORKER_MODE_SINGLE_PLAY;
-	worker->pl.items = NULL;
+	worker->pl.items = g_ptr_array_new();
 	worker->pl.current = 0;
+	worker->pl.parse = NULL;
+	worker->pl.stalled = FALSE;
+	worker->pl.stalled_error = NULL;
 	worker->pl.notify_play_pending = TRUE;
+	worker->pl.parse_count = 0;
+	worker->pl.parse_first_total = 0.0;
+	worker->pl.parse_first_max = 0.0;
+	worker->pl.parse_total = 0.0;
 	worker->owner = owner;
 	worker->report_statechanges = TRUE;
+	worker->pause_pending = FALSE;
 	worker->state = GST_STATE_NULL;
 	worker->seek_position = -1;
 	worker->ready_timeout = 0;
@@ -2426,12 +5498,63 @@ MafwGstRendererWorker *mafw_gst_renderer_worker_new(gpointer owner)
 	worker->xid = 0;
 	worker->autopaint = TRUE;
 	worker->colorkey = -1;
-    worker->equalizer = NULL;
+	worker->equalizer = NULL;
+	worker->convolver = NULL;
+	memset(&worker->eq_layout, 0, sizeof(worker->eq_layout));
+	memset(worker->eq_gains, 0, sizeof(worker->eq_gains));
+	worker->eq_engine = MAFW_GST_RENDERER_CONVOLVER_OFF;
+	worker->limiter = NULL;
+	worker->fader = NULL;
 	worker->vsink = NULL;
 	worker->asink = NULL;
-    worker->abin = NULL;
+	worker->abin = NULL;
 	worker->tag_list = NULL;
 	worker->current_metadata = NULL;
+	worker->reuse_pipeline = TRUE;
+	worker->switch_timer = g_timer_new();
+	worker->stall_timer = g_timer_new();
+	worker->stall_peak = 0.0;
+	worker->stall_peak_where = NULL;
+	worker->buffering_state = GST_STATE_VOID_PENDING;
+	worker->switch_pending = FALSE;
+	worker->switch_count = 0;
+	worker->switch_total = 0.0;
+	worker->switch_max = 0.0;
+	worker->switch_stop = 0.0;
+	worker->seek_accurate = FALSE;
+	worker->seek_in_flight = FALSE;
+	worker->seek_queued = -1;
+	worker->seek_timeout = 0;
+	worker->seek_timer = g_timer_new();
+	worker->seek_count = 0;
+	worker->seek_merged = 0;
+	worker->seek_total = 0.0;
+	worker->seek_max = 0.0;
+	worker->stats_lock = g_mutex_new();
+	worker->position_lock = g_mutex_new();
+	worker->media_lock = g_mutex_new();
+	worker->position_valid = FALSE;
+	worker->position_clock = NULL;
+	worker->position_base = 0;
+	worker->position_base_time = GST_CLOCK_TIME_NONE;
+	worker->next_uri = NULL;
+	worker->gapless = TRUE;
+	worker->gapless_lock = g_mutex_new();
+	worker->gapless_next = NULL;
+	worker->gapless_queued = NULL;
+	worker->gapless_flushed = FALSE;
+	worker->gapless_pending = FALSE;
+	worker->gapless_pad = NULL;
+	worker->gapless_probe_id = 0;
+	memset(&worker->standby, 0, sizeof(worker->standby));
+	worker->standby_budget = MAFW_GST_RENDERER_WORKER_STANDBY_BUDGET;
+	worker->standby_hits = 0;
+	worker->standby_misses = 0;
+	worker->crossfade = 0;
+	worker->crossfade_id = 0;
+	worker->crossfade_pending = FALSE;
+	worker->crossfade_length = 0;
+	memset(&worker->fadeout, 0, sizeof(worker->fadeout));
 
 #ifdef HAVE_GDKPIXBUF
 	worker->current_frame_on_pause = FALSE;
@@ -2442,11 +5565,27 @@ MafwGstRendererWorker *mafw_gst_renderer_worker_new(gpointer owner)
 	worker->notify_play_handler = NULL;
 	worker->notify_buffer_status_handler = NULL;
 	worker->notify_eos_handler = NULL;
+	worker->notify_next_handler = NULL;
 	worker->notify_error_handler = NULL;
+	worker->owner_context = g_main_context_ref(g_main_context_default());
+	worker->context = g_main_context_ref(worker->owner_context);
+	worker->thread = NULL;
+	worker->loop = NULL;
+	worker->thread_lock = g_mutex_new();
+	worker->command_cond = g_cond_new();
+	worker->commands = g_queue_new();
+	worker->command_id = 0;
+	worker->notifications = NULL;
+	worker->notify_generation = 0;
+	worker->config.reuse_pipeline = worker->reuse_pipeline;
+	worker->config.gapless = worker->gapless;
+	worker->config.standby_budget = worker->standby_budget;
+	worker->config.crossfade = worker->crossfade;
+	worker->config.seek_accurate = worker->seek_accurate;
+	worker->media.source_seekable = SEEKABILITY_UNKNOWN;
 	Global_worker = worker;
-	main_context = g_main_context_default();
 	worker->wvolume = NULL;
-	mafw_gst_renderer_worker_volume_init(main_context,
+	mafw_gst_renderer_worker_volume_init(worker->owner_context,
 					     _volume_init_cb, worker,
 					     _volume_cb, worker,
 #ifdef MAFW_GST_RENDERER_ENABLE_MUTE
@@ -2456,11 +5595,43 @@ MafwGstRendererWorker *mafw_gst_renderer_worker_new(gpointer owner)
 #endif
                                              worker);
 	blanking_init();
+
+	if (threaded) {
+		GError *error = NULL;
+
+		g_main_context_unref(worker->context);
+		worker->context = g_main_context_new();
+		worker->loop = g_main_loop_new(worker->context, FALSE);
+		worker->thread = g_thread_create(_thread_main, worker, TRUE,
+						 &error);
+		if (worker->thread == NULL) {
+			g_warning("could not start the worker thread, "
+				  "running on the owner one: %s",
+				  error->message);
+			g_error_free(error);
+			g_main_loop_unref(worker->loop);
+			worker->loop = NULL;
+			g_main_context_unref(worker->context);
+			worker->context =
+				g_main_context_ref(worker->owner_context);
+		}
+	}
+
+	/* Nothing is dispatched for the pipeline before it is started */
 	_construct_pipeline(worker);
 
 	return worker;
 }
 
+static void _exit_cmd(MafwGstRendererWorker *worker, WorkerCommand *cmd)
+{
+        mafw_gst_renderer_worker_stop(worker);
+	_reset_seeks(worker);
+	_discard_standby(worker);
+	_destroy_pipeline(worker);
+	_detach_gapless_probe(worker);
+}
+
 void mafw_gst_renderer_worker_exit(MafwGstRendererWorker *worker)
 {
 	blanking_deinit();
@@ -2468,6 +5639,53 @@ void mafw_gst_renderer_worker_exit(MafwGstRendererWorker *worker)
 	_destroy_tmp_files_pool(worker);
 #endif
 	mafw_gst_renderer_worker_volume_destroy(worker->wvolume);
-        mafw_gst_renderer_worker_stop(worker);
+	if (worker->thread != NULL) {
+		/* The pipelines go away on the thread running them */
+		_call_command(worker, _command_new(_exit_cmd));
+		g_main_loop_quit(worker->loop);
+		g_thread_join(worker->thread);
+		worker->thread = NULL;
+		g_main_loop_unref(worker->loop);
+		worker->loop = NULL;
+	} else {
+		_exit_cmd(worker, NULL);
+	}
+
+	/* Notifications not delivered yet are dropped */
+	while (worker->notifications != NULL) {
+		GSource *source = worker->notifications->data;
+
+		worker->notifications = g_slist_delete_link(
+			worker->notifications, worker->notifications);
+		g_source_destroy(source);
+	}
+	g_queue_free(worker->commands);
+	worker->commands = NULL;
+	g_cond_free(worker->command_cond);
+	worker->command_cond = NULL;
+	g_mutex_free(worker->thread_lock);
+	worker->thread_lock = NULL;
+	g_main_context_unref(worker->context);
+	worker->context = NULL;
+	g_main_context_unref(worker->owner_context);
+	worker->owner_context = NULL;
+
+	g_timer_destroy(worker->switch_timer);
+	worker->switch_timer = NULL;
+	g_timer_destroy(worker->stall_timer);
+	worker->stall_timer = NULL;
+	g_timer_destroy(worker->seek_timer);
+	worker->seek_timer = NULL;
+	_drop_position(worker);
+	g_mutex_free(worker->stats_lock);
+	worker->stats_lock = NULL;
+	g_mutex_free(worker->position_lock);
+	worker->position_lock = NULL;
+	g_mutex_free(worker->media_lock);
+	worker->media_lock = NULL;
+	_clear_gapless(worker);
+	g_mutex_free(worker->gapless_lock);
+	worker->gapless_lock = NULL;
+	_free_pl_items(worker);
 }
 /* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
@@ -32,16 +32,20 @@
 #include <glib-object.h>
 #include <gst/gst.h>
 #include "mafw-gst-renderer-worker-volume.h"
+#include "mafw-gst-renderer-equalizer-dsp.h"
+#include "mafw-gst-renderer-convolver.h"
 
 #define MAFW_GST_RENDERER_MAX_TMP_FILES 5
 
 typedef struct _MafwGstRendererWorker MafwGstRendererWorker;
+typedef struct _WorkerPlaylistParse WorkerPlaylistParse;
 
 typedef void (*MafwGstRendererWorkerNotifySeekCb)(MafwGstRendererWorker *worker, gpointer owner);
 typedef void (*MafwGstRendererWorkerNotifyPauseCb)(MafwGstRendererWorker *worker, gpointer owner);
 typedef void (*MafwGstRendererWorkerNotifyPlayCb)(MafwGstRendererWorker *worker, gpointer owner);
 typedef void (*MafwGstRendererWorkerNotifyBufferStatusCb)(MafwGstRendererWorker *worker, gpointer owner, gdouble percent);
 typedef void (*MafwGstRendererWorkerNotifyEOSCb)(MafwGstRendererWorker *worker, gpointer owner);
+typedef void (*MafwGstRendererWorkerNotifyNextCb)(MafwGstRendererWorker *worker, gpointer owner);
 typedef void (*MafwGstRendererWorkerNotifyErrorCb)(MafwGstRendererWorker *worker,
                                                    gpointer owner,
                                                    const GError *error);
@@ -66,8 +70,21 @@ typedef enum {
  *   video_width:        If media contains video, this tells the video width
  *   video_height:       If media contains video, this tells the video height
  *   seekable:           Tells whether the media can be seeked
+ *   source_seekable:    Whether the source says it can, as the owner set it
+ *                       before playing the media; not reset with the rest
  *   par_n:              Video pixel aspect ratio numerator
  *   par_d:              Video pixel aspect ratio denominator
+ * pl:           Entries of the playlist file being played
+ *   items:              The entries, as URIs
+ *   current:            Index of the one being played
+ *   parse:              Parse of the file going on in the background, NULL
+ *                       once all of its entries are in items
+ *   stalled:            Playback got past the entries parsed so far
+ *   stalled_error:      Error the last of them ended with, if any
+ *   parse_count, parse_first_total, parse_first_max, parse_total: Parses
+ *                       run to the end, the total and longest time to
+ *                       their first entry and their total time, in
+ *                       milliseconds
  * owner:        Owner of the worker; usually a MafwGstRenderer (FIXME USUALLY?)
  * pipeline:     Playback pipeline
  * bus:          Message bus
@@ -83,12 +100,113 @@ typedef enum {
  * async_bus_id:        ID handle for GstBus
  * buffer_probe_id:     ID of the video renderer buffer probe
  * seek_position:       Indicates the pos where to seek, in seconds
- * equalizer:           Equalizer element of the pipeline
+ * equalizer:           Equalizer element of the pipeline, a
+ *                      MafwGstRendererEqualizer
+ * convolver:           FFT convolution stage after the equalizer, a
+ *                      MafwGstRendererConvolver
+ * eq_layout, eq_gains: Equalizer curve given by the owner
+ * eq_engine:           How the convolver applies it, as given by the owner
+ * limiter:             Lookahead peak limiter after the convolver, a
+ *                      MafwGstRendererLimiter
+ * fader:               Gain ramps ahead of the equalizer, a
+ *                      MafwGstRendererFader
  * vsink:               Video sink element of the pipeline
  * asink:               Audio sink element of the pipeline
- * abin:                A bin containing equalizer + asink
+ * abin:                A bin containing fader + equalizer + convolver +
+ *                      limiter + asink
  * xid:                 XID for video playback
  * current_frame_on_pause: whether to emit current frame when pausing
+ * reuse_pipeline:      Whether stop keeps the pipeline in READY for the
+ *                      next media instead of building a new one
+ * switch_timer:        Times track switches, from stop to the preroll of
+ *                      the next media
+ * switch_pending:      Whether switch_timer is running
+ * switch_count, switch_total, switch_max: Track switches timed since
+ *                      reuse_pipeline was last changed, and their total
+ *                      and longest time in milliseconds
+ * switch_stop:         Milliseconds spent in the last stop
+ * stall_timer:         Times the sections run from the main loop: bus
+ *                      messages and the play, pause, stop and seek
+ *                      requests
+ * stall_depth:         Nesting of the timed sections
+ * stall_max, stall_where: Longest section of the session in milliseconds,
+ *                      and its name; stall_where is NULL if none was timed
+ * stall_peak, stall_peak_where: Longest section since the worker was
+ *                      created, kept across sessions
+ * seek_accurate:       Whether seeks go to the exact position instead of
+ *                      the keyframe before it
+ * seek_in_flight:      A flushing seek has been sent and the pipeline has
+ *                      not prerolled since
+ * seek_queued:         Position of the seek waiting for it, -1 if none
+ * seek_timeout:        Timeout giving up on the seek in flight
+ * seek_timer:          Times the seek in flight, up to its first frame
+ * seek_count, seek_total, seek_max: Seeks timed since seek_accurate was
+ *                      last changed, and their total and longest time in
+ *                      milliseconds
+ * seek_merged:         Seeks replaced by a later one while waiting
+ * stats_lock:          Protects the track switch, seek, standby, playlist
+ *                      parse and stall peak figures, which the owner reads
+ *                      from its own thread
+ * position_lock:       Protects the position anchor, seek_position and
+ *                      media.length_nanos, read from any thread
+ * position_valid:      Whether the position has been anchored
+ * position_base:       Position at the anchor, in nanoseconds
+ * position_clock:      Pipeline clock the position follows from the anchor,
+ *                      NULL if it stays at position_base
+ * position_base_time:  Time of position_clock at the anchor
+ * media_lock:          Protects media.location, media.has_visual_content,
+ *                      media.seekable, the video details of media, eos and
+ *                      current_metadata, which the owner reads from its
+ *                      own thread and the streaming threads may write
+ * next_uri:            URI given by the owner to play after the current
+ *                      media
+ * gapless:             Whether next_uri is queued to play without a gap
+ * gapless_lock:        Protects gapless_next, gapless_queued and
+ *                      gapless_flushed, which are used from the streaming
+ *                      thread
+ * gapless_next:        URI to be queued on playbin2 about-to-finish
+ * gapless_queued:      URI queued, until its first segment is seen
+ * gapless_flushed:     A flushing seek came after the URI was queued, so
+ *                      the next segment is not the one of the queued media
+ * gapless_pending:     A media has been queued and has not started yet
+ * gapless_pad:         Pad of abin watched for the first segment of the
+ *                      queued media
+ * gapless_probe_id:    ID of the event probe watching it
+ * standby:             Pipeline prerolled for the next media while the
+ *                      current one plays, with its own audio bin, so that
+ *                      playing it next is just a swap
+ *   uri:                The media it prerolls
+ *   prerolled:          Whether it has reached PAUSED
+ *   tag_list:           Tag messages got meanwhile
+ * standby_budget:      Memory budget of the standby pipeline, in KB
+ * standby_hits, standby_misses: Media played from the standby pipeline, and
+ *                      played while another one was on standby
+ * crossfade:           Length of the crossfade into the standby, in
+ *                      milliseconds, 0 for none
+ * crossfade_id:        Timeout starting the crossfade
+ * crossfade_pending:   The standby was started, and is not playing yet
+ * crossfade_length:    Length of the fade in under way
+ * fadeout:             Previous pipeline, fading out after a crossfade
+ *   timeout_id:         Timeout discarding it, should its EOS not come
+ * context:             Main context the worker sources are attached to
+ * owner_context:       Main context of the owner, where the notifications
+ *                      are delivered
+ * thread:              Thread running context, NULL if the worker runs on
+ *                      the owner context
+ * loop:                Main loop of thread
+ * thread_lock:         Protects commands, command_id, notifications and
+ *                      notify_generation
+ * command_cond:        Signalled when a command waited for is done
+ * commands:            Commands queued from other threads, run in order
+ *                      on thread
+ * command_id:          Idle source running commands
+ * notifications:       Sources delivering notifications on owner_context
+ * notify_generation:   Bumped by play and stop: the notifications posted
+ *                      before are about media the owner is done with, and
+ *                      are dropped
+ * config:              The settings as the owner last set them, which its
+ *                      getters return without waiting for thread to apply
+ *                      them; only used from the owner
  */
 struct _MafwGstRendererWorker {
 	struct {
@@ -99,14 +217,22 @@ struct _MafwGstRendererWorker {
 		gint video_height;
 		gdouble fps;
 		SeekabilityType seekable;
+		SeekabilityType source_seekable;
 		gint par_n;
 		gint par_d;
 	} media;
 	PlaybackMode mode;
 	struct {
-		GSList *items;
+		GPtrArray *items;
 		gint current;
 		gboolean notify_play_pending;
+		WorkerPlaylistParse *parse;
+		gboolean stalled;
+		GError *stalled_error;
+		guint parse_count;
+		gdouble parse_first_total;
+		gdouble parse_first_max;
+		gdouble parse_total;
 	} pl;
         gpointer owner;
 	GstElement *pipeline;
@@ -122,12 +248,16 @@ struct _MafwGstRendererWorker {
 	gboolean is_error;
 	/* pipeline is buffering */
 	gboolean buffering;
+	/* state the buffering handler asked the pipeline for and that it
+	 * has not reached yet, GST_STATE_VOID_PENDING if none */
+	GstState buffering_state;
 	/* pipeline is prerolling */
 	gboolean prerolling;
 	/* stream is live and doesn't need prerolling */
 	gboolean is_live;
 	/* if we have to stay in paused though a do_play was
-	 * requested. Usually used when pausing in transitioning */
+	 * requested. Usually used when pausing in transitioning; the
+	 * owner sets it with mafw_gst_renderer_worker_set_stay_paused() */
 	gboolean stay_paused;
 	/* this variable should be FALSE while we are hiding state
 	 * changed to the UI. This is that GStreamer can perform
@@ -135,6 +265,9 @@ struct _MafwGstRendererWorker {
 	 * seeking, buffering and so on and we have to hide those
 	 * changes */
 	gboolean report_statechanges;
+	/* a pause was asked for and the pipeline has not got to PAUSED
+	 * yet; the pause is reported when it does */
+	gboolean pause_pending;
 	guint async_bus_id;
 	gint seek_position;
 	guint ready_timeout;
@@ -154,15 +287,103 @@ struct _MafwGstRendererWorker {
 	 * again.
 	 */
 	gboolean in_ready;
-    GstElement *equalizer;
+	GstElement *equalizer;
+	GstElement *convolver;
+	EqDspLayout eq_layout;
+	gdouble eq_gains[EQ_DSP_MAX_BANDS];
+	MafwGstRendererConvolverMode eq_engine;
+	GstElement *limiter;
+	GstElement *fader;
 	GstElement *vsink;
 	GstElement *asink;
-    GstElement *abin;
+	GstElement *abin;
 	XID xid;
 	gboolean autopaint;
 	gint colorkey;
 	GPtrArray *tag_list;
 	GHashTable *current_metadata;
+	gboolean reuse_pipeline;
+	GTimer *switch_timer;
+	gboolean switch_pending;
+	guint switch_count;
+	gdouble switch_total;
+	gdouble switch_max;
+	gdouble switch_stop;
+	GTimer *stall_timer;
+	guint stall_depth;
+	gdouble stall_max;
+	const gchar *stall_where;
+	gdouble stall_peak;
+	const gchar *stall_peak_where;
+	gboolean seek_accurate;
+	gboolean seek_in_flight;
+	gint seek_queued;
+	guint seek_timeout;
+	GTimer *seek_timer;
+	guint seek_count;
+	guint seek_merged;
+	gdouble seek_total;
+	gdouble seek_max;
+	GMutex *stats_lock;
+	GMutex *position_lock;
+	gboolean position_valid;
+	gint64 position_base;
+	GstClock *position_clock;
+	GstClockTime position_base_time;
+	GMutex *media_lock;
+	gchar *next_uri;
+	gboolean gapless;
+	GMutex *gapless_lock;
+	gchar *gapless_next;
+	gchar *gapless_queued;
+	gboolean gapless_flushed;
+	gboolean gapless_pending;
+	GstPad *gapless_pad;
+	gulong gapless_probe_id;
+	struct {
+		gchar *uri;
+		GstElement *pipeline;
+		GstBus *bus;
+		guint bus_id;
+		GstElement *equalizer;
+		GstElement *convolver;
+		GstElement *limiter;
+		GstElement *fader;
+		GstElement *asink;
+		GstElement *abin;
+		GPtrArray *tag_list;
+		gboolean prerolled;
+	} standby;
+	guint standby_budget;
+	guint standby_hits;
+	guint standby_misses;
+	guint crossfade;
+	guint crossfade_id;
+	gboolean crossfade_pending;
+	GstClockTime crossfade_length;
+	struct {
+		GstElement *pipeline;
+		GstBus *bus;
+		guint bus_id;
+		guint timeout_id;
+	} fadeout;
+	GMainContext *context;
+	GMainContext *owner_context;
+	GThread *thread;
+	GMainLoop *loop;
+	GMutex *thread_lock;
+	GCond *command_cond;
+	GQueue *commands;
+	guint command_id;
+	GSList *notifications;
+	guint notify_generation;
+	struct {
+		gboolean reuse_pipeline;
+		gboolean gapless;
+		guint standby_budget;
+		guint crossfade;
+		gboolean seek_accurate;
+	} config;
 
 #ifdef HAVE_GDKPIXBUF
 	gboolean current_frame_on_pause;
@@ -176,12 +397,15 @@ struct _MafwGstRendererWorker {
         MafwGstRendererWorkerNotifyPlayCb notify_play_handler;
         MafwGstRendererWorkerNotifyBufferStatusCb notify_buffer_status_handler;
         MafwGstRendererWorkerNotifyEOSCb notify_eos_handler;
+        MafwGstRendererWorkerNotifyNextCb notify_next_handler;
         MafwGstRendererWorkerNotifyErrorCb notify_error_handler;
 };
 
 G_BEGIN_DECLS
 
 MafwGstRendererWorker *mafw_gst_renderer_worker_new(gpointer owner);
+MafwGstRendererWorker *mafw_gst_renderer_worker_new_full(gpointer owner,
+                                                         gboolean threaded);
 void mafw_gst_renderer_worker_exit(MafwGstRendererWorker *worker);
 
 void mafw_gst_renderer_worker_set_volume(MafwGstRendererWorker *worker,
@@ -207,7 +431,57 @@ void mafw_gst_renderer_worker_set_autopaint(MafwGstRendererWorker *worker, gbool
 gint mafw_gst_renderer_worker_get_colorkey(MafwGstRendererWorker *worker);
 void mafw_gst_renderer_worker_set_colorkey(MafwGstRendererWorker *worker, gint autopaint);
 gboolean mafw_gst_renderer_worker_get_seekable(MafwGstRendererWorker *worker);
+void mafw_gst_renderer_worker_set_source_seekability(
+	MafwGstRendererWorker *worker, SeekabilityType seekability);
+gchar *mafw_gst_renderer_worker_get_location(MafwGstRendererWorker *worker);
+gboolean mafw_gst_renderer_worker_get_has_visual_content(MafwGstRendererWorker *worker);
+void mafw_gst_renderer_worker_set_stay_paused(MafwGstRendererWorker *worker,
+                                              gboolean stay_paused);
+void mafw_gst_renderer_worker_set_eq_curve(MafwGstRendererWorker *worker,
+                                           const EqDspLayout *layout,
+                                           const gdouble *gains);
+void mafw_gst_renderer_worker_set_eq_engine(MafwGstRendererWorker *worker,
+                                            MafwGstRendererConvolverMode engine,
+                                            const gchar *ir_file);
+void mafw_gst_renderer_worker_set_reuse_pipeline(MafwGstRendererWorker *worker,
+                                                 gboolean reuse_pipeline);
+gboolean mafw_gst_renderer_worker_get_reuse_pipeline(MafwGstRendererWorker *worker);
+void mafw_gst_renderer_worker_get_switch_stats(MafwGstRendererWorker *worker,
+					       guint *switch_count,
+					       gdouble *mean_ms,
+					       gdouble *max_ms);
+void mafw_gst_renderer_worker_set_next_uri(MafwGstRendererWorker *worker,
+                                           const gchar *uri);
+void mafw_gst_renderer_worker_set_gapless(MafwGstRendererWorker *worker,
+                                          gboolean gapless);
+gboolean mafw_gst_renderer_worker_get_gapless(MafwGstRendererWorker *worker);
+void mafw_gst_renderer_worker_set_standby_budget(MafwGstRendererWorker *worker,
+                                                 guint budget);
+guint mafw_gst_renderer_worker_get_standby_budget(MafwGstRendererWorker *worker);
+void mafw_gst_renderer_worker_get_standby_stats(MafwGstRendererWorker *worker,
+						guint *hit_count,
+						guint *miss_count);
+void mafw_gst_renderer_worker_set_crossfade(MafwGstRendererWorker *worker,
+                                            guint crossfade);
+guint mafw_gst_renderer_worker_get_crossfade(MafwGstRendererWorker *worker);
+void mafw_gst_renderer_worker_set_accurate_seek(MafwGstRendererWorker *worker,
+                                                gboolean accurate);
+gboolean mafw_gst_renderer_worker_get_accurate_seek(MafwGstRendererWorker *worker);
+void mafw_gst_renderer_worker_get_seek_stats(MafwGstRendererWorker *worker,
+					     guint *seek_count,
+					     gdouble *mean_ms,
+					     gdouble *max_ms,
+					     guint *merged_count);
+gint64 mafw_gst_renderer_worker_get_position_ms(MafwGstRendererWorker *worker);
 GHashTable *mafw_gst_renderer_worker_get_current_metadata(MafwGstRendererWorker *worker);
+void mafw_gst_renderer_worker_get_parse_stats(MafwGstRendererWorker *worker,
+					      guint *parse_count,
+					      gdouble *first_entry_ms,
+					      gdouble *first_entry_max_ms,
+					      gdouble *parse_ms);
+void mafw_gst_renderer_worker_get_stall_stats(MafwGstRendererWorker *worker,
+					      gdouble *max_ms,
+					      const gchar **where);
 void mafw_gst_renderer_worker_play(MafwGstRendererWorker *worker, const gchar *uri, GSList *plitems);
 void mafw_gst_renderer_worker_play_alternatives(MafwGstRendererWorker *worker, gchar **uris);
 void mafw_gst_renderer_worker_stop(MafwGstRendererWorker *worker);
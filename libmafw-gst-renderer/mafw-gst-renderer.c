@@ -39,6 +39,8 @@
 #include "mafw-gst-renderer.h"
 #include "mafw-gst-renderer-utils.h"
 #include "mafw-gst-renderer-worker.h"
+#include "mafw-gst-renderer-equalizer.h"
+#include "mafw-gst-renderer-eq-layout.h"
 
 #include "mafw-gst-renderer-state-playing.h"
 #include "mafw-gst-renderer-state-stopped.h"
@@ -84,6 +86,37 @@ static void mafw_gst_renderer_deinitialize(GError **error);
 static void mafw_gst_renderer_dispose(GObject *object);
 static void mafw_gst_renderer_finalize(GObject *object);
 
+/*----------------------------------------------------------------------------
+  Command queue
+  ----------------------------------------------------------------------------*/
+
+static void _queue_play(MafwRenderer *self, MafwRendererPlaybackCB callback,
+			gpointer user_data);
+static void _queue_play_object(MafwRenderer *self, const gchar *object_id,
+			       MafwRendererPlaybackCB callback,
+			       gpointer user_data);
+static void _queue_stop(MafwRenderer *self, MafwRendererPlaybackCB callback,
+			gpointer user_data);
+static void _queue_pause(MafwRenderer *self, MafwRendererPlaybackCB callback,
+			 gpointer user_data);
+static void _queue_resume(MafwRenderer *self, MafwRendererPlaybackCB callback,
+			  gpointer user_data);
+static void _queue_next(MafwRenderer *self, MafwRendererPlaybackCB callback,
+			gpointer user_data);
+static void _queue_previous(MafwRenderer *self,
+			    MafwRendererPlaybackCB callback,
+			    gpointer user_data);
+static void _queue_goto_index(MafwRenderer *self, guint index,
+			      MafwRendererPlaybackCB callback,
+			      gpointer user_data);
+static void _queue_set_position(MafwRenderer *self, MafwRendererSeekMode mode,
+				gint seconds, MafwRendererPositionCB callback,
+				gpointer user_data);
+static void _flush_commands(MafwGstRenderer *renderer);
+static void _cancel_commands(MafwGstRenderer *renderer);
+static void _flush_playlist_changed(MafwGstRenderer *renderer);
+static void _drop_playlist_changed(MafwGstRenderer *renderer);
+
 /*----------------------------------------------------------------------------
   Hal callbacks
   ----------------------------------------------------------------------------*/
@@ -105,6 +138,8 @@ static void _gst_equalizer_changed_cb(GConfClient *client,
                                       guint cnxn_id,
                                       GConfEntry *entry,
                                       MafwGstRenderer *renderer);
+static void _gst_equalizer_load(MafwGstRenderer *renderer);
+static gboolean _gst_equalizer_prewarm_cb(MafwGstRenderer *renderer);
 
 /*----------------------------------------------------------------------------
   Gnome VFS notifications
@@ -122,6 +157,8 @@ static void _signal_state_changed(MafwGstRenderer * self);
 static void _signal_media_changed(MafwGstRenderer * self);
 static void _signal_playlist_changed(MafwGstRenderer * self);
 static void _signal_transport_actions_property_changed(MafwGstRenderer * self);
+static void _update_position_ticks(MafwGstRenderer *renderer);
+static void _restart_position_ticks(MafwGstRenderer *renderer);
 
 /*----------------------------------------------------------------------------
   Properties
@@ -156,6 +193,7 @@ static void _notify_seek(MafwGstRendererWorker *worker, gpointer owner);
 static void _notify_buffer_status(MafwGstRendererWorker *worker, gpointer owner,
 				  gdouble percent);
 static void _notify_eos(MafwGstRendererWorker *worker, gpointer owner);
+static void _notify_next(MafwGstRendererWorker *worker, gpointer owner);
 static void _error_handler(MafwGstRendererWorker *worker, gpointer owner,
 			   const GError *error);
 
@@ -226,23 +264,23 @@ static void mafw_gst_renderer_class_init(MafwGstRendererClass *klass)
 
 	/* Playback */
 
-	renderer_class->play = mafw_gst_renderer_play;
-	renderer_class->play_object = mafw_gst_renderer_play_object;
-	renderer_class->stop = mafw_gst_renderer_stop;
-	renderer_class->pause = mafw_gst_renderer_pause;
-	renderer_class->resume = mafw_gst_renderer_resume;
+	renderer_class->play = _queue_play;
+	renderer_class->play_object = _queue_play_object;
+	renderer_class->stop = _queue_stop;
+	renderer_class->pause = _queue_pause;
+	renderer_class->resume = _queue_resume;
 	renderer_class->get_status = mafw_gst_renderer_get_status;
 
 	/* Playlist operations */
 
 	renderer_class->assign_playlist = mafw_gst_renderer_assign_playlist;
-	renderer_class->next = mafw_gst_renderer_next;
-	renderer_class->previous = mafw_gst_renderer_previous;
-	renderer_class->goto_index = mafw_gst_renderer_goto_index;
+	renderer_class->next = _queue_next;
+	renderer_class->previous = _queue_previous;
+	renderer_class->goto_index = _queue_goto_index;
 
 	/* Playback position */
 
-	renderer_class->set_position = mafw_gst_renderer_set_position;
+	renderer_class->set_position = _queue_set_position;
 	renderer_class->get_position = mafw_gst_renderer_get_position;
 
 	/* Metadata */
@@ -298,6 +336,27 @@ static void mafw_gst_renderer_init(MafwGstRenderer *self)
         mafw_extension_add_property(MAFW_EXTENSION(self),
                                     MAFW_PROPERTY_GST_RENDERER_TV_CONNECTED,
                                     G_TYPE_BOOLEAN);
+        mafw_extension_add_property(MAFW_EXTENSION(self),
+                                    MAFW_PROPERTY_GST_RENDERER_REUSE_PIPELINE,
+                                    G_TYPE_BOOLEAN);
+        mafw_extension_add_property(MAFW_EXTENSION(self),
+                                    MAFW_PROPERTY_GST_RENDERER_GAPLESS,
+                                    G_TYPE_BOOLEAN);
+        mafw_extension_add_property(MAFW_EXTENSION(self),
+                                    MAFW_PROPERTY_GST_RENDERER_STANDBY_BUDGET,
+                                    G_TYPE_UINT);
+        mafw_extension_add_property(MAFW_EXTENSION(self),
+                                    MAFW_PROPERTY_GST_RENDERER_CROSSFADE,
+                                    G_TYPE_UINT);
+        mafw_extension_add_property(MAFW_EXTENSION(self),
+                                    MAFW_PROPERTY_GST_RENDERER_ACCURATE_SEEK,
+                                    G_TYPE_BOOLEAN);
+        mafw_extension_add_property(MAFW_EXTENSION(self),
+                                    MAFW_PROPERTY_GST_RENDERER_POSITION_INTERVAL,
+                                    G_TYPE_UINT);
+        mafw_extension_add_property(MAFW_EXTENSION(self),
+                                    MAFW_PROPERTY_GST_RENDERER_POSITION,
+                                    G_TYPE_INT);
  	MAFW_EXTENSION_SUPPORTS_TRANSPORT_ACTIONS(self);
 	renderer->media = g_new0(MafwGstRendererMedia, 1);
 	renderer->media->seekability = SEEKABILITY_UNKNOWN;
@@ -307,8 +366,22 @@ static void mafw_gst_renderer_init(MafwGstRenderer *self)
 	renderer->iterator = NULL;
 	renderer->seeking_to = -1;
         renderer->update_playcount_id = 0;
-
+	renderer->next_object_id = NULL;
+	renderer->next_index = -1;
+	renderer->next_metadata = NULL;
+	renderer->commands = g_queue_new();
+	renderer->command_id = 0;
+	renderer->playlist_changed_id = 0;
+	renderer->playlist_pending = FALSE;
+	renderer->playlist_clip_changed = FALSE;
+	renderer->position_interval = 0;
+	renderer->position_tick_id = 0;
+
+#ifdef MAFW_GST_RENDERER_ENABLE_WORKER_THREAD
+        self->worker = mafw_gst_renderer_worker_new_full(self, TRUE);
+#else
         self->worker = mafw_gst_renderer_worker_new(self);
+#endif
 
         /* Set notification handlers for worker */
         renderer->worker->notify_play_handler = _notify_play;
@@ -316,6 +389,7 @@ static void mafw_gst_renderer_init(MafwGstRenderer *self)
         renderer->worker->notify_seek_handler = _notify_seek;
         renderer->worker->notify_error_handler = _error_handler;
         renderer->worker->notify_eos_handler = _notify_eos;
+        renderer->worker->notify_next_handler = _notify_next;
 	renderer->worker->notify_buffer_status_handler = _notify_buffer_status;
 
 	renderer->states = g_new0 (MafwGstRendererState*, _LastMafwPlayState);
@@ -331,6 +405,7 @@ static void mafw_gst_renderer_init(MafwGstRenderer *self)
 
 	renderer->current_state = Stopped;
 	renderer->resume_playlist = FALSE;
+	renderer->stay_paused = FALSE;
 	renderer->playback_mode = MAFW_GST_RENDERER_MODE_PLAYLIST;
 
 #ifdef HAVE_CONIC
@@ -384,28 +459,10 @@ static void mafw_gst_renderer_init(MafwGstRenderer *self)
 	}
 
         /* Initialize equalizer values */
-        if (self->worker->equalizer) {
-                gconf_client_notify(renderer->gconf_client,
-                                    GCONF_MAFW_GST_EQ_RENDERER "/band0");
-                gconf_client_notify(renderer->gconf_client,
-                                    GCONF_MAFW_GST_EQ_RENDERER "/band1");
-                gconf_client_notify(renderer->gconf_client,
-                                    GCONF_MAFW_GST_EQ_RENDERER "/band2");
-                gconf_client_notify(renderer->gconf_client,
-                                    GCONF_MAFW_GST_EQ_RENDERER "/band3");
-                gconf_client_notify(renderer->gconf_client,
-                                    GCONF_MAFW_GST_EQ_RENDERER "/band4");
-                gconf_client_notify(renderer->gconf_client,
-                                    GCONF_MAFW_GST_EQ_RENDERER "/band5");
-                gconf_client_notify(renderer->gconf_client,
-                                    GCONF_MAFW_GST_EQ_RENDERER "/band6");
-                gconf_client_notify(renderer->gconf_client,
-                                    GCONF_MAFW_GST_EQ_RENDERER "/band7");
-                gconf_client_notify(renderer->gconf_client,
-                                    GCONF_MAFW_GST_EQ_RENDERER "/band8");
-                gconf_client_notify(renderer->gconf_client,
-                                    GCONF_MAFW_GST_EQ_RENDERER "/band9");
-        }
+        _gst_equalizer_load(renderer);
+        renderer->eq_prewarm_id =
+                g_idle_add((GSourceFunc) _gst_equalizer_prewarm_cb,
+                           renderer);
 
 	if (gnome_vfs_init()) {
 		GnomeVFSVolumeMonitor *monitor = gnome_vfs_get_volume_monitor();
@@ -424,6 +481,21 @@ static void mafw_gst_renderer_dispose(GObject *object)
 
 	renderer = MAFW_GST_RENDERER(object);
 
+	if (renderer->commands != NULL) {
+		_cancel_commands(renderer);
+		g_debug("%u of %u transport calls coalesced",
+			renderer->commands_coalesced,
+			renderer->commands_queued);
+		g_queue_free(renderer->commands);
+		renderer->commands = NULL;
+	}
+
+	if (renderer->playlist_edits > 0)
+		g_debug("%u of %u playlist edits coalesced",
+			renderer->playlist_edits_coalesced,
+			renderer->playlist_edits);
+	_drop_playlist_changed(renderer);
+
 	if (renderer->worker != NULL) {
 		mafw_gst_renderer_worker_exit(renderer->worker);
 		renderer->seek_pending = FALSE;
@@ -467,6 +539,24 @@ static void mafw_gst_renderer_dispose(GObject *object)
 		renderer->gconf_client = NULL;
 	}
 
+	if (renderer->eq_update_id != 0) {
+		g_source_remove(renderer->eq_update_id);
+		renderer->eq_update_id = 0;
+	}
+
+	if (renderer->eq_prewarm_id != 0) {
+		g_source_remove(renderer->eq_prewarm_id);
+		renderer->eq_prewarm_id = 0;
+	}
+
+	if (renderer->position_tick_id != 0) {
+		g_source_remove(renderer->position_tick_id);
+		renderer->position_tick_id = 0;
+	}
+
+	g_free(renderer->eq_ir_file);
+	renderer->eq_ir_file = NULL;
+
 	G_OBJECT_CLASS(mafw_gst_renderer_parent_class)->dispose(object);
 }
 
@@ -632,6 +722,27 @@ static MafwSource* _get_source(MafwGstRenderer *renderer,
 	return source;
 }
 
+typedef struct {
+	MafwGstRenderer *renderer;
+	gchar *object_id;
+	GHashTable *metadata;
+} MafwGstRendererMetadataClosure;
+
+static gboolean _notify_prefetched_metadata_idle(gpointer data)
+{
+	MafwGstRendererMetadataClosure *closure = data;
+
+	_notify_metadata(NULL, closure->object_id, closure->metadata,
+			 closure->renderer, NULL);
+
+	g_object_unref(closure->renderer);
+	g_free(closure->object_id);
+	g_hash_table_unref(closure->metadata);
+	g_free(closure);
+
+	return FALSE;
+}
+
 void mafw_gst_renderer_get_metadata(MafwGstRenderer* self,
 				  const gchar* objectid,
 				  GError **error)
@@ -640,6 +751,22 @@ void mafw_gst_renderer_get_metadata(MafwGstRenderer* self,
 
 	g_assert(self != NULL);
 
+	/* The item prefetched after the current one needs no request, and
+	 * may be prerolled on the standby pipeline already.  It is delivered
+	 * from an idle, as the source would, once in Transitioning; the
+	 * idle keeps a reference so that the renderer outlives it. */
+	if (self->next_metadata != NULL &&
+	    strcmp(objectid, self->next_object_id) == 0) {
+		MafwGstRendererMetadataClosure *closure;
+
+		closure = g_new0(MafwGstRendererMetadataClosure, 1);
+		closure->renderer = g_object_ref(self);
+		closure->object_id = g_strdup(objectid);
+		closure->metadata = g_hash_table_ref(self->next_metadata);
+		g_idle_add(_notify_prefetched_metadata_idle, closure);
+		return;
+	}
+
 	/*
 	 * Any error here is an error when trying to Play, so
 	 * it must be handled by error policy.
@@ -683,6 +810,126 @@ void mafw_gst_renderer_get_metadata(MafwGstRenderer* self,
 	}
 }
 
+/*
+ * Forgets the item prefetched for gapless playback and the standby
+ * pipeline, and withdraws its URI from the worker.
+ */
+static void _clear_next(MafwGstRenderer *self)
+{
+	g_free(self->next_object_id);
+	self->next_object_id = NULL;
+	self->next_index = -1;
+
+	if (self->next_metadata != NULL) {
+		g_hash_table_unref(self->next_metadata);
+		self->next_metadata = NULL;
+	}
+
+	if (self->worker != NULL) {
+		mafw_gst_renderer_worker_set_next_uri(self->worker, NULL);
+	}
+}
+
+static void _prefetch_metadata_cb(MafwSource *cb_source,
+				  const gchar *cb_object_id,
+				  GHashTable *cb_metadata,
+				  gpointer cb_user_data,
+				  const GError *cb_error)
+{
+	MafwGstRenderer *renderer = (MafwGstRenderer*) cb_user_data;
+	gpointer value;
+	GValue *mval;
+
+	g_return_if_fail(MAFW_IS_GST_RENDERER(renderer));
+
+	/* Playback has moved on meanwhile */
+	if (renderer->next_object_id == NULL ||
+	    strcmp(cb_object_id, renderer->next_object_id) != 0) {
+		return;
+	}
+
+	if (cb_error != NULL) {
+		g_debug("no gapless playback for %s: %s", cb_object_id,
+			cb_error->message);
+		return;
+	}
+
+	/* Items with alternative URIs take the usual way, as the worker has
+	 * to try them one by one */
+	value = g_hash_table_lookup(cb_metadata, MAFW_METADATA_KEY_URI);
+	if (value == NULL || mafw_metadata_nvalues(value) != 1) {
+		return;
+	}
+
+	mval = mafw_metadata_first(cb_metadata, MAFW_METADATA_KEY_URI);
+	renderer->next_metadata = g_hash_table_ref(cb_metadata);
+	mafw_gst_renderer_worker_set_next_uri(renderer->worker,
+					      g_value_get_string(mval));
+}
+
+/**
+ * mafw_gst_renderer_prefetch_next:
+ *
+ * @self A #MafwGstRenderer
+ *
+ * Requests the URI of the playlist item after the current one, and hands it
+ * to the worker so that it continues with it without a gap.
+ **/
+void mafw_gst_renderer_prefetch_next(MafwGstRenderer *self)
+{
+	MafwSource *source;
+	gchar *objectid;
+	gint index;
+	static const gchar * const keys[] =
+		{ MAFW_METADATA_KEY_URI,
+		  MAFW_METADATA_KEY_IS_SEEKABLE,
+		  MAFW_METADATA_KEY_DURATION,
+		  NULL };
+
+	g_return_if_fail(MAFW_IS_GST_RENDERER(self));
+
+	if (self->playback_mode != MAFW_GST_RENDERER_MODE_PLAYLIST ||
+	    self->playlist == NULL ||
+	    !mafw_playlist_iterator_is_valid(self->iterator)) {
+		_clear_next(self);
+		return;
+	}
+
+	objectid = mafw_playlist_iterator_peek_next(self->iterator, &index,
+						    NULL);
+	if (objectid == NULL) {
+		_clear_next(self);
+		return;
+	}
+
+	/* Still the same item: keep it, and the worker its standby
+	 * pipeline.  Stopping made the worker forget the URI, though. */
+	if (self->next_object_id != NULL && self->next_index == index &&
+	    strcmp(objectid, self->next_object_id) == 0) {
+		g_free(objectid);
+		if (self->next_metadata != NULL) {
+			GValue *mval = mafw_metadata_first(
+				self->next_metadata, MAFW_METADATA_KEY_URI);
+			mafw_gst_renderer_worker_set_next_uri(
+				self->worker, g_value_get_string(mval));
+		}
+		return;
+	}
+
+	_clear_next(self);
+
+	source = _get_source(self, objectid);
+	if (source == NULL) {
+		g_free(objectid);
+		return;
+	}
+
+	self->next_object_id = objectid;
+	self->next_index = index;
+	mafw_source_get_metadata(source, objectid, keys,
+				 _prefetch_metadata_cb, self);
+}
+
 void mafw_gst_renderer_set_object(MafwGstRenderer *self, const gchar *object_id)
 {
 	MafwGstRenderer *renderer = (MafwGstRenderer *) self;
@@ -890,6 +1137,188 @@ static void _battery_cover_open_cb(GConfClient *client,
 	}
 }
 
+/*
+ * Pushes the whole curve in renderer->eq_layout and renderer->eq_gains to
+ * the worker in one go.  Presets write the band keys one by one, so
+ * updates are batched here instead of being applied per key: the streaming
+ * thread only sees complete curves and recomputes the coefficients once per
+ * batch.
+ */
+static gboolean _gst_equalizer_apply_cb(MafwGstRenderer *renderer)
+{
+        renderer->eq_update_id = 0;
+
+        if (!renderer->worker) {
+                return FALSE;
+        }
+
+        /* Only when they change, so that a band tweak never reloads or
+         * partitions the response again */
+        if (renderer->eq_engine_changed) {
+                mafw_gst_renderer_worker_set_eq_engine(renderer->worker,
+                                                       renderer->eq_engine,
+                                                       renderer->eq_ir_file);
+                renderer->eq_engine_changed = FALSE;
+        }
+        mafw_gst_renderer_worker_set_eq_curve(renderer->worker,
+                                              &renderer->eq_layout,
+                                              renderer->eq_gains);
+
+        return FALSE;
+}
+
+/* Schedules _gst_equalizer_apply_cb(), once for a burst of changes */
+static void _gst_equalizer_schedule_apply(MafwGstRenderer *renderer)
+{
+        if (renderer->eq_update_id == 0) {
+                renderer->eq_update_id =
+                        g_idle_add((GSourceFunc) _gst_equalizer_apply_cb,
+                                   renderer);
+        }
+}
+
+/* Reads the equalizer engine and impulse response file from gconf */
+static void _gst_equalizer_load_engine(MafwGstRenderer *renderer)
+{
+        MafwGstRendererConvolverMode old_engine = renderer->eq_engine;
+        gchar *engine, *ir_file;
+
+        engine = gconf_client_get_string(renderer->gconf_client,
+                                         GCONF_MAFW_GST_EQ_RENDERER_ENGINE,
+                                         NULL);
+        if (engine && strcmp(engine, "linear-phase") == 0) {
+                renderer->eq_engine = MAFW_GST_RENDERER_CONVOLVER_LINEAR_PHASE;
+        } else if (engine && strcmp(engine, "impulse-response") == 0) {
+                renderer->eq_engine =
+                        MAFW_GST_RENDERER_CONVOLVER_IMPULSE_RESPONSE;
+        } else {
+                if (engine && strcmp(engine, "iir") != 0) {
+                        g_warning("Unknown equalizer engine %s", engine);
+                }
+                renderer->eq_engine = MAFW_GST_RENDERER_CONVOLVER_OFF;
+        }
+        g_free(engine);
+
+        ir_file = gconf_client_get_string(renderer->gconf_client,
+                                          GCONF_MAFW_GST_EQ_RENDERER_IR_FILE,
+                                          NULL);
+        if (renderer->eq_engine != old_engine ||
+            g_strcmp0(ir_file, renderer->eq_ir_file) != 0) {
+                renderer->eq_engine_changed = TRUE;
+        }
+        g_free(renderer->eq_ir_file);
+        renderer->eq_ir_file = ir_file;
+}
+
+/* Reads the band layout stored in gconf, falling back to the 10 band
+ * graphic equalizer if there is none or it is wrong */
+static void _gst_equalizer_load_layout(MafwGstRenderer *renderer)
+{
+        gchar *layout;
+
+        layout = gconf_client_get_string(renderer->gconf_client,
+                                         GCONF_MAFW_GST_EQ_RENDERER_LAYOUT,
+                                         NULL);
+        if (!layout || !eq_layout_parse(layout, &renderer->eq_layout)) {
+                eq_layout_init_default(&renderer->eq_layout);
+        }
+        g_free(layout);
+}
+
+/* Reads the complete curve from gconf and applies it right away */
+static void _gst_equalizer_load(MafwGstRenderer *renderer)
+{
+        GError *error = NULL;
+        gchar *key;
+        gint i;
+
+        _gst_equalizer_load_layout(renderer);
+        _gst_equalizer_load_engine(renderer);
+        /* The convolver gets them at least once */
+        renderer->eq_engine_changed = TRUE;
+
+        for (i = 0; i < EQ_DSP_MAX_BANDS; i++) {
+                key = g_strdup_printf(GCONF_MAFW_GST_EQ_RENDERER "/band%d", i);
+                renderer->eq_gains[i] =
+                        CLAMP(gconf_client_get_float(renderer->gconf_client,
+                                                     key, &error),
+                              EQ_GAIN_MIN, EQ_GAIN_MAX);
+                if (error) {
+                        g_warning("%s", error->message);
+                        g_error_free(error);
+                        error = NULL;
+                        renderer->eq_gains[i] = 0.0;
+                }
+                g_free(key);
+        }
+
+        _gst_equalizer_apply_cb(renderer);
+}
+
+/* Sample rates the equalizer coefficients are prewarmed at */
+static const gint eq_prewarm_rates[] = { 44100, 48000 };
+
+/* Designs the coefficients of every preset in @path */
+static void _gst_equalizer_prewarm_dir(MafwGstRenderer *renderer,
+                                       const gchar *path)
+{
+        EqDspBiquad bq[EQ_DSP_MAX_BANDS];
+        gdouble gains[EQ_DSP_MAX_BANDS];
+        EqDspLayout layout;
+        const gchar *name;
+        gchar *filename;
+        GDir *dir;
+        gint i;
+
+        dir = g_dir_open(path, 0, NULL);
+        if (!dir) {
+                g_debug("No equalizer presets in %s", path);
+                return;
+        }
+
+        while ((name = g_dir_read_name(dir)) != NULL) {
+                filename = g_build_filename(path, name, NULL);
+                /* Presets store the layout they were saved on */
+                layout = renderer->eq_layout;
+                if (load_eq_preset(filename, gains, EQ_DSP_MAX_BANDS,
+                                   &layout)) {
+                        for (i = 0; i < G_N_ELEMENTS(eq_prewarm_rates); i++) {
+                                eq_dsp_design_layout_cached(
+                                        bq, &layout, gains,
+                                        eq_prewarm_rates[i], NULL);
+                        }
+                }
+                g_free(filename);
+        }
+        g_dir_close(dir);
+}
+
+/*
+ * Designs the coefficients of every preset, the shipped ones and the
+ * user's, and of the current curve, at the usual sample rates so that
+ * selecting a preset or starting a track only needs a cache lookup in the
+ * streaming thread.  A user preset copied from a shipped one is only
+ * designed once, the second time is a cache hit.
+ */
+static gboolean _gst_equalizer_prewarm_cb(MafwGstRenderer *renderer)
+{
+        EqDspBiquad bq[EQ_DSP_MAX_BANDS];
+        gint i;
+
+        renderer->eq_prewarm_id = 0;
+
+        for (i = 0; i < G_N_ELEMENTS(eq_prewarm_rates); i++) {
+                eq_dsp_design_layout_cached(bq, &renderer->eq_layout,
+                                            renderer->eq_gains,
+                                            eq_prewarm_rates[i], NULL);
+        }
+
+        _gst_equalizer_prewarm_dir(renderer, SYSTEM_PRESETS);
+        _gst_equalizer_prewarm_dir(renderer, HOME_PRESETS);
+
+        return FALSE;
+}
+
 static void _gst_equalizer_changed_cb(GConfClient *client,
                                       guint cnxn_id,
                                       GConfEntry *entry,
@@ -898,21 +1327,37 @@ static void _gst_equalizer_changed_cb(GConfClient *client,
         const gchar *key;
         GConfValue *value;
         gdouble gain;
-
-        if (G_UNLIKELY(!renderer->worker->equalizer)) {
-                g_warning("There is no equalizer component");
-                return;
-        }
+        gchar *end;
+        glong band;
 
         key = gconf_entry_get_key(entry);
 
         /* Only key without absolute path is required */
         key += strlen(GCONF_MAFW_GST_EQ_RENDERER) + 1;
 
+        if (strcmp(key, "layout") == 0) {
+                g_debug("Equalizer layout changed");
+                _gst_equalizer_load_layout(renderer);
+                _gst_equalizer_schedule_apply(renderer);
+                return;
+        }
+
+        if (strcmp(key, "engine") == 0 || strcmp(key, "ir-file") == 0) {
+                g_debug("Equalizer engine changed");
+                _gst_equalizer_load_engine(renderer);
+                _gst_equalizer_schedule_apply(renderer);
+                return;
+        }
+
         /* Check key soundness */
-        if (strncmp(key, "band", 4) == 0 &&
-            key[4] >= '0' && key[4] <= '9' &&
-            key[5] == '\0') {
+        band = -1;
+        if (strncmp(key, "band", 4) == 0 && g_ascii_isdigit(key[4])) {
+                band = strtol(key + 4, &end, 10);
+                if (*end != '\0')
+                        band = -1;
+        }
+
+        if (band >= 0 && band < EQ_DSP_MAX_BANDS) {
                 value = gconf_entry_get_value(entry);
                 if (!value) {
                         gain = 0.0;
@@ -921,8 +1366,8 @@ static void _gst_equalizer_changed_cb(GConfClient *client,
                                      EQ_GAIN_MIN, EQ_GAIN_MAX);
                 }
                 g_debug("Equalizer changed (%s = %f dB)", key, gain);
-                g_object_set(renderer->worker->equalizer,
-                             key, gain, NULL);
+                renderer->eq_gains[band] = gain;
+                _gst_equalizer_schedule_apply(renderer);
         } else {
                 g_warning("Wrong %s key, %s", GCONF_MAFW_GST_EQ_RENDERER, key);
         }
@@ -1038,6 +1483,77 @@ static void _signal_transport_actions_property_changed(MafwGstRenderer * self)
 }
 
 
+/*----------------------------------------------------------------------------
+  Position ticks
+  ----------------------------------------------------------------------------*/
+
+/* With position_interval set, the position is pushed to clients as a
+ * change of the "position" property every position_interval seconds while
+ * playing, instead of them polling it.  The timeout is a seconds one, so
+ * that its wakeups are aligned with other such timeouts in the system, and
+ * is only there in Playing: the position does not move in the other
+ * states, the pipeline being set to READY after a while paused among
+ * them. */
+
+static gboolean _position_tick_cb(MafwGstRenderer *renderer)
+{
+	GValue value = {0};
+	gint position;
+
+	position = mafw_gst_renderer_worker_get_position(renderer->worker);
+	if (position >= 0) {
+		g_value_init(&value, G_TYPE_INT);
+		g_value_set_int(&value, position);
+		mafw_extension_emit_property_changed(
+			MAFW_EXTENSION(renderer),
+			MAFW_PROPERTY_GST_RENDERER_POSITION, &value);
+		g_value_unset(&value);
+	}
+
+	return TRUE;
+}
+
+static void _update_position_ticks(MafwGstRenderer *renderer)
+{
+	gboolean tick;
+
+	tick = renderer->position_interval > 0 &&
+		renderer->current_state == Playing;
+
+	if (!tick && renderer->position_tick_id != 0) {
+		g_source_remove(renderer->position_tick_id);
+		renderer->position_tick_id = 0;
+	} else if (tick && renderer->position_tick_id == 0) {
+		renderer->position_tick_id =
+			g_timeout_add_seconds(renderer->position_interval,
+					      (GSourceFunc) _position_tick_cb,
+					      renderer);
+		/* Clients get the position it starts from right away */
+		_position_tick_cb(renderer);
+	}
+}
+
+/* Pushes the position right away and counts the interval from now, e.g.
+ * once a seek has made it jump */
+static void _restart_position_ticks(MafwGstRenderer *renderer)
+{
+	if (renderer->position_tick_id != 0) {
+		g_source_remove(renderer->position_tick_id);
+		renderer->position_tick_id = 0;
+	}
+	_update_position_ticks(renderer);
+}
+
+static void _set_position_interval(MafwGstRenderer *renderer,
+				   guint interval)
+{
+	if (renderer->position_interval == interval)
+		return;
+
+	renderer->position_interval = interval;
+	_restart_position_ticks(renderer);
+}
+
 /*----------------------------------------------------------------------------
   State pattern support
   ----------------------------------------------------------------------------*/
@@ -1049,193 +1565,472 @@ void mafw_gst_renderer_set_state(MafwGstRenderer *self, MafwPlayState state)
 	self->current_state = state;
 	_signal_state_changed(self);
 	_signal_transport_actions_property_changed(self);
+	_update_position_ticks(self);
 }
 
-void mafw_gst_renderer_play(MafwRenderer *self, MafwRendererPlaybackCB callback,
-			  gpointer user_data)
+/*
+ * Tells the worker whether to stay paused when it would go on playing.  The
+ * worker reads the flag on its own thread, so the states keep their own
+ * copy of it.
+ */
+void mafw_gst_renderer_set_stay_paused(MafwGstRenderer *self,
+				       gboolean stay_paused)
 {
-	MafwGstRenderer *renderer = (MafwGstRenderer*) self;
-	GError *error = NULL;
-
 	g_return_if_fail(MAFW_IS_GST_RENDERER(self));
 
-	g_return_if_fail((renderer->states != 0) &&
-			 (renderer->current_state != _LastMafwPlayState) &&
-			 (renderer->states[renderer->current_state] != NULL));
+	self->stay_paused = stay_paused;
+	mafw_gst_renderer_worker_set_stay_paused(self->worker, stay_paused);
+}
 
-	mafw_gst_renderer_state_play(
-		MAFW_GST_RENDERER_STATE(renderer->states[renderer->current_state]),
-		&error);
+/*----------------------------------------------------------------------------
+  Command queue
+  ----------------------------------------------------------------------------*/
 
-	if (callback != NULL)
-		callback(self, user_data, error);
-	if (error)
-		g_error_free(error);
+/* Transport calls coming from clients are not run right away but queued and
+ * run from an idle, so that a burst of them is seen as a whole.  A seek is
+ * superseded by a later seek or playlist movement, and a movement by a later
+ * goto_index: only the last of them is run.  The callbacks of superseded
+ * calls are still called, with the outcome of the call superseding them. */
+
+typedef enum {
+	COMMAND_PLAY,
+	COMMAND_PLAY_OBJECT,
+	COMMAND_STOP,
+	COMMAND_PAUSE,
+	COMMAND_RESUME,
+	COMMAND_NEXT,
+	COMMAND_PREVIOUS,
+	COMMAND_GOTO_INDEX,
+	COMMAND_SET_POSITION,
+} RendererCommandType;
+
+static const gchar *command_names[] = {
+	"play", "play_object", "stop", "pause", "resume", "next", "previous",
+	"goto_index", "set_position",
+};
+
+/* A client waiting for a command, @seconds being the position it asked for
+ * if it is a set_position one */
+typedef struct {
+	MafwRendererPlaybackCB playback_cb;
+	MafwRendererPositionCB position_cb;
+	gpointer user_data;
+	gint seconds;
+} RendererCommandReply;
+
+typedef struct {
+	RendererCommandType type;
+	gchar *object_id;
+	guint index;
+	MafwRendererSeekMode mode;
+	gint seconds;
+	GSList *replies;
+} RendererCommand;
+
+static RendererCommand *_command_new(RendererCommandType type,
+				     MafwRendererPlaybackCB callback,
+				     gpointer user_data)
+{
+	RendererCommand *cmd = g_new0(RendererCommand, 1);
+	RendererCommandReply *reply = g_new0(RendererCommandReply, 1);
+
+	cmd->type = type;
+	reply->playback_cb = callback;
+	reply->user_data = user_data;
+	cmd->replies = g_slist_prepend(NULL, reply);
+	return cmd;
 }
 
-void mafw_gst_renderer_play_object(MafwRenderer *self,
-				 const gchar *object_id,
-				 MafwRendererPlaybackCB callback,
-				 gpointer user_data)
+static RendererCommand *_command_new_seek(MafwRendererSeekMode mode,
+					  gint seconds,
+					  MafwRendererPositionCB callback,
+					  gpointer user_data)
+{
+	RendererCommand *cmd = _command_new(COMMAND_SET_POSITION, NULL,
+					    user_data);
+	RendererCommandReply *reply = cmd->replies->data;
+
+	cmd->mode = mode;
+	cmd->seconds = seconds;
+	reply->position_cb = callback;
+	reply->seconds = seconds;
+	return cmd;
+}
+
+static void _command_free(RendererCommand *cmd)
+{
+	g_slist_foreach(cmd->replies, (GFunc) g_free, NULL);
+	g_slist_free(cmd->replies);
+	g_free(cmd->object_id);
+	g_free(cmd);
+}
+
+static gboolean _command_supersedes(const RendererCommand *cmd,
+				    const RendererCommand *old)
+{
+	switch (old->type) {
+	case COMMAND_SET_POSITION:
+		return cmd->type == COMMAND_SET_POSITION ||
+			cmd->type == COMMAND_NEXT ||
+			cmd->type == COMMAND_PREVIOUS ||
+			cmd->type == COMMAND_GOTO_INDEX;
+	case COMMAND_NEXT:
+	case COMMAND_PREVIOUS:
+	case COMMAND_GOTO_INDEX:
+		return cmd->type == COMMAND_GOTO_INDEX;
+	default:
+		return FALSE;
+	}
+}
+
+/* Calls back everyone waiting for @cmd, with the @error it ended with */
+static void _reply_command(MafwGstRenderer *renderer, RendererCommand *cmd,
+			   const GError *error)
+{
+	GSList *l;
+
+	for (l = cmd->replies; l != NULL; l = l->next) {
+		RendererCommandReply *reply = l->data;
+
+		if (reply->playback_cb != NULL)
+			reply->playback_cb(MAFW_RENDERER(renderer),
+					   reply->user_data, error);
+		else if (reply->position_cb != NULL)
+			reply->position_cb(MAFW_RENDERER(renderer),
+					   reply->seconds, reply->user_data,
+					   error);
+	}
+}
+
+/* Runs @cmd in the current state, calls back everyone waiting for it and
+ * frees it */
+static void _run_command(MafwGstRenderer *renderer, RendererCommand *cmd)
 {
-	MafwGstRenderer *renderer = (MafwGstRenderer*) self;
+	MafwGstRendererState *state;
 	GError *error = NULL;
 
-	g_return_if_fail(MAFW_IS_GST_RENDERER(self));
-	g_return_if_fail(object_id != NULL);
+	/* The call has to see the playlist as it is now */
+	_flush_playlist_changed(renderer);
 
-	g_return_if_fail((renderer->states != 0) &&
-			 (renderer->current_state != _LastMafwPlayState) &&
-			 (renderer->states[renderer->current_state] != NULL));
+	state = MAFW_GST_RENDERER_STATE(renderer->states[renderer->current_state]);
 
-	mafw_gst_renderer_state_play_object(
-		MAFW_GST_RENDERER_STATE(renderer->states[renderer->current_state]),
-		object_id,
-		&error);
+	switch (cmd->type) {
+	case COMMAND_PLAY:
+		mafw_gst_renderer_state_play(state, &error);
+		break;
+	case COMMAND_PLAY_OBJECT:
+		mafw_gst_renderer_state_play_object(state, cmd->object_id,
+						    &error);
+		break;
+	case COMMAND_STOP:
+		renderer->play_failed_count = 0;
+		mafw_gst_renderer_state_stop(state, &error);
+		break;
+	case COMMAND_PAUSE:
+		mafw_gst_renderer_state_pause(state, &error);
+		break;
+	case COMMAND_RESUME:
+		mafw_gst_renderer_state_resume(state, &error);
+		break;
+	case COMMAND_NEXT:
+		renderer->play_failed_count = 0;
+		mafw_gst_renderer_state_next(state, &error);
+		break;
+	case COMMAND_PREVIOUS:
+		renderer->play_failed_count = 0;
+		mafw_gst_renderer_state_previous(state, &error);
+		break;
+	case COMMAND_GOTO_INDEX:
+		renderer->play_failed_count = 0;
+		mafw_gst_renderer_state_goto_index(state, cmd->index, &error);
+		break;
+	case COMMAND_SET_POSITION:
+		mafw_gst_renderer_state_set_position(state, cmd->mode,
+						     cmd->seconds, &error);
+		break;
+	}
 
-	if (callback != NULL)
-		callback(self, user_data, error);
+	_reply_command(renderer, cmd, error);
 	if (error)
 		g_error_free(error);
+	_command_free(cmd);
 }
 
-void mafw_gst_renderer_stop(MafwRenderer *self, MafwRendererPlaybackCB callback,
-			  gpointer user_data)
+static gboolean _run_commands_cb(MafwGstRenderer *renderer)
 {
-	MafwGstRenderer *renderer = (MafwGstRenderer *) self;
-	GError *error = NULL;
+	RendererCommand *cmd;
 
-	g_return_if_fail(MAFW_IS_GST_RENDERER(self));
+	renderer->command_id = 0;
+	while ((cmd = g_queue_pop_head(renderer->commands)) != NULL)
+		_run_command(renderer, cmd);
 
-	g_return_if_fail((renderer->states != 0) &&
-			 (renderer->current_state != _LastMafwPlayState) &&
-			 (renderer->states[renderer->current_state] != NULL));
+	return FALSE;
+}
 
-	renderer->play_failed_count = 0;
-	mafw_gst_renderer_state_stop(
-		MAFW_GST_RENDERER_STATE(renderer->states[renderer->current_state]),
-		&error);
+/* Runs whatever clients have queued so far, for calls that have to see its
+ * outcome */
+static void _flush_commands(MafwGstRenderer *renderer)
+{
+	if (renderer->command_id != 0) {
+		g_source_remove(renderer->command_id);
+		_run_commands_cb(renderer);
+	}
+}
 
-	if (callback != NULL)
-		callback(self, user_data, error);
-	if (error)
+/* Fails whatever clients have queued so far, for a renderer going away */
+static void _cancel_commands(MafwGstRenderer *renderer)
+{
+	RendererCommand *cmd;
+	GError *error;
+
+	if (renderer->command_id != 0) {
+		g_source_remove(renderer->command_id);
+		renderer->command_id = 0;
+	}
+
+	while ((cmd = g_queue_pop_head(renderer->commands)) != NULL) {
+		g_debug("cancelling %s", command_names[cmd->type]);
+		error = g_error_new(MAFW_RENDERER_ERROR,
+				    MAFW_RENDERER_ERROR_CANNOT_PLAY,
+				    "Renderer is being disposed");
+		_reply_command(renderer, cmd, error);
 		g_error_free(error);
+		_command_free(cmd);
+	}
 }
 
-
-void mafw_gst_renderer_pause(MafwRenderer *self, MafwRendererPlaybackCB callback,
-			   gpointer user_data)
+static void _queue_command(MafwGstRenderer *renderer, RendererCommand *cmd)
 {
-	MafwGstRenderer *renderer = (MafwGstRenderer *) self;
-	GError *error = NULL;
+	RendererCommand *old;
+
+	renderer->commands_queued++;
+
+	while ((old = g_queue_peek_tail(renderer->commands)) != NULL &&
+	       _command_supersedes(cmd, old)) {
+		g_queue_pop_tail(renderer->commands);
+
+		/* Relative seeks add up */
+		if (old->type == COMMAND_SET_POSITION &&
+		    cmd->type == COMMAND_SET_POSITION &&
+		    cmd->mode == SeekRelative) {
+			cmd->mode = old->mode;
+			cmd->seconds += old->seconds;
+			if (cmd->mode == SeekAbsolute)
+				cmd->seconds = MAX(cmd->seconds, 0);
+		}
 
-	g_return_if_fail(MAFW_IS_GST_RENDERER(self));
+		cmd->replies = g_slist_concat(old->replies, cmd->replies);
+		old->replies = NULL;
+		renderer->commands_coalesced++;
+		g_debug("%s superseded by %s: %u of %u transport calls "
+			"coalesced", command_names[old->type],
+			command_names[cmd->type], renderer->commands_coalesced,
+			renderer->commands_queued);
+		_command_free(old);
+	}
 
-	g_return_if_fail((renderer->states != 0) &&
-			 (renderer->current_state != _LastMafwPlayState) &&
-			 (renderer->states[renderer->current_state] != NULL));
+	g_queue_push_tail(renderer->commands, cmd);
+	if (renderer->command_id == 0)
+		renderer->command_id =
+			g_idle_add((GSourceFunc) _run_commands_cb, renderer);
+}
 
-	mafw_gst_renderer_state_pause(
-		MAFW_GST_RENDERER_STATE(renderer->states[renderer->current_state]),
-		&error);
+/* Gets how many transport calls clients made, and how many of them were
+ * superseded by a later one.  Either may be NULL. */
+void mafw_gst_renderer_get_command_stats(MafwGstRenderer *self,
+					 guint *queued, guint *coalesced)
+{
+	g_return_if_fail(MAFW_IS_GST_RENDERER(self));
 
-	if (callback != NULL)
-		callback(self, user_data, error);
-	if (error)
-		g_error_free(error);
+	if (queued != NULL)
+		*queued = self->commands_queued;
+	if (coalesced != NULL)
+		*coalesced = self->commands_coalesced;
 }
 
-void mafw_gst_renderer_resume(MafwRenderer *self, MafwRendererPlaybackCB callback,
-			    gpointer user_data)
+static gboolean _is_ready(MafwRenderer *self)
 {
 	MafwGstRenderer *renderer = (MafwGstRenderer *) self;
-	GError *error = NULL;
 
-	g_return_if_fail(MAFW_IS_GST_RENDERER(self));
+	g_return_val_if_fail(MAFW_IS_GST_RENDERER(self), FALSE);
 
-	g_return_if_fail((renderer->states != 0) &&
-			 (renderer->current_state != _LastMafwPlayState) &&
-			 (renderer->states[renderer->current_state] != NULL));
+	g_return_val_if_fail((renderer->states != 0) &&
+			     (renderer->current_state != _LastMafwPlayState) &&
+			     (renderer->states[renderer->current_state] != NULL),
+			     FALSE);
+	return TRUE;
+}
 
-	mafw_gst_renderer_state_resume(
-		MAFW_GST_RENDERER_STATE (renderer->states[renderer->current_state]),
-		&error);
+static void _queue_play(MafwRenderer *self, MafwRendererPlaybackCB callback,
+			gpointer user_data)
+{
+	if (_is_ready(self))
+		_queue_command(MAFW_GST_RENDERER(self),
+			       _command_new(COMMAND_PLAY, callback, user_data));
+}
 
-	if (callback != NULL)
-		callback(self, user_data, error);
-	if (error)
-		g_error_free(error);
+static void _queue_play_object(MafwRenderer *self, const gchar *object_id,
+			       MafwRendererPlaybackCB callback,
+			       gpointer user_data)
+{
+	RendererCommand *cmd;
+
+	g_return_if_fail(object_id != NULL);
+
+	if (_is_ready(self)) {
+		cmd = _command_new(COMMAND_PLAY_OBJECT, callback, user_data);
+		cmd->object_id = g_strdup(object_id);
+		_queue_command(MAFW_GST_RENDERER(self), cmd);
+	}
 }
 
-void mafw_gst_renderer_next(MafwRenderer *self, MafwRendererPlaybackCB callback,
-			  gpointer user_data)
+static void _queue_stop(MafwRenderer *self, MafwRendererPlaybackCB callback,
+			gpointer user_data)
 {
-	MafwGstRenderer *renderer = (MafwGstRenderer *) self;
-	GError *error = NULL;
+	if (_is_ready(self))
+		_queue_command(MAFW_GST_RENDERER(self),
+			       _command_new(COMMAND_STOP, callback, user_data));
+}
 
-	g_return_if_fail(MAFW_IS_GST_RENDERER(self));
+static void _queue_pause(MafwRenderer *self, MafwRendererPlaybackCB callback,
+			 gpointer user_data)
+{
+	if (_is_ready(self))
+		_queue_command(MAFW_GST_RENDERER(self),
+			       _command_new(COMMAND_PAUSE, callback,
+					    user_data));
+}
 
-	g_return_if_fail((renderer->states != 0) &&
-			 (renderer->current_state != _LastMafwPlayState) &&
-			 (renderer->states[renderer->current_state] != NULL));
+static void _queue_resume(MafwRenderer *self, MafwRendererPlaybackCB callback,
+			  gpointer user_data)
+{
+	if (_is_ready(self))
+		_queue_command(MAFW_GST_RENDERER(self),
+			       _command_new(COMMAND_RESUME, callback,
+					    user_data));
+}
 
-	renderer->play_failed_count = 0;
-	mafw_gst_renderer_state_next(
-		MAFW_GST_RENDERER_STATE(renderer->states[renderer->current_state]),
-		&error);
+static void _queue_next(MafwRenderer *self, MafwRendererPlaybackCB callback,
+			gpointer user_data)
+{
+	if (_is_ready(self))
+		_queue_command(MAFW_GST_RENDERER(self),
+			       _command_new(COMMAND_NEXT, callback, user_data));
+}
 
-	if (callback != NULL)
-		callback(self, user_data, error);
-	if (error)
-		g_error_free(error);
+static void _queue_previous(MafwRenderer *self,
+			    MafwRendererPlaybackCB callback,
+			    gpointer user_data)
+{
+	if (_is_ready(self))
+		_queue_command(MAFW_GST_RENDERER(self),
+			       _command_new(COMMAND_PREVIOUS, callback,
+					    user_data));
 }
 
-void mafw_gst_renderer_previous(MafwRenderer *self, MafwRendererPlaybackCB callback,
+static void _queue_goto_index(MafwRenderer *self, guint index,
+			      MafwRendererPlaybackCB callback,
 			      gpointer user_data)
 {
-	MafwGstRenderer *renderer = (MafwGstRenderer *) self;
-	GError *error = NULL;
+	RendererCommand *cmd;
 
-	g_return_if_fail(MAFW_IS_GST_RENDERER(self));
+	if (_is_ready(self)) {
+		cmd = _command_new(COMMAND_GOTO_INDEX, callback, user_data);
+		cmd->index = index;
+		_queue_command(MAFW_GST_RENDERER(self), cmd);
+	}
+}
 
-	g_return_if_fail((renderer->states != 0) &&
-			 (renderer->current_state != _LastMafwPlayState) &&
-			 (renderer->states[renderer->current_state] != NULL));
+static void _queue_set_position(MafwRenderer *self, MafwRendererSeekMode mode,
+				gint seconds, MafwRendererPositionCB callback,
+				gpointer user_data)
+{
+	if (_is_ready(self))
+		_queue_command(MAFW_GST_RENDERER(self),
+			       _command_new_seek(mode, seconds, callback,
+						 user_data));
+}
 
-	renderer->play_failed_count = 0;
-	mafw_gst_renderer_state_previous(
-		MAFW_GST_RENDERER_STATE(renderer->states[renderer->current_state]),
-		&error);
+/* The mafw_gst_renderer_*() transport calls below are the ones used from
+ * within the renderer, and are run right away */
 
-	if (callback != NULL)
-		callback(self, user_data, error);
-	if (error)
-		g_error_free(error);
+void mafw_gst_renderer_play(MafwRenderer *self, MafwRendererPlaybackCB callback,
+			  gpointer user_data)
+{
+	if (_is_ready(self))
+		_run_command(MAFW_GST_RENDERER(self),
+			     _command_new(COMMAND_PLAY, callback, user_data));
 }
 
-void mafw_gst_renderer_goto_index(MafwRenderer *self, guint index,
-				MafwRendererPlaybackCB callback,
-				gpointer user_data)
+void mafw_gst_renderer_play_object(MafwRenderer *self,
+				 const gchar *object_id,
+				 MafwRendererPlaybackCB callback,
+				 gpointer user_data)
 {
-	MafwGstRenderer *renderer = (MafwGstRenderer *) self;
-	GError *error = NULL;
+	RendererCommand *cmd;
 
-	g_return_if_fail(MAFW_IS_GST_RENDERER(self));
+	g_return_if_fail(object_id != NULL);
 
-	g_return_if_fail((renderer->states != 0) &&
-			 (renderer->current_state != _LastMafwPlayState) &&
-			 (renderer->states[renderer->current_state] != NULL));
+	if (_is_ready(self)) {
+		cmd = _command_new(COMMAND_PLAY_OBJECT, callback, user_data);
+		cmd->object_id = g_strdup(object_id);
+		_run_command(MAFW_GST_RENDERER(self), cmd);
+	}
+}
 
-	renderer->play_failed_count = 0;
-	mafw_gst_renderer_state_goto_index(
-		MAFW_GST_RENDERER_STATE(renderer->states[renderer->current_state]),
-		index,
-		&error);
+void mafw_gst_renderer_stop(MafwRenderer *self, MafwRendererPlaybackCB callback,
+			  gpointer user_data)
+{
+	if (_is_ready(self))
+		_run_command(MAFW_GST_RENDERER(self),
+			     _command_new(COMMAND_STOP, callback, user_data));
+}
 
-	if (callback != NULL)
-		callback(self, user_data, error);
-	if (error)
-		g_error_free(error);
+
+void mafw_gst_renderer_pause(MafwRenderer *self, MafwRendererPlaybackCB callback,
+			   gpointer user_data)
+{
+	if (_is_ready(self))
+		_run_command(MAFW_GST_RENDERER(self),
+			     _command_new(COMMAND_PAUSE, callback, user_data));
+}
+
+void mafw_gst_renderer_resume(MafwRenderer *self, MafwRendererPlaybackCB callback,
+			    gpointer user_data)
+{
+	if (_is_ready(self))
+		_run_command(MAFW_GST_RENDERER(self),
+			     _command_new(COMMAND_RESUME, callback, user_data));
+}
+
+void mafw_gst_renderer_next(MafwRenderer *self, MafwRendererPlaybackCB callback,
+			  gpointer user_data)
+{
+	if (_is_ready(self))
+		_run_command(MAFW_GST_RENDERER(self),
+			     _command_new(COMMAND_NEXT, callback, user_data));
+}
+
+void mafw_gst_renderer_previous(MafwRenderer *self, MafwRendererPlaybackCB callback,
+			      gpointer user_data)
+{
+	if (_is_ready(self))
+		_run_command(MAFW_GST_RENDERER(self),
+			     _command_new(COMMAND_PREVIOUS, callback,
+					  user_data));
+}
+
+void mafw_gst_renderer_goto_index(MafwRenderer *self, guint index,
+				MafwRendererPlaybackCB callback,
+				gpointer user_data)
+{
+	RendererCommand *cmd;
+
+	if (_is_ready(self)) {
+		cmd = _command_new(COMMAND_GOTO_INDEX, callback, user_data);
+		cmd->index = index;
+		_run_command(MAFW_GST_RENDERER(self), cmd);
+	}
 }
 
 void mafw_gst_renderer_get_position(MafwRenderer *self, MafwRendererPositionCB callback,
@@ -1254,6 +2049,9 @@ void mafw_gst_renderer_get_position(MafwRenderer *self, MafwRendererPositionCB c
 			 (renderer->current_state != _LastMafwPlayState) &&
 			 (renderer->states[renderer->current_state] != NULL));
 
+	/* A seek queued by the client is the position it expects */
+	_flush_commands(renderer);
+
 	mafw_gst_renderer_state_get_position(
                 MAFW_GST_RENDERER_STATE (renderer->states[renderer->current_state]),
 		&pos,
@@ -1268,25 +2066,10 @@ void mafw_gst_renderer_set_position(MafwRenderer *self, MafwRendererSeekMode mod
 				   gint seconds, MafwRendererPositionCB callback,
 				   gpointer user_data)
 {
-	MafwGstRenderer *renderer = (MafwGstRenderer *) self;
-	GError *error = NULL;
-
-	g_return_if_fail(MAFW_IS_GST_RENDERER(self));
-
-	g_return_if_fail((renderer->states != 0) &&
-			 (renderer->current_state != _LastMafwPlayState) &&
-			 (renderer->states[renderer->current_state] != NULL));
-
-	mafw_gst_renderer_state_set_position(
-		MAFW_GST_RENDERER_STATE (renderer->states[renderer->current_state]),
-		mode,
-		seconds,
-		&error);
-
-	if (callback != NULL)
-		callback(self, seconds, user_data, error);
-	if (error)
-		g_error_free(error);
+	if (_is_ready(self))
+		_run_command(MAFW_GST_RENDERER(self),
+			     _command_new_seek(mode, seconds, callback,
+					       user_data));
 }
 
 gboolean mafw_gst_renderer_manage_error_idle(gpointer data)
@@ -1522,7 +2305,8 @@ gboolean mafw_gst_renderer_update_stats(gpointer data)
 
         /* Update stats only for audio content */
         if (renderer->media->object_id &&
-            !renderer->worker->media.has_visual_content) {
+            !mafw_gst_renderer_worker_get_has_visual_content(
+                    renderer->worker)) {
 		GHashTable *mdata = mafw_gst_renderer_add_lastplayed(NULL);
 		mafw_gst_renderer_increase_playcount(renderer,
                                                      renderer->media->object_id,
@@ -1689,6 +2473,45 @@ static void _notify_seek(MafwGstRendererWorker *worker, gpointer owner)
 	mafw_gst_renderer_state_notify_seek(renderer->states[renderer->current_state],
 					  &error);
 
+	/* Clients following the position see where it landed at once */
+	_restart_position_ticks(renderer);
+
+	if (error != NULL) {
+		g_signal_emit_by_name(MAFW_EXTENSION(renderer), "error",
+				      error->domain, error->code,
+				      error->message);
+		g_error_free(error);
+	}
+}
+
+/* Lets the renderer and the current state know about playlist edits that
+ * went well */
+static void _apply_playlist_changed(MafwGstRenderer *renderer,
+				    gboolean clip_changed)
+{
+	GError *error = NULL;
+	MafwGstRendererPlaybackMode mode;
+
+	/* We update the current index and media here,  for this is
+	   the same for all the states. Then we delegate in the state
+	   to finish the task (for example, start playback if needed) */
+	mode = mafw_gst_renderer_get_playback_mode(renderer);
+
+	/* Only in non-playobject mode */
+	if (clip_changed && mode == MAFW_GST_RENDERER_MODE_PLAYLIST)
+		mafw_gst_renderer_set_media_playlist(renderer);
+
+	/* We let the state know if the current clip has changed as
+	   result of this operation, so it can do its work */
+	mafw_gst_renderer_state_playlist_contents_changed_handler(
+		renderer->states[renderer->current_state],
+		clip_changed,
+		&error);
+
+	/* The item after the current one may be another now */
+	if (!clip_changed && renderer->current_state == Playing)
+		mafw_gst_renderer_prefetch_next(renderer);
+
 	if (error != NULL) {
 		g_signal_emit_by_name(MAFW_EXTENSION(renderer), "error",
 				      error->domain, error->code,
@@ -1697,6 +2520,63 @@ static void _notify_seek(MafwGstRendererWorker *worker, gpointer owner)
 	}
 }
 
+/*
+ * Applies the playlist edits received since the last one was applied, as
+ * if they were a single one.  The current item has only changed if the one
+ * the edits leave is not the one the renderer has.
+ */
+static gboolean _playlist_changed_cb(MafwGstRenderer *renderer)
+{
+	gboolean clip_changed;
+
+	renderer->playlist_changed_id = 0;
+	if (!renderer->playlist_pending)
+		return FALSE;
+
+	clip_changed = renderer->playlist_clip_changed;
+	if (clip_changed && renderer->iterator != NULL &&
+	    mafw_gst_renderer_get_playback_mode(renderer) ==
+	    MAFW_GST_RENDERER_MODE_PLAYLIST) {
+		clip_changed = g_strcmp0(
+			renderer->media->object_id,
+			mafw_playlist_iterator_get_current_objectid(
+				renderer->iterator)) != 0;
+	}
+
+	renderer->playlist_pending = FALSE;
+	renderer->playlist_clip_changed = FALSE;
+	g_debug("%u of %u playlist edits coalesced",
+		renderer->playlist_edits_coalesced, renderer->playlist_edits);
+	_apply_playlist_changed(renderer, clip_changed);
+
+	return FALSE;
+}
+
+/* Applies the playlist edits waiting, for calls that have to see them */
+static void _flush_playlist_changed(MafwGstRenderer *renderer)
+{
+	if (renderer->playlist_changed_id != 0) {
+		g_source_remove(renderer->playlist_changed_id);
+		_playlist_changed_cb(renderer);
+	}
+}
+
+/* Forgets the playlist edits waiting, which are of no use any more */
+static void _drop_playlist_changed(MafwGstRenderer *renderer)
+{
+	if (renderer->playlist_changed_id != 0) {
+		g_source_remove(renderer->playlist_changed_id);
+		renderer->playlist_changed_id = 0;
+	}
+	renderer->playlist_pending = FALSE;
+	renderer->playlist_clip_changed = FALSE;
+}
+
+/*
+ * Edits of the playlist are applied together once the main loop goes idle,
+ * so that a client adding or removing many items does not make the
+ * renderer go through each of them, nor notify more than once.
+ */
 static void _playlist_changed_handler(MafwPlaylistIterator *iterator,
 				      gboolean clip_changed, GQuark domain,
 				      gint code, const gchar *message,
@@ -1710,10 +2590,6 @@ static void _playlist_changed_handler(MafwPlaylistIterator *iterator,
 			 (renderer->current_state != _LastMafwPlayState) &&
 			 (renderer->states[renderer->current_state] != NULL));
 
-	/* We update the current index and media here,  for this is
-	   the same for all the states. Then we delegate in the state
-	   to finish the task (for example, start playback if needed) */
-
 	if (renderer->playlist == NULL) {
 		g_critical("Got iterator:contents-changed but renderer has no" \
 			   "playlist assigned!. Skipping...");
@@ -1723,30 +2599,33 @@ static void _playlist_changed_handler(MafwPlaylistIterator *iterator,
 	if (domain != 0) {
 		g_signal_emit_by_name(MAFW_EXTENSION(renderer), "error",
 				      domain, code, message);
-	} else {
-		GError *error = NULL;
-		MafwGstRendererPlaybackMode mode;
-		
-		mode = mafw_gst_renderer_get_playback_mode(renderer);
+		return;
+	}
 
-		/* Only in non-playobject mode */		
-		if (clip_changed && mode == MAFW_GST_RENDERER_MODE_PLAYLIST)
-			mafw_gst_renderer_set_media_playlist(renderer);
+	renderer->playlist_edits++;
+	if (renderer->playlist_pending)
+		renderer->playlist_edits_coalesced++;
+	renderer->playlist_pending = TRUE;
+	renderer->playlist_clip_changed |= clip_changed;
 
-		/* We let the state know if the current clip has changed as
-		   result of this operation, so it can do its work */
-		mafw_gst_renderer_state_playlist_contents_changed_handler(
-			renderer->states[renderer->current_state],
-			clip_changed,
-			&error);
+	if (renderer->playlist_changed_id == 0)
+		renderer->playlist_changed_id =
+			g_idle_add((GSourceFunc) _playlist_changed_cb,
+				   renderer);
+}
 
-		if (error != NULL) {
-			g_signal_emit_by_name(MAFW_EXTENSION(renderer), "error",
-					      error->domain, error->code,
-					      error->message);
-			g_error_free(error);
-		}
-	}
+/* Gets how many playlist edits were received, and how many of them were
+ * applied together with an earlier one.  Either may be NULL. */
+void mafw_gst_renderer_get_playlist_edit_stats(MafwGstRenderer *self,
+					       guint *edits,
+					       guint *coalesced)
+{
+	g_return_if_fail(MAFW_IS_GST_RENDERER(self));
+
+	if (edits != NULL)
+		*edits = self->playlist_edits;
+	if (coalesced != NULL)
+		*coalesced = self->playlist_edits_coalesced;
 }
 
 static void _error_handler(MafwGstRendererWorker *worker, gpointer owner,
@@ -1903,6 +2782,28 @@ void mafw_gst_renderer_manage_error(MafwGstRenderer *self, const GError *error)
         }
 }
 
+static void _notify_next(MafwGstRendererWorker *worker, gpointer owner)
+{
+	MafwGstRenderer *renderer = (MafwGstRenderer*) owner;
+	GError *error = NULL;
+
+	g_return_if_fail(MAFW_IS_GST_RENDERER (renderer));
+
+	g_return_if_fail((renderer->states != 0) &&
+			 (renderer->current_state != _LastMafwPlayState) &&
+			 (renderer->states[renderer->current_state] != NULL));
+
+	mafw_gst_renderer_state_notify_next(renderer->states[renderer->current_state],
+					  &error);
+
+	if (error != NULL) {
+		g_signal_emit_by_name(MAFW_EXTENSION(renderer), "error",
+				      error->domain, error->code,
+				      error->message);
+		g_error_free(error);
+	}
+}
+
 static void _notify_eos(MafwGstRendererWorker *worker, gpointer owner)
 {
 	MafwGstRenderer *renderer = (MafwGstRenderer*) owner;
@@ -1940,6 +2841,8 @@ void mafw_gst_renderer_get_status(MafwRenderer *self, MafwRendererStatusCB callb
 	g_return_if_fail(callback != NULL);
 	renderer = MAFW_GST_RENDERER(self);
 
+	_flush_commands(renderer);
+	_flush_playlist_changed(renderer);
 	mode = mafw_gst_renderer_get_playback_mode(MAFW_GST_RENDERER(self));
 	if ((mode == MAFW_GST_RENDERER_MODE_STANDALONE) || (renderer->iterator == NULL)) {
 		index = -1;
@@ -1971,6 +2874,9 @@ void mafw_gst_renderer_get_current_metadata(MafwRenderer *self,
 		 metadata,
 		 user_data,
 		 NULL);
+
+	if (metadata != NULL)
+		g_hash_table_unref(metadata);
 }
 
 /*----------------------------------------------------------------------------
@@ -1996,6 +2902,10 @@ gboolean mafw_gst_renderer_assign_playlist(MafwRenderer *self,
 
 	g_return_val_if_fail(MAFW_IS_GST_RENDERER(self), FALSE);
 
+	/* Pending movements are meant for the old playlist */
+	_flush_commands(renderer);
+	_drop_playlist_changed(renderer);
+
 	/* Get rid of previously assigned playlist  */
 	if (renderer->playlist != NULL) {
 		g_signal_handlers_disconnect_matched(renderer->iterator,
@@ -2054,6 +2964,7 @@ gboolean mafw_gst_renderer_assign_playlist(MafwRenderer *self,
 	}
 
 	/* Set the new media and signal playlist changed signal */
+	_clear_next(renderer);
 	_signal_playlist_changed(renderer);
 	mafw_gst_renderer_set_media_playlist(renderer);
 
@@ -2144,6 +3055,10 @@ static void mafw_gst_renderer_get_property(MafwExtension *self,
 	g_return_if_fail(key != NULL);
 
 	renderer = MAFW_GST_RENDERER(self);
+
+	/* The properties have to reflect the calls made before */
+	_flush_commands(renderer);
+
 	if (!strcmp(key, MAFW_PROPERTY_RENDERER_VOLUME)) {
 		guint volume;
 
@@ -2207,6 +3122,61 @@ static void mafw_gst_renderer_get_property(MafwExtension *self,
                 g_value_init(value, G_TYPE_BOOLEAN);
                 g_value_set_boolean(value, renderer->tv_connected);
         }
+        else if (!strcmp(key,
+                         MAFW_PROPERTY_GST_RENDERER_REUSE_PIPELINE)) {
+                value = g_new0(GValue, 1);
+                g_value_init(value, G_TYPE_BOOLEAN);
+                g_value_set_boolean(
+                        value,
+                        mafw_gst_renderer_worker_get_reuse_pipeline(
+                                renderer->worker));
+        }
+        else if (!strcmp(key, MAFW_PROPERTY_GST_RENDERER_GAPLESS)) {
+                value = g_new0(GValue, 1);
+                g_value_init(value, G_TYPE_BOOLEAN);
+                g_value_set_boolean(
+                        value,
+                        mafw_gst_renderer_worker_get_gapless(
+                                renderer->worker));
+        }
+        else if (!strcmp(key, MAFW_PROPERTY_GST_RENDERER_STANDBY_BUDGET)) {
+                value = g_new0(GValue, 1);
+                g_value_init(value, G_TYPE_UINT);
+                g_value_set_uint(
+                        value,
+                        mafw_gst_renderer_worker_get_standby_budget(
+                                renderer->worker));
+        }
+        else if (!strcmp(key, MAFW_PROPERTY_GST_RENDERER_CROSSFADE)) {
+                value = g_new0(GValue, 1);
+                g_value_init(value, G_TYPE_UINT);
+                g_value_set_uint(
+                        value,
+                        mafw_gst_renderer_worker_get_crossfade(
+                                renderer->worker));
+        }
+        else if (!strcmp(key, MAFW_PROPERTY_GST_RENDERER_ACCURATE_SEEK)) {
+                value = g_new0(GValue, 1);
+                g_value_init(value, G_TYPE_BOOLEAN);
+                g_value_set_boolean(
+                        value,
+                        mafw_gst_renderer_worker_get_accurate_seek(
+                                renderer->worker));
+        }
+        else if (!strcmp(key,
+                         MAFW_PROPERTY_GST_RENDERER_POSITION_INTERVAL)) {
+                value = g_new0(GValue, 1);
+                g_value_init(value, G_TYPE_UINT);
+                g_value_set_uint(value, renderer->position_interval);
+        }
+        else if (!strcmp(key, MAFW_PROPERTY_GST_RENDERER_POSITION)) {
+                value = g_new0(GValue, 1);
+                g_value_init(value, G_TYPE_INT);
+                g_value_set_int(
+                        value,
+                        mafw_gst_renderer_worker_get_position(
+                                renderer->worker));
+        }
 	else if (!strcmp(key,
 			 MAFW_PROPERTY_RENDERER_TRANSPORT_ACTIONS)){
 		/* Delegate in the state. */
@@ -2283,6 +3253,30 @@ static void mafw_gst_renderer_set_property(MafwExtension *self,
 									   current_frame_on_pause);
 	}
 #endif
+        else if (!strcmp(key, MAFW_PROPERTY_GST_RENDERER_REUSE_PIPELINE)) {
+                mafw_gst_renderer_worker_set_reuse_pipeline(
+                        renderer->worker, g_value_get_boolean(value));
+        }
+        else if (!strcmp(key, MAFW_PROPERTY_GST_RENDERER_GAPLESS)) {
+                mafw_gst_renderer_worker_set_gapless(
+                        renderer->worker, g_value_get_boolean(value));
+        }
+        else if (!strcmp(key, MAFW_PROPERTY_GST_RENDERER_STANDBY_BUDGET)) {
+                mafw_gst_renderer_worker_set_standby_budget(
+                        renderer->worker, g_value_get_uint(value));
+        }
+        else if (!strcmp(key, MAFW_PROPERTY_GST_RENDERER_CROSSFADE)) {
+                mafw_gst_renderer_worker_set_crossfade(
+                        renderer->worker, g_value_get_uint(value));
+        }
+        else if (!strcmp(key, MAFW_PROPERTY_GST_RENDERER_ACCURATE_SEEK)) {
+                mafw_gst_renderer_worker_set_accurate_seek(
+                        renderer->worker, g_value_get_boolean(value));
+        }
+        else if (!strcmp(key,
+                         MAFW_PROPERTY_GST_RENDERER_POSITION_INTERVAL)) {
+                _set_position_interval(renderer, g_value_get_uint(value));
+        }
 	else return;
 
 	/* FIXME I'm not sure when to emit property-changed signals.
@@ -34,6 +34,8 @@
 
 #include "mafw-gst-renderer-utils.h"
 #include "mafw-gst-renderer-worker.h"
+#include "mafw-gst-renderer-equalizer-dsp.h"
+#include "mafw-gst-renderer-convolver.h"
 #include "mafw-playlist-iterator.h"
 /* Solving the cyclic dependencies */
 typedef struct _MafwGstRenderer MafwGstRenderer;
@@ -75,6 +77,20 @@ typedef enum {
 
 #define MAFW_PROPERTY_GST_RENDERER_TV_CONNECTED "tv-connected"
 
+#define MAFW_PROPERTY_GST_RENDERER_REUSE_PIPELINE "reuse-pipeline"
+
+#define MAFW_PROPERTY_GST_RENDERER_GAPLESS "gapless"
+
+#define MAFW_PROPERTY_GST_RENDERER_STANDBY_BUDGET "standby-budget"
+
+#define MAFW_PROPERTY_GST_RENDERER_CROSSFADE "crossfade"
+
+#define MAFW_PROPERTY_GST_RENDERER_ACCURATE_SEEK "accurate-seek"
+
+#define MAFW_PROPERTY_GST_RENDERER_POSITION_INTERVAL "position-interval"
+
+#define MAFW_PROPERTY_GST_RENDERER_POSITION "position"
+
 /*----------------------------------------------------------------------------
   GObject type conversion macros
   ----------------------------------------------------------------------------*/
@@ -140,9 +156,41 @@ struct _MafwGstRendererClass {
  * playback_mode:     Playback mode
  * resume_playlist:   Do we want to resume playlist playback when play_object
  *                    is finished
+ * stay_paused:       Whether the worker was last told to stay paused, see
+ *                    mafw_gst_renderer_set_stay_paused()
  * states:            State array
  * error_policy:      error policy
  * tv_connected:      if TV-out cable is connected
+ * eq_gains:          Equalizer gains read from gconf, in dB
+ * eq_layout:         Equalizer band layout read from gconf
+ * eq_engine:         How the equalizer curve is applied: by the IIR
+ *                    equalizer (OFF), as a linear phase FIR, or by the IIR
+ *                    equalizer followed by an impulse response
+ * eq_ir_file:        Impulse response file read from gconf
+ * eq_engine_changed: Whether eq_engine or eq_ir_file changed since they
+ *                    were last given to the convolver
+ * eq_update_id:      Idle source applying eq_layout and eq_gains to the
+ *                    equalizer
+ * eq_prewarm_id:     Idle source filling the equalizer coefficient cache
+ * next_object_id:    Playlist item after the current one, whose URI has
+ *                    been requested to play it gaplessly or from the
+ *                    worker's standby pipeline
+ * next_index:        Its index in the playlist
+ * next_metadata:     Its metadata, once the source has sent it
+ * commands:          Transport calls from clients waiting to be run
+ * command_id:        Idle source running them
+ * commands_queued:   Transport calls received from clients
+ * commands_coalesced: How many of them were superseded by a later one
+ * position_interval: Seconds between position changes pushed to clients
+ *                    while playing, 0 for none
+ * position_tick_id:  Timeout pushing them
+ * playlist_changed_id: Idle source applying the playlist edits received
+ *                    since it last ran
+ * playlist_pending:  Whether there are any
+ * playlist_clip_changed: Whether the current item changed in them
+ * playlist_edits:    Playlist edits received
+ * playlist_edits_coalesced: How many of them were applied with an
+ *                    earlier one
  */
 struct _MafwGstRenderer{
 	MafwRenderer parent;
@@ -163,6 +211,7 @@ struct _MafwGstRenderer{
 
 	MafwGstRendererPlaybackMode playback_mode;
 	gboolean resume_playlist;
+	gboolean stay_paused;
  	MafwGstRendererState **states;
 	MafwRendererErrorPolicy error_policy;
         gboolean tv_connected;
@@ -172,6 +221,27 @@ struct _MafwGstRenderer{
 	ConIcConnection *connection;
 #endif
 	GConfClient *gconf_client;
+	gdouble eq_gains[EQ_DSP_MAX_BANDS];
+	EqDspLayout eq_layout;
+	MafwGstRendererConvolverMode eq_engine;
+	gchar *eq_ir_file;
+	gboolean eq_engine_changed;
+	guint eq_update_id;
+	guint eq_prewarm_id;
+	gchar *next_object_id;
+	gint next_index;
+	GHashTable *next_metadata;
+	GQueue *commands;
+	guint command_id;
+	guint commands_queued;
+	guint commands_coalesced;
+	guint position_interval;
+	guint position_tick_id;
+	guint playlist_changed_id;
+	gboolean playlist_pending;
+	gboolean playlist_clip_changed;
+	guint playlist_edits;
+	guint playlist_edits_coalesced;
 };
 
 typedef struct {
@@ -221,6 +291,7 @@ void mafw_gst_renderer_clear_media(MafwGstRenderer *self);
 
 void mafw_gst_renderer_get_metadata(MafwGstRenderer* self, const gchar* objectid,
                                     GError **error);
+void mafw_gst_renderer_prefetch_next(MafwGstRenderer *self);
 gboolean mafw_gst_renderer_update_stats(gpointer data);
 
 /*----------------------------------------------------------------------------
@@ -273,6 +344,9 @@ void mafw_gst_renderer_get_current_metadata(MafwRenderer *self,
 
 void mafw_gst_renderer_set_state(MafwGstRenderer *self, MafwPlayState state);
 
+void mafw_gst_renderer_set_stay_paused(MafwGstRenderer *self,
+				       gboolean stay_paused);
+
 gboolean mafw_gst_renderer_manage_error_idle(gpointer data);
 
 void mafw_gst_renderer_manage_error(MafwGstRenderer *self, const GError *error);
@@ -286,6 +360,12 @@ MafwGstRendererPlaybackMode mafw_gst_renderer_get_playback_mode(
 void mafw_gst_renderer_update_source_duration(MafwGstRenderer *renderer,
 					      gint duration);
 
+void mafw_gst_renderer_get_command_stats(MafwGstRenderer *self,
+					 guint *queued, guint *coalesced);
+void mafw_gst_renderer_get_playlist_edit_stats(MafwGstRenderer *self,
+					       guint *edits,
+					       guint *coalesced);
+
 G_END_DECLS
 
 #endif
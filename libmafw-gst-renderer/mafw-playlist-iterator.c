@@ -22,17 +22,36 @@
  *
  */
 
+#include <string.h>
+
 #include "mafw-playlist-iterator.h"
 #include "mafw-gst-renderer-marshal.h"
 
 #undef  G_LOG_DOMAIN
 #define G_LOG_DOMAIN "mafw-gst-renderer-playlist-iterator"
 
+/* Object ids kept around the current item */
+#define ITERATOR_WINDOW 64
+
+/*
+ * The size and the current index are kept up to date from the playlist
+ * signals, and so is a window of object ids around the current item, so
+ * that editing the playlist does not need a round trip to the playlist
+ * daemon for every change.  Only the object ids not in the window are
+ * asked for.
+ *
+ * window:       Object ids of the items from window_start on, NULL where
+ *               not known
+ */
 struct _MafwPlaylistIteratorPrivate {
 	MafwPlaylist *playlist;
 	gint current_index;
 	gchar *current_objectid;
 	gint size;
+	gint window_start;
+	gchar *window[ITERATOR_WINDOW];
+	guint window_hits;
+	guint window_misses;
 };
 
 typedef gboolean (*movement_function) (MafwPlaylist *playlist,
@@ -95,6 +114,104 @@ mafw_playlist_iterator_init(MafwPlaylistIterator *self)
 						 MafwPlaylistIteratorPrivate);
 }
 
+/*----------------------------------------------------------------------------
+  Object id window
+  ----------------------------------------------------------------------------*/
+
+static void
+mafw_playlist_iterator_window_clear(MafwPlaylistIterator *iterator)
+{
+	gint i;
+
+	for (i = 0; i < ITERATOR_WINDOW; i++) {
+		g_free(iterator->priv->window[i]);
+		iterator->priv->window[i] = NULL;
+	}
+	iterator->priv->window_start = 0;
+}
+
+static void
+mafw_playlist_iterator_window_store(MafwPlaylistIterator *iterator,
+				     gint index, const gchar *objectid)
+{
+	MafwPlaylistIteratorPrivate *priv = iterator->priv;
+
+	if (index < 0 || objectid == NULL)
+		return;
+
+	/* Centre the window on items far from it */
+	if (index < priv->window_start ||
+	    index >= priv->window_start + ITERATOR_WINDOW) {
+		mafw_playlist_iterator_window_clear(iterator);
+		priv->window_start = MAX(0, index - ITERATOR_WINDOW / 2);
+	}
+
+	g_free(priv->window[index - priv->window_start]);
+	priv->window[index - priv->window_start] = g_strdup(objectid);
+}
+
+/*
+ * Replaces the @nremove items from @from on with @ninsert items not known
+ * yet, moving the ones behind them.
+ */
+static void
+mafw_playlist_iterator_window_splice(MafwPlaylistIterator *iterator,
+				      gint from, gint nremove, gint ninsert)
+{
+	MafwPlaylistIteratorPrivate *priv = iterator->priv;
+	gchar *window[ITERATOR_WINDOW] = { NULL, };
+	gint i, index;
+
+	for (i = 0; i < ITERATOR_WINDOW; i++) {
+		index = priv->window_start + i;
+		if (priv->window[i] == NULL || index < from) {
+			window[i] = priv->window[i];
+			continue;
+		}
+
+		index -= priv->window_start;
+		if (index >= from - priv->window_start + nremove)
+			index += ninsert - nremove;
+		else
+			index = -1;
+		if (index >= 0 && index < ITERATOR_WINDOW)
+			window[index] = priv->window[i];
+		else
+			g_free(priv->window[i]);
+	}
+
+	memcpy(priv->window, window, sizeof(window));
+}
+
+/* Returns the object id of the item at @index, asking the playlist for it
+ * if it is not in the window */
+static gchar *
+mafw_playlist_iterator_get_item(MafwPlaylistIterator *iterator, gint index,
+				 GError **error)
+{
+	MafwPlaylistIteratorPrivate *priv = iterator->priv;
+	gchar *objectid;
+
+	if (index >= priv->window_start &&
+	    index < priv->window_start + ITERATOR_WINDOW &&
+	    priv->window[index - priv->window_start] != NULL) {
+		priv->window_hits++;
+		return g_strdup(priv->window[index - priv->window_start]);
+	}
+
+	priv->window_misses++;
+	g_debug("item %d not in the window (%u hits, %u misses)", index,
+		priv->window_hits, priv->window_misses);
+	objectid = mafw_playlist_get_item(priv->playlist, index, error);
+	mafw_playlist_iterator_window_store(iterator, index, objectid);
+
+	return objectid;
+}
+
+/*----------------------------------------------------------------------------
+  Iterator
+  ----------------------------------------------------------------------------*/
+
 static void
 mafw_playlist_iterator_set_data(MafwPlaylistIterator *iterator, gint index,
 				 gchar *objectid)
@@ -104,6 +221,14 @@ mafw_playlist_iterator_set_data(MafwPlaylistIterator *iterator, gint index,
 	g_free(iterator->priv->current_objectid);
 	iterator->priv->current_index = index;
 	iterator->priv->current_objectid = objectid;
+	mafw_playlist_iterator_window_store(iterator, index, objectid);
+}
+
+/* The current item stays the same, at @index */
+static void
+mafw_playlist_iterator_set_index(MafwPlaylistIterator *iterator, gint index)
+{
+	iterator->priv->current_index = index;
 }
 
 static MafwPlaylistIteratorMovementResult
@@ -165,6 +290,7 @@ mafw_playlist_iterator_playlist_contents_changed_handler(MafwPlaylist *playlist,
 
 	play_index = iterator->priv->current_index;
 	iterator->priv->size += nreplace;
+	mafw_playlist_iterator_window_splice(iterator, from, nremove, nreplace);
 
 	if (nremove > 0) {
 		/* Items have been removed from the playlist */
@@ -196,13 +322,11 @@ mafw_playlist_iterator_playlist_contents_changed_handler(MafwPlaylist *playlist,
 		} else if (from < play_index) {
 			/* The current index has been moved towards
 			   the head of the playlist */
-			play_index -= nremove;
+			play_index += nreplace - nremove;
 			if (play_index < 0) {
 				play_index = 0;
 			}
-			mafw_playlist_iterator_move_to_index(iterator,
-							      play_index,
-							      &error);
+			mafw_playlist_iterator_set_index(iterator, play_index);
 		}
 	} else if (nremove == 0) {
 		/* Items have been inserted in the playlist */
@@ -214,9 +338,8 @@ mafw_playlist_iterator_playlist_contents_changed_handler(MafwPlaylist *playlist,
 		} else if (play_index >= from) {
 			/* The current item has been moved towards the
 			   tail of the playlist */
-			mafw_playlist_iterator_move_to_index(iterator,
-							      play_index + nreplace,
-							      &error);
+			mafw_playlist_iterator_set_index(iterator,
+							  play_index + nreplace);
 		}
 	}
 
@@ -242,7 +365,7 @@ mafw_playlist_iterator_playlist_item_moved_handler(MafwPlaylist *playlist,
 {
 	MafwPlaylistIterator *iterator = (MafwPlaylistIterator *) user_data;
 	gint play_index;
-	GError *error = NULL;
+	gchar *objectid;
 
 	g_return_if_fail(MAFW_IS_PLAYLIST(playlist));
 	g_return_if_fail(MAFW_IS_PLAYLIST_ITERATOR(iterator));
@@ -255,24 +378,31 @@ mafw_playlist_iterator_playlist_item_moved_handler(MafwPlaylist *playlist,
 
 	play_index = iterator->priv->current_index;
 
+	/* The item moved keeps its object id, if it is known */
+	objectid = NULL;
+	if (from >= iterator->priv->window_start &&
+	    from < iterator->priv->window_start + ITERATOR_WINDOW)
+		objectid = g_strdup(iterator->priv->window[
+					    from - iterator->priv->window_start]);
+	mafw_playlist_iterator_window_splice(iterator, from, 1, 0);
+	mafw_playlist_iterator_window_splice(iterator, to, 0, 1);
+	if (to >= iterator->priv->window_start &&
+	    to < iterator->priv->window_start + ITERATOR_WINDOW)
+		mafw_playlist_iterator_window_store(iterator, to, objectid);
+	g_free(objectid);
+
 	if (play_index == from) {
 		/* So the current item has been moved, let's update the
 		   the current index to the new location  */
-		mafw_playlist_iterator_move_to_index(iterator, to, &error);
+		mafw_playlist_iterator_set_index(iterator, to);
 	} else if (play_index > from && play_index <= to) {
 		/* So we current item  has been pushed one position towards
 		   the head, let's update the current index */
-		mafw_playlist_iterator_move_to_prev(iterator, &error);
+		mafw_playlist_iterator_set_index(iterator, play_index - 1);
 	}  else if (play_index >= to && play_index < from) {
 		/* So we current item  has been pushed one position towards
 		   the head, let's update the current index */
-		mafw_playlist_iterator_move_to_next(iterator, &error);
-	}
-
-	if (error != NULL) {
-		g_critical("playlist::item-moved handler failed "
-			   "with \"%s\"", error->message);
-		g_error_free (error);
+		mafw_playlist_iterator_set_index(iterator, play_index + 1);
 	}
 }
 
@@ -288,6 +418,7 @@ mafw_playlist_iterator_new(void)
 	iterator->priv->current_index = -1;
 	iterator->priv->current_objectid = NULL;
 	iterator->priv->size = -1;
+	iterator->priv->window_start = 0;
 
 	return iterator;
 }
@@ -318,6 +449,7 @@ mafw_playlist_iterator_initialize(MafwPlaylistIterator *iterator,
 		iterator->priv->current_index = index;
 		iterator->priv->current_objectid = objectid;
 		iterator->priv->size = size;
+		mafw_playlist_iterator_window_store(iterator, index, objectid);
 
 		g_signal_connect(playlist,
 				 "item-moved",
@@ -357,6 +489,7 @@ mafw_playlist_iterator_invalidate(MafwPlaylistIterator *iterator)
 		iterator->priv->current_index = -1;
 		iterator->priv->current_objectid = NULL;
 		iterator->priv->size = -1;
+		mafw_playlist_iterator_window_clear(iterator);
 	}
 }
 
@@ -453,9 +586,8 @@ mafw_playlist_iterator_move_to_index(MafwPlaylistIterator *iterator,
 			MAFW_PLAYLIST_ITERATOR_MOVE_RESULT_LIMIT;
 	} else {
 		gchar *objectid =
-			mafw_playlist_get_item(iterator->priv->playlist,
-						index,
-						&new_error);
+			mafw_playlist_iterator_get_item(iterator, index,
+							 &new_error);
 
 		if (new_error != NULL) {
 			g_propagate_error(error, new_error);
@@ -476,9 +608,9 @@ mafw_playlist_iterator_update(MafwPlaylistIterator *iterator, GError **error)
 	gchar *objectid = NULL;
 
 	objectid =
-		mafw_playlist_get_item(iterator->priv->playlist,
-					iterator->priv->current_index,
-					&new_error);
+		mafw_playlist_iterator_get_item(iterator,
+						 iterator->priv->current_index,
+						 &new_error);
 
 	if (new_error != NULL) {
 		g_propagate_error(error, new_error);
@@ -489,6 +621,40 @@ mafw_playlist_iterator_update(MafwPlaylistIterator *iterator, GError **error)
 	}
 }
 
+/*
+ * Returns the object id of the item mafw_playlist_iterator_move_to_next()
+ * would move to, and its index in @index, without moving.  Returns NULL at
+ * the end of the playlist.
+ */
+gchar *
+mafw_playlist_iterator_peek_next(MafwPlaylistIterator *iterator,
+				  gint *index, GError **error)
+{
+	gint next_index;
+	gchar *objectid = NULL;
+	GError *new_error = NULL;
+
+	g_return_val_if_fail(mafw_playlist_iterator_is_valid(iterator), NULL);
+
+	next_index = iterator->priv->current_index;
+
+	if (!mafw_playlist_get_next(iterator->priv->playlist,
+				    (guint *) &next_index, &objectid,
+				    &new_error) || new_error != NULL) {
+		if (new_error != NULL) {
+			g_propagate_error(error, new_error);
+		}
+		g_free(objectid);
+		return NULL;
+	}
+
+	if (index != NULL) {
+		*index = next_index;
+	}
+
+	return objectid;
+}
+
 const gchar *
 mafw_playlist_iterator_get_current_objectid(MafwPlaylistIterator *iterator)
 {
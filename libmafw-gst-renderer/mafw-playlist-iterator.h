@@ -88,6 +88,8 @@ MafwPlaylistIteratorMovementResult mafw_playlist_iterator_move_to_index(MafwPlay
 									  GError **error);
 void mafw_playlist_iterator_update(MafwPlaylistIterator *iterator, GError **error);
 const gchar *mafw_playlist_iterator_get_current_objectid(MafwPlaylistIterator *iterator);
+gchar *mafw_playlist_iterator_peek_next(MafwPlaylistIterator *iterator,
+					gint *index, GError **error);
 gint mafw_playlist_iterator_get_current_index(MafwPlaylistIterator *iterator);
 gint mafw_playlist_iterator_get_size(MafwPlaylistIterator *iterator,
 				      GError **error);
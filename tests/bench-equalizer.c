@@ -0,0 +1,417 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Throughput benchmark of the renderer equalizer against the stock
+ * equalizer-10bands element.  Each run pushes the same amount of pink noise
+ * through audiotestsrc ! capsfilter ! <equalizer> ! fakesink as fast as
+ * possible and reports the processed samples per second.
+ *
+ * Then it runs the kernels alone on parametric layouts of growing size and
+ * reports the cost of each band, to size the layouts the device can afford,
+ * and the partitioned convolution on impulse responses of growing length,
+ * and the limiter on a signal loud enough to keep it busy.
+ *
+ * Usage: bench-equalizer [seconds-of-audio]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <glib.h>
+#include <gst/gst.h>
+
+#include "mafw-gst-renderer-equalizer.h"
+#include "mafw-gst-renderer-convolver-dsp.h"
+#include "mafw-gst-renderer-limiter-dsp.h"
+
+#define BENCH_RATE		44100
+#define BENCH_CHANNELS		2
+#define BENCH_SAMPLES_PER_BUFFER	1024
+
+/* A boosted, non-flat curve so that no band is skipped */
+static const gdouble bench_gains[EQ_DSP_NUM_BANDS] = {
+	8.0, 6.0, 4.0, 1.0, -2.0, -3.0, 1.0, 4.0, 6.0, 7.0
+};
+
+static const gchar *bench_caps[] = {
+	"audio/x-raw-int, width=16, depth=16, signed=true, "
+	"endianness=BYTE_ORDER, rate=44100, channels=2",
+	"audio/x-raw-float, width=32, endianness=BYTE_ORDER, "
+	"rate=44100, channels=2",
+	NULL
+};
+
+static const gchar *bench_format_names[] = { "int16", "float32" };
+
+/* Layout sizes measured by _bench_bands() */
+static const gint bench_band_counts[] = { 1, 2, 4, 8, 10, 16, 24, 31, 32 };
+
+/* Impulse response lengths and partition sizes measured by
+ * _bench_convolver() */
+static const gint bench_taps[] = { 1024, 4096, 16384, 32768 };
+static const gint bench_blocks[] = { 128, 256, 512 };
+
+static GstElement *_make_equalizer(gboolean stock)
+{
+	GstElement *eq;
+	gchar *name;
+	gint i;
+
+	if (stock)
+		eq = gst_element_factory_make("equalizer-10bands", NULL);
+	else
+		eq = mafw_gst_renderer_equalizer_new();
+	if (!eq)
+		return NULL;
+
+	for (i = 0; i < EQ_DSP_NUM_BANDS; i++) {
+		name = g_strdup_printf("band%d", i);
+		g_object_set(eq, name, bench_gains[i], NULL);
+		g_free(name);
+	}
+	return eq;
+}
+
+/* Returns the wall clock time spent, or a negative value on failure */
+static gdouble _run(GstElement *eq, const gchar *caps_str, gint buffers)
+{
+	GstElement *pipeline, *src, *filter, *sink;
+	GstCaps *caps;
+	GstBus *bus;
+	GstMessage *msg;
+	GTimer *timer;
+	gdouble elapsed = -1.0;
+
+	pipeline = gst_pipeline_new("bench");
+	src = gst_element_factory_make("audiotestsrc", NULL);
+	filter = gst_element_factory_make("capsfilter", NULL);
+	sink = gst_element_factory_make("fakesink", NULL);
+	if (!src || !filter || !sink) {
+		g_printerr("audiotestsrc, capsfilter and fakesink are "
+			   "needed\n");
+		exit(EXIT_FAILURE);
+	}
+
+	caps = gst_caps_from_string(caps_str);
+	g_object_set(filter, "caps", caps, NULL);
+	gst_caps_unref(caps);
+	g_object_set(src, "wave", 5 /* pink noise */,
+		     "num-buffers", buffers,
+		     "samplesperbuffer", BENCH_SAMPLES_PER_BUFFER,
+		     "is-live", FALSE, NULL);
+	g_object_set(sink, "sync", FALSE, NULL);
+
+	gst_bin_add_many(GST_BIN(pipeline), src, filter, eq, sink, NULL);
+	if (!gst_element_link_many(src, filter, eq, sink, NULL))
+		goto out;
+
+	/* Preroll first so that setup costs are not measured */
+	gst_element_set_state(pipeline, GST_STATE_PAUSED);
+	gst_element_get_state(pipeline, NULL, NULL, GST_CLOCK_TIME_NONE);
+
+	bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline));
+	timer = g_timer_new();
+	gst_element_set_state(pipeline, GST_STATE_PLAYING);
+	msg = gst_bus_timed_pop_filtered(bus, GST_CLOCK_TIME_NONE,
+					 GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+	g_timer_stop(timer);
+	if (msg && GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS)
+		elapsed = g_timer_elapsed(timer, NULL);
+	if (msg)
+		gst_message_unref(msg);
+	g_timer_destroy(timer);
+	gst_object_unref(bus);
+
+out:
+	gst_element_set_state(pipeline, GST_STATE_NULL);
+	gst_object_unref(pipeline);
+	return elapsed;
+}
+
+/* Peaks spread evenly in log scale from 30 Hz to 16 kHz */
+static void _make_layout(EqDspLayout *layout, gdouble *gains, gint n_bands)
+{
+	gint i;
+
+	layout->n_bands = n_bands;
+	for (i = 0; i < n_bands; i++) {
+		layout->bands[i].type = EQ_DSP_FILTER_PEAK;
+		layout->bands[i].freq = n_bands > 1 ?
+			30.0 * pow(16000.0 / 30.0, (gdouble) i / (n_bands - 1)) :
+			1000.0;
+		layout->bands[i].q = 2.0;
+		gains[i] = (i & 1) ? -3.0 : 4.0;
+	}
+}
+
+/* Times the int16 (float and fixed point) and float32 kernels alone on
+ * @frames stereo frames.  Each block is refilled from the same noise first,
+ * since filtering a buffer over and over would drift to overflows or
+ * denormals */
+static void _bench_bands(gint frames)
+{
+	EqDspLayout layout;
+	EqDspBiquad bq[EQ_DSP_MAX_BANDS];
+	EqDspState state;
+	gdouble gains[EQ_DSP_MAX_BANDS];
+	gint16 *noise_s16, *s16;
+	gfloat *noise_f32, *f32;
+	GTimer *timer;
+	gdouble t_s16, t_fixed, t_f32;
+	gint i, j, n_bands, block;
+
+	noise_s16 = g_new(gint16, BENCH_SAMPLES_PER_BUFFER * BENCH_CHANNELS);
+	noise_f32 = g_new(gfloat, BENCH_SAMPLES_PER_BUFFER * BENCH_CHANNELS);
+	s16 = g_new(gint16, BENCH_SAMPLES_PER_BUFFER * BENCH_CHANNELS);
+	f32 = g_new(gfloat, BENCH_SAMPLES_PER_BUFFER * BENCH_CHANNELS);
+	for (j = 0; j < BENCH_SAMPLES_PER_BUFFER * BENCH_CHANNELS; j++) {
+		noise_s16[j] = g_random_int_range(-8192, 8192);
+		noise_f32[j] = noise_s16[j] / 32768.0f;
+	}
+	timer = g_timer_new();
+
+	g_print("\n%-6s %14s %14s %14s %14s\n", "bands", "int16 ns/frame",
+		"fixed ns/frame", "float ns/frame", "ns/band/frame");
+
+	for (i = 0; i < G_N_ELEMENTS(bench_band_counts); i++) {
+		n_bands = bench_band_counts[i];
+		_make_layout(&layout, gains, n_bands);
+		eq_dsp_design_layout(bq, &layout, gains, BENCH_RATE);
+
+		eq_dsp_reset(&state);
+		g_timer_start(timer);
+		for (j = 0; j < frames; j += block) {
+			block = MIN(BENCH_SAMPLES_PER_BUFFER, frames - j);
+			memcpy(s16, noise_s16,
+			       block * BENCH_CHANNELS * sizeof(gint16));
+			eq_dsp_process_s16(bq, n_bands, &state, s16, block,
+					   BENCH_CHANNELS);
+		}
+		t_s16 = g_timer_elapsed(timer, NULL);
+
+		eq_dsp_reset(&state);
+		g_timer_start(timer);
+		for (j = 0; j < frames; j += block) {
+			block = MIN(BENCH_SAMPLES_PER_BUFFER, frames - j);
+			memcpy(s16, noise_s16,
+			       block * BENCH_CHANNELS * sizeof(gint16));
+			eq_dsp_process_s16_fixed(bq, n_bands, &state, s16,
+						 block, BENCH_CHANNELS);
+		}
+		t_fixed = g_timer_elapsed(timer, NULL);
+
+		eq_dsp_reset(&state);
+		g_timer_start(timer);
+		for (j = 0; j < frames; j += block) {
+			block = MIN(BENCH_SAMPLES_PER_BUFFER, frames - j);
+			memcpy(f32, noise_f32,
+			       block * BENCH_CHANNELS * sizeof(gfloat));
+			eq_dsp_process_float(bq, n_bands, &state, f32, block,
+					     BENCH_CHANNELS);
+		}
+		t_f32 = g_timer_elapsed(timer, NULL);
+
+		g_print("%-6d %14.2f %14.2f %14.2f %14.2f\n", n_bands,
+			t_s16 * 1e9 / frames, t_fixed * 1e9 / frames,
+			t_f32 * 1e9 / frames, t_f32 * 1e9 / frames / n_bands);
+	}
+
+	g_timer_destroy(timer);
+	g_free(noise_s16);
+	g_free(noise_f32);
+	g_free(s16);
+	g_free(f32);
+}
+
+/* Times the stereo partitioned convolution alone on @frames frames */
+static void _bench_convolver(gint frames)
+{
+	EqConvFilter *filter;
+	EqConv *conv;
+	gfloat *ir;
+	GTimer *timer;
+	gdouble elapsed;
+	gint t, b, i, j, block;
+
+	timer = g_timer_new();
+
+	g_print("\n%-6s %-6s %12s %12s\n", "taps", "block", "latency ms",
+		"x realtime");
+
+	for (t = 0; t < G_N_ELEMENTS(bench_taps); t++) {
+		ir = g_new(gfloat, bench_taps[t]);
+		for (i = 0; i < bench_taps[t]; i++)
+			ir[i] = g_random_double_range(-1.0, 1.0) *
+				exp(-4.0 * i / bench_taps[t]);
+
+		for (b = 0; b < G_N_ELEMENTS(bench_blocks); b++) {
+			block = bench_blocks[b];
+			filter = eq_conv_filter_new(ir, bench_taps[t], 1,
+						    block);
+			conv = eq_conv_new(block, BENCH_CHANNELS,
+					   EQ_CONV_MAX_TAPS / block);
+			for (i = 0; i < BENCH_CHANNELS * 2 * block; i++)
+				conv->input[i] =
+					g_random_double_range(-0.5, 0.5);
+
+			g_timer_start(timer);
+			for (j = 0; j < frames; j += block) {
+				/* Keep feeding the same noise */
+				for (i = 0; i < BENCH_CHANNELS; i++) {
+					memcpy(conv->input + (2 * i + 1) * block,
+					       conv->input + 2 * i * block,
+					       block * sizeof(gfloat));
+				}
+				eq_conv_process(conv, filter, NULL);
+			}
+			elapsed = g_timer_elapsed(timer, NULL);
+
+			g_print("%-6d %-6d %12.1f %12.1f\n", bench_taps[t],
+				block, 1000.0 * block / BENCH_RATE,
+				(gdouble) frames / BENCH_RATE / elapsed);
+
+			eq_conv_free(conv);
+			eq_conv_filter_free(filter);
+		}
+		g_free(ir);
+	}
+
+	g_timer_destroy(timer);
+}
+
+/* Times the stereo limiter alone on @frames frames of noise peaking 6 dB
+ * over full scale */
+static void _bench_limiter(gint frames)
+{
+	EqLimiter *lim;
+	gfloat *noise, *f32;
+	gint16 *noise_s16, *s16;
+	GTimer *timer;
+	gdouble elapsed[2];
+	gint i, j, n, samples;
+
+	samples = BENCH_SAMPLES_PER_BUFFER * BENCH_CHANNELS;
+	noise = g_new(gfloat, samples);
+	noise_s16 = g_new(gint16, samples);
+	f32 = g_new(gfloat, samples);
+	s16 = g_new(gint16, samples);
+	for (i = 0; i < samples; i++) {
+		noise[i] = g_random_double_range(-2.0, 2.0);
+		noise_s16[i] = g_random_int_range(G_MININT16, G_MAXINT16);
+	}
+
+	timer = g_timer_new();
+	lim = eq_limiter_new(BENCH_CHANNELS, BENCH_RATE * 2 / 1000);
+	eq_limiter_set_threshold(lim, -0.3);
+	eq_limiter_set_release(lim, 50, BENCH_RATE);
+
+	for (n = 0; n < 2; n++) {
+		eq_limiter_reset(lim);
+		g_timer_start(timer);
+		for (j = 0; j < frames; j += BENCH_SAMPLES_PER_BUFFER) {
+			if (n == 0) {
+				memcpy(s16, noise_s16, samples * sizeof(gint16));
+				eq_limiter_process_s16(lim, s16,
+						       BENCH_SAMPLES_PER_BUFFER);
+			} else {
+				memcpy(f32, noise, samples * sizeof(gfloat));
+				eq_limiter_process_float(
+					lim, f32, BENCH_SAMPLES_PER_BUFFER);
+			}
+		}
+		elapsed[n] = g_timer_elapsed(timer, NULL);
+	}
+
+	g_print("\n%-8s %12s %12s\n", "limiter", "ns/frame", "x realtime");
+	for (n = 0; n < 2; n++) {
+		g_print("%-8s %12.1f %12.1f\n", bench_format_names[n],
+			elapsed[n] * 1e9 / frames,
+			(gdouble) frames / BENCH_RATE / elapsed[n]);
+	}
+
+	eq_limiter_free(lim);
+	g_timer_destroy(timer);
+	g_free(noise);
+	g_free(noise_s16);
+	g_free(f32);
+	g_free(s16);
+}
+
+int main(int argc, char *argv[])
+{
+	gint seconds = 600, buffers, f, stock;
+	gdouble elapsed, samples, results[2];
+	GstElement *eq;
+
+	gst_init(&argc, &argv);
+	if (argc > 1)
+		seconds = MAX(1, atoi(argv[1]));
+
+	buffers = seconds * BENCH_RATE / BENCH_SAMPLES_PER_BUFFER;
+	samples = (gdouble) buffers * BENCH_SAMPLES_PER_BUFFER *
+		BENCH_CHANNELS;
+
+	g_print("%d s of %d Hz stereo audio, %d frames per buffer\n\n",
+		seconds, BENCH_RATE, BENCH_SAMPLES_PER_BUFFER);
+	g_print("%-8s %-20s %12s %12s\n", "format", "element",
+		"Msamples/s", "x realtime");
+
+	for (f = 0; bench_caps[f] != NULL; f++) {
+		for (stock = 1; stock >= 0; stock--) {
+			const gchar *name = stock ? "equalizer-10bands" :
+				"renderer equalizer";
+
+			results[stock] = -1.0;
+			eq = _make_equalizer(stock);
+			if (!eq) {
+				g_print("%-8s %-20s %12s\n",
+					bench_format_names[f], name,
+					"unavailable");
+				continue;
+			}
+			elapsed = _run(eq, bench_caps[f], buffers);
+			if (elapsed <= 0.0) {
+				g_print("%-8s %-20s %12s\n",
+					bench_format_names[f], name, "failed");
+				continue;
+			}
+			results[stock] = elapsed;
+			g_print("%-8s %-20s %12.2f %12.1f\n",
+				bench_format_names[f], name,
+				samples / elapsed / 1e6, seconds / elapsed);
+		}
+		if (results[0] > 0.0 && results[1] > 0.0)
+			g_print("%-8s speedup %.2fx\n", bench_format_names[f],
+				results[1] / results[0]);
+	}
+
+	_bench_bands(MIN(seconds, 60) * BENCH_RATE);
+	_bench_convolver(MIN(seconds, 60) * BENCH_RATE);
+	_bench_limiter(MIN(seconds, 60) * BENCH_RATE);
+
+	return EXIT_SUCCESS;
+}
+
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
@@ -0,0 +1,144 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Cost of a storm of playlist edits on the renderer.  A script of random
+ * inserts and removals, the same on every run, is replayed on the playlist
+ * assigned to a renderer, letting the main loop run every so many edits,
+ * as it would between the batches of signals coming from the playlist
+ * daemon.  Edits received within a batch are applied together, so the
+ * bigger the batches, the fewer media changes the renderer goes through.
+ *
+ * Usage: bench-playlist-edits [edits]
+ */
+
+#include <stdlib.h>
+#include <glib.h>
+#include <gst/gst.h>
+#include <libmafw/mafw.h>
+
+#include "mafw-gst-renderer.h"
+#include "mafw-mock-playlist.h"
+
+#define DEFAULT_EDITS		10000
+#define SCRIPT_SEED		20100301
+
+static guint media_changes;
+
+static void _media_changed_cb(MafwRenderer *renderer, gint index,
+			      gchar *objectid, gpointer user_data)
+{
+	media_changes++;
+}
+
+static void _run_main_loop(void)
+{
+	while (g_main_context_iteration(NULL, FALSE));
+}
+
+/* Replays @edits edits on a new playlist assigned to @renderer, running the
+ * main loop every @batch of them; returns the time taken in milliseconds */
+static gdouble _run(MafwRenderer *renderer, gint edits, gint batch)
+{
+	MafwPlaylist *playlist;
+	GRand *rand;
+	GTimer *timer;
+	gchar *objectid;
+	gdouble ms;
+	guint size = 0;
+	gint i;
+
+	playlist = MAFW_PLAYLIST(mafw_mock_playlist_new());
+	mafw_renderer_assign_playlist(renderer, playlist, NULL);
+	_run_main_loop();
+	media_changes = 0;
+
+	rand = g_rand_new_with_seed(SCRIPT_SEED);
+	timer = g_timer_new();
+	for (i = 0; i < edits; i++) {
+		/* Two inserts for every removal */
+		if (size == 0 || g_rand_int_range(rand, 0, 3) > 0) {
+			objectid = g_strdup_printf("bench::item%d", i);
+			mafw_playlist_insert_item(
+				playlist, g_rand_int_range(rand, 0, size + 1),
+				objectid, NULL);
+			g_free(objectid);
+			size++;
+		} else {
+			mafw_playlist_remove_item(
+				playlist, g_rand_int_range(rand, 0, size),
+				NULL);
+			size--;
+		}
+
+		if ((i + 1) % batch == 0)
+			_run_main_loop();
+	}
+	_run_main_loop();
+	ms = 1000.0 * g_timer_elapsed(timer, NULL);
+
+	g_timer_destroy(timer);
+	g_rand_free(rand);
+	mafw_renderer_assign_playlist(renderer, NULL, NULL);
+	g_object_unref(playlist);
+
+	return ms;
+}
+
+int main(int argc, char *argv[])
+{
+	static const gint batches[] = { 1, 10, 100, 1000 };
+	MafwRenderer *renderer;
+	gint edits = DEFAULT_EDITS;
+	gdouble ms;
+	guint i;
+
+	gst_init(&argc, &argv);
+	if (argc > 1)
+		edits = MAX(1, atoi(argv[1]));
+
+	renderer = MAFW_RENDERER(mafw_gst_renderer_new(
+					 MAFW_REGISTRY(
+						 mafw_registry_get_instance())));
+	if (renderer == NULL)
+		return EXIT_FAILURE;
+	g_signal_connect(renderer, "media-changed",
+			 G_CALLBACK(_media_changed_cb), NULL);
+
+	g_print("%d playlist edits\n\n", edits);
+	g_print("%-12s %12s %12s %14s\n", "batch", "total ms", "per edit us",
+		"media changes");
+
+	for (i = 0; i < G_N_ELEMENTS(batches); i++) {
+		ms = _run(renderer, edits, batches[i]);
+		g_print("%-12d %12.1f %12.3f %14u\n", batches[i], ms,
+			1000.0 * ms / edits, media_changes);
+	}
+
+	g_object_unref(renderer);
+
+	return EXIT_SUCCESS;
+}
+
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
@@ -0,0 +1,161 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Cost of going through the entries of a playlist file in the worker.  A
+ * playlist of missing files is given to mafw_gst_renderer_worker_play(),
+ * so that every entry fails at once and the worker moves on to the next
+ * one, as it does on an error or an end of stream, until the last one
+ * fails and the error is notified.  Playlists of a hundredth, a tenth and
+ * all of the entries are run: if the bookkeeping is linear, the time per
+ * entry stays the same.
+ *
+ * Usage: bench-playlist [entries]
+ */
+
+#include <stdlib.h>
+#include <glib.h>
+#include <gst/gst.h>
+#include <libmafw/mafw.h>
+
+#include "mafw-gst-renderer.h"
+#include "mafw-gst-renderer-worker.h"
+
+#define DEFAULT_ENTRIES		100000
+
+/* Longest wait for an entry to fail, in milliseconds */
+#define ENTRY_TIMEOUT		100
+
+static GMainLoop *bench_loop;
+static gboolean bench_done;
+
+static void _error_cb(MafwGstRendererWorker *worker, gpointer owner,
+		      const GError *error)
+{
+	bench_done = TRUE;
+	g_main_loop_quit(bench_loop);
+}
+
+static gboolean _timeout_cb(gpointer data)
+{
+	g_main_loop_quit(bench_loop);
+	return FALSE;
+}
+
+/* Plays a playlist of @entries missing files through; returns the time
+ * taken in milliseconds, or a negative one if the worker got stuck */
+static gdouble _run(MafwRenderer *owner, const gchar *dir, gint entries)
+{
+	MafwGstRendererWorker *worker;
+	GSList *items = NULL;
+	GTimer *timer;
+	gchar *path;
+	gdouble ms;
+	guint timeout_id;
+	gint i;
+
+	for (i = entries - 1; i >= 0; i--) {
+		path = g_strdup_printf("%s/missing-%06d.wav", dir, i);
+		items = g_slist_prepend(items,
+					g_filename_to_uri(path, NULL, NULL));
+		g_free(path);
+	}
+
+	/* The owner only gets the metadata the worker emits */
+	worker = mafw_gst_renderer_worker_new(owner);
+	worker->notify_error_handler = _error_cb;
+
+	bench_done = FALSE;
+	timeout_id = g_timeout_add(entries * ENTRY_TIMEOUT, _timeout_cb, NULL);
+	timer = g_timer_new();
+	mafw_gst_renderer_worker_play(worker, NULL, items);
+	g_main_loop_run(bench_loop);
+	ms = 1000.0 * g_timer_elapsed(timer, NULL);
+	g_timer_destroy(timer);
+
+	if (bench_done)
+		g_source_remove(timeout_id);
+	else
+		ms = -1.0;
+
+	mafw_gst_renderer_worker_stop(worker);
+	mafw_gst_renderer_worker_exit(worker);
+	g_free(worker);
+
+	return ms;
+}
+
+int main(int argc, char *argv[])
+{
+	static const gint fractions[] = { 100, 10, 1 };
+	MafwRenderer *owner;
+	gint entries = DEFAULT_ENTRIES, n;
+	guint i;
+	gdouble ms;
+	gchar *dir;
+
+	gst_init(&argc, &argv);
+	if (argc > 1)
+		entries = MAX(1, atoi(argv[1]));
+
+	dir = g_build_filename(g_getenv("TESTS_DIR") ?
+			       g_getenv("TESTS_DIR") : ".", "media", NULL);
+	if (!g_path_is_absolute(dir)) {
+		gchar *cwd = g_get_current_dir();
+		gchar *abs = g_build_filename(cwd, dir, NULL);
+
+		g_free(cwd);
+		g_free(dir);
+		dir = abs;
+	}
+
+	owner = MAFW_RENDERER(mafw_gst_renderer_new(
+				      MAFW_REGISTRY(
+					      mafw_registry_get_instance())));
+	if (owner == NULL)
+		return EXIT_FAILURE;
+	bench_loop = g_main_loop_new(NULL, FALSE);
+
+	g_print("%-12s %12s %12s\n", "entries", "total ms", "per entry us");
+
+	for (i = 0; i < G_N_ELEMENTS(fractions); i++) {
+		n = entries / fractions[i];
+		if (n == 0)
+			continue;
+		ms = _run(owner, dir, n);
+		if (ms < 0.0) {
+			g_print("%-12d %12s\n", n, "failed");
+			break;
+		}
+		g_print("%-12d %12.1f %12.3f\n", n, ms, 1000.0 * ms / n);
+	}
+
+	g_main_loop_unref(bench_loop);
+	g_object_unref(owner);
+	g_free(dir);
+
+	return EXIT_SUCCESS;
+}
+
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
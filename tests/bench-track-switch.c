@@ -0,0 +1,179 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Track switch latency of the worker, reusing its pipeline across media
+ * and building a new one for each.  Every switch is a
+ * mafw_gst_renderer_worker_stop() followed by a
+ * mafw_gst_renderer_worker_play() of the next media, timed up to the
+ * notification that it plays.  The worker times the same switches from
+ * the stop to the preroll, and those figures are printed along.
+ *
+ * Usage: bench-track-switch [switches]
+ *
+ * The media is $TESTS_DIR/media/test.wav, played on the sinks the worker
+ * makes for itself.
+ */
+
+#include <stdlib.h>
+#include <glib.h>
+#include <gst/gst.h>
+#include <libmafw/mafw.h>
+
+#include "mafw-gst-renderer.h"
+#include "mafw-gst-renderer-worker.h"
+
+#define DEFAULT_SWITCHES	50
+
+/* Longest wait for a media to play, in milliseconds */
+#define PLAY_TIMEOUT		5000
+
+static gchar *bench_uri;
+static GMainLoop *bench_loop;
+static gboolean bench_playing;
+
+static void _play_cb(MafwGstRendererWorker *worker, gpointer owner)
+{
+	bench_playing = TRUE;
+	g_main_loop_quit(bench_loop);
+}
+
+static void _error_cb(MafwGstRendererWorker *worker, gpointer owner,
+		      const GError *error)
+{
+	g_printerr("%s\n", error->message);
+	g_main_loop_quit(bench_loop);
+}
+
+static gboolean _timeout_cb(gpointer data)
+{
+	g_main_loop_quit(bench_loop);
+	return FALSE;
+}
+
+/* Plays the media on @worker and waits until it does */
+static gboolean _play(MafwGstRendererWorker *worker)
+{
+	guint timeout_id;
+
+	bench_playing = FALSE;
+	timeout_id = g_timeout_add(PLAY_TIMEOUT, _timeout_cb, NULL);
+	mafw_gst_renderer_worker_play(worker, bench_uri, NULL);
+	g_main_loop_run(bench_loop);
+	if (bench_playing)
+		g_source_remove(timeout_id);
+
+	return bench_playing;
+}
+
+/* Runs @switches track switches; returns the mean and the longest one in
+ * milliseconds, or FALSE if a media did not play */
+static gboolean _run(MafwRenderer *owner, gboolean reuse, gint switches,
+		     gdouble *mean, gdouble *max, gdouble *preroll)
+{
+	MafwGstRendererWorker *worker;
+	GTimer *timer;
+	gdouble ms, total = 0.0;
+	gboolean ok;
+	gint i;
+
+	/* The owner only gets the metadata the worker emits */
+	worker = mafw_gst_renderer_worker_new(owner);
+	worker->notify_play_handler = _play_cb;
+	worker->notify_error_handler = _error_cb;
+	mafw_gst_renderer_worker_set_reuse_pipeline(worker, reuse);
+
+	ok = _play(worker);
+
+	timer = g_timer_new();
+	*max = 0.0;
+	for (i = 0; i < switches && ok; i++) {
+		g_timer_start(timer);
+		mafw_gst_renderer_worker_stop(worker);
+		ok = _play(worker);
+		ms = 1000.0 * g_timer_elapsed(timer, NULL);
+		total += ms;
+		*max = MAX(*max, ms);
+	}
+	*mean = total / switches;
+	*preroll = worker->switch_count > 0 ?
+		worker->switch_total / worker->switch_count : 0.0;
+	g_timer_destroy(timer);
+
+	mafw_gst_renderer_worker_stop(worker);
+	mafw_gst_renderer_worker_exit(worker);
+	g_free(worker);
+
+	return ok;
+}
+
+int main(int argc, char *argv[])
+{
+	MafwRenderer *owner;
+	gint switches = DEFAULT_SWITCHES, reuse;
+	gdouble mean, max, preroll;
+	gchar *path;
+	const gchar *dir;
+
+	gst_init(&argc, &argv);
+	if (argc > 1)
+		switches = MAX(1, atoi(argv[1]));
+
+	dir = g_getenv("TESTS_DIR");
+	path = g_build_filename(dir ? dir : ".", "media", "test.wav", NULL);
+	bench_uri = g_filename_to_uri(path, NULL, NULL);
+	g_free(path);
+	if (!bench_uri)
+		return EXIT_FAILURE;
+
+	owner = MAFW_RENDERER(mafw_gst_renderer_new(
+				      MAFW_REGISTRY(
+					      mafw_registry_get_instance())));
+	if (owner == NULL)
+		return EXIT_FAILURE;
+	bench_loop = g_main_loop_new(NULL, FALSE);
+
+	g_print("%d switches of %s\n\n", switches, bench_uri);
+	g_print("%-12s %12s %12s %16s\n", "pipeline", "mean ms", "max ms",
+		"to preroll ms");
+
+	for (reuse = 0; reuse < 2; reuse++) {
+		const gchar *name = reuse ? "reused" : "rebuilt";
+
+		if (!_run(owner, reuse, switches, &mean, &max, &preroll)) {
+			g_print("%-12s %12s\n", name, "failed");
+			continue;
+		}
+		g_print("%-12s %12.1f %12.1f %16.1f\n", name, mean, max,
+			preroll);
+	}
+
+	g_main_loop_unref(bench_loop);
+	g_object_unref(owner);
+	g_free(bench_uri);
+
+	return EXIT_SUCCESS;
+}
+
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
@@ -0,0 +1,1213 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * check-equalizer.c
+ *
+ * Equalizer kernel regression tests.  The fixed point and float kernels
+ * are run against a double precision run of the same filters on a corpus
+ * of curves of the default layout, sample rates and test signals, all
+ * processed in buffers as the element does, and the float kernel against
+ * a scalar run of the same filters.  The partitioned
+ * convolution is checked against a direct one.  Then the preamp and the
+ * limiter are checked to keep boosted curves from clipping, the
+ * crossfade ramps to give every frame its gain, and band layouts to be
+ * parsed or rejected as a whole.  The coefficient cache is checked to
+ * find known curves and to tell apart any other.  Last, buffers are pushed
+ * through the element itself to check that it stays out of the way while
+ * the curve is flat, ramps its coefficients on curve changes and skips
+ * silence, and denormals are checked not to linger in the history.
+ */
+
+#include <glib.h>
+#include <check.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <gst/gst.h>
+#include <gst/audio/gstringbuffer.h>
+
+#include "mafw-gst-renderer-equalizer.h"
+#include "mafw-gst-renderer-equalizer-dsp.h"
+#include "mafw-gst-renderer-eq-layout.h"
+#include "mafw-gst-renderer-convolver-dsp.h"
+#include "mafw-gst-renderer-limiter-dsp.h"
+#include "mafw-gst-renderer-fader-dsp.h"
+#include "../constants.h"
+
+#undef  G_LOG_DOMAIN
+#define G_LOG_DOMAIN "check-equalizer"
+
+#define CHANNELS	2
+#define FRAMES		22050
+#define BUFFER_FRAMES	1024
+
+/* Level of the test signals, -18 dBFS, so the loudest curves do not clip */
+#define LEVEL		(32767.0 / 8)
+
+/* Biggest difference, in LSBs, allowed between the float kernel on int16
+ * samples and a double precision run of the same filters.  Most of it is
+ * the float32 rounding noise of the low bands */
+#define FLOAT_S16_MAX_ERROR 16
+
+/* Number of random curves in the corpus */
+#define RANDOM_CURVES	8
+
+/* Biggest difference, relative to full scale, allowed between the float
+ * kernel and a scalar run of the same filters */
+#define FLOAT_MAX_ERROR	1e-5
+
+/* Biggest difference, relative to full scale, allowed between the
+ * partitioned convolution and a direct one */
+#define CONV_MAX_ERROR	1e-4
+
+/* Caps the element is negotiated to */
+#define ELEMENT_CAPS	"audio/x-raw-int, width=16, depth=16, signed=true, " \
+			"endianness=BYTE_ORDER, rate=44100, channels=2"
+#define ELEMENT_RATE	44100
+
+/* Limiter settings of the element */
+#define LIMITER_LOOKAHEAD	(44100 * 2 / 1000)
+#define LIMITER_THRESHOLD	-0.3
+
+SRunner *configure_tests(void);
+
+static const gint rates[] = { 22050, 44100, 48000 };
+
+static const gdouble curves[][EQ_DSP_NUM_BANDS] = {
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+	{ 12, 12, 12, 12, 12, 12, 12, 12, 12, 12 },
+	{ -24, -24, -24, -24, -24, -24, -24, -24, -24, -24 },
+	{ 12, -24, 12, -24, 12, -24, 12, -24, 12, -24 },
+	{ 12, 9, 6, 3, 0, 0, 0, 0, 0, 0 },
+	{ 0, 0, 0, 0, 0, 0, 3, 6, 9, 12 },
+	{ 8, 6, 2, -2, -4, -4, -2, 2, 6, 8 },
+	{ -6, -4, -2, 2, 6, 6, 2, -2, -4, -6 },
+};
+
+typedef enum {
+	SIGNAL_NOISE,
+	SIGNAL_SWEEP,
+	SIGNAL_SQUARE,
+	SIGNAL_IMPULSES,
+	N_SIGNALS
+} Signal;
+
+static void _make_signal(gint16 *data, Signal signal, gint rate, GRand *rand)
+{
+	gdouble v, phase = 0.0;
+	gint i, c;
+
+	for (i = 0; i < FRAMES; i++) {
+		switch (signal) {
+		case SIGNAL_NOISE:
+			v = g_rand_double_range(rand, -1.0, 1.0);
+			break;
+		case SIGNAL_SWEEP:
+			/* 20 Hz to 20 kHz, logarithmic */
+			phase += 2.0 * G_PI * 20.0 *
+				pow(1000.0, (gdouble) i / FRAMES) / rate;
+			v = sin(phase);
+			break;
+		case SIGNAL_SQUARE:
+			v = (i / (rate / 882)) % 2 ? 1.0 : -1.0;
+			break;
+		case SIGNAL_IMPULSES:
+		default:
+			v = i % (rate / 10) == 0 ? 1.0 : 0.0;
+			break;
+		}
+		for (c = 0; c < CHANNELS; c++)
+			data[i * CHANNELS + c] = (gint16) lrint(v * LEVEL);
+	}
+}
+
+/* Runs the cascade in double precision, transposed direct form II */
+static void _process_reference(const EqDspBiquad *bq, gint n_bands,
+			       const gint16 *in, gint16 *out, gint frames,
+			       gint channels)
+{
+	gdouble z1[EQ_DSP_MAX_BANDS][EQ_DSP_MAX_CHANNELS];
+	gdouble z2[EQ_DSP_MAX_BANDS][EQ_DSP_MAX_CHANNELS];
+	gdouble x, y;
+	gint i, c, b;
+
+	memset(z1, 0, sizeof(z1));
+	memset(z2, 0, sizeof(z2));
+
+	for (i = 0; i < frames * channels; i++) {
+		c = i % channels;
+		x = in[i];
+		for (b = 0; b < n_bands; b++) {
+			y = bq[b].b0 * x + z1[b][c];
+			z1[b][c] = bq[b].b1 * x - bq[b].a1 * y + z2[b][c];
+			z2[b][c] = bq[b].b2 * x - bq[b].a2 * y;
+			x = y;
+		}
+		out[i] = (gint16) CLAMP(floor(x + 0.5), G_MININT16,
+					G_MAXINT16);
+	}
+}
+
+static gint _max_difference(const gint16 *a, const gint16 *b)
+{
+	gint i, max = 0;
+
+	for (i = 0; i < FRAMES * CHANNELS; i++)
+		max = MAX(max, ABS(a[i] - b[i]));
+	return max;
+}
+
+/* Runs @data through one of the kernels, one buffer at a time */
+static void _process_buffers(const EqDspBiquad *bq, gint n_bands,
+			     gint16 *data, gboolean fixed)
+{
+	EqDspState state;
+	gint i, n;
+
+	eq_dsp_reset(&state);
+	for (i = 0; i < FRAMES; i += n) {
+		n = MIN(BUFFER_FRAMES, FRAMES - i);
+		if (fixed) {
+			eq_dsp_process_s16_fixed(bq, n_bands, &state,
+						 data + i * CHANNELS, n,
+						 CHANNELS);
+		} else {
+			eq_dsp_process_s16(bq, n_bands, &state,
+					   data + i * CHANNELS, n, CHANNELS);
+		}
+	}
+}
+
+static void _check_curve(const EqDspLayout *layout, const gdouble *gains,
+			 GRand *rand)
+{
+	EqDspBiquad bq[EQ_DSP_MAX_BANDS];
+	gint16 *in, *fixed, *flt, *ref;
+	gint r, s, err;
+
+	in = g_new(gint16, FRAMES * CHANNELS);
+	fixed = g_new(gint16, FRAMES * CHANNELS);
+	flt = g_new(gint16, FRAMES * CHANNELS);
+	ref = g_new(gint16, FRAMES * CHANNELS);
+
+	for (r = 0; r < G_N_ELEMENTS(rates); r++) {
+		eq_dsp_design_layout(bq, layout, gains, rates[r]);
+		for (s = 0; s < N_SIGNALS; s++) {
+			_make_signal(in, s, rates[r], rand);
+			memcpy(fixed, in, FRAMES * CHANNELS * sizeof(gint16));
+			memcpy(flt, in, FRAMES * CHANNELS * sizeof(gint16));
+
+			_process_buffers(bq, layout->n_bands, fixed, TRUE);
+			_process_buffers(bq, layout->n_bands, flt, FALSE);
+			_process_reference(bq, layout->n_bands, in, ref,
+					   FRAMES, CHANNELS);
+
+			err = _max_difference(fixed, ref);
+			fail_if(err > EQ_DSP_FIXED_MAX_ERROR,
+				"Fixed point kernel %d LSBs away from the "
+				"reference (signal %d at %d Hz)", err, s,
+				rates[r]);
+
+			err = _max_difference(flt, ref);
+			fail_if(err > FLOAT_S16_MAX_ERROR,
+				"Float kernel %d LSBs away from the "
+				"reference (signal %d at %d Hz)", err, s,
+				rates[r]);
+		}
+	}
+
+	g_free(in);
+	g_free(fixed);
+	g_free(flt);
+	g_free(ref);
+}
+
+START_TEST(test_fixed_point_corpus)
+{
+	EqDspLayout layout;
+	gdouble gains[EQ_DSP_MAX_BANDS];
+	GRand *rand;
+	gint i, b;
+
+	eq_layout_init_default(&layout);
+	rand = g_rand_new_with_seed(1);
+
+	for (i = 0; i < G_N_ELEMENTS(curves); i++) {
+		memset(gains, 0, sizeof(gains));
+		memcpy(gains, curves[i], sizeof(curves[i]));
+		_check_curve(&layout, gains, rand);
+	}
+
+	for (i = 0; i < RANDOM_CURVES; i++) {
+		memset(gains, 0, sizeof(gains));
+		for (b = 0; b < layout.n_bands; b++) {
+			gains[b] = g_rand_int_range(rand, EQ_GAIN_MIN,
+						    EQ_GAIN_MAX + 1);
+		}
+		_check_curve(&layout, gains, rand);
+	}
+
+	g_rand_free(rand);
+}
+END_TEST
+
+/* Out of range results must saturate, never wrap around */
+START_TEST(test_fixed_point_saturation)
+{
+	EqDspLayout layout;
+	EqDspState state;
+	EqDspBiquad bq[EQ_DSP_MAX_BANDS];
+	gdouble gains[EQ_DSP_MAX_BANDS];
+	gint16 in[BUFFER_FRAMES], fixed[BUFFER_FRAMES], ref[BUFFER_FRAMES];
+	gint i;
+
+	eq_layout_init_default(&layout);
+	for (i = 0; i < EQ_DSP_MAX_BANDS; i++)
+		gains[i] = EQ_GAIN_MAX;
+	eq_dsp_design_layout(bq, &layout, gains, 44100);
+
+	for (i = 0; i < BUFFER_FRAMES; i++)
+		in[i] = (i / 50) % 2 ? G_MAXINT16 : G_MININT16;
+	memcpy(fixed, in, sizeof(in));
+
+	eq_dsp_reset(&state);
+	eq_dsp_process_s16_fixed(bq, layout.n_bands, &state, fixed,
+				 BUFFER_FRAMES, 1);
+	_process_reference(bq, layout.n_bands, in, ref, BUFFER_FRAMES, 1);
+
+	for (i = 0; i < BUFFER_FRAMES; i++) {
+		fail_if(ABS(fixed[i] - ref[i]) > EQ_DSP_FIXED_MAX_ERROR,
+			"Sample %d is %d instead of %d", i, fixed[i], ref[i]);
+	}
+}
+END_TEST
+
+/* Runs the cascade on float samples one at a time, in the order the
+ * vector kernel uses */
+static void _process_float_scalar(const EqDspBiquad *bq, gint n_bands,
+				  gfloat *data, gint frames, gint channels)
+{
+	gfloat z1[EQ_DSP_MAX_BANDS][EQ_DSP_MAX_CHANNELS];
+	gfloat z2[EQ_DSP_MAX_BANDS][EQ_DSP_MAX_CHANNELS];
+	gfloat x, y;
+	gint i, c, b;
+
+	memset(z1, 0, sizeof(z1));
+	memset(z2, 0, sizeof(z2));
+
+	for (i = 0; i < frames * channels; i++) {
+		c = i % channels;
+		x = data[i];
+		for (b = 0; b < n_bands; b++) {
+			y = bq[b].b0 * x + z1[b][c];
+			z1[b][c] = bq[b].b1 * x - bq[b].a1 * y + z2[b][c];
+			z2[b][c] = bq[b].b2 * x - bq[b].a2 * y;
+			x = y;
+		}
+		data[i] = x;
+	}
+}
+
+/* The float kernel, vectorized or not, on any channel count and buffer
+ * size, must give what the scalar code does */
+START_TEST(test_float_kernel)
+{
+	static const gint channel_counts[] = { 1, 2, 3, 6 };
+	EqDspLayout layout;
+	EqDspState state;
+	EqDspBiquad bq[EQ_DSP_MAX_BANDS];
+	gdouble gains[EQ_DSP_MAX_BANDS];
+	gfloat *simd, *ref;
+	GRand *rand;
+	gint i, n, k, ch, channels, err_at;
+	gfloat err;
+
+	eq_layout_init_default(&layout);
+	rand = g_rand_new_with_seed(4);
+	simd = g_new(gfloat, FRAMES * EQ_DSP_MAX_CHANNELS);
+	ref = g_new(gfloat, FRAMES * EQ_DSP_MAX_CHANNELS);
+
+	for (i = 0; i < G_N_ELEMENTS(curves); i++) {
+		memset(gains, 0, sizeof(gains));
+		memcpy(gains, curves[i], sizeof(curves[i]));
+		eq_dsp_design_layout(bq, &layout, gains, 44100);
+
+		for (ch = 0; ch < G_N_ELEMENTS(channel_counts); ch++) {
+			channels = channel_counts[ch];
+			for (k = 0; k < FRAMES * channels; k++) {
+				ref[k] = g_rand_double_range(rand, -0.125,
+							     0.125);
+			}
+			memcpy(simd, ref, FRAMES * channels * sizeof(gfloat));
+
+			/* Odd buffer sizes, so no frame count is special */
+			eq_dsp_reset(&state);
+			for (k = 0; k < FRAMES; k += n) {
+				n = MIN(BUFFER_FRAMES - 1, FRAMES - k);
+				eq_dsp_process_float(bq, layout.n_bands,
+						     &state,
+						     simd + k * channels, n,
+						     channels);
+			}
+			_process_float_scalar(bq, layout.n_bands, ref, FRAMES,
+					      channels);
+
+			err = 0.0f;
+			err_at = 0;
+			for (k = 0; k < FRAMES * channels; k++) {
+				if (fabsf(simd[k] - ref[k]) > err) {
+					err = fabsf(simd[k] - ref[k]);
+					err_at = k;
+				}
+			}
+			fail_if(err > FLOAT_MAX_ERROR,
+				"Float kernel off by %g at sample %d (curve "
+				"%d, %d channels, %s)", err, err_at, i,
+				channels,
+				eq_dsp_has_simd() ? "SIMD" : "scalar");
+		}
+	}
+
+	g_rand_free(rand);
+	g_free(simd);
+	g_free(ref);
+}
+END_TEST
+
+/* Convolves @in with @ir directly, in double precision */
+static void _convolve_direct(const gfloat *ir, gint taps, const gfloat *in,
+			     gfloat *out, gint frames)
+{
+	gdouble acc;
+	gint i, k;
+
+	for (i = 0; i < frames; i++) {
+		acc = 0.0;
+		for (k = 0; k < taps && k <= i; k++)
+			acc += (gdouble) ir[k] * in[i - k];
+		out[i] = acc;
+	}
+}
+
+/* The partitioned convolution must match a direct one for responses
+ * shorter, as long as and longer than a block, on every block size */
+START_TEST(test_convolver)
+{
+	static const gint blocks[] = { EQ_CONV_MIN_BLOCK, 256, 1024 };
+	static const gint tap_counts[] = { 1, 63, 64, 200, 1000, 5000 };
+	const gint channels = 2;
+	EqConvFilter *filter;
+	EqConv *conv;
+	gfloat *ir, *in, *ref, *out;
+	GRand *rand;
+	gint b, t, block, taps, frames, i, c;
+	gfloat err;
+
+	rand = g_rand_new_with_seed(5);
+
+	for (b = 0; b < G_N_ELEMENTS(blocks); b++) {
+		for (t = 0; t < G_N_ELEMENTS(tap_counts); t++) {
+			block = blocks[b];
+			taps = tap_counts[t];
+			frames = 8 * block + taps;
+			frames -= frames % block;
+
+			/* A decaying response for each channel */
+			ir = g_new(gfloat, channels * taps);
+			for (i = 0; i < channels * taps; i++) {
+				ir[i] = g_rand_double_range(rand, -1.0, 1.0) *
+					exp(-4.0 * (i % taps) / taps) / 8;
+			}
+			in = g_new(gfloat, channels * frames);
+			ref = g_new(gfloat, channels * frames);
+			out = g_new(gfloat, channels * frames);
+			for (i = 0; i < channels * frames; i++)
+				in[i] = g_rand_double_range(rand, -0.5, 0.5);
+			for (c = 0; c < channels; c++) {
+				_convolve_direct(ir + c * taps, taps,
+						 in + c * frames,
+						 ref + c * frames, frames);
+			}
+
+			filter = eq_conv_filter_new(ir, taps, channels, block);
+			conv = eq_conv_new(block, channels,
+					   filter->n_partitions);
+			for (i = 0; i < frames; i += block) {
+				for (c = 0; c < channels; c++) {
+					memcpy(conv->input + c * 2 * block +
+					       block, in + c * frames + i,
+					       block * sizeof(gfloat));
+				}
+				eq_conv_process(conv, filter, NULL);
+				for (c = 0; c < channels; c++) {
+					memcpy(out + c * frames + i,
+					       conv->output + c * block,
+					       block * sizeof(gfloat));
+				}
+			}
+
+			err = 0.0f;
+			for (i = 0; i < channels * frames; i++)
+				err = MAX(err, fabsf(out[i] - ref[i]));
+			fail_if(err > CONV_MAX_ERROR,
+				"Convolution of %d taps in blocks of %d off "
+				"by %g", taps, block, err);
+
+			eq_conv_free(conv);
+			eq_conv_filter_free(filter);
+			g_free(ir);
+			g_free(in);
+			g_free(ref);
+			g_free(out);
+		}
+	}
+
+	g_rand_free(rand);
+}
+END_TEST
+
+/* Once scaled by the preamp no curve of the corpus may boost any
+ * frequency */
+START_TEST(test_preamp)
+{
+	EqDspLayout layout;
+	EqDspBiquad bq[EQ_DSP_MAX_BANDS];
+	gdouble gains[EQ_DSP_MAX_BANDS], peak, w;
+	gint i, r, k;
+
+	eq_layout_init_default(&layout);
+
+	for (i = 0; i < G_N_ELEMENTS(curves); i++) {
+		memset(gains, 0, sizeof(gains));
+		memcpy(gains, curves[i], sizeof(curves[i]));
+		for (r = 0; r < G_N_ELEMENTS(rates); r++) {
+			eq_dsp_design_layout(bq, &layout, gains, rates[r]);
+			peak = eq_dsp_peak_gain(bq, layout.n_bands, rates[r]);
+			fail_if(peak < 1.0, "Peak gain %f below 1", peak);
+			eq_dsp_apply_preamp(bq, peak);
+
+			for (k = 1; k < 1000; k++) {
+				w = G_PI * k / 1000;
+				fail_if(eq_dsp_magnitude(bq, layout.n_bands, w) >
+					1.0 + 1e-3,
+					"Curve %d boosts %f Hz at %d Hz", i,
+					w * rates[r] / (2 * G_PI), rates[r]);
+			}
+		}
+	}
+}
+END_TEST
+
+/* Peaks way over full scale must come out at the threshold at most */
+START_TEST(test_limiter_peaks)
+{
+	EqLimiter *lim;
+	gfloat *f32;
+	gint16 *s16;
+	GRand *rand;
+	gfloat threshold;
+	gint i, n;
+
+	rand = g_rand_new_with_seed(2);
+	f32 = g_new(gfloat, FRAMES * CHANNELS);
+	s16 = g_new(gint16, FRAMES * CHANNELS);
+	for (i = 0; i < FRAMES * CHANNELS; i++) {
+		f32[i] = g_rand_double_range(rand, -0.5, 0.5);
+		if (i % 997 == 0)
+			f32[i] = 4.0f;
+		s16[i] = i % 50 < 25 ? G_MAXINT16 : G_MININT16;
+	}
+
+	lim = eq_limiter_new(CHANNELS, LIMITER_LOOKAHEAD);
+	eq_limiter_set_threshold(lim, LIMITER_THRESHOLD);
+	eq_limiter_set_release(lim, 50, 44100);
+	threshold = pow(10.0, LIMITER_THRESHOLD / 20.0);
+
+	for (i = 0; i < FRAMES; i += n) {
+		n = MIN(BUFFER_FRAMES - 1, FRAMES - i);
+		eq_limiter_process_float(lim, f32 + i * CHANNELS, n);
+	}
+	for (i = 0; i < FRAMES * CHANNELS; i++) {
+		fail_if(fabsf(f32[i]) > threshold * 1.0001f,
+			"Sample %d is %f", i, f32[i]);
+	}
+
+	eq_limiter_reset(lim);
+	fail_if(!eq_limiter_process_s16(lim, s16, FRAMES),
+		"Full scale square wave not limited");
+	for (i = 0; i < FRAMES * CHANNELS; i++) {
+		fail_if(ABS(s16[i]) > threshold * 32768 + 1,
+			"Sample %d is %d", i, s16[i]);
+	}
+
+	eq_limiter_free(lim);
+	g_rand_free(rand);
+	g_free(f32);
+	g_free(s16);
+}
+END_TEST
+
+/* Below the threshold the signal must only be delayed */
+START_TEST(test_limiter_transparent)
+{
+	EqLimiter *lim;
+	gint16 *in, *out;
+	GRand *rand;
+	gint i;
+
+	rand = g_rand_new_with_seed(3);
+	in = g_new(gint16, FRAMES * CHANNELS);
+	out = g_new(gint16, FRAMES * CHANNELS);
+	_make_signal(in, SIGNAL_NOISE, 44100, rand);
+	memcpy(out, in, FRAMES * CHANNELS * sizeof(gint16));
+
+	lim = eq_limiter_new(CHANNELS, LIMITER_LOOKAHEAD);
+	eq_limiter_set_threshold(lim, LIMITER_THRESHOLD);
+	fail_if(eq_limiter_process_s16(lim, out, FRAMES),
+		"Signal below the threshold limited");
+
+	for (i = 0; i < LIMITER_LOOKAHEAD * CHANNELS; i++)
+		fail_if(out[i] != 0, "Sample %d is %d", i, out[i]);
+	for (; i < FRAMES * CHANNELS; i++) {
+		fail_if(out[i] != in[i - LIMITER_LOOKAHEAD * CHANNELS],
+			"Sample %d is %d", i, out[i]);
+	}
+
+	eq_limiter_free(lim);
+	g_rand_free(rand);
+	g_free(in);
+	g_free(out);
+}
+END_TEST
+
+/* A ramp starting within a buffer must give each frame its own gain, and
+ * leave the signal alone once back at unity */
+START_TEST(test_fader_ramp)
+{
+	const gint start = 1000, len = 10000;
+	EqFader f32_fader, s16_fader;
+	gfloat *f32;
+	gint16 *s16;
+	gdouble gain;
+	gint i, n;
+
+	f32 = g_new(gfloat, FRAMES * CHANNELS);
+	s16 = g_new(gint16, FRAMES * CHANNELS);
+	for (i = 0; i < FRAMES * CHANNELS; i++) {
+		f32[i] = 0.5f;
+		s16[i] = 16384;
+	}
+
+	eq_fader_init(&f32_fader, CHANNELS);
+	eq_fader_init(&s16_fader, CHANNELS);
+	eq_fader_start(&f32_fader, 1.0f, 0.0f, -start, len);
+	eq_fader_start(&s16_fader, 1.0f, 0.0f, -start, len);
+	for (i = 0; i < FRAMES; i += n) {
+		n = MIN(BUFFER_FRAMES - 1, FRAMES - i);
+		eq_fader_process_float(&f32_fader, f32 + i * CHANNELS, n);
+		eq_fader_process_s16(&s16_fader, s16 + i * CHANNELS, n);
+	}
+
+	for (i = 0; i < FRAMES * CHANNELS; i++) {
+		n = i / CHANNELS;
+		if (n < start)
+			gain = 1.0;
+		else if (n < start + len)
+			gain = 1.0 - (gdouble) (n - start) / len;
+		else
+			gain = 0.0;
+		fail_if(fabs(f32[i] - 0.5 * gain) > 1e-5,
+			"Float sample %d is %f", i, f32[i]);
+		fail_if(fabs(s16[i] - 16384 * gain) > 1.0,
+			"Int16 sample %d is %d", i, s16[i]);
+	}
+
+	eq_fader_start(&f32_fader, 0.0f, 1.0f, len, len);
+	for (i = 0; i < FRAMES * CHANNELS; i++)
+		f32[i] = 0.5f;
+	fail_if(eq_fader_process_float(&f32_fader, f32, FRAMES),
+		"Signal at unity gain touched");
+
+	g_free(f32);
+	g_free(s16);
+}
+END_TEST
+
+/* Compares the coefficients of two designs */
+static gboolean _same_design(const EqDspBiquad *a, const EqDspBiquad *b,
+			     gint n_bands)
+{
+	gint i;
+
+	for (i = 0; i < n_bands; i++) {
+		if (a[i].b0 != b[i].b0 || a[i].b1 != b[i].b1 ||
+		    a[i].b2 != b[i].b2 || a[i].a1 != b[i].a1 ||
+		    a[i].a2 != b[i].a2)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/* Known curves must be found in the cache, curves that only differ below
+ * its quantization step must share an entry and any other curve or rate
+ * must get its own */
+START_TEST(test_design_cache)
+{
+	EqDspBiquad first[EQ_DSP_MAX_BANDS], bq[EQ_DSP_MAX_BANDS];
+	EqDspBiquad direct[EQ_DSP_MAX_BANDS];
+	EqDspLayout layout;
+	gdouble gains[EQ_DSP_MAX_BANDS], nudged[EQ_DSP_MAX_BANDS];
+	guint hits, misses, hits0, misses0;
+	gint b;
+
+	/* A layout and gains on the quantization grid */
+	fail_unless(eq_layout_parse("lowshelf:100:0.707;peak:250.5:1.414;"
+				    "peak:1000:2.5;peak:4000:1.414;"
+				    "highshelf:10000:0.707", &layout),
+		    "Layout not parsed");
+	memset(gains, 0, sizeof(gains));
+	for (b = 0; b < layout.n_bands; b++)
+		gains[b] = 7.25 - 4.5 * b;
+	eq_dsp_cache_stats(&hits0, &misses0);
+
+	eq_dsp_design_layout_cached(first, &layout, gains, 44100, NULL);
+	eq_dsp_cache_stats(&hits, &misses);
+	fail_unless(hits == hits0 && misses == misses0 + 1,
+		    "New curve not a miss (%u hits, %u misses)",
+		    hits - hits0, misses - misses0);
+
+	/* Gains on the quantization grid are designed as they are */
+	eq_dsp_design_layout(direct, &layout, gains, 44100);
+	fail_unless(_same_design(first, direct, layout.n_bands),
+		    "Cached design differs from a direct one");
+
+	eq_dsp_design_layout_cached(bq, &layout, gains, 44100, NULL);
+	eq_dsp_cache_stats(&hits, &misses);
+	fail_unless(hits == hits0 + 1 && misses == misses0 + 1,
+		    "Known curve not a hit (%u hits, %u misses)",
+		    hits - hits0, misses - misses0);
+	fail_unless(_same_design(first, bq, layout.n_bands),
+		    "Hit returned another design");
+
+	/* As read back from gconf, a hair away from the stored value */
+	for (b = 0; b < EQ_DSP_MAX_BANDS; b++)
+		nudged[b] = gains[b] + 0.001;
+	eq_dsp_design_layout_cached(bq, &layout, nudged, 44100, NULL);
+	eq_dsp_cache_stats(&hits, &misses);
+	fail_unless(hits == hits0 + 2 && misses == misses0 + 1,
+		    "Curve within the quantization step not a hit "
+		    "(%u hits, %u misses)", hits - hits0, misses - misses0);
+	fail_unless(_same_design(first, bq, layout.n_bands),
+		    "Quantized curve got another design");
+
+	for (b = 0; b < EQ_DSP_MAX_BANDS; b++)
+		nudged[b] = gains[b] + 0.01;
+	eq_dsp_design_layout_cached(bq, &layout, nudged, 44100, NULL);
+	eq_dsp_cache_stats(&hits, &misses);
+	fail_unless(hits == hits0 + 2 && misses == misses0 + 2,
+		    "Curve beyond the quantization step not a miss "
+		    "(%u hits, %u misses)", hits - hits0, misses - misses0);
+
+	eq_dsp_design_layout_cached(bq, &layout, gains, 48000, NULL);
+	eq_dsp_cache_stats(&hits, &misses);
+	fail_unless(hits == hits0 + 2 && misses == misses0 + 3,
+		    "Known curve at another rate not a miss "
+		    "(%u hits, %u misses)", hits - hits0, misses - misses0);
+	fail_if(_same_design(first, bq, layout.n_bands),
+		"Same design at another rate");
+
+	layout.bands[3].freq += 1.0;
+	eq_dsp_design_layout_cached(bq, &layout, gains, 44100, NULL);
+	eq_dsp_cache_stats(&hits, &misses);
+	fail_unless(hits == hits0 + 2 && misses == misses0 + 4,
+		    "Known gains on another layout not a miss "
+		    "(%u hits, %u misses)", hits - hits0, misses - misses0);
+}
+END_TEST
+
+/* Layouts written by the applet, or by hand in gconf, must be read back
+ * band by band */
+START_TEST(test_layout_parse)
+{
+	EqDspLayout layout, parsed;
+	gchar *str;
+
+	fail_unless(eq_layout_parse("lowshelf:60:0.707;peak:1000:1.414;"
+				    "highshelf:12000:0.707", &layout),
+		    "Layout not parsed");
+	fail_unless(layout.n_bands == 3, "Layout has %d bands",
+		    layout.n_bands);
+	fail_unless(layout.bands[0].type == EQ_DSP_FILTER_LOW_SHELF &&
+		    layout.bands[1].type == EQ_DSP_FILTER_PEAK &&
+		    layout.bands[2].type == EQ_DSP_FILTER_HIGH_SHELF,
+		    "Wrong band types");
+	fail_unless(layout.bands[0].freq == 60.0 &&
+		    layout.bands[1].freq == 1000.0 &&
+		    layout.bands[2].freq == 12000.0,
+		    "Wrong band frequencies");
+	fail_unless(layout.bands[1].q == 1.414, "Wrong band Q");
+
+	/* Blanks around bands and a trailing separator are allowed */
+	fail_unless(eq_layout_parse(" peak:100:1 ; peak:200:2 ;", &layout),
+		    "Layout with blanks not parsed");
+	fail_unless(layout.n_bands == 2, "Layout has %d bands",
+		    layout.n_bands);
+
+	/* The string written for a layout is read back as the same one */
+	eq_layout_init_default(&layout);
+	str = eq_layout_to_string(&layout);
+	fail_unless(eq_layout_parse(str, &parsed), "Layout %s not parsed",
+		    str);
+	fail_unless(eq_layout_equal(&layout, &parsed),
+		    "Layout %s read back differently", str);
+	g_free(str);
+}
+END_TEST
+
+/* Malformed layouts must be rejected as a whole, keeping the current one */
+START_TEST(test_layout_reject)
+{
+	static const gchar *wrong[] = {
+		"",
+		";",
+		"peak:1000",
+		"peak:1000:1:2",
+		"notch:1000:1",
+		"peak:0:1",
+		"peak:-100:1",
+		"peak:1000:0",
+		"peak:1kHz:1",
+		"peak:1000:1;;peak:2000:1",
+		"peak:1000:1;garbage",
+	};
+	EqDspLayout layout, current;
+	GString *str;
+	gint i;
+
+	eq_layout_init_default(&current);
+	layout = current;
+
+	fail_if(eq_layout_parse(NULL, &layout), "NULL layout parsed");
+	for (i = 0; i < G_N_ELEMENTS(wrong); i++) {
+		fail_if(eq_layout_parse(wrong[i], &layout),
+			"Layout '%s' parsed", wrong[i]);
+	}
+
+	str = g_string_new(NULL);
+	for (i = 0; i <= EQ_DSP_MAX_BANDS; i++) {
+		g_string_append_printf(str, "%speak:%d:1", i ? ";" : "",
+				       100 + i * 100);
+	}
+	fail_if(eq_layout_parse(str->str, &layout),
+		"Layout of %d bands parsed", EQ_DSP_MAX_BANDS + 1);
+	g_string_free(str, TRUE);
+
+	fail_unless(eq_layout_equal(&layout, &current),
+		    "Rejected layout changed the current one");
+}
+END_TEST
+
+/* Negotiates a standalone equalizer as the audio bin would, so that
+ * buffers can be pushed through it one by one */
+static MafwGstRendererEqualizer *_make_element(void)
+{
+	GstAudioFilter *filter;
+	GstCaps *caps;
+
+	filter = GST_AUDIO_FILTER(mafw_gst_renderer_equalizer_new());
+	caps = gst_caps_from_string(ELEMENT_CAPS);
+	fail_unless(gst_ring_buffer_parse_caps(&filter->format, caps),
+		    "Caps not parsed");
+	fail_unless(GST_AUDIO_FILTER_GET_CLASS(filter)->setup(
+			    filter, &filter->format),
+		    "Caps refused");
+	gst_caps_unref(caps);
+
+	return MAFW_GST_RENDERER_EQUALIZER(filter);
+}
+
+/* Runs @frames frames of @data through @eq in place */
+static void _push(MafwGstRendererEqualizer *eq, gint16 *data, guint frames)
+{
+	GstBuffer *buf;
+
+	buf = gst_buffer_new();
+	GST_BUFFER_DATA(buf) = (guint8 *) data;
+	GST_BUFFER_SIZE(buf) = frames * CHANNELS * sizeof(gint16);
+	fail_unless(GST_BASE_TRANSFORM_GET_CLASS(eq)->transform_ip(
+			    GST_BASE_TRANSFORM(eq), buf) == GST_FLOW_OK,
+		    "Buffer not processed");
+	gst_buffer_unref(buf);
+}
+
+static void _get_counters(MafwGstRendererEqualizer *eq, guint *bypassed,
+			  guint *processed, guint *skipped)
+{
+	g_object_get(eq, "buffers-bypassed", bypassed,
+		     "buffers-processed", processed,
+		     "buffers-skipped", skipped, NULL);
+}
+
+/* A flat curve must leave buffers alone and count them as bypassed, and
+ * any other one must be applied */
+START_TEST(test_bypass_at_unity)
+{
+	MafwGstRendererEqualizer *eq;
+	gint16 *in, *out;
+	guint bypassed, processed, skipped;
+	gint i;
+
+	in = g_new(gint16, FRAMES * CHANNELS);
+	out = g_new(gint16, FRAMES * CHANNELS);
+	_make_signal(in, SIGNAL_SWEEP, ELEMENT_RATE, NULL);
+	memcpy(out, in, FRAMES * CHANNELS * sizeof(gint16));
+
+	eq = _make_element();
+	fail_unless(gst_base_transform_is_passthrough(GST_BASE_TRANSFORM(eq)),
+		    "Flat equalizer not in passthrough");
+	for (i = 0; i < 8; i++)
+		_push(eq, out + i * BUFFER_FRAMES * CHANNELS, BUFFER_FRAMES);
+	fail_if(memcmp(in, out, 8 * BUFFER_FRAMES * CHANNELS *
+		       sizeof(gint16)) != 0,
+		"Flat equalizer touched the signal");
+	_get_counters(eq, &bypassed, &processed, &skipped);
+	fail_unless(bypassed == 8 && processed == 0 && skipped == 0,
+		    "%u bypassed, %u processed, %u skipped at unity",
+		    bypassed, processed, skipped);
+
+	/* The buffer where the curve changes still goes out untouched */
+	g_object_set(eq, "band3", 6.0, NULL);
+	_push(eq, out + 8 * BUFFER_FRAMES * CHANNELS, BUFFER_FRAMES);
+	fail_if(gst_base_transform_is_passthrough(GST_BASE_TRANSFORM(eq)),
+		"Boosted equalizer in passthrough");
+	for (i = 9; i < 16; i++)
+		_push(eq, out + i * BUFFER_FRAMES * CHANNELS, BUFFER_FRAMES);
+	fail_unless(memcmp(in, out, 9 * BUFFER_FRAMES * CHANNELS *
+			   sizeof(gint16)) == 0,
+		    "Signal touched before leaving bypass");
+	fail_if(memcmp(in + 9 * BUFFER_FRAMES * CHANNELS,
+		       out + 9 * BUFFER_FRAMES * CHANNELS,
+		       7 * BUFFER_FRAMES * CHANNELS * sizeof(gint16)) == 0,
+		"Boosted equalizer left the signal alone");
+	_get_counters(eq, &bypassed, &processed, &skipped);
+	fail_unless(bypassed == 9 && processed == 7 && skipped == 0,
+		    "%u bypassed, %u processed, %u skipped once boosted",
+		    bypassed, processed, skipped);
+
+	/* Back at unity, the filters ramp out and bypass is entered again */
+	g_object_set(eq, "band3", 0.0, NULL);
+	for (i = 16; i < FRAMES / BUFFER_FRAMES - 1; i++) {
+		_push(eq, out + i * BUFFER_FRAMES * CHANNELS, BUFFER_FRAMES);
+		if (gst_base_transform_is_passthrough(GST_BASE_TRANSFORM(eq)))
+			break;
+	}
+	fail_unless(gst_base_transform_is_passthrough(GST_BASE_TRANSFORM(eq)),
+		    "Equalizer back at unity not in passthrough");
+	_get_counters(eq, &bypassed, &processed, &skipped);
+	fail_unless(bypassed == 9, "Buffers bypassed while ramping out");
+
+	memcpy(out, in, FRAMES * CHANNELS * sizeof(gint16));
+	_push(eq, out, BUFFER_FRAMES);
+	fail_if(memcmp(in, out, BUFFER_FRAMES * CHANNELS *
+		       sizeof(gint16)) != 0,
+		"Equalizer back at unity touched the signal");
+	_get_counters(eq, &bypassed, &processed, &skipped);
+	fail_unless(bypassed == 10, "Buffer at unity not bypassed");
+
+	gst_object_unref(eq);
+	g_free(in);
+	g_free(out);
+}
+END_TEST
+
+/* Whether every coefficient of @cur is between @prev and @to, so that it
+ * only moved towards its target */
+static gboolean _moved_towards(const EqDspBiquad *prev, const EqDspBiquad *cur,
+			       const EqDspBiquad *to, gint n_bands)
+{
+	const gfloat *p = (const gfloat *) prev;
+	const gfloat *c = (const gfloat *) cur;
+	const gfloat *t = (const gfloat *) to;
+	gint i;
+
+	for (i = 0; i < n_bands * 5; i++) {
+		if (c[i] < MIN(p[i], t[i]) - 1e-6f ||
+		    c[i] > MAX(p[i], t[i]) + 1e-6f)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/* Curve changes must ramp the coefficients over ramp-time, moving them
+ * straight towards the new ones, and switching the equalizer in must take
+ * at least EQ_DSP_FADE_FRAMES whatever ramp-time */
+START_TEST(test_coefficient_ramp)
+{
+	const gint ramp_time = 20;
+	const guint ramp_frames = ramp_time * ELEMENT_RATE / 1000;
+	MafwGstRendererEqualizer *eq;
+	EqDspBiquad from[EQ_DSP_MAX_BANDS], to[EQ_DSP_MAX_BANDS];
+	EqDspBiquad prev[EQ_DSP_MAX_BANDS];
+	GRand *rand;
+	gint16 *data;
+	guint frames;
+	gint n_bands;
+
+	data = g_new(gint16, FRAMES * CHANNELS);
+	rand = g_rand_new_with_seed(1);
+	_make_signal(data, SIGNAL_NOISE, ELEMENT_RATE, rand);
+	eq = _make_element();
+
+	g_object_set(eq, "ramp-time", 0, "band2", 6.0, NULL);
+	_push(eq, data, BUFFER_FRAMES);
+	fail_unless(eq->ramp_len == EQ_DSP_FADE_FRAMES,
+		    "Switching in takes %u frames", eq->ramp_len);
+	_push(eq, data, BUFFER_FRAMES);
+	fail_unless(eq->ramp_len == 0, "Ramp not over");
+
+	g_object_set(eq, "ramp-time", ramp_time, "band7", -9.0, NULL);
+	memcpy(from, eq->coeffs, sizeof(from));
+	_push(eq, data, EQ_DSP_RAMP_BLOCK);
+	fail_unless(eq->ramp_len == ramp_frames,
+		    "Ramp of %u frames instead of %u", eq->ramp_len,
+		    ramp_frames);
+	fail_unless(memcmp(eq->ramp_from, from, sizeof(from)) == 0,
+		    "Ramp does not start at the current coefficients");
+	memcpy(to, eq->ramp_to, sizeof(to));
+	n_bands = eq->n_active;
+
+	/* Coefficients move every block, only towards the new ones, and
+	 * reach them when the ramp is over, not before */
+	frames = EQ_DSP_RAMP_BLOCK;
+	memcpy(prev, from, sizeof(prev));
+	while (eq->ramp_len > 0) {
+		fail_unless(_moved_towards(prev, eq->coeffs, to, n_bands),
+			    "Coefficients moved away at frame %u", frames);
+		fail_if(memcmp(prev, eq->coeffs, sizeof(prev)) == 0,
+			"Coefficients stuck at frame %u", frames);
+		fail_if(frames >= ramp_frames,
+			"Ramp longer than %u frames", ramp_frames);
+		memcpy(prev, eq->coeffs, sizeof(prev));
+		_push(eq, data, EQ_DSP_RAMP_BLOCK);
+		frames += EQ_DSP_RAMP_BLOCK;
+	}
+	fail_unless(frames >= ramp_frames, "Ramp over after %u frames",
+		    frames);
+	fail_unless(memcmp(eq->coeffs, to, n_bands * sizeof(EqDspBiquad)) == 0,
+		    "Ramp did not end at the new coefficients");
+
+	gst_object_unref(eq);
+	g_rand_free(rand);
+	g_free(data);
+}
+END_TEST
+
+/* Silent buffers must be left alone once the history has decayed, and
+ * filtered until then so that the tail of the signal is not cut */
+START_TEST(test_silence_skip)
+{
+	MafwGstRendererEqualizer *eq;
+	gint16 *noise, *data, *zeros;
+	guint bypassed, processed, skipped, tail;
+	GstBuffer *buf;
+	GRand *rand;
+	gint i;
+
+	noise = g_new(gint16, BUFFER_FRAMES * CHANNELS);
+	data = g_new(gint16, BUFFER_FRAMES * CHANNELS);
+	zeros = g_new0(gint16, BUFFER_FRAMES * CHANNELS);
+	rand = g_rand_new_with_seed(1);
+	eq = _make_element();
+
+	/* Leave bypass; the history is clear, so silence is skipped at
+	 * once */
+	g_object_set(eq, "band0", 9.0, NULL);
+	memset(data, 0, BUFFER_FRAMES * CHANNELS * sizeof(gint16));
+	_push(eq, data, BUFFER_FRAMES);
+	_push(eq, data, BUFFER_FRAMES);
+	_get_counters(eq, &bypassed, &processed, &skipped);
+	fail_unless(processed == 0 && skipped == 1,
+		    "%u processed, %u skipped on silence", processed, skipped);
+
+	/* Low band ringing after loud noise takes a while to decay */
+	for (i = 0; i < BUFFER_FRAMES * CHANNELS; i++)
+		noise[i] = g_rand_int_range(rand, -16384, 16384);
+	memcpy(data, noise, BUFFER_FRAMES * CHANNELS * sizeof(gint16));
+	_push(eq, data, BUFFER_FRAMES);
+	tail = 0;
+	for (i = 0; i < 200; i++) {
+		memset(data, 0, BUFFER_FRAMES * CHANNELS * sizeof(gint16));
+		_push(eq, data, BUFFER_FRAMES);
+		_get_counters(eq, &bypassed, &processed, &skipped);
+		if (skipped > 1)
+			break;
+		tail++;
+	}
+	fail_unless(tail > 0, "Silence right after the signal skipped");
+	fail_unless(skipped == 2, "Silence never skipped after the signal");
+	fail_unless(processed == 1 + tail, "%u buffers processed",
+		    processed);
+	fail_if(memcmp(data, zeros, BUFFER_FRAMES * CHANNELS *
+		       sizeof(gint16)) != 0,
+		"Skipped buffer touched");
+
+	/* Gaps are skipped whatever they hold */
+	memcpy(data, noise, BUFFER_FRAMES * CHANNELS * sizeof(gint16));
+	buf = gst_buffer_new();
+	GST_BUFFER_DATA(buf) = (guint8 *) data;
+	GST_BUFFER_SIZE(buf) = BUFFER_FRAMES * CHANNELS * sizeof(gint16);
+	GST_BUFFER_FLAG_SET(buf, GST_BUFFER_FLAG_GAP);
+	GST_BASE_TRANSFORM_GET_CLASS(eq)->transform_ip(GST_BASE_TRANSFORM(eq),
+						       buf);
+	gst_buffer_unref(buf);
+	_get_counters(eq, &bypassed, &processed, &skipped);
+	fail_unless(skipped == 3, "Gap not skipped");
+	fail_if(memcmp(data, noise, BUFFER_FRAMES * CHANNELS *
+		       sizeof(gint16)) != 0,
+		"Gap touched");
+
+	gst_object_unref(eq);
+	g_rand_free(rand);
+	g_free(noise);
+	g_free(data);
+	g_free(zeros);
+}
+END_TEST
+
+/* Once denormals are flushed, the history of the float kernel must decay
+ * straight to zero on silence instead of lingering in denormals */
+START_TEST(test_denormals)
+{
+	EqDspLayout layout;
+	EqDspBiquad bq[EQ_DSP_MAX_BANDS];
+	EqDspState state;
+	gdouble gains[EQ_DSP_MAX_BANDS];
+	volatile gfloat tiny = FLT_MIN;
+	gfloat *data;
+	gint i, b, c;
+
+	eq_dsp_flush_denormals();
+#if defined(__SSE__) || defined(__aarch64__) || \
+	(defined(__arm__) && defined(__VFP_FP__) && !defined(__SOFTFP__))
+	fail_unless(tiny / 2.0f == 0.0f, "Denormals not flushed");
+#endif
+
+	eq_layout_init_default(&layout);
+	memset(gains, 0, sizeof(gains));
+	memcpy(gains, curves[3], sizeof(curves[3]));
+	eq_dsp_design_layout(bq, &layout, gains, ELEMENT_RATE);
+
+	data = g_new0(gfloat, FRAMES * CHANNELS);
+	data[0] = data[1] = 1.0f;
+	eq_dsp_reset(&state);
+	for (i = 0; i < 20; i++) {
+		eq_dsp_process_float(bq, layout.n_bands, &state, data, FRAMES,
+				     CHANNELS);
+		memset(data, 0, FRAMES * CHANNELS * sizeof(gfloat));
+	}
+
+#if defined(__SSE__) || defined(__aarch64__) || \
+	(defined(__arm__) && defined(__VFP_FP__) && !defined(__SOFTFP__))
+	for (b = 0; b < layout.n_bands; b++) {
+		for (c = 0; c < CHANNELS; c++) {
+			fail_if(fpclassify(state.z1[b][c]) == FP_SUBNORMAL ||
+				fpclassify(state.z2[b][c]) == FP_SUBNORMAL,
+				"Denormal history in band %d", b);
+		}
+	}
+#endif
+	fail_unless(eq_dsp_state_is_quiet(&state, layout.n_bands),
+		    "History not quiet after silence");
+
+	g_free(data);
+}
+END_TEST
+
+/*----------------------------------------------------------------------------
+  Suit creation
+  ----------------------------------------------------------------------------*/
+
+SRunner *configure_tests(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	gst_init(NULL, NULL);
+
+	s = suite_create("Equalizer");
+
+	tc = tcase_create("Fixed point");
+	tcase_add_test(tc, test_fixed_point_corpus);
+	tcase_add_test(tc, test_fixed_point_saturation);
+	tcase_set_timeout(tc, 0);
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("Float");
+	tcase_add_test(tc, test_float_kernel);
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("Design cache");
+	tcase_add_test(tc, test_design_cache);
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("Convolution");
+	tcase_add_test(tc, test_convolver);
+	tcase_set_timeout(tc, 0);
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("Clipping");
+	tcase_add_test(tc, test_preamp);
+	tcase_add_test(tc, test_limiter_peaks);
+	tcase_add_test(tc, test_limiter_transparent);
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("Fader");
+	tcase_add_test(tc, test_fader_ramp);
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("Bypass");
+	tcase_add_test(tc, test_bypass_at_unity);
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("Ramps");
+	tcase_add_test(tc, test_coefficient_ramp);
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("Layout");
+	tcase_add_test(tc, test_layout_parse);
+	tcase_add_test(tc, test_layout_reject);
+	suite_add_tcase(s, tc);
+
+	/* Last, as flushing denormals sticks to the thread without
+	 * CK_FORK */
+	tc = tcase_create("Silence");
+	tcase_add_test(tc, test_silence_skip);
+	tcase_add_test(tc, test_denormals);
+	suite_add_tcase(s, tc);
+
+	return srunner_create(s);
+}
+
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */
@@ -238,6 +238,23 @@ static void status_cb(MafwRenderer* renderer, MafwPlaylist* playlist, guint inde
 
 }
 
+static void status_index_cb(MafwRenderer* renderer, MafwPlaylist* playlist,
+			    guint index, MafwPlayState state,
+			    const gchar* object_id, gpointer user_data,
+			    const GError *error)
+{
+	/* MafwRendererStatusCB, keeping the playlist index too */
+	RendererInfo* s = (RendererInfo*) user_data;
+	g_assert(s != NULL);
+
+	if (error != NULL) {
+		fail("Error received while trying to get renderer status: (%d) %s",
+		     error->code, error->message);
+	}
+	s->index = index;
+	s->state = state;
+}
+
 static void playback_cb(MafwRenderer* renderer, gpointer user_data, const GError* error)
 {
 	/* MafwRendererPlaybackCB:
@@ -281,6 +298,7 @@ static void  get_position_cb(MafwRenderer *self, gint position,
 
 	g_debug("get position cb: %d", position);
 
+	c->seek_position = position;
 	if (error != NULL) {
 		c->error = TRUE;
 		c->err_code = error->code;
@@ -399,6 +417,28 @@ static gboolean wait_for_state(RendererInfo *renderer_info,
 	return (renderer_info->state == expected_state);
 }
 
+static gboolean wait_for_index(RendererInfo *renderer_info,
+			       gint expected_index, guint millis)
+{
+	guint timeout = 0;
+	gboolean stop_wait = FALSE;
+
+	g_debug("Init wait for index");
+	/* We'll wait a limitted ammount of time */
+	timeout = g_timeout_add(millis, stop_wait_timeout, &stop_wait);
+
+	while (renderer_info->index != expected_index && !stop_wait) {
+		g_main_context_iteration(NULL, TRUE);
+	}
+
+	if (!stop_wait) {
+		g_source_remove(timeout);
+	}
+
+	g_debug("End wait for index");
+	return (renderer_info->index == expected_index);
+}
+
 static gboolean wait_for_callback(CallbackInfo *callback, guint millis)
 {
 	guint timeout = 0;
@@ -1977,7 +2017,11 @@ START_TEST(test_play_state)
 	mafw_playlist_remove_item(playlist, 9, NULL);
 	fail_if(mafw_playlist_get_size(playlist, NULL) != 9,
 		"Playlist should have 9 elements");
-	fail_if(s.index != 8, index_err_msg, s.index, 8);
+
+	/* The edit is applied once the main loop goes idle */
+	if (wait_for_index(&s, 8, wait_tout_val) == FALSE) {
+		fail(index_err_msg, s.index, 8);
+	}
 
 	if (wait_for_state(&s, Transitioning, wait_tout_val) == FALSE) {
 		fail(state_err_msg, "mafw_playlist_remove_element",
@@ -2347,7 +2391,11 @@ START_TEST(test_pause_state)
 	mafw_playlist_remove_item(playlist, 9, NULL);
 	fail_if(mafw_playlist_get_size(playlist, NULL) != 9,
 		"Playlist should have 9 elements");
-	fail_if(s.index != 8, index_err_msg, s.index, 8);
+
+	/* The edit is applied once the main loop goes idle */
+	if (wait_for_index(&s, 8, wait_tout_val) == FALSE) {
+		fail(index_err_msg, s.index, 8);
+	}
 
 	if (wait_for_state(&s, Transitioning, wait_tout_val) == FALSE) {
 		fail(state_err_msg, "mafw_playlist_remove_item",
@@ -2761,7 +2809,11 @@ START_TEST(test_transitioning_state)
 	mafw_playlist_remove_item(playlist, 9, NULL);
 	fail_if(mafw_playlist_get_size(playlist, NULL) != 9,
 		"Playlist should have 9 elements");
-	fail_if(s.index != 8, index_err_msg, s.index, 8);
+
+	/* The edit is applied once the main loop goes idle */
+	if (wait_for_index(&s, 8, wait_tout_val) == FALSE) {
+		fail(index_err_msg, s.index, 8);
+	}
 
 	if (wait_for_state(&s, Transitioning, wait_tout_val) == FALSE) {
 		fail(state_err_msg, "mafw_playlist_remove_element",
@@ -3352,6 +3404,73 @@ START_TEST(test_playlist_iterator)
 }
 END_TEST
 
+static void check_iterator_current(MafwPlaylistIterator *iterator,
+				   gint expected_index,
+				   const gchar *expected_objectid)
+{
+	gint index;
+	const gchar *objectid;
+
+	index = mafw_playlist_iterator_get_current_index(iterator);
+	fail_if(index != expected_index, "Index should be %d and it is %d",
+		expected_index, index);
+	objectid = mafw_playlist_iterator_get_current_objectid(iterator);
+	fail_if(g_strcmp0(objectid, expected_objectid) != 0,
+		"Current item should be %s and it is %s", expected_objectid,
+		objectid);
+}
+
+START_TEST(test_playlist_iterator_window)
+{
+	MafwPlaylist *playlist = NULL;
+	MafwPlaylistIterator *iterator = NULL;
+	GError *error = NULL;
+	gchar *objectid;
+	gint i;
+
+	playlist = MAFW_PLAYLIST(mafw_mock_playlist_new());
+	iterator = mafw_playlist_iterator_new();
+	mafw_playlist_iterator_initialize(iterator, playlist, &error);
+	fail_if(error != NULL, "Error found: %s",
+		error ? error->message : NULL);
+
+	for (i = 0; i < 10; i++) {
+		objectid = g_strdup_printf("item%d", i);
+		mafw_playlist_insert_item(playlist, i, objectid, NULL);
+		g_free(objectid);
+	}
+	check_iterator_current(iterator, 0, "item0");
+
+	mafw_playlist_iterator_move_to_index(iterator, 5, NULL);
+	check_iterator_current(iterator, 5, "item5");
+
+	/* Edits before the current item only move it */
+	mafw_playlist_remove_item(playlist, 0, NULL);
+	check_iterator_current(iterator, 4, "item5");
+	mafw_playlist_insert_item(playlist, 2, "new", NULL);
+	check_iterator_current(iterator, 5, "item5");
+
+	/* item1 item2 new item3 item4 item5 item6 ... */
+	mafw_playlist_iterator_move_to_index(iterator, 6, NULL);
+	check_iterator_current(iterator, 6, "item6");
+	mafw_playlist_iterator_move_to_index(iterator, 2, NULL);
+	check_iterator_current(iterator, 2, "new");
+
+	/* Removing the current item takes the next one */
+	mafw_playlist_remove_item(playlist, 2, NULL);
+	check_iterator_current(iterator, 2, "item3");
+
+	/* Known items have moved along */
+	mafw_playlist_iterator_move_to_index(iterator, 5, NULL);
+	check_iterator_current(iterator, 5, "item6");
+	fail_if(mafw_playlist_iterator_get_size(iterator, NULL) != 9,
+		"Playlist should have 9 elements");
+
+	g_object_unref(iterator);
+	g_object_unref(playlist);
+}
+END_TEST
+
 START_TEST(test_video)
 {
 	RendererInfo s = {0, };;
@@ -4115,6 +4234,323 @@ START_TEST(test_buffering)
 }
 END_TEST
 
+START_TEST(test_command_coalescing)
+{
+	MafwPlaylist *playlist = NULL;
+	MafwGstRenderer *renderer = MAFW_GST_RENDERER(g_gst_renderer);
+	RendererInfo s = {0, };
+	RendererInfo status = {0, };
+	CallbackInfo c = {0, };
+	CallbackInfo c1 = {0, };
+	CallbackInfo c2 = {0, };
+	CallbackInfo c3 = {0, };
+	gchar *objectid = NULL;
+	guint before, coalesced;
+	gint i;
+
+	/* Connect to renderer signals */
+	g_signal_connect(g_gst_renderer, "error",
+			 G_CALLBACK(error_cb),
+			 &c);
+	g_signal_connect(g_gst_renderer, "state-changed",
+			 G_CALLBACK(state_changed_cb),
+			 &s);
+	g_signal_connect(g_gst_renderer, "media-changed",
+			 G_CALLBACK(media_changed_cb),
+			 &s);
+
+	/* --- Create and assign a playlist --- */
+
+	playlist = MAFW_PLAYLIST(mafw_mock_playlist_new());
+	objectid = get_sample_clip_objectid(SAMPLE_AUDIO_CLIP);
+	for (i = 0; i < 3; i++) {
+		mafw_playlist_insert_item(playlist, i, objectid, NULL);
+	}
+	g_free(objectid);
+
+	if (!mafw_renderer_assign_playlist(g_gst_renderer, playlist, NULL)) {
+		fail("Assign playlist failed");
+	}
+
+	wait_for_state(&s, Stopped, wait_tout_val);
+
+	/* --- Play and pause, so that the position stays put --- */
+
+	reset_callback_info(&c);
+
+	g_debug("play...");
+	mafw_renderer_play(g_gst_renderer, playback_cb, &c);
+
+	if (wait_for_callback(&c, wait_tout_val)) {
+		if (c.error)
+			fail(callback_err_msg, "playing", c.err_code,
+			     c.err_msg);
+	} else {
+		fail(no_callback_msg);
+	}
+
+	if (wait_for_state(&s, Playing, wait_tout_val) == FALSE) {
+		fail(state_err_msg, "mafw_renderer_play", "Playing", s.state);
+	}
+
+	reset_callback_info(&c);
+
+	g_debug("pause...");
+	mafw_renderer_pause(g_gst_renderer, playback_cb, &c);
+
+	if (wait_for_callback(&c, wait_tout_val)) {
+		if (c.error)
+			fail(callback_err_msg, "pausing", c.err_code,
+			     c.err_msg);
+	} else {
+		fail(no_callback_msg);
+	}
+
+	if (wait_for_state(&s, Paused, wait_tout_val) == FALSE) {
+		fail(state_err_msg, "mafw_renderer_pause", "Paused", s.state);
+	}
+
+	/* --- Relative seeks add up, get_position runs them first --- */
+
+	reset_callback_info(&c1);
+	reset_callback_info(&c2);
+	reset_callback_info(&c3);
+	mafw_gst_renderer_get_command_stats(renderer, NULL, &before);
+
+	g_debug("seek burst...");
+	mafw_renderer_set_position(g_gst_renderer, SeekAbsolute, 0, seek_cb,
+				   &c1);
+	mafw_renderer_set_position(g_gst_renderer, SeekRelative, 1, seek_cb,
+				   &c2);
+	mafw_renderer_set_position(g_gst_renderer, SeekRelative, 1, seek_cb,
+				   &c3);
+
+	mafw_gst_renderer_get_command_stats(renderer, NULL, &coalesced);
+	fail_if(coalesced - before != 2,
+		"%u seeks coalesced and 2 expected", coalesced - before);
+	fail_if(c1.called || c2.called || c3.called,
+		"Seek run before the burst was over");
+
+	reset_callback_info(&c);
+
+	mafw_renderer_get_position(g_gst_renderer, get_position_cb, &c);
+
+	fail_unless(c1.called && c2.called && c3.called,
+		    "Queued seeks not run before get_position");
+	fail_if(c1.error || c2.error || c3.error,
+		"Error received when seeking");
+	fail_unless(c.called, no_callback_msg);
+	fail_if(c.seek_position != 2,
+		"Position is %d instead of the summed 2", c.seek_position);
+
+	/* --- A seek is superseded by a playlist movement --- */
+
+	reset_callback_info(&c1);
+	reset_callback_info(&c2);
+	before = coalesced;
+
+	g_debug("seek and next...");
+	mafw_renderer_set_position(g_gst_renderer, SeekAbsolute, 1, seek_cb,
+				   &c1);
+	mafw_renderer_next(g_gst_renderer, playback_cb, &c2);
+
+	mafw_gst_renderer_get_command_stats(renderer, NULL, &coalesced);
+	fail_if(coalesced - before != 1,
+		"%u calls coalesced and 1 expected", coalesced - before);
+
+	if (wait_for_callback(&c2, wait_tout_val)) {
+		if (c2.error)
+			fail(callback_err_msg, "going to next", c2.err_code,
+			     c2.err_msg);
+	} else {
+		fail(no_callback_msg);
+	}
+	fail_unless(c1.called, "Superseded seek not called back");
+
+	mafw_renderer_get_status(g_gst_renderer, status_index_cb, &status);
+	fail_if(status.index != 1, index_err_msg, status.index, 1);
+
+	/* --- A movement is superseded by goto_index, get_status runs it
+	 * first --- */
+
+	reset_callback_info(&c1);
+	reset_callback_info(&c2);
+	before = coalesced;
+
+	g_debug("next and goto_index...");
+	mafw_renderer_next(g_gst_renderer, playback_cb, &c1);
+	mafw_renderer_goto_index(g_gst_renderer, 0, playback_cb, &c2);
+
+	mafw_gst_renderer_get_command_stats(renderer, NULL, &coalesced);
+	fail_if(coalesced - before != 1,
+		"%u calls coalesced and 1 expected", coalesced - before);
+
+	mafw_renderer_get_status(g_gst_renderer, status_index_cb, &status);
+
+	fail_unless(c1.called && c2.called,
+		    "Queued calls not run before get_status");
+	fail_if(c1.error || c2.error, "Error received when moving");
+	fail_if(status.index != 0, index_err_msg, status.index, 0);
+
+	/* --- get_property runs the queued calls first --- */
+
+	reset_callback_info(&c1);
+	reset_callback_info(&c);
+
+	g_debug("goto_index and get_property...");
+	mafw_renderer_goto_index(g_gst_renderer, 2, playback_cb, &c1);
+
+	c.property_expected = MAFW_PROPERTY_RENDERER_VOLUME;
+	mafw_extension_get_property(MAFW_EXTENSION(g_gst_renderer),
+				    MAFW_PROPERTY_RENDERER_VOLUME,
+				    get_property_cb, &c);
+
+	fail_unless(c1.called, "Queued call not run before get_property");
+	fail_if(c1.error, "Error received when moving");
+
+	mafw_renderer_get_status(g_gst_renderer, status_index_cb, &status);
+	fail_if(status.index != 2, index_err_msg, status.index, 2);
+
+	/* --- Stop --- */
+
+	reset_callback_info(&c);
+
+	g_debug("stop...");
+	mafw_renderer_stop(g_gst_renderer, playback_cb, &c);
+
+	if (wait_for_callback(&c, wait_tout_val)) {
+		if (c.error)
+			fail(callback_err_msg, "stopping", c.err_code,
+			     c.err_msg);
+	} else {
+		fail(no_callback_msg);
+	}
+
+	if (wait_for_state(&s, Stopped, wait_tout_val) == FALSE) {
+		fail(state_err_msg, "mafw_renderer_stop", "Stopped", s.state);
+	}
+
+	reset_callback_info(&c);
+	reset_callback_info(&c1);
+	reset_callback_info(&c2);
+	reset_callback_info(&c3);
+}
+END_TEST
+
+START_TEST(test_command_dispose)
+{
+	MafwRenderer *renderer = NULL;
+	CallbackInfo c = {0, };
+
+	/* A renderer of its own, as the fixture one is disposed later */
+	renderer = MAFW_RENDERER(mafw_gst_renderer_new(
+					 MAFW_REGISTRY(
+						 mafw_registry_get_instance())));
+	fail_if(!MAFW_IS_GST_RENDERER(renderer),
+		"Could not create gst renderer instance");
+
+	/* --- A call still queued fails when the renderer goes away --- */
+
+	reset_callback_info(&c);
+
+	g_debug("stop and dispose...");
+	mafw_renderer_stop(renderer, playback_cb, &c);
+	fail_if(c.called, "Stop run before the burst was over");
+
+	g_object_unref(renderer);
+
+	fail_unless(c.called, "Queued call not called back on dispose");
+	fail_unless(c.error, callback_no_err_msg, "disposing", c.err_code,
+		    c.err_msg);
+	fail_if(c.err_code != MAFW_RENDERER_ERROR_CANNOT_PLAY,
+		"Error %d received and %d expected", c.err_code,
+		MAFW_RENDERER_ERROR_CANNOT_PLAY);
+
+	reset_callback_info(&c);
+}
+END_TEST
+
+static void media_changed_count_cb(MafwRenderer *s, gint index,
+				   gchar *objectid, gpointer user_data)
+{
+	guint *count = user_data;
+
+	(*count)++;
+	g_debug("media changed (%d), %u so far ---", index, *count);
+}
+
+START_TEST(test_playlist_edit_burst)
+{
+	MafwPlaylist *playlist = NULL;
+	MafwGstRenderer *renderer = MAFW_GST_RENDERER(g_gst_renderer);
+	RendererInfo s = {0, };
+	RendererInfo status = {0, };
+	gchar *audio_oid = NULL;
+	gchar *video_oid = NULL;
+	guint changes = 0;
+	guint edits_before, coalesced_before, edits, coalesced;
+	gint i;
+
+	g_signal_connect(g_gst_renderer, "state-changed",
+			 G_CALLBACK(state_changed_cb),
+			 &s);
+
+	/* --- Create and assign a playlist --- */
+
+	playlist = MAFW_PLAYLIST(mafw_mock_playlist_new());
+	audio_oid = get_sample_clip_objectid(SAMPLE_AUDIO_CLIP);
+	video_oid = get_sample_clip_objectid(SAMPLE_VIDEO_CLIP);
+	for (i = 0; i < 5; i++) {
+		mafw_playlist_insert_item(playlist, i,
+					  i % 2 ? video_oid : audio_oid, NULL);
+	}
+
+	if (!mafw_renderer_assign_playlist(g_gst_renderer, playlist, NULL)) {
+		fail("Assign playlist failed");
+	}
+
+	wait_for_state(&s, Stopped, wait_tout_val);
+	wait_until_timeout_finishes(100);
+
+	/* --- Remove the current item three times in a row --- */
+
+	g_signal_connect(g_gst_renderer, "media-changed",
+			 G_CALLBACK(media_changed_count_cb),
+			 &changes);
+	mafw_gst_renderer_get_playlist_edit_stats(renderer, &edits_before,
+						  &coalesced_before);
+
+	g_debug("removing the current item three times...");
+	for (i = 0; i < 3; i++) {
+		mafw_playlist_remove_item(playlist, 0, NULL);
+	}
+
+	fail_if(changes != 0,
+		"Playlist edit applied before the burst was over");
+
+	wait_until_timeout_finishes(100);
+
+	/* [audio, video] is left, video being the current item now */
+	fail_if(changes != 1,
+		"%u media changes for a burst of edits and 1 expected",
+		changes);
+	mafw_renderer_get_status(g_gst_renderer, status_index_cb, &status);
+	fail_if(status.index != 0, index_err_msg, status.index, 0);
+
+	mafw_gst_renderer_get_playlist_edit_stats(renderer, &edits,
+						  &coalesced);
+	fail_if(edits - edits_before != 3,
+		"%u playlist edits received and 3 expected",
+		edits - edits_before);
+	fail_if(coalesced - coalesced_before != 2,
+		"%u playlist edits coalesced and 2 expected",
+		coalesced - coalesced_before);
+
+	g_free(audio_oid);
+	g_free(video_oid);
+}
+END_TEST
+
 /*----------------------------------------------------------------------------
   Suit creation
   ----------------------------------------------------------------------------*/
@@ -4156,10 +4592,14 @@ if (1)  tcase_add_test(tc1, test_stop_state);
 if (1)  tcase_add_test(tc1, test_transitioning_state);
 if (1)  tcase_add_test(tc1, test_state_class);
 if (1)  tcase_add_test(tc1, test_playlist_iterator);
+if (1)  tcase_add_test(tc1, test_playlist_iterator_window);
 if (1)  tcase_add_test(tc1, test_video);
 if (1)  tcase_add_test(tc1, test_media_art);
 if (1)  tcase_add_test(tc1, test_properties_management);
 if (1)  tcase_add_test(tc1, test_buffering);
+if (1)  tcase_add_test(tc1, test_command_coalescing);
+if (1)  tcase_add_test(tc1, test_command_dispose);
+if (1)  tcase_add_test(tc1, test_playlist_edit_burst);
 
 	tcase_set_timeout(tc1, 0);
 
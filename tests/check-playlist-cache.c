@@ -0,0 +1,264 @@
+/*
+ * This file is a part of MAFW
+ *
+ * Copyright (C) 2009, 2010 Igalia S.L.
+ *
+ * Contact: Juan A. Suarez Romero <jasuarez@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * check-playlist-cache.c
+ *
+ * Playlist cache tests.  Entries are stored and looked up again in a
+ * scratch directory, and stale or damaged cache files must be misses.
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mafw-gst-renderer-playlist-cache.h"
+
+#undef  G_LOG_DOMAIN
+#define G_LOG_DOMAIN "check-playlist-cache"
+
+#define URI	"http://radio.example.com/stations.pls"
+#define MTIME	1262304000
+#define SIZE	4096
+
+SRunner *configure_tests(void);
+
+static const gchar *items[] = {
+	"http://radio.example.com:8000/jazz",
+	"http://radio.example.com:8000/classical",
+	"file:///home/user/MyDocs/.sounds/a b.mp3",
+};
+
+static gchar *dir;
+
+static void fx_setup(void)
+{
+	dir = g_build_filename(g_get_tmp_dir(), "check-playlist-cache-XXXXXX",
+			       NULL);
+	fail_if(mkdtemp(dir) == NULL, "Cannot create %s", dir);
+}
+
+static void fx_teardown(void)
+{
+	const gchar *name;
+	gchar *file;
+	GDir *d;
+
+	d = g_dir_open(dir, 0, NULL);
+	if (d != NULL) {
+		while ((name = g_dir_read_name(d)) != NULL) {
+			file = g_build_filename(dir, name, NULL);
+			g_unlink(file);
+			g_free(file);
+		}
+		g_dir_close(d);
+	}
+	g_rmdir(dir);
+	g_free(dir);
+}
+
+static void store_items(void)
+{
+	GSList *entries = NULL;
+	gint i;
+
+	for (i = G_N_ELEMENTS(items) - 1; i >= 0; i--)
+		entries = g_slist_prepend(entries, (gpointer) items[i]);
+	fail_unless(mafw_gst_renderer_playlist_cache_store(dir, URI, MTIME,
+							   SIZE, entries),
+		    "Cannot store the entries");
+	g_slist_free(entries);
+}
+
+/* The only file in the scratch directory */
+static gchar *cache_file(void)
+{
+	const gchar *name;
+	gchar *file;
+	GDir *d;
+
+	d = g_dir_open(dir, 0, NULL);
+	fail_if(d == NULL, "Cannot open %s", dir);
+	name = g_dir_read_name(d);
+	fail_if(name == NULL, "No cache file");
+	file = g_build_filename(dir, name, NULL);
+	fail_if(g_dir_read_name(d) != NULL, "More than one cache file");
+	g_dir_close(d);
+
+	return file;
+}
+
+/*----------------------------------------------------------------------------
+  Tests
+  ----------------------------------------------------------------------------*/
+
+START_TEST(test_round_trip)
+{
+	gchar **entries;
+	guint hits, misses, i;
+
+	store_items();
+	entries = mafw_gst_renderer_playlist_cache_lookup(dir, URI, MTIME,
+							  SIZE);
+	fail_if(entries == NULL, "Miss after storing");
+	fail_unless(g_strv_length(entries) == G_N_ELEMENTS(items),
+		    "Got %u entries", g_strv_length(entries));
+	for (i = 0; i < G_N_ELEMENTS(items); i++)
+		fail_if(strcmp(entries[i], items[i]) != 0,
+			"Entry %u is %s", i, entries[i]);
+	g_strfreev(entries);
+
+	mafw_gst_renderer_playlist_cache_get_stats(&hits, &misses);
+	fail_unless(hits == 1 && misses == 0, "%u hits, %u misses", hits,
+		    misses);
+}
+END_TEST
+
+START_TEST(test_stale)
+{
+	guint hits, misses;
+
+	store_items();
+	fail_if(mafw_gst_renderer_playlist_cache_lookup(dir, URI, MTIME + 1,
+							SIZE) != NULL,
+		"Hit with another modification time");
+	fail_if(mafw_gst_renderer_playlist_cache_lookup(dir, URI, MTIME,
+							SIZE + 1) != NULL,
+		"Hit with another size");
+	fail_if(mafw_gst_renderer_playlist_cache_lookup(dir, URI "?x", MTIME,
+							SIZE) != NULL,
+		"Hit for another URI");
+
+	mafw_gst_renderer_playlist_cache_get_stats(&hits, &misses);
+	fail_unless(hits == 0 && misses == 3, "%u hits, %u misses", hits,
+		    misses);
+}
+END_TEST
+
+START_TEST(test_damaged)
+{
+	gchar *file, *data;
+	gsize len;
+
+	store_items();
+	file = cache_file();
+	fail_unless(g_file_get_contents(file, &data, &len, NULL),
+		    "Cannot read %s", file);
+
+	/* Cut in the middle of the last entry */
+	fail_unless(g_file_set_contents(file, data, len - 4, NULL),
+		    "Cannot write %s", file);
+	fail_if(mafw_gst_renderer_playlist_cache_lookup(dir, URI, MTIME,
+							SIZE) != NULL,
+		"Hit on a truncated file");
+
+	/* Cut in the header */
+	fail_unless(g_file_set_contents(file, data, 10, NULL),
+		    "Cannot write %s", file);
+	fail_if(mafw_gst_renderer_playlist_cache_lookup(dir, URI, MTIME,
+							SIZE) != NULL,
+		"Hit on a truncated header");
+
+	/* Wrong magic */
+	data[0] = 'X';
+	fail_unless(g_file_set_contents(file, data, len, NULL),
+		    "Cannot write %s", file);
+	fail_if(mafw_gst_renderer_playlist_cache_lookup(dir, URI, MTIME,
+							SIZE) != NULL,
+		"Hit on a bad magic");
+
+	g_free(data);
+	g_free(file);
+}
+END_TEST
+
+/* Playlists bigger than the cache, one after another: the older ones are
+ * removed, and the last one is kept */
+START_TEST(test_prune)
+{
+	GSList *entries;
+	gchar *entry, *uri, **found;
+	const gchar *name;
+	struct stat st;
+	goffset total = 0;
+	gchar *file;
+	GDir *d;
+	gint i;
+
+	entry = g_strnfill(512 * 1024, 'x');
+	entries = g_slist_prepend(NULL, entry);
+	for (i = 0; i < 10; i++) {
+		uri = g_strdup_printf(URI "?%d", i);
+		fail_unless(mafw_gst_renderer_playlist_cache_store(
+				    dir, uri, MTIME, SIZE, entries),
+			    "Cannot store %s", uri);
+		g_free(uri);
+	}
+	g_slist_free(entries);
+	g_free(entry);
+
+	d = g_dir_open(dir, 0, NULL);
+	fail_if(d == NULL, "Cannot open %s", dir);
+	while ((name = g_dir_read_name(d)) != NULL) {
+		file = g_build_filename(dir, name, NULL);
+		if (g_stat(file, &st) == 0)
+			total += st.st_size;
+		g_free(file);
+	}
+	g_dir_close(d);
+	fail_if(total > 2 * 1024 * 1024, "Cache takes %lld bytes",
+		(long long) total);
+
+	found = mafw_gst_renderer_playlist_cache_lookup(dir, URI "?9", MTIME,
+							SIZE);
+	fail_if(found == NULL, "Last playlist stored was pruned");
+	g_strfreev(found);
+}
+END_TEST
+
+/*----------------------------------------------------------------------------
+  Suit creation
+  ----------------------------------------------------------------------------*/
+
+SRunner *configure_tests(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("Playlist cache");
+
+	tc = tcase_create("Lookup");
+	tcase_add_checked_fixture(tc, fx_setup, fx_teardown);
+	tcase_add_test(tc, test_round_trip);
+	tcase_add_test(tc, test_stale);
+	tcase_add_test(tc, test_damaged);
+	tcase_add_test(tc, test_prune);
+	suite_add_tcase(s, tc);
+
+	return srunner_create(s);
+}
+
+/* vi: set noexpandtab ts=8 sw=8 cino=t0,(0: */